@@ -18,6 +18,26 @@ void s_init(void)
 {
 }
 
+/*
+ * Enable VFP/NEON, which is off out of reset. If the secure world does not
+ * grant access to cp10 and cp11, the write has no effect and it stays off.
+ */
+int arch_cpu_init(void)
+{
+	u32 cpacr;
+
+	asm volatile("mrc p15, 0, %0, c1, c0, 2" : "=r" (cpacr));
+	cpacr |= 0xf << 20;
+	asm volatile("mcr p15, 0, %0, c1, c0, 2" : : "r" (cpacr));
+	isb();
+	asm volatile("mrc p15, 0, %0, c1, c0, 2" : "=r" (cpacr));
+	/* Set FPEXC.EN; vmsr is not available to this soft-float file */
+	if ((cpacr & (0xf << 20)) == (0xf << 20))
+		asm volatile("mcr p10, 7, %0, cr8, cr0, 0" : : "r" (1 << 30));
+
+	return 0;
+}
+
 #if defined(CONFIG_DISPLAY_CPUINFO)
 int print_cpuinfo(void)
 {
@@ -10,8 +10,45 @@
 #ifndef __ETH_H
 #define __ETH_H
 
+struct udevice;
+
 void sandbox_eth_disable_response(int index, bool disable);
 
 void sandbox_eth_skip_timeout(void);
 
+/**
+ * sandbox_eth_tx_hand_f - Handler for packets sent by a sandbox device
+ *
+ * The handler stands in for the machine at the other end. It can queue
+ * replies with sandbox_eth_recv_packet().
+ *
+ * @dev: Device sending the packet
+ * @packet: Packet, starting with its ethernet header
+ * @length: Length of the packet in bytes
+ * @return 0 if the packet was dealt with, -ENOENT to give the usual ARP and
+ * ping replies, other -ve on error
+ */
+typedef int sandbox_eth_tx_hand_f(struct udevice *dev, void *packet,
+				  unsigned int length);
+
+/**
+ * sandbox_eth_set_tx_handler() - Set the handler for packets a device sends
+ *
+ * @index: The alias index (also DM seq number)
+ * @handler: Handler to use, or NULL for just the usual ARP and ping replies
+ */
+void sandbox_eth_set_tx_handler(int index, sandbox_eth_tx_hand_f *handler);
+
+/**
+ * sandbox_eth_recv_packet() - Queue a packet for a device to receive
+ *
+ * @dev: Device to receive the packet
+ * @packet: Packet, starting with its ethernet header
+ * @length: Length of the packet in bytes
+ * @return 0 if OK, -ENOSPC if too many packets are waiting, -E2BIG if the
+ * packet is too large
+ */
+int sandbox_eth_recv_packet(struct udevice *dev, const void *packet,
+			    unsigned int length);
+
 #endif /* __ETH_H */
@@ -14,30 +14,41 @@ static int blkc_show(cmd_tbl_t *cmdtp, int flag,
 		     int argc, char * const argv[])
 {
 	struct block_cache_stats stats;
+	struct block_cache_dev_stats dev_stats;
+	int i;
+
 	blkcache_stats(&stats);
 
 	printf("hits: %u\n"
+	       "partial hits: %u\n"
 	       "misses: %u\n"
 	       "entries: %u\n"
 	       "max blocks/entry: %u\n"
-	       "max cache entries: %u\n",
-	       stats.hits, stats.misses, stats.entries,
-	       stats.max_blocks_per_entry, stats.max_entries);
+	       "size: %lu\n"
+	       "max size: %lu\n",
+	       stats.hits, stats.partial, stats.misses, stats.entries,
+	       stats.max_blocks_per_entry, stats.size, stats.max_size);
+
+	for (i = 0; !blkcache_dev_stats(i, &dev_stats); i++)
+		printf("device %d:%d: hits %u, partial %u, misses %u, entries %u\n",
+		       dev_stats.iftype, dev_stats.devnum, dev_stats.hits,
+		       dev_stats.partial, dev_stats.misses, dev_stats.entries);
 	return 0;
 }
 
 static int blkc_configure(cmd_tbl_t *cmdtp, int flag,
 			  int argc, char * const argv[])
 {
-	unsigned blocks_per_entry, max_entries;
+	unsigned blocks_per_entry;
+	unsigned long max_size;
 	if (argc != 3)
 		return CMD_RET_USAGE;
 
 	blocks_per_entry = simple_strtoul(argv[1], 0, 0);
-	max_entries = simple_strtoul(argv[2], 0, 0);
-	blkcache_configure(blocks_per_entry, max_entries);
-	printf("changed to max of %u entries of %u blocks each\n",
-	       max_entries, blocks_per_entry);
+	max_size = simple_strtoul(argv[2], 0, 0);
+	blkcache_configure(blocks_per_entry, max_size);
+	printf("changed to max of %lu bytes, for up to %u blocks per read\n",
+	       max_size, blocks_per_entry);
 	return 0;
 }
 
@@ -83,5 +94,7 @@ U_BOOT_CMD(
 	blkcache, 4, 0, do_blkcache,
 	"block cache diagnostics and control",
 	"show - show and reset statistics\n"
-	"blkcache configure blocks entries\n"
+	"blkcache configure blocks size\n"
+	"    - cache reads of up to 'blocks' blocks (default 32), in at most\n"
+	"      'size' bytes (this was a number of entries before)\n"
 );
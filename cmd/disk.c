@@ -5,9 +5,76 @@
  * SPDX-License-Identifier:	GPL-2.0+
  */
 #include <common.h>
+#include <bootm.h>
 #include <command.h>
+#include <mapmem.h>
 #include <part.h>
 
+#if defined(CONFIG_IMAGE_FORMAT_LEGACY) && defined(CONFIG_BLK)
+/*
+ * Read a compressed legacy kernel image, decompressing it to its load
+ * address while it is read, so that bootm does not have to do it afterwards.
+ * The image itself is still read to @addr, for bootm to check it. This is
+ * only done when asked for with "diskboot_decomp", as bootm then trusts the
+ * decompressed kernel to be unchanged.
+ *
+ * Returns 0 if OK, -ENOENT if the image should be read as usual, other -ve
+ * on error.
+ */
+static int diskboot_decomp(struct blk_desc *dev_desc, lbaint_t start,
+			   ulong cnt, ulong addr)
+{
+	image_header_t *hdr = map_sysmem(addr, 0);
+	ulong image_start = addr + image_get_header_size();
+	ulong image_len = image_get_data_size(hdr);
+	ulong load = image_get_load(hdr);
+	ulong end = addr + cnt * dev_desc->blksz;
+	int comp = image_get_comp(hdr);
+	ulong load_len;
+	int ret;
+
+	if (getenv_yesno("diskboot_decomp") != 1)
+		return -ENOENT;
+	if (genimg_get_format(hdr) != IMAGE_FORMAT_LEGACY ||
+	    image_get_type(hdr) != IH_TYPE_KERNEL || comp == IH_COMP_NONE)
+		return -ENOENT;
+	if (load < end && load + CONFIG_SYS_BOOTM_LEN > addr)
+		return -ENOENT;
+
+	ret = bootm_decomp_blk(dev_desc, start, cnt, hdr, image_start - addr,
+			       image_len, comp, IH_TYPE_KERNEL,
+			       map_sysmem(load, 0), CONFIG_SYS_BOOTM_LEN,
+			       &load_len);
+	if (ret == -EPROTONOSUPPORT)
+		return -ENOENT;
+	if (ret)
+		return ret;
+	flush_cache(load, ALIGN(load_len, ARCH_DMA_MINALIGN));
+	bootm_decomp_set_loaded(comp, load, image_start, image_len,
+				load + load_len);
+
+	return 0;
+}
+#endif
+
+/* Read the image at @addr, whose first block is already there */
+static int diskboot_read(struct blk_desc *dev_desc, lbaint_t start,
+			 ulong cnt, ulong addr)
+{
+#if defined(CONFIG_IMAGE_FORMAT_LEGACY) && defined(CONFIG_BLK)
+	int ret;
+
+	ret = diskboot_decomp(dev_desc, start, cnt, addr);
+	if (ret != -ENOENT)
+		return ret;
+#endif
+	if (blk_dread(dev_desc, start + 1, cnt - 1,
+		      map_sysmem(addr + dev_desc->blksz, 0)) != cnt - 1)
+		return -EIO;
+
+	return 0;
+}
+
 int common_diskboot(cmd_tbl_t *cmdtp, const char *intf, int argc,
 		    char *const argv[])
 {
@@ -55,17 +122,17 @@ int common_diskboot(cmd_tbl_t *cmdtp, const char *intf, int argc,
 	      ", Block Size: %ld\n",
 	      info.start, info.size, info.blksz);
 
-	if (blk_dread(dev_desc, info.start, 1, (ulong *)addr) != 1) {
+	if (blk_dread(dev_desc, info.start, 1, map_sysmem(addr, 0)) != 1) {
 		printf("** Read error on %d:%d\n", dev, part);
 		bootstage_error(BOOTSTAGE_ID_IDE_PART_READ);
 		return 1;
 	}
 	bootstage_mark(BOOTSTAGE_ID_IDE_PART_READ);
 
-	switch (genimg_get_format((void *) addr)) {
+	switch (genimg_get_format(map_sysmem(addr, 0))) {
 #if defined(CONFIG_IMAGE_FORMAT_LEGACY)
 	case IMAGE_FORMAT_LEGACY:
-		hdr = (image_header_t *) addr;
+		hdr = map_sysmem(addr, 0);
 
 		bootstage_mark(BOOTSTAGE_ID_IDE_FORMAT);
 
@@ -83,7 +150,7 @@ int common_diskboot(cmd_tbl_t *cmdtp, const char *intf, int argc,
 #endif
 #if CONFIG_IS_ENABLED(FIT)
 	case IMAGE_FORMAT_FIT:
-		fit_hdr = (const void *) addr;
+		fit_hdr = map_sysmem(addr, 0);
 		puts("Fit image detected...\n");
 
 		cnt = fit_get_size(fit_hdr);
@@ -97,10 +164,8 @@ int common_diskboot(cmd_tbl_t *cmdtp, const char *intf, int argc,
 
 	cnt += info.blksz - 1;
 	cnt /= info.blksz;
-	cnt -= 1;
 
-	if (blk_dread(dev_desc, info.start + 1, cnt,
-		      (ulong *)(addr + info.blksz)) != cnt) {
+	if (diskboot_read(dev_desc, info.start, cnt, addr)) {
 		printf("** Read error on %d:%d\n", dev, part);
 		bootstage_error(BOOTSTAGE_ID_IDE_READ);
 		return 1;
@@ -110,7 +175,7 @@ int common_diskboot(cmd_tbl_t *cmdtp, const char *intf, int argc,
 #if CONFIG_IS_ENABLED(FIT)
 	/* This cannot be done earlier,
 	 * we need complete FIT image in RAM first */
-	if (genimg_get_format((void *) addr) == IMAGE_FORMAT_FIT) {
+	if (genimg_get_format(map_sysmem(addr, 0)) == IMAGE_FORMAT_FIT) {
 		if (!fit_check_format(fit_hdr)) {
 			bootstage_error(BOOTSTAGE_ID_IDE_FIT_READ);
 			puts("** Bad FIT image format\n");
@@ -121,7 +186,7 @@ int common_diskboot(cmd_tbl_t *cmdtp, const char *intf, int argc,
 	}
 #endif
 
-	flush_cache(addr, (cnt+1)*info.blksz);
+	flush_cache(addr, cnt * info.blksz);
 
 	/* Loading ok, update default load address */
 	load_addr = addr;
@@ -16,6 +16,7 @@
 #include <libfdt.h>
 #include <fdt_support.h>
 #include <mapmem.h>
+#include <of_live.h>
 #include <asm/io.h>
 
 #define MAX_LEVEL	32		/* how deeply nested we will go */
@@ -79,7 +80,8 @@ static int fdt_value_setenv(const void *nodep, int len, const char *var)
 /*
  * Flattened Device Tree command, see the help for parameter definitions.
  */
-static int do_fdt(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+static int do_fdt_cmd(cmd_tbl_t *cmdtp, int flag, int argc,
+		      char * const argv[])
 {
 	if (argc < 2)
 		return CMD_RET_USAGE;
@@ -643,7 +645,32 @@ static int do_fdt(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		unsigned long addr;
 		struct fdt_header *blob;
 		int ret;
+#ifdef CONFIG_OF_OVERLAY_LIST
+		void *blobs[CONFIG_SYS_MAXARGS];
+		int i;
+
+		if (argc < 3)
+			return CMD_RET_USAGE;
+
+		if (!working_fdt)
+			return CMD_RET_FAILURE;
+
+		for (i = 2; i < argc; i++) {
+			addr = simple_strtoul(argv[i], NULL, 16);
+			blob = map_sysmem(addr, 0);
+			if (!fdt_valid(&blob))
+				return CMD_RET_FAILURE;
+			blobs[i - 2] = blob;
+		}
 
+		/* The tree is left as it was if any overlay fails */
+		ret = fdt_overlay_apply_list(working_fdt, blobs, argc - 2);
+		if (ret) {
+			printf("fdt_overlay_apply_list(): %s\n",
+			       fdt_strerror(ret));
+			return CMD_RET_FAILURE;
+		}
+#else
 		if (argc != 3)
 			return CMD_RET_USAGE;
 
@@ -660,6 +687,7 @@ static int do_fdt(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 			printf("fdt_overlay_apply(): %s\n", fdt_strerror(ret));
 			return CMD_RET_FAILURE;
 		}
+#endif
 	}
 #endif
 	/* resize the fdt */
@@ -1053,7 +1081,9 @@ static int fdt_print(const char *pathp, char *prop, int depth)
 #ifdef CONFIG_SYS_LONGHELP
 static char fdt_help_text[] =
 	"addr [-c]  <addr> [<length>]   - Set the [control] fdt location to <addr>\n"
-#ifdef CONFIG_OF_LIBFDT_OVERLAY
+#if defined(CONFIG_OF_OVERLAY_LIST)
+	"fdt apply <addr> [<addr>...]        - Apply overlays to the DT\n"
+#elif defined(CONFIG_OF_LIBFDT_OVERLAY)
 	"fdt apply <addr>                    - Apply overlay to the DT\n"
 #endif
 #ifdef CONFIG_OF_BOARD_SETUP
@@ -1090,6 +1120,22 @@ static char fdt_help_text[] =
 		"e.g. fdt print ethernet0.";
 #endif
 
+/*
+ * The live tree points into the control FDT, so rebuild it if the control FDT
+ * has been moved, or may have been changed as the working FDT.
+ */
+static int do_fdt(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	const void *control = gd->fdt_blob;
+	int ret;
+
+	ret = do_fdt_cmd(cmdtp, flag, argc, argv);
+	if (gd->fdt_blob != control || (void *)working_fdt == gd->fdt_blob)
+		of_live_sync();
+
+	return ret;
+}
+
 U_BOOT_CMD(
 	fdt,	255,	0,	do_fdt,
 	"flattened device tree utility commands", fdt_help_text
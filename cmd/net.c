@@ -10,6 +10,7 @@
  */
 #include <common.h>
 #include <command.h>
+#include <dm.h>
 #include <net.h>
 
 static int netboot_common(enum proto_t, cmd_tbl_t *, int, char * const []);
@@ -110,6 +111,19 @@ U_BOOT_CMD(
 );
 #endif
 
+#if defined(CONFIG_CMD_WGET)
+static int do_wget(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	return netboot_common(WGET, cmdtp, argc, argv);
+}
+
+U_BOOT_CMD(
+	wget,	3,	1,	do_wget,
+	"boot image via network using HTTP protocol",
+	"[loadAddress] [[hostIPaddr:]path]"
+);
+#endif
+
 static void netboot_update_env(void)
 {
 	char tmp[22];
@@ -442,3 +456,46 @@ U_BOOT_CMD(
 );
 
 #endif  /* CONFIG_CMD_LINK_LOCAL */
+
+#if defined(CONFIG_CMD_NET_STATS)
+static void net_show_stats(struct udevice *dev)
+{
+	struct eth_stats *stats = eth_get_stats(dev);
+
+	printf("eth%d: %s%s\n", dev->seq, dev->name,
+	       dev == eth_get_dev() ? " (active)" : "");
+	printf("  RX: %lu packets, %lu bytes, %lu errors, %lu dropped\n",
+	       stats->rx_packets, stats->rx_bytes, stats->rx_errors,
+	       stats->rx_dropped);
+	printf("      %lu polls, at most %lu packets at once, %lu times full\n",
+	       stats->rx_polls, stats->rx_queue_max, stats->rx_full);
+	printf("  TX: %lu packets, %lu errors\n", stats->tx_packets,
+	       stats->tx_errors);
+}
+
+static int do_net(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct udevice *dev;
+	struct uclass *uc;
+
+	if (argc != 2 || strcmp(argv[1], "stats"))
+		return CMD_RET_USAGE;
+
+	if (uclass_get(UCLASS_ETH, &uc))
+		return CMD_RET_FAILURE;
+
+	printf("Receive queue: %d packets\n", CONFIG_NET_RX_QUEUE_SIZE);
+	uclass_foreach_dev(dev, uc) {
+		if (device_active(dev))
+			net_show_stats(dev);
+	}
+
+	return CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	net,	2,	1,	do_net,
+	"network device information",
+	"stats - show the packet counters of the probed ethernet devices"
+);
+#endif  /* CONFIG_CMD_NET_STATS */
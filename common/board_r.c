@@ -42,6 +42,7 @@
 #endif
 #include <mmc.h>
 #include <nand.h>
+#include <of_live.h>
 #include <onenand_uboot.h>
 #include <scsi.h>
 #include <serial.h>
@@ -305,6 +306,7 @@ static int initr_dm(void)
 #ifdef CONFIG_TIMER
 	gd->timer = NULL;
 #endif
+	of_live_sync();
 	ret = dm_init_and_scan(false);
 	if (ret)
 		return ret;
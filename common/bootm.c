@@ -7,7 +7,6 @@
 
 #ifndef USE_HOSTCC
 #include <common.h>
-#include <bootstage.h>
 #include <bzlib.h>
 #include <errno.h>
 #include <fdt_support.h>
@@ -28,13 +27,9 @@
 
 #include <command.h>
 #include <bootm.h>
+#include <bootstage.h>
 #include <image.h>
 
-#ifndef CONFIG_SYS_BOOTM_LEN
-/* use 8MByte as default max gunzip size */
-#define CONFIG_SYS_BOOTM_LEN	0x800000
-#endif
-
 #define IH_INITRD_ARCH IH_ARCH_DEFAULT
 
 #ifndef USE_HOSTCC
@@ -352,14 +347,25 @@ int bootm_decomp_image(int comp, ulong load, ulong image_start, int type,
 	 * loaded, ret will be non-zero on error.
 	 */
 	switch (comp) {
-	case IH_COMP_NONE:
-		if (load == image_start)
+	case IH_COMP_NONE: {
+		ulong start = bootstage_prof_start();
+
+		if (load == image_start) {
+			bootstage_prof_add(BOOTSTAGE_PROF_COPY,
+					   genimg_get_type_short_name(type),
+					   start, 0, 0);
 			break;
-		if (image_len <= unc_len)
+		}
+		if (image_len <= unc_len) {
 			memmove_wd(load_buf, image_buf, image_len, CHUNKSZ);
-		else
+			bootstage_prof_add(BOOTSTAGE_PROF_COPY,
+					   genimg_get_type_short_name(type),
+					   start, 0, image_len);
+		} else {
 			ret = 1;
+		}
 		break;
+	}
 #ifdef CONFIG_GZIP
 	case IH_COMP_GZIP: {
 		ret = gunzip(load_buf, unc_len, image_buf, &image_len);
@@ -425,6 +431,216 @@ int bootm_decomp_image(int comp, ulong load, ulong image_start, int type,
 }
 
 #ifndef USE_HOSTCC
+int bootm_decomp_stream_start(struct bootm_decomp_stream *ds, int comp,
+			      void *load_buf, const void *image_buf,
+			      ulong unc_len)
+{
+	int ret = 0;
+
+	memset(ds, '\0', sizeof(*ds));
+	ds->comp = comp;
+	ds->load_buf = load_buf;
+	ds->image_buf = image_buf;
+	ds->unc_len = unc_len;
+
+	switch (comp) {
+	case IH_COMP_NONE:
+		break;
+#ifdef CONFIG_GZIP
+	case IH_COMP_GZIP:
+		ret = gunzip_stream_init(&ds->gz, image_buf, load_buf, unc_len);
+		break;
+#endif
+#ifdef CONFIG_LZ4
+	case IH_COMP_LZ4:
+		ret = ulz4_stream_init(&ds->lz4, image_buf, load_buf, unc_len);
+		break;
+#endif
+	default:
+		return -EPROTONOSUPPORT;
+	}
+
+	return ret;
+}
+
+int bootm_decomp_stream_feed(struct bootm_decomp_stream *ds, ulong avail)
+{
+	int ret = 0;
+
+	if (ds->err)
+		return ds->err;
+	if (avail < ds->avail)
+		avail = ds->avail;
+
+	switch (ds->comp) {
+	case IH_COMP_NONE:
+		if (ds->load_buf == ds->image_buf)
+			break;
+		if (avail > ds->unc_len) {
+			ret = -ENOBUFS;
+			break;
+		}
+		memmove(ds->load_buf + ds->avail, ds->image_buf + ds->avail,
+			avail - ds->avail);
+		break;
+#ifdef CONFIG_GZIP
+	case IH_COMP_GZIP:
+		ret = gunzip_stream_feed(&ds->gz, avail);
+		break;
+#endif
+#ifdef CONFIG_LZ4
+	case IH_COMP_LZ4:
+		ret = ulz4_stream_feed(&ds->lz4, avail);
+		break;
+#endif
+	}
+	ds->avail = avail;
+	if (ret < 0)
+		ds->err = ret;
+
+	return ret;
+}
+
+int bootm_decomp_stream_end(struct bootm_decomp_stream *ds, ulong image_len,
+			    ulong *load_len)
+{
+	ulong len = 0;
+	int ret;
+
+	ret = bootm_decomp_stream_feed(ds, image_len);
+	switch (ds->comp) {
+	case IH_COMP_NONE:
+		/* There is no end marker: the image is done when loaded */
+		len = image_len;
+		if (!ret)
+			ret = 1;
+		break;
+#ifdef CONFIG_GZIP
+	case IH_COMP_GZIP:
+		gunzip_stream_end(&ds->gz, &len);
+		break;
+#endif
+#ifdef CONFIG_LZ4
+	case IH_COMP_LZ4:
+		len = ds->lz4.out;
+		break;
+#endif
+	}
+	/* The data ran out before the end of the compressed stream */
+	if (!ret)
+		ret = -EINVAL;
+	else if (ret == 1)
+		ret = 0;
+	if (ret)
+		return handle_decomp_error(ds->comp, len, ds->unc_len, ret);
+	*load_len = len;
+
+	return 0;
+}
+
+#ifdef CONFIG_BLK
+/* Number of bytes to read between each part that is decompressed */
+#define BOOTM_BLK_CHUNK		(64 << 10)
+
+struct bootm_blk_stream {
+	struct bootm_decomp_stream ds;
+	ulong offset;
+	ulong image_len;
+};
+
+static int bootm_blk_consume(void *priv, ulong avail)
+{
+	struct bootm_blk_stream *bs = priv;
+	int ret;
+
+	if (avail <= bs->offset)
+		return 0;
+	ret = bootm_decomp_stream_feed(&bs->ds, min(avail - bs->offset,
+						    bs->image_len));
+
+	return ret < 0 ? ret : 0;
+}
+
+int bootm_decomp_blk(struct blk_desc *desc, lbaint_t start, lbaint_t blkcnt,
+		     void *buf, ulong offset, ulong image_len, int comp,
+		     int type, void *load_buf, ulong unc_len, ulong *load_len)
+{
+	struct bootm_blk_stream bs;
+	lbaint_t chunk;
+	int ret;
+
+	ret = bootm_decomp_stream_start(&bs.ds, comp, load_buf, buf + offset,
+					unc_len);
+	if (ret)
+		return ret;
+	bs.offset = offset;
+	bs.image_len = image_len;
+
+	print_decomp_msg(comp, type, false);
+	chunk = max(BOOTM_BLK_CHUNK / desc->blksz, 1UL);
+	ret = blk_dread_stream(desc, start, blkcnt, chunk, buf,
+			       bootm_blk_consume, &bs);
+	if (ret && !bs.ds.err) {
+		puts("read error\n");
+#ifdef CONFIG_GZIP
+		if (comp == IH_COMP_GZIP)
+			gunzip_stream_end(&bs.ds.gz, NULL);
+#endif
+		return -EIO;
+	}
+	ret = bootm_decomp_stream_end(&bs.ds, image_len, load_len);
+	if (ret)
+		return ret;
+
+	puts("OK\n");
+
+	return 0;
+}
+#endif
+
+/* An OS image which was decompressed while it was loaded */
+static struct {
+	int comp;
+	ulong load;
+	ulong load_end;
+	ulong image_start;
+	ulong image_len;
+	image_header_t hdr;	/* header of the image, to recognise it */
+} decomp_loaded;
+
+void bootm_decomp_set_loaded(int comp, ulong load, ulong image_start,
+			     ulong image_len, ulong load_end)
+{
+	decomp_loaded.comp = comp;
+	decomp_loaded.load = load;
+	decomp_loaded.load_end = load_end;
+	decomp_loaded.image_start = image_start;
+	decomp_loaded.image_len = image_len;
+	memcpy(&decomp_loaded.hdr,
+	       map_sysmem(image_start - sizeof(image_header_t), 0),
+	       sizeof(image_header_t));
+}
+
+bool bootm_decomp_get_loaded(int comp, ulong load, ulong image_start,
+			     ulong image_len, ulong *load_end)
+{
+	bool found;
+
+	found = decomp_loaded.image_len &&
+		decomp_loaded.comp == comp &&
+		decomp_loaded.load == load &&
+		decomp_loaded.image_start == image_start &&
+		decomp_loaded.image_len == image_len &&
+		!memcmp(&decomp_loaded.hdr,
+			map_sysmem(image_start - sizeof(image_header_t), 0),
+			sizeof(image_header_t));
+	if (found)
+		*load_end = decomp_loaded.load_end;
+	decomp_loaded.image_len = 0;
+
+	return found;
+}
+
 static int bootm_load_os(bootm_headers_t *images, unsigned long *load_end,
 			 int boot_progress)
 {
@@ -438,14 +654,21 @@ static int bootm_load_os(bootm_headers_t *images, unsigned long *load_end,
 	void *load_buf, *image_buf;
 	int err;
 
-	load_buf = map_sysmem(load, 0);
-	image_buf = map_sysmem(os.image_start, image_len);
-	err = bootm_decomp_image(os.comp, load, os.image_start, os.type,
-				 load_buf, image_buf, image_len,
-				 CONFIG_SYS_BOOTM_LEN, load_end);
-	if (err) {
-		bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
-		return err;
+	if (bootm_decomp_get_loaded(os.comp, load, image_start, image_len,
+				    load_end)) {
+		printf("   %s already uncompressed\n",
+		       genimg_get_type_name(os.type));
+	} else {
+		load_buf = map_sysmem(load, 0);
+		image_buf = map_sysmem(os.image_start, image_len);
+		err = bootm_decomp_image(os.comp, load, os.image_start,
+					 os.type, load_buf, image_buf,
+					 image_len, CONFIG_SYS_BOOTM_LEN,
+					 load_end);
+		if (err) {
+			bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
+			return err;
+		}
 	}
 	flush_cache(load, ALIGN(*load_end - load, ARCH_DMA_MINALIGN));
 
@@ -43,6 +43,30 @@ struct bootstage_hdr {
 	uint32_t magic;		/* Unused */
 };
 
+#ifdef CONFIG_BOOTSTAGE_PROFILE
+/* Follows the name strings in a stash, aligned to 8 bytes */
+struct bootstage_prof_hdr {
+	uint32_t count;		/* Number of profile records */
+	uint32_t rec_size;	/* sizeof(struct bootstage_prof) */
+};
+
+/* Kept in .data, as the first records are made before relocation */
+static struct bootstage_prof prof[CONFIG_BOOTSTAGE_PROFILE_COUNT]
+	__attribute__((section(".data")));
+static int prof_count __attribute__((section(".data")));
+static int prof_dropped __attribute__((section(".data")));
+static bool prof_busy __attribute__((section(".data")));
+/* GD_FLG_RELOC when the timer was last seen working, -1 if never */
+static int prof_timer_ok = -1;
+
+static const char *const prof_kind_name[BOOTSTAGE_PROF_KIND_COUNT] = {
+	[BOOTSTAGE_PROF_INITCALL]	= "initcall",
+	[BOOTSTAGE_PROF_PROBE]		= "probe",
+	[BOOTSTAGE_PROF_BLK]		= "blk",
+	[BOOTSTAGE_PROF_COPY]		= "copy",
+};
+#endif
+
 int bootstage_relocate(void)
 {
 	int i;
@@ -66,6 +90,11 @@ ulong bootstage_add_record(enum bootstage_id id, const char *name,
 	if (flags & BOOTSTAGEF_ALLOC)
 		id = next_id++;
 
+#ifdef CONFIG_BOOTSTAGE_PROFILE
+	/* A time was just read, so profiling can start in this phase */
+	prof_timer_ok = gd->flags & GD_FLG_RELOC;
+#endif
+
 	if (id < BOOTSTAGE_ID_COUNT) {
 		rec = &record[id];
 
@@ -150,6 +179,123 @@ uint32_t bootstage_accum(enum bootstage_id id)
 	return duration;
 }
 
+#ifdef CONFIG_BOOTSTAGE_PROFILE
+ulong bootstage_prof_start(void)
+{
+	ulong start;
+
+	/*
+	 * Before relocation the timer works once a mark has been made, and
+	 * after relocation once one is made again. Reading it may probe the
+	 * timer device, which must not be timed in turn.
+	 */
+	if (prof_busy || prof_timer_ok != (gd->flags & GD_FLG_RELOC))
+		return BOOTSTAGE_PROF_NONE;
+
+	prof_busy = true;
+	start = timer_get_boot_us();
+	prof_busy = false;
+
+	return start;
+}
+
+static struct bootstage_prof *prof_find(enum bootstage_prof_kind kind,
+					const char *name)
+{
+	struct bootstage_prof *p;
+
+	for (p = prof; p < prof + prof_count; p++) {
+		if (p->kind == kind &&
+		    !strncmp(p->name, name, BOOTSTAGE_PROF_NAME_LEN - 1))
+			return p;
+	}
+
+	return NULL;
+}
+
+void bootstage_prof_add(enum bootstage_prof_kind kind, const char *name,
+			ulong start, ulong blocks, uint64_t bytes)
+{
+	struct bootstage_prof *p;
+	ulong now;
+
+	if (start == BOOTSTAGE_PROF_NONE)
+		return;
+	now = timer_get_boot_us();
+
+	p = prof_find(kind, name);
+	if (!p) {
+		if (prof_count == ARRAY_SIZE(prof)) {
+			prof_dropped++;
+			return;
+		}
+		p = &prof[prof_count++];
+		p->kind = kind;
+		strlcpy(p->name, name, sizeof(p->name));
+	}
+	p->count++;
+	p->time_us += now - start;
+	p->blocks += blocks;
+	p->bytes += bytes;
+}
+
+int bootstage_prof_get(enum bootstage_prof_kind kind, const char *name,
+		       struct bootstage_prof *profp)
+{
+	struct bootstage_prof *p = prof_find(kind, name);
+
+	if (!p)
+		return -ENOENT;
+	memcpy(profp, p, sizeof(*p));
+
+	return 0;
+}
+
+void bootstage_prof_reset(void)
+{
+	memset(prof, '\0', sizeof(prof));
+	prof_count = 0;
+	prof_dropped = 0;
+}
+
+/* Sort by kind, then by decreasing time */
+static int h_compare_prof(const void *p1, const void *p2)
+{
+	const struct bootstage_prof *prof1 = p1, *prof2 = p2;
+
+	if (prof1->kind != prof2->kind)
+		return prof1->kind > prof2->kind ? 1 : -1;
+
+	return prof1->time_us < prof2->time_us ? 1 : -1;
+}
+
+static void prof_report(void)
+{
+	struct bootstage_prof *p;
+
+	if (!prof_count)
+		return;
+
+	qsort(prof, prof_count, sizeof(*p), h_compare_prof);
+	puts("\nProfile:\n");
+	printf("%11s%11s  %s\n", "Time", "Count", "Activity");
+	for (p = prof; p < prof + prof_count; p++) {
+		print_grouped_ull(p->time_us, BOOTSTAGE_DIGITS);
+		print_grouped_ull(p->count, BOOTSTAGE_DIGITS);
+		printf("  %s %s", prof_kind_name[p->kind], p->name);
+		if (p->kind == BOOTSTAGE_PROF_BLK)
+			printf(": %u blocks, %llu bytes", p->blocks,
+			       (unsigned long long)p->bytes);
+		else if (p->kind == BOOTSTAGE_PROF_COPY)
+			printf(": %llu bytes", (unsigned long long)p->bytes);
+		putc('\n');
+	}
+	if (prof_dropped)
+		printf("(Dropped %d profile records - please increase CONFIG_BOOTSTAGE_PROFILE_COUNT)\n",
+		       prof_dropped);
+}
+#endif /* CONFIG_BOOTSTAGE_PROFILE */
+
 /**
  * Get a record name as a printable string
  *
@@ -220,6 +366,37 @@ static int add_bootstages_devicetree(struct fdt_header *blob)
 	if (bootstage < 0)
 		return -1;
 
+#ifdef CONFIG_BOOTSTAGE_PROFILE
+	/*
+	 * Profile records go after the others, so are added first. Their
+	 * node names follow on from the largest one the records can use.
+	 */
+	for (i = prof_count - 1; i >= 0; i--) {
+		struct bootstage_prof *p = &prof[i];
+		char name[BOOTSTAGE_PROF_NAME_LEN + 10];
+		int node;
+
+		node = fdt_add_subnode(blob, bootstage,
+				       simple_itoa(BOOTSTAGE_ID_COUNT + i));
+		if (node < 0)
+			break;
+
+		snprintf(name, sizeof(name), "%s %s", prof_kind_name[p->kind],
+			 p->name);
+		if (fdt_setprop_string(blob, node, "name", name) ||
+		    fdt_setprop_cell(blob, node, "accum", p->time_us) ||
+		    fdt_setprop_cell(blob, node, "count", p->count))
+			return -1;
+		if (p->kind == BOOTSTAGE_PROF_BLK &&
+		    (fdt_setprop_cell(blob, node, "blocks", p->blocks) ||
+		     fdt_setprop_u64(blob, node, "bytes", p->bytes)))
+			return -1;
+		if (p->kind == BOOTSTAGE_PROF_COPY &&
+		    fdt_setprop_u64(blob, node, "bytes", p->bytes))
+			return -1;
+	}
+#endif
+
 	/*
 	 * Insert the timings to the device tree in the reverse order so
 	 * that they can be printed in the Linux kernel in the right order.
@@ -290,6 +467,9 @@ void bootstage_report(void)
 		if (rec->start_us)
 			prev = print_time_record(id, rec, -1);
 	}
+#ifdef CONFIG_BOOTSTAGE_PROFILE
+	prof_report();
+#endif
 }
 
 ulong __timer_get_boot_us(void)
@@ -381,6 +561,23 @@ int bootstage_stash(void *base, int size)
 		return -1;
 	}
 
+#ifdef CONFIG_BOOTSTAGE_PROFILE
+	/* Then as many profile records as there is space for */
+	ptr = (char *)base + ALIGN(ptr - (char *)base, 8);
+	if (prof_count && ptr + sizeof(struct bootstage_prof_hdr) <= end) {
+		struct bootstage_prof_hdr *phdr = (void *)ptr;
+
+		ptr += sizeof(*phdr);
+		phdr->count = min_t(int, prof_count,
+				    (end - ptr) / sizeof(*prof));
+		phdr->rec_size = sizeof(*prof);
+		append_data(&ptr, end, prof, phdr->count * sizeof(*prof));
+		if (phdr->count < prof_count)
+			printf("Stash has no space for %d profile records\n",
+			       prof_count - phdr->count);
+	}
+#endif
+
 	/* Update total data size */
 	hdr->size = ptr - (char *)base;
 	printf("Stashed %d records\n", hdr->count);
@@ -449,6 +646,38 @@ int bootstage_unstash(void *base, int size)
 		ptr += strlen(ptr) + 1;
 	}
 
+#ifdef CONFIG_BOOTSTAGE_PROFILE
+	/* Read any profile records which follow, adding to our own */
+	ptr = (char *)base + ALIGN(ptr - (char *)base, 8);
+	if (ptr + sizeof(struct bootstage_prof_hdr) <= (char *)base + hdr->size) {
+		struct bootstage_prof_hdr *phdr = (void *)ptr;
+		struct bootstage_prof *p, *q;
+
+		ptr += sizeof(*phdr);
+		if (phdr->rec_size != sizeof(*p) ||
+		    ptr + phdr->count * sizeof(*p) > (char *)base + hdr->size) {
+			debug("%s: Invalid bootstage profile records\n",
+			      __func__);
+			return -1;
+		}
+		for (p = (void *)ptr; p < (struct bootstage_prof *)ptr +
+		     phdr->count; p++) {
+			q = prof_find(p->kind, p->name);
+			if (!q && prof_count < ARRAY_SIZE(prof)) {
+				q = &prof[prof_count++];
+				memcpy(q, p, sizeof(*q));
+			} else if (q) {
+				q->count += p->count;
+				q->time_us += p->time_us;
+				q->blocks += p->blocks;
+				q->bytes += p->bytes;
+			} else {
+				prof_dropped++;
+			}
+		}
+	}
+#endif
+
 	/* Mark the records as read */
 	next_id += hdr->count;
 	printf("Unstashed %d records\n", hdr->count);
@@ -53,11 +53,18 @@ int bounce_buffer_start(struct bounce_buffer *state, void *data,
 
 	/*
 	 * Flush data to RAM so DMA reads can pick it up,
-	 * and any CPU writebacks don't race with DMA writes
+	 * and any CPU writebacks don't race with DMA writes.
+	 * A buffer which DMA only writes to is overwritten in full, so
+	 * dropping its cache lines is enough and saves cleaning them.
 	 */
-	flush_dcache_range((unsigned long)state->bounce_buffer,
-				(unsigned long)(state->bounce_buffer) +
-					state->len_aligned);
+	if (state->flags == GEN_BB_WRITE)
+		invalidate_dcache_range((unsigned long)state->bounce_buffer,
+					(unsigned long)(state->bounce_buffer) +
+						state->len_aligned);
+	else
+		flush_dcache_range((unsigned long)state->bounce_buffer,
+					(unsigned long)(state->bounce_buffer) +
+						state->len_aligned);
 
 	return 0;
 }
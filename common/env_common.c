@@ -27,6 +27,10 @@ struct hsearch_data env_htab = {
 	.change_ok = env_flags_validate,
 };
 
+/* env_htab.changes when the stored environment last matched it */
+static unsigned int env_clean_changes;
+static bool env_clean;
+
 __weak uchar env_get_char_spec(int index)
 {
 	return *((uchar *)(gd->env_addr + index));
@@ -216,6 +220,7 @@ int env_import(const char *buf, int check)
 	if (himport_r(&env_htab, (char *)ep->data, ENV_SIZE, '\0', 0, 0,
 			0, NULL)) {
 		gd->flags |= GD_FLG_ENV_READY;
+		env_set_clean();
 		return 1;
 	}
 
@@ -250,6 +255,17 @@ int env_export(env_t *env_out)
 	return 0;
 }
 
+void env_set_clean(void)
+{
+	env_clean_changes = env_htab.changes;
+	env_clean = true;
+}
+
+bool env_is_dirty(void)
+{
+	return !env_clean || env_htab.changes != env_clean_changes;
+}
+
 void env_relocate(void)
 {
 #if defined(CONFIG_NEEDS_MANUAL_RELOC)
@@ -116,6 +116,23 @@ static void fini_mmc_for_env(struct mmc *mmc)
 #endif
 }
 
+#if defined(CONFIG_ENV_INCREMENTAL_SAVE) && defined(CONFIG_CMD_SAVEENV)
+/* What each copy of the environment holds, or NULL if not known */
+static env_t *env_stored[2];
+
+static void env_mmc_stored(int copy, const void *buf)
+{
+	if (!env_stored[copy])
+		env_stored[copy] = memalign(ARCH_DMA_MINALIGN, CONFIG_ENV_SIZE);
+	if (env_stored[copy])
+		memcpy(env_stored[copy], buf, CONFIG_ENV_SIZE);
+}
+#else
+static inline void env_mmc_stored(int copy, const void *buf)
+{
+}
+#endif
+
 #ifdef CONFIG_CMD_SAVEENV
 static inline int write_env(struct mmc *mmc, unsigned long size,
 			    unsigned long offset, const void *buffer)
@@ -131,6 +148,66 @@ static inline int write_env(struct mmc *mmc, unsigned long size,
 	return (n == blk_cnt) ? 0 : -1;
 }
 
+#ifdef CONFIG_ENV_INCREMENTAL_SAVE
+static bool env_block_changed(const char *new, const char *old, uint blk,
+			      uint bl_len, unsigned long size)
+{
+	unsigned long pos = blk * bl_len;
+
+	return memcmp(new + pos, old + pos, min(size - pos, (ulong)bl_len));
+}
+
+/* Write only the runs of blocks which differ from what the copy holds */
+static int write_env_changed(struct mmc *mmc, unsigned long size,
+			     unsigned long offset, const void *buffer, int copy)
+{
+	const char *old = (const char *)env_stored[copy];
+	struct blk_desc *desc = mmc_get_blk_desc(mmc);
+	uint bl_len = mmc->write_bl_len;
+	uint blk_start, blk_cnt, blk, end, n;
+	int ret = 0;
+
+	if (!old)
+		ret = write_env(mmc, size, offset, buffer);
+
+	blk_start	= ALIGN(offset, bl_len) / bl_len;
+	blk_cnt		= ALIGN(size, bl_len) / bl_len;
+
+	for (blk = 0; old && blk < blk_cnt; blk++) {
+		if (!env_block_changed(buffer, old, blk, bl_len, size))
+			continue;
+		for (end = blk + 1; end < blk_cnt; end++) {
+			if (!env_block_changed(buffer, old, end, bl_len, size))
+				break;
+		}
+		n = blk_dwrite(desc, blk_start + blk, end - blk,
+			       buffer + blk * bl_len);
+		if (n != end - blk) {
+			ret = -1;
+			break;
+		}
+		blk = end;
+	}
+
+	/* After a failed write the contents of the copy are not known */
+	if (ret) {
+		free(env_stored[copy]);
+		env_stored[copy] = NULL;
+	} else {
+		env_mmc_stored(copy, buffer);
+	}
+
+	return ret;
+}
+#else
+static inline int write_env_changed(struct mmc *mmc, unsigned long size,
+				    unsigned long offset, const void *buffer,
+				    int copy)
+{
+	return write_env(mmc, size, offset, buffer);
+}
+#endif
+
 #ifdef CONFIG_ENV_OFFSET_REDUND
 static unsigned char env_flags;
 #endif
@@ -144,6 +221,11 @@ int saveenv(void)
 	int	ret, copy = 0;
 	const char *errmsg;
 
+	if (IS_ENABLED(CONFIG_ENV_INCREMENTAL_SAVE) && !env_is_dirty()) {
+		puts("Environment unchanged, not saved\n");
+		return 0;
+	}
+
 	errmsg = init_mmc_for_env(mmc);
 	if (errmsg) {
 		printf("%s\n", errmsg);
@@ -167,7 +249,7 @@ int saveenv(void)
 	}
 
 	printf("Writing to %sMMC(%d)... ", copy ? "redundant " : "", dev);
-	if (write_env(mmc, CONFIG_ENV_SIZE, offset, (u_char *)env_new)) {
+	if (write_env_changed(mmc, CONFIG_ENV_SIZE, offset, env_new, copy)) {
 		puts("failed\n");
 		ret = 1;
 		goto fini;
@@ -175,6 +257,7 @@ int saveenv(void)
 
 	puts("done\n");
 	ret = 0;
+	env_set_clean();
 
 #ifdef CONFIG_ENV_OFFSET_REDUND
 	gd->env_valid = gd->env_valid == 2 ? 1 : 2;
@@ -232,6 +315,10 @@ void env_relocate_spec(void)
 
 	read1_fail = read_env(mmc, CONFIG_ENV_SIZE, offset1, tmp_env1);
 	read2_fail = read_env(mmc, CONFIG_ENV_SIZE, offset2, tmp_env2);
+	if (!read1_fail)
+		env_mmc_stored(0, tmp_env1);
+	if (!read2_fail)
+		env_mmc_stored(1, tmp_env2);
 
 	if (read1_fail && read2_fail)
 		puts("*** Error - No Valid Environment Area found\n");
@@ -313,6 +400,7 @@ void env_relocate_spec(void)
 		ret = 1;
 		goto fini;
 	}
+	env_mmc_stored(0, buf);
 
 	env_import(buf, 1);
 	ret = 0;
@@ -54,7 +54,14 @@ int saveenv(void)
 	int	ret;
 #ifdef CONFIG_DM_SPI_FLASH
 	struct udevice *new;
+#endif
+
+	if (IS_ENABLED(CONFIG_ENV_INCREMENTAL_SAVE) && !env_is_dirty()) {
+		puts("Environment unchanged, not saved\n");
+		return 0;
+	}
 
+#ifdef CONFIG_DM_SPI_FLASH
 	/* speed and mode will be read from DT */
 	ret = spi_flash_probe_bus_cs(CONFIG_ENV_SPI_BUS, CONFIG_ENV_SPI_CS,
 				     0, 0, &new);
@@ -139,6 +146,7 @@ int saveenv(void)
 	puts("done\n");
 
 	gd->env_valid = gd->env_valid == 2 ? 1 : 2;
+	env_set_clean();
 
 	printf("Valid environment: %d\n", (int)gd->env_valid);
 
@@ -244,7 +252,14 @@ int saveenv(void)
 	env_t	env_new;
 #ifdef CONFIG_DM_SPI_FLASH
 	struct udevice *new;
+#endif
+
+	if (IS_ENABLED(CONFIG_ENV_INCREMENTAL_SAVE) && !env_is_dirty()) {
+		puts("Environment unchanged, not saved\n");
+		return 0;
+	}
 
+#ifdef CONFIG_DM_SPI_FLASH
 	/* speed and mode will be read from DT */
 	ret = spi_flash_probe_bus_cs(CONFIG_ENV_SPI_BUS, CONFIG_ENV_SPI_CS,
 				     0, 0, &new);
@@ -312,6 +327,7 @@ int saveenv(void)
 
 	ret = 0;
 	puts("done\n");
+	env_set_clean();
 
  done:
 	if (saved_buffer)
@@ -7,9 +7,11 @@
 #include <config.h>
 #include <common.h>
 #include <blk.h>
+#include <errno.h>
 #include <fastboot.h>
 #include <fb_mmc.h>
 #include <image-sparse.h>
+#include <image-stream.h>
 #include <part.h>
 #include <mmc.h>
 #include <div64.h>
@@ -68,6 +70,15 @@ static lbaint_t fb_mmc_sparse_reserve(struct sparse_storage *info,
 	return blkcnt;
 }
 
+static lbaint_t fb_mmc_sparse_erase(struct sparse_storage *info,
+		lbaint_t blk, lbaint_t blkcnt)
+{
+	struct fb_mmc_sparse *sparse = info->priv;
+	struct blk_desc *dev_desc = sparse->dev_desc;
+
+	return blk_derase(dev_desc, blk, blkcnt);
+}
+
 static void write_raw_image(struct blk_desc *dev_desc, disk_partition_t *info,
 		const char *part_name, void *buffer,
 		unsigned int download_bytes)
@@ -160,6 +171,7 @@ void fb_mmc_flash_write(const char *cmd, void *download_buffer,
 	}
 
 	if (is_sparse_image(download_buffer)) {
+		struct mmc *mmc = find_mmc_device(CONFIG_FASTBOOT_FLASH_MMC_DEV);
 		struct fb_mmc_sparse sparse_priv;
 		struct sparse_storage sparse;
 
@@ -170,19 +182,59 @@ void fb_mmc_flash_write(const char *cmd, void *download_buffer,
 		sparse.size = info.size;
 		sparse.write = fb_mmc_sparse_write;
 		sparse.reserve = fb_mmc_sparse_reserve;
+		sparse.erase = mmc ? fb_mmc_sparse_erase : NULL;
+		sparse.erase_grp = mmc ? mmc->erase_grp_size : 0;
+		sparse.erase_zeroes = mmc && !mmc->erased_byte;
+		sparse.mssg = fastboot_fail;
 
 		printf("Flashing sparse image at offset " LBAFU "\n",
 		       sparse.start);
 
 		sparse.priv = &sparse_priv;
-		write_sparse_image(&sparse, cmd, download_buffer,
-				   download_bytes);
+		if (!write_sparse_image(&sparse, cmd, download_buffer,
+					download_bytes))
+			fastboot_okay("");
 	} else {
 		write_raw_image(dev_desc, &info, cmd, download_buffer,
 				download_bytes);
 	}
 }
 
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+static lbaint_t fb_mmc_stream_write(struct stream_storage *info,
+		lbaint_t blk, lbaint_t blkcnt, const void *buffer)
+{
+	struct blk_desc *dev_desc = info->priv;
+
+	return blk_dwrite(dev_desc, blk, blkcnt, buffer);
+}
+
+int fb_mmc_stream_begin(const char *cmd, struct stream_storage *info)
+{
+	struct blk_desc *dev_desc;
+	disk_partition_t part;
+
+	dev_desc = blk_get_dev("mmc", CONFIG_FASTBOOT_FLASH_MMC_DEV);
+	if (!dev_desc || dev_desc->type == DEV_TYPE_UNKNOWN) {
+		error("invalid mmc device\n");
+		return -ENODEV;
+	}
+
+	if (part_get_info_by_name_or_alias(dev_desc, cmd, &part)) {
+		error("cannot find partition: '%s'\n", cmd);
+		return -ENOENT;
+	}
+
+	info->blksz = part.blksz;
+	info->start = part.start;
+	info->size = part.size;
+	info->priv = dev_desc;
+	info->write = fb_mmc_stream_write;
+
+	return 0;
+}
+#endif
+
 void fb_mmc_erase(const char *cmd)
 {
 	int ret;
@@ -175,13 +175,18 @@ void fb_nand_flash_write(const char *cmd, void *download_buffer,
 		sparse.size = part->size / sparse.blksz;
 		sparse.write = fb_nand_sparse_write;
 		sparse.reserve = fb_nand_sparse_reserve;
+		sparse.erase = NULL;
+		sparse.mssg = fastboot_fail;
 
 		printf("Flashing sparse image at offset " LBAFU "\n",
 		       sparse.start);
 
 		sparse.priv = &sparse_priv;
-		write_sparse_image(&sparse, cmd, download_buffer,
-				   download_bytes);
+		ret = write_sparse_image(&sparse, cmd, download_buffer,
+					 download_bytes);
+		/* the failure reason has already been reported */
+		if (ret)
+			return;
 	} else {
 		printf("Flashing raw image at offset 0x%llx\n",
 		       part->offset);
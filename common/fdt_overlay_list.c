@@ -0,0 +1,711 @@
+/*
+ * Applying a list of device tree overlays in one pass
+ *
+ * Copyright (C) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <fdt_support.h>
+#include <malloc.h>
+#include <linux/log2.h>
+
+/*
+ * fdt_overlay_apply() walks the whole base tree to find its largest phandle,
+ * and again for each fragment which targets a phandle. It looks up each
+ * symbol and target path one component at a time, comparing the name of
+ * every sibling on the way, and merges each property and node in place,
+ * moving the rest of the tree along each time.
+ *
+ * Here the base tree is walked once, recording the parent and phandle of each
+ * node in a table, with hash tables from (parent, name) to node, from phandle
+ * to node and from label to symbol. The overlays are merged into a batch of
+ * edits (struct fdt_txn), in which the nodes of the base tree keep their
+ * offsets, and the tree is written out once at the end. Nodes added by the
+ * batch are not in the tables, so below a node which has gained a subnode a
+ * path is looked up through the batch instead. Phandles set by the overlays
+ * are added to the phandle table as they are merged, so the result is the
+ * same as applying the overlays in turn with fdt_overlay_apply().
+ */
+#define FDT_OVL_MIN		64
+#define FDT_OVL_HASH_MIN	16
+
+/* Parent used for the labels of the symbols node in the name table */
+#define FDT_OVL_SYMBOL		-1
+
+/**
+ * struct fdt_ovl_node - A node of the base tree
+ *
+ * @offset: Offset of the node
+ * @parent: Index of the parent node, or -1 for the root node
+ * @depth: Depth of the node, 0 for the root node
+ * @phandle: Phandle of the node, or 0 if none
+ * @grown: true if the batch has added a subnode to the node
+ */
+struct fdt_ovl_node {
+	int offset;
+	int parent;
+	int depth;
+	uint32_t phandle;
+	bool grown;
+};
+
+/**
+ * struct fdt_ovl_name - An entry in the name table
+ *
+ * A node named "name@unit" is entered both under its full name and under
+ * "name", as libfdt matches either. A label of the symbols node is entered
+ * under FDT_OVL_SYMBOL.
+ *
+ * @name: Name, or NULL if the entry is free
+ * @len: Length of @name
+ * @parent: Index of the parent node, or FDT_OVL_SYMBOL
+ * @value: Index of the node, or the offset of the symbol's property
+ */
+struct fdt_ovl_name {
+	const char *name;
+	int len;
+	int parent;
+	int value;
+};
+
+/**
+ * struct fdt_ovl_phandle - An entry in the phandle table
+ *
+ * @phandle: Phandle, or 0 if the entry is free
+ * @node: Offset or batch handle of the node
+ */
+struct fdt_ovl_phandle {
+	uint32_t phandle;
+	int node;
+};
+
+/**
+ * struct fdt_ovl - State of the overlays being applied
+ *
+ * @txn: Batch of edits to the base tree
+ * @nodes: Nodes of the base tree, in tree order
+ * @node_count: Number of entries used in @nodes
+ * @node_size: Number of entries allocated in @nodes
+ * @names: Hash table of node names and labels
+ * @name_mask: Number of entries in @names, less one
+ * @phandles: Hash table of phandles
+ * @phandle_count: Number of entries used in @phandles
+ * @phandle_mask: Number of entries in @phandles, less one
+ * @symbols: Offset of the symbols node in the base tree, or -FDT_ERR_NOTFOUND
+ * @symbols_changed: true if an overlay has targeted the symbols node, so its
+ *	labels must be looked up through the batch
+ * @max_phandle: Largest phandle in the tree so far
+ */
+struct fdt_ovl {
+	struct fdt_txn txn;
+	struct fdt_ovl_node *nodes;
+	int node_count;
+	int node_size;
+	struct fdt_ovl_name *names;
+	uint name_mask;
+	struct fdt_ovl_phandle *phandles;
+	int phandle_count;
+	uint phandle_mask;
+	int symbols;
+	bool symbols_changed;
+	uint32_t max_phandle;
+};
+
+static uint fdt_ovl_hash_size(int count)
+{
+	return max_t(uint, roundup_pow_of_two(count * 2), FDT_OVL_HASH_MIN);
+}
+
+/* Return the entry for a name, or the free entry where it would go */
+static struct fdt_ovl_name *fdt_ovl_name_slot(struct fdt_ovl *ovl, int parent,
+					      const char *name, int len)
+{
+	struct fdt_ovl_name *entry;
+	uint hash = 2166136261U ^ parent;
+	int i;
+
+	for (i = 0; i < len; i++)
+		hash = (hash ^ (u8)name[i]) * 16777619U;
+	for (hash &= ovl->name_mask;; hash = (hash + 1) & ovl->name_mask) {
+		entry = &ovl->names[hash];
+		if (!entry->name || (entry->parent == parent &&
+				     entry->len == len &&
+				     !memcmp(entry->name, name, len)))
+			return entry;
+	}
+}
+
+/* As fdt_subnode_offset(), the first matching node wins */
+static void fdt_ovl_add_name(struct fdt_ovl *ovl, int parent,
+			     const char *name, int len, int value)
+{
+	struct fdt_ovl_name *entry;
+
+	entry = fdt_ovl_name_slot(ovl, parent, name, len);
+	if (entry->name)
+		return;
+	entry->name = name;
+	entry->len = len;
+	entry->parent = parent;
+	entry->value = value;
+}
+
+static struct fdt_ovl_phandle *fdt_ovl_phandle_slot(struct fdt_ovl *ovl,
+						    uint32_t phandle)
+{
+	uint mask = ovl->phandle_mask, slot = phandle & mask;
+
+	for (; ovl->phandles[slot].phandle; slot = (slot + 1) & mask)
+		if (ovl->phandles[slot].phandle == phandle)
+			break;
+
+	return &ovl->phandles[slot];
+}
+
+/* As fdt_node_offset_by_phandle(), the first node wins */
+static int fdt_ovl_add_phandle(struct fdt_ovl *ovl, uint32_t phandle,
+			       int node)
+{
+	struct fdt_ovl_phandle *old, *entry;
+	uint old_mask = ovl->phandle_mask;
+	uint i;
+
+	if ((ovl->phandle_count + 1) * 2 > old_mask + 1) {
+		old = ovl->phandles;
+		ovl->phandle_mask = fdt_ovl_hash_size(ovl->phandle_count + 1);
+		ovl->phandle_mask--;
+		ovl->phandles = calloc(ovl->phandle_mask + 1, sizeof(*old));
+		if (!ovl->phandles) {
+			ovl->phandles = old;
+			ovl->phandle_mask = old_mask;
+			return -FDT_ERR_NOSPACE;
+		}
+		for (i = 0; old && i <= old_mask; i++) {
+			if (old[i].phandle)
+				*fdt_ovl_phandle_slot(ovl, old[i].phandle) =
+					old[i];
+		}
+		free(old);
+	}
+	entry = fdt_ovl_phandle_slot(ovl, phandle);
+	if (!entry->phandle) {
+		entry->phandle = phandle;
+		entry->node = node;
+		ovl->phandle_count++;
+	}
+
+	return 0;
+}
+
+/* Find the index of a node of the base tree from its offset */
+static int fdt_ovl_node_index(struct fdt_ovl *ovl, int offset)
+{
+	int lo = 0, hi = ovl->node_count, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (ovl->nodes[mid].offset < offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo < ovl->node_count && ovl->nodes[lo].offset == offset ?
+		lo : -1;
+}
+
+/* Record the nodes of the base tree, their names and their phandles */
+static int fdt_ovl_scan(struct fdt_ovl *ovl, const void *fdt)
+{
+	struct fdt_ovl_node *node, *nodes;
+	const char *name, *at;
+	int offset, depth = 0, prop;
+	int i, len, size, count = 0;
+
+	/* The depth goes below zero at the end of the root node */
+	for (offset = 0; offset >= 0 && depth >= 0;
+	     offset = fdt_next_node(fdt, offset, &depth)) {
+		if (ovl->node_count == ovl->node_size) {
+			size = max(ovl->node_size * 2, FDT_OVL_MIN);
+			nodes = realloc(ovl->nodes, size * sizeof(*nodes));
+			if (!nodes)
+				return -FDT_ERR_NOSPACE;
+			ovl->nodes = nodes;
+			ovl->node_size = size;
+		}
+		node = &ovl->nodes[ovl->node_count];
+		node->offset = offset;
+		node->depth = depth;
+		node->grown = false;
+		/* The parent is the last node seen which is less deep */
+		for (i = ovl->node_count - 1;
+		     i >= 0 && ovl->nodes[i].depth >= depth;
+		     i = ovl->nodes[i].parent)
+			;
+		node->parent = i;
+		node->phandle = fdt_get_phandle(fdt, offset);
+		if (node->phandle == (uint32_t)-1)
+			node->phandle = 0;
+		if (node->phandle) {
+			ovl->max_phandle = max(ovl->max_phandle, node->phandle);
+			count++;
+		}
+		ovl->node_count++;
+	}
+	if (offset < 0)
+		return offset;
+
+	ovl->phandle_mask = fdt_ovl_hash_size(count) - 1;
+	ovl->phandles = calloc(ovl->phandle_mask + 1, sizeof(*ovl->phandles));
+	if (!ovl->phandles)
+		return -FDT_ERR_NOSPACE;
+	for (i = 0; i < ovl->node_count; i++) {
+		node = &ovl->nodes[i];
+		if (node->phandle &&
+		    fdt_ovl_add_phandle(ovl, node->phandle, node->offset))
+			return -FDT_ERR_NOSPACE;
+	}
+
+	count = ovl->node_count * 2;
+	ovl->symbols = fdt_subnode_offset(fdt, 0, "__symbols__");
+	if (ovl->symbols >= 0) {
+		fdt_for_each_property_offset(prop, fdt, ovl->symbols)
+			count++;
+	}
+	ovl->name_mask = fdt_ovl_hash_size(count) - 1;
+	ovl->names = calloc(ovl->name_mask + 1, sizeof(*ovl->names));
+	if (!ovl->names)
+		return -FDT_ERR_NOSPACE;
+	for (i = 1; i < ovl->node_count; i++) {
+		node = &ovl->nodes[i];
+		name = fdt_get_name(fdt, node->offset, &len);
+		if (!name)
+			return len;
+		fdt_ovl_add_name(ovl, node->parent, name, len, i);
+		at = memchr(name, '@', len);
+		if (at)
+			fdt_ovl_add_name(ovl, node->parent, name, at - name, i);
+	}
+	if (ovl->symbols >= 0) {
+		fdt_for_each_property_offset(prop, fdt, ovl->symbols) {
+			if (!fdt_getprop_by_offset(fdt, prop, &name, &len))
+				return len;
+			fdt_ovl_add_name(ovl, FDT_OVL_SYMBOL, name,
+					 strlen(name), prop);
+		}
+	} else if (ovl->symbols != -FDT_ERR_NOTFOUND) {
+		return ovl->symbols;
+	}
+
+	return 0;
+}
+
+/* As fdt_path_offset(), but in the batch */
+static int fdt_ovl_path_offset(struct fdt_ovl *ovl, const char *path)
+{
+	struct fdt_ovl_name *entry;
+	const char *end;
+	int node = 0, index = 0;
+
+	/* Aliases are looked up in the base tree */
+	if (*path != '/')
+		return fdt_txn_path_offset(&ovl->txn, path);
+
+	while (*path) {
+		while (*path == '/')
+			path++;
+		if (!*path)
+			break;
+		end = strchr(path, '/');
+		if (!end)
+			end = path + strlen(path);
+		if (index >= 0 && !ovl->nodes[index].grown) {
+			entry = fdt_ovl_name_slot(ovl, index, path,
+						  end - path);
+			if (!entry->name)
+				return -FDT_ERR_NOTFOUND;
+			index = entry->value;
+			node = ovl->nodes[index].offset;
+		} else {
+			node = fdt_txn_subnode_offset_namelen(&ovl->txn, node,
+							      path, end - path);
+			if (node < 0)
+				return node;
+			index = fdt_ovl_node_index(ovl, node);
+		}
+		path = end;
+	}
+
+	return node;
+}
+
+/* As fdt_get_phandle(), but in the batch */
+static uint32_t fdt_ovl_get_phandle(struct fdt_ovl *ovl, int node)
+{
+	const fdt32_t *php;
+	int len;
+
+	php = fdt_txn_getprop(&ovl->txn, node, "phandle", &len);
+	if (!php || len != sizeof(*php)) {
+		php = fdt_txn_getprop(&ovl->txn, node, "linux,phandle", &len);
+		if (!php || len != sizeof(*php))
+			return 0;
+	}
+
+	return fdt32_to_cpu(*php);
+}
+
+/* Find the phandle of the node that a label of the symbols node refers to */
+static int fdt_ovl_symbol_phandle(struct fdt_ovl *ovl, const char *label,
+				  uint32_t *phandlep)
+{
+	const struct fdt_ovl_name *entry;
+	const char *path;
+	int node, len;
+
+	if (ovl->symbols >= 0 && !ovl->symbols_changed) {
+		entry = fdt_ovl_name_slot(ovl, FDT_OVL_SYMBOL, label,
+					  strlen(label));
+		if (!entry->name)
+			return -FDT_ERR_NOTFOUND;
+		path = fdt_getprop_by_offset(ovl->txn.fdt, entry->value, NULL,
+					     &len);
+	} else {
+		node = fdt_ovl_path_offset(ovl, "/__symbols__");
+		if (node < 0)
+			return node;
+		path = fdt_txn_getprop(&ovl->txn, node, label, &len);
+	}
+	if (!path)
+		return len;
+
+	node = fdt_ovl_path_offset(ovl, path);
+	if (node < 0)
+		return node;
+	*phandlep = fdt_ovl_get_phandle(ovl, node);
+
+	return *phandlep ? 0 : -FDT_ERR_NOTFOUND;
+}
+
+/* As overlay_adjust_local_phandles() in libfdt */
+static int fdt_ovl_adjust_phandles(void *fdto, uint32_t delta)
+{
+	static const char *const names[] = { "phandle", "linux,phandle" };
+	const fdt32_t *val;
+	uint32_t phandle;
+	int node, len, ret;
+	int i;
+
+	for (node = 0; node >= 0; node = fdt_next_node(fdto, node, NULL)) {
+		for (i = 0; i < ARRAY_SIZE(names); i++) {
+			val = fdt_getprop(fdto, node, names[i], &len);
+			if (!val) {
+				if (len != -FDT_ERR_NOTFOUND)
+					return len;
+				continue;
+			}
+			if (len != sizeof(*val))
+				return -FDT_ERR_BADPHANDLE;
+			phandle = fdt32_to_cpu(*val);
+			if (phandle + delta < phandle ||
+			    phandle + delta == (uint32_t)-1)
+				return -FDT_ERR_NOPHANDLES;
+			ret = fdt_setprop_inplace_u32(fdto, node, names[i],
+						      phandle + delta);
+			if (ret)
+				return ret;
+		}
+	}
+
+	return node == -FDT_ERR_NOTFOUND ? 0 : node;
+}
+
+/* As overlay_update_local_node_references() in libfdt */
+static int fdt_ovl_update_local_refs(void *fdto, int tree_node,
+				     int fixup_node, uint32_t delta)
+{
+	const fdt32_t *fixup_val;
+	const char *tree_val, *name;
+	int fixup_len, tree_len;
+	int prop, child, tree_child;
+	fdt32_t adj_val;
+	uint32_t poffset;
+	int i, ret;
+
+	fdt_for_each_property_offset(prop, fdto, fixup_node) {
+		fixup_val = fdt_getprop_by_offset(fdto, prop, &name,
+						  &fixup_len);
+		if (!fixup_val)
+			return fixup_len;
+		if (fixup_len % sizeof(uint32_t))
+			return -FDT_ERR_BADOVERLAY;
+		tree_val = fdt_getprop(fdto, tree_node, name, &tree_len);
+		if (!tree_val)
+			return tree_len == -FDT_ERR_NOTFOUND ?
+				-FDT_ERR_BADOVERLAY : tree_len;
+
+		for (i = 0; i < fixup_len / sizeof(uint32_t); i++) {
+			poffset = fdt32_to_cpu(fixup_val[i]);
+			/* The phandle may not be aligned */
+			memcpy(&adj_val, tree_val + poffset, sizeof(adj_val));
+			adj_val = cpu_to_fdt32(fdt32_to_cpu(adj_val) + delta);
+			ret = fdt_setprop_inplace_namelen_partial(fdto,
+					tree_node, name, strlen(name), poffset,
+					&adj_val, sizeof(adj_val));
+			if (ret)
+				return ret == -FDT_ERR_NOSPACE ?
+					-FDT_ERR_BADOVERLAY : ret;
+		}
+	}
+
+	fdt_for_each_subnode(child, fdto, fixup_node) {
+		name = fdt_get_name(fdto, child, NULL);
+		tree_child = fdt_subnode_offset(fdto, tree_node, name);
+		if (tree_child < 0)
+			return tree_child == -FDT_ERR_NOTFOUND ?
+				-FDT_ERR_BADOVERLAY : tree_child;
+		ret = fdt_ovl_update_local_refs(fdto, tree_child, child,
+						delta);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/* As overlay_fixup_phandle() in libfdt, for one property of __fixups__ */
+static int fdt_ovl_fixup_phandle(struct fdt_ovl *ovl, void *fdto, int prop)
+{
+	const char *value, *label, *path, *name, *sep, *end;
+	uint32_t phandle = 0;
+	fdt32_t phandle_prop;
+	int len, path_len, name_len, fixup_len;
+	int poffset, node, ret;
+	char *endptr;
+
+	value = fdt_getprop_by_offset(fdto, prop, &label, &len);
+	if (!value)
+		return len == -FDT_ERR_NOTFOUND ? -FDT_ERR_INTERNAL : len;
+
+	do {
+		/* Each entry is "path:property:offset" */
+		end = memchr(value, '\0', len);
+		if (!end)
+			return -FDT_ERR_BADOVERLAY;
+		fixup_len = end - value;
+		path = value;
+		len -= fixup_len + 1;
+		value += fixup_len + 1;
+
+		sep = memchr(path, ':', fixup_len);
+		if (!sep)
+			return -FDT_ERR_BADOVERLAY;
+		path_len = sep - path;
+		if (path_len == fixup_len - 1)
+			return -FDT_ERR_BADOVERLAY;
+		fixup_len -= path_len + 1;
+		name = sep + 1;
+		sep = memchr(name, ':', fixup_len);
+		if (!sep)
+			return -FDT_ERR_BADOVERLAY;
+		name_len = sep - name;
+		if (!name_len)
+			return -FDT_ERR_BADOVERLAY;
+		poffset = simple_strtoul(sep + 1, &endptr, 10);
+		if (*endptr || endptr <= sep + 1)
+			return -FDT_ERR_BADOVERLAY;
+
+		/* The label is the same for each entry */
+		if (!phandle) {
+			ret = fdt_ovl_symbol_phandle(ovl, label, &phandle);
+			if (ret)
+				return ret;
+		}
+		node = fdt_path_offset_namelen(fdto, path, path_len);
+		if (node < 0)
+			return node == -FDT_ERR_NOTFOUND ?
+				-FDT_ERR_BADOVERLAY : node;
+		phandle_prop = cpu_to_fdt32(phandle);
+		ret = fdt_setprop_inplace_namelen_partial(fdto, node, name,
+				name_len, poffset, &phandle_prop,
+				sizeof(phandle_prop));
+		if (ret)
+			return ret;
+	} while (len > 0);
+
+	return 0;
+}
+
+/* Note a change to the phandle of a node */
+static int fdt_ovl_set_phandle(struct fdt_ovl *ovl, int node)
+{
+	uint32_t phandle = fdt_ovl_get_phandle(ovl, node);
+
+	if (!phandle || phandle == (uint32_t)-1)
+		return 0;
+	ovl->max_phandle = max(ovl->max_phandle, phandle);
+
+	return fdt_ovl_add_phandle(ovl, phandle, node);
+}
+
+/* As overlay_apply_node() in libfdt */
+static int fdt_ovl_merge_node(struct fdt_ovl *ovl, int target,
+			      const void *fdto, int node)
+{
+	const char *name;
+	const void *val;
+	int prop, subnode, nnode, index;
+	int len, ret;
+
+	if (target == ovl->symbols)
+		ovl->symbols_changed = true;
+	fdt_for_each_property_offset(prop, fdto, node) {
+		val = fdt_getprop_by_offset(fdto, prop, &name, &len);
+		if (!val)
+			return len == -FDT_ERR_NOTFOUND ?
+				-FDT_ERR_INTERNAL : len;
+		ret = fdt_txn_setprop(&ovl->txn, target, name, val, len);
+		if (!ret && (!strcmp(name, "phandle") ||
+			     !strcmp(name, "linux,phandle")))
+			ret = fdt_ovl_set_phandle(ovl, target);
+		if (ret)
+			return ret;
+	}
+
+	fdt_for_each_subnode(subnode, fdto, node) {
+		name = fdt_get_name(fdto, subnode, NULL);
+		nnode = fdt_txn_add_subnode(&ovl->txn, target, name);
+		if (nnode == -FDT_ERR_EXISTS) {
+			nnode = fdt_txn_subnode_offset(&ovl->txn, target, name);
+			if (nnode == -FDT_ERR_NOTFOUND)
+				return -FDT_ERR_INTERNAL;
+		} else if (nnode >= 0) {
+			index = fdt_ovl_node_index(ovl, target);
+			if (index >= 0)
+				ovl->nodes[index].grown = true;
+		}
+		if (nnode < 0)
+			return nnode;
+
+		ret = fdt_ovl_merge_node(ovl, nnode, fdto, subnode);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/* As overlay_get_target() in libfdt */
+static int fdt_ovl_target(struct fdt_ovl *ovl, const void *fdto,
+			  int fragment)
+{
+	const struct fdt_ovl_phandle *entry;
+	const fdt32_t *val;
+	const char *path;
+	uint32_t phandle;
+	int len;
+
+	val = fdt_getprop(fdto, fragment, "target", &len);
+	if (val) {
+		if (len != sizeof(*val) || fdt32_to_cpu(*val) == (uint32_t)-1)
+			return -FDT_ERR_BADPHANDLE;
+		phandle = fdt32_to_cpu(*val);
+		if (phandle) {
+			entry = fdt_ovl_phandle_slot(ovl, phandle);
+			return entry->phandle ? entry->node :
+				-FDT_ERR_NOTFOUND;
+		}
+	}
+
+	path = fdt_getprop(fdto, fragment, "target-path", &len);
+	if (!path)
+		return len == -FDT_ERR_NOTFOUND ? -FDT_ERR_BADOVERLAY : len;
+
+	return fdt_ovl_path_offset(ovl, path);
+}
+
+static int fdt_ovl_apply(struct fdt_ovl *ovl, void *fdto)
+{
+	uint32_t delta = ovl->max_phandle;
+	int fixups, fragment, overlay, target;
+	int prop, ret;
+
+	ret = fdt_check_header(fdto);
+	if (ret)
+		return ret;
+
+	/* Move the overlay's own phandles past those of the tree */
+	ret = fdt_ovl_adjust_phandles(fdto, delta);
+	if (ret)
+		return ret;
+	fixups = fdt_path_offset(fdto, "/__local_fixups__");
+	if (fixups >= 0)
+		ret = fdt_ovl_update_local_refs(fdto, 0, fixups, delta);
+	else if (fixups != -FDT_ERR_NOTFOUND)
+		ret = fixups;
+	if (ret)
+		return ret;
+
+	/* Point its references to the tree at the right nodes */
+	fixups = fdt_path_offset(fdto, "/__fixups__");
+	if (fixups < 0 && fixups != -FDT_ERR_NOTFOUND)
+		return fixups;
+	if (fixups >= 0) {
+		fdt_for_each_property_offset(prop, fdto, fixups) {
+			ret = fdt_ovl_fixup_phandle(ovl, fdto, prop);
+			if (ret)
+				return ret;
+		}
+	}
+
+	fdt_for_each_subnode(fragment, fdto, 0) {
+		overlay = fdt_subnode_offset(fdto, fragment, "__overlay__");
+		if (overlay == -FDT_ERR_NOTFOUND)
+			continue;
+		if (overlay < 0)
+			return overlay;
+		target = fdt_ovl_target(ovl, fdto, fragment);
+		if (target < 0)
+			return target;
+		ret = fdt_ovl_merge_node(ovl, target, fdto, overlay);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+int fdt_overlay_apply_list(void *fdt, void *const fdtos[], int count)
+{
+	struct fdt_ovl ovl;
+	void *buf = NULL;
+	int size, ret, i;
+
+	memset(&ovl, '\0', sizeof(ovl));
+	ret = fdt_txn_init(&ovl.txn, fdt);
+	if (!ret)
+		ret = fdt_ovl_scan(&ovl, fdt);
+	for (i = 0; !ret && i < count; i++) {
+		ret = fdt_ovl_apply(&ovl, fdtos[i]);
+		/* As with fdt_overlay_apply(), the overlay is now damaged */
+		fdt_set_magic(fdtos[i], ~0);
+	}
+
+	if (!ret) {
+		size = fdt_totalsize(fdt);
+		buf = malloc(size);
+		ret = buf ? fdt_txn_commit(&ovl.txn, buf, size) :
+			-FDT_ERR_NOSPACE;
+		if (!ret)
+			memcpy(fdt, buf, size);
+	}
+	free(buf);
+	free(ovl.phandles);
+	free(ovl.names);
+	free(ovl.nodes);
+	fdt_txn_free(&ovl.txn);
+
+	return ret;
+}
@@ -109,13 +109,23 @@ int fdt_find_and_setprop(void *fdt, const char *node, const char *prop,
  * If the subnode does not exist, it will be created.
  */
 int fdt_find_or_add_subnode(void *fdt, int parentoffset, const char *name)
+{
+	struct fdt_txn txn;
+
+	fdt_txn_init_direct(&txn, fdt);
+
+	return fdt_txn_find_or_add_subnode(&txn, parentoffset, name);
+}
+
+int fdt_txn_find_or_add_subnode(struct fdt_txn *txn, int parentoffset,
+				const char *name)
 {
 	int offset;
 
-	offset = fdt_subnode_offset(fdt, parentoffset, name);
+	offset = fdt_txn_subnode_offset(txn, parentoffset, name);
 
 	if (offset == -FDT_ERR_NOTFOUND)
-		offset = fdt_add_subnode(fdt, parentoffset, name);
+		offset = fdt_txn_add_subnode(txn, parentoffset, name);
 
 	if (offset < 0)
 		printf("%s: %s: %s\n", __func__, name, fdt_strerror(offset));
@@ -125,13 +135,13 @@ int fdt_find_or_add_subnode(void *fdt, int parentoffset, const char *name)
 
 /* rename to CONFIG_OF_STDOUT_PATH ? */
 #if defined(OF_STDOUT_PATH)
-static int fdt_fixup_stdout(void *fdt, int chosenoff)
+static int fdt_fixup_stdout(struct fdt_txn *txn, int chosenoff)
 {
-	return fdt_setprop(fdt, chosenoff, "linux,stdout-path",
-			      OF_STDOUT_PATH, strlen(OF_STDOUT_PATH) + 1);
+	return fdt_txn_setprop(txn, chosenoff, "linux,stdout-path",
+			       OF_STDOUT_PATH, strlen(OF_STDOUT_PATH) + 1);
 }
 #elif defined(CONFIG_OF_STDOUT_VIA_ALIAS) && defined(CONFIG_CONS_INDEX)
-static int fdt_fixup_stdout(void *fdt, int chosenoff)
+static int fdt_fixup_stdout(struct fdt_txn *txn, int chosenoff)
 {
 	int err;
 	int aliasoff;
@@ -142,13 +152,13 @@ static int fdt_fixup_stdout(void *fdt, int chosenoff)
 
 	sprintf(sername, "serial%d", CONFIG_CONS_INDEX - 1);
 
-	aliasoff = fdt_path_offset(fdt, "/aliases");
+	aliasoff = fdt_txn_path_offset(txn, "/aliases");
 	if (aliasoff < 0) {
 		err = aliasoff;
 		goto noalias;
 	}
 
-	path = fdt_getprop(fdt, aliasoff, sername, &len);
+	path = fdt_txn_getprop(txn, aliasoff, sername, &len);
 	if (!path) {
 		err = len;
 		goto noalias;
@@ -157,7 +167,7 @@ static int fdt_fixup_stdout(void *fdt, int chosenoff)
 	/* fdt_setprop may break "path" so we copy it to tmp buffer */
 	memcpy(tmp, path, len);
 
-	err = fdt_setprop(fdt, chosenoff, "linux,stdout-path", tmp, len);
+	err = fdt_txn_setprop(txn, chosenoff, "linux,stdout-path", tmp, len);
 	if (err < 0)
 		printf("WARNING: could not set linux,stdout-path %s.\n",
 		       fdt_strerror(err));
@@ -171,7 +181,7 @@ noalias:
 	return 0;
 }
 #else
-static int fdt_fixup_stdout(void *fdt, int chosenoff)
+static int fdt_fixup_stdout(struct fdt_txn *txn, int chosenoff)
 {
 	return 0;
 }
@@ -187,11 +197,20 @@ static inline int fdt_setprop_uxx(void *fdt, int nodeoffset, const char *name,
 }
 
 int fdt_root(void *fdt)
+{
+	struct fdt_txn txn;
+
+	fdt_txn_init_direct(&txn, fdt);
+
+	return fdt_txn_root(&txn);
+}
+
+int fdt_txn_root(struct fdt_txn *txn)
 {
 	char *serial;
 	int err;
 
-	err = fdt_check_header(fdt);
+	err = fdt_check_header(txn->fdt);
 	if (err < 0) {
 		printf("fdt_root: %s\n", fdt_strerror(err));
 		return err;
@@ -199,8 +218,8 @@ int fdt_root(void *fdt)
 
 	serial = getenv("serial#");
 	if (serial) {
-		err = fdt_setprop(fdt, 0, "serial-number", serial,
-				  strlen(serial) + 1);
+		err = fdt_txn_setprop(txn, 0, "serial-number", serial,
+				      strlen(serial) + 1);
 
 		if (err < 0) {
 			printf("WARNING: could not set serial-number %s.\n",
@@ -273,26 +292,35 @@ int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end)
 }
 
 int fdt_chosen(void *fdt)
+{
+	struct fdt_txn txn;
+
+	fdt_txn_init_direct(&txn, fdt);
+
+	return fdt_txn_chosen(&txn);
+}
+
+int fdt_txn_chosen(struct fdt_txn *txn)
 {
 	int   nodeoffset;
 	int   err;
 	char  *str;		/* used to set string properties */
 
-	err = fdt_check_header(fdt);
+	err = fdt_check_header(txn->fdt);
 	if (err < 0) {
 		printf("fdt_chosen: %s\n", fdt_strerror(err));
 		return err;
 	}
 
 	/* find or create "/chosen" node. */
-	nodeoffset = fdt_find_or_add_subnode(fdt, 0, "chosen");
+	nodeoffset = fdt_txn_find_or_add_subnode(txn, 0, "chosen");
 	if (nodeoffset < 0)
 		return nodeoffset;
 
 	str = getenv("bootargs");
 	if (str) {
-		err = fdt_setprop(fdt, nodeoffset, "bootargs", str,
-				  strlen(str) + 1);
+		err = fdt_txn_setprop(txn, nodeoffset, "bootargs", str,
+				      strlen(str) + 1);
 		if (err < 0) {
 			printf("WARNING: could not set bootargs %s.\n",
 			       fdt_strerror(err));
@@ -300,7 +328,7 @@ int fdt_chosen(void *fdt)
 		}
 	}
 
-	return fdt_fixup_stdout(fdt, nodeoffset);
+	return fdt_fixup_stdout(txn, nodeoffset);
 }
 
 void do_fixup_by_path(void *fdt, const char *path, const char *prop,
@@ -417,6 +445,17 @@ static int fdt_pack_reg(const void *fdt, void *buf, u64 *address, u64 *size,
 #endif
 int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
 {
+	struct fdt_txn txn;
+
+	fdt_txn_init_direct(&txn, blob);
+
+	return fdt_txn_fixup_memory_banks(&txn, start, size, banks);
+}
+
+int fdt_txn_fixup_memory_banks(struct fdt_txn *txn, u64 start[], u64 size[],
+			       int banks)
+{
+	void *blob = txn->fdt;
 	int err, nodeoffset;
 	int len;
 	u8 tmp[MEMORY_BANKS_MAX * 16]; /* Up to 64-bit address + 64-bit size */
@@ -435,12 +474,12 @@ int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
 	}
 
 	/* find or create "/memory" node. */
-	nodeoffset = fdt_find_or_add_subnode(blob, 0, "memory");
+	nodeoffset = fdt_txn_find_or_add_subnode(txn, 0, "memory");
 	if (nodeoffset < 0)
 			return nodeoffset;
 
-	err = fdt_setprop(blob, nodeoffset, "device_type", "memory",
-			sizeof("memory"));
+	err = fdt_txn_setprop(txn, nodeoffset, "device_type", "memory",
+			      sizeof("memory"));
 	if (err < 0) {
 		printf("WARNING: could not set %s %s.\n", "device_type",
 				fdt_strerror(err));
@@ -452,7 +491,7 @@ int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
 
 	len = fdt_pack_reg(blob, tmp, start, size, banks);
 
-	err = fdt_setprop(blob, nodeoffset, "reg", tmp, len);
+	err = fdt_txn_setprop(txn, nodeoffset, "reg", tmp, len);
 	if (err < 0) {
 		printf("WARNING: could not set %s %s.\n",
 				"reg", fdt_strerror(err));
@@ -469,6 +508,33 @@ int fdt_fixup_memory(void *blob, u64 start, u64 size)
 
 void fdt_fixup_ethernet(void *fdt)
 {
+	struct fdt_txn txn;
+
+	fdt_txn_init_direct(&txn, fdt);
+	fdt_txn_fixup_ethernet(&txn);
+}
+
+/* As do_fixup_by_path(), for a batch */
+static void fdt_txn_fixup_by_path(struct fdt_txn *txn, const char *path,
+				  const char *prop, const void *val, int len,
+				  int create)
+{
+	int nodeoff = fdt_txn_path_offset(txn, path);
+	int rc = nodeoff;
+
+	if (nodeoff >= 0) {
+		rc = 0;
+		if (create || fdt_txn_getprop(txn, nodeoff, prop, NULL))
+			rc = fdt_txn_setprop(txn, nodeoff, prop, val, len);
+	}
+	if (rc)
+		printf("Unable to update property %s:%s, err=%s\n",
+			path, prop, fdt_strerror(rc));
+}
+
+void fdt_txn_fixup_ethernet(struct fdt_txn *txn)
+{
+	void *fdt = txn->fdt;
 	int i, j, prop;
 	char *tmp, *end;
 	char mac[16];
@@ -520,10 +586,10 @@ void fdt_fixup_ethernet(void *fdt)
 					tmp = (*end) ? end + 1 : end;
 			}
 
-			do_fixup_by_path(fdt, path, "mac-address",
-					 &mac_addr, 6, 0);
-			do_fixup_by_path(fdt, path, "local-mac-address",
-					 &mac_addr, 6, 1);
+			fdt_txn_fixup_by_path(txn, path, "mac-address",
+					      &mac_addr, 6, 0);
+			fdt_txn_fixup_by_path(txn, path, "local-mac-address",
+					      &mac_addr, 6, 1);
 		}
 	}
 }
@@ -1413,6 +1479,16 @@ unsigned int fdt_create_phandle(void *fdt, int nodeoffset)
  */
 int fdt_set_node_status(void *fdt, int nodeoffset,
 			enum fdt_status status, unsigned int error_code)
+{
+	struct fdt_txn txn;
+
+	fdt_txn_init_direct(&txn, fdt);
+
+	return fdt_txn_set_node_status(&txn, nodeoffset, status, error_code);
+}
+
+int fdt_txn_set_node_status(struct fdt_txn *txn, int nodeoffset,
+			    enum fdt_status status, unsigned int error_code)
 {
 	char buf[16];
 	int ret = 0;
@@ -1422,17 +1498,18 @@ int fdt_set_node_status(void *fdt, int nodeoffset,
 
 	switch (status) {
 	case FDT_STATUS_OKAY:
-		ret = fdt_setprop_string(fdt, nodeoffset, "status", "okay");
+		ret = fdt_txn_setprop_string(txn, nodeoffset, "status", "okay");
 		break;
 	case FDT_STATUS_DISABLED:
-		ret = fdt_setprop_string(fdt, nodeoffset, "status", "disabled");
+		ret = fdt_txn_setprop_string(txn, nodeoffset, "status",
+					     "disabled");
 		break;
 	case FDT_STATUS_FAIL:
-		ret = fdt_setprop_string(fdt, nodeoffset, "status", "fail");
+		ret = fdt_txn_setprop_string(txn, nodeoffset, "status", "fail");
 		break;
 	case FDT_STATUS_FAIL_ERROR_CODE:
 		sprintf(buf, "fail-%d", error_code);
-		ret = fdt_setprop_string(fdt, nodeoffset, "status", buf);
+		ret = fdt_txn_setprop_string(txn, nodeoffset, "status", buf);
 		break;
 	default:
 		printf("Invalid fdt status: %x\n", status);
@@ -0,0 +1,746 @@
+/*
+ * Batches of edits to a flattened device tree
+ *
+ * Copyright (C) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <fdt_txn.h>
+#include <malloc.h>
+
+/*
+ * libfdt puts a new property before the other properties of its node and a
+ * new subnode before the other subnodes, and changes or deletes a property or
+ * node where it is. The edits are kept sorted by node, then by type in the
+ * order in which they are written out, then by key, so that fdt_txn_commit()
+ * finds the edits of each node with one lookup.
+ */
+enum fdt_txn_type {
+	FDT_TXN_DEL_NODE,	/* Node of the tree deleted, key is 0 */
+	FDT_TXN_ADD_PROP,	/* Property added, key is minus its sequence */
+	FDT_TXN_SET_PROP,	/* Property of the tree changed, key is offset */
+	FDT_TXN_ADD_NODE,	/* Subnode added, key is minus its sequence */
+};
+
+#define FDT_TXN_MIN	16
+
+/**
+ * struct fdt_txn_edit - An edit in a batch
+ *
+ * @node: Offset or handle of the node edited
+ * @type: Type of edit (enum fdt_txn_type)
+ * @key: Order of the edit among those of the same node and type
+ * @ref: For FDT_TXN_ADD_PROP the offset of the property name in the strings
+ *	block; for FDT_TXN_ADD_NODE the handle of the new node
+ * @data: Offset of the property value or node name in txn->data
+ * @len: Length of the property value or node name; -1 if the property is
+ *	deleted; for FDT_TXN_DEL_NODE the offset of the end of the node
+ */
+struct fdt_txn_edit {
+	int node;
+	int type;
+	int key;
+	int ref;
+	int data;
+	int len;
+};
+
+/**
+ * struct fdt_txn_out - The structure block written by fdt_txn_commit()
+ *
+ * @txn: Batch being committed
+ * @buf: Start of the structure block
+ * @pos: Number of bytes written
+ * @size: Number of bytes available
+ */
+struct fdt_txn_out {
+	struct fdt_txn *txn;
+	char *buf;
+	int pos;
+	int size;
+};
+
+int fdt_txn_init(struct fdt_txn *txn, const void *fdt)
+{
+	int ret;
+
+	memset(txn, '\0', sizeof(*txn));
+	ret = fdt_check_header(fdt);
+	if (ret)
+		return ret;
+	if (fdt_version(fdt) < 17)
+		return -FDT_ERR_BADVERSION;
+	/* A batch never writes to the tree */
+	txn->fdt = (void *)fdt;
+	txn->base = fdt_size_dt_struct(fdt);
+
+	return 0;
+}
+
+void fdt_txn_init_direct(struct fdt_txn *txn, void *fdt)
+{
+	memset(txn, '\0', sizeof(*txn));
+	txn->fdt = fdt;
+	txn->direct = true;
+}
+
+void fdt_txn_free(struct fdt_txn *txn)
+{
+	free(txn->edits);
+	free(txn->data);
+	free(txn->strings);
+	txn->edits = NULL;
+	txn->data = NULL;
+	txn->strings = NULL;
+	txn->count = 0;
+	txn->size = 0;
+	txn->data_len = 0;
+	txn->data_size = 0;
+	txn->strings_len = 0;
+	txn->strings_size = 0;
+}
+
+/* Make room for @more entries of @elsize bytes after the @used in a buffer */
+static bool fdt_txn_grow(void *bufp, int *sizep, int used, int more,
+			 int elsize)
+{
+	int size = *sizep;
+	void *buf;
+
+	if (used + more <= size)
+		return true;
+	size = max(size * 2, FDT_TXN_MIN);
+	while (size < used + more)
+		size *= 2;
+	buf = realloc(*(void **)bufp, size * elsize);
+	if (!buf)
+		return false;
+	*(void **)bufp = buf;
+	*sizep = size;
+
+	return true;
+}
+
+static int fdt_txn_cmp(const struct fdt_txn_edit *edit, int node, int type,
+		       int key)
+{
+	if (edit->node != node)
+		return edit->node < node ? -1 : 1;
+	if (edit->type != type)
+		return edit->type < type ? -1 : 1;
+	if (edit->key != key)
+		return edit->key < key ? -1 : 1;
+
+	return 0;
+}
+
+/* Return the index of the first edit which does not sort before the key */
+static int fdt_txn_lower(struct fdt_txn *txn, int node, int type, int key)
+{
+	int low = 0, high = txn->count, mid;
+
+	while (low < high) {
+		mid = (low + high) / 2;
+		if (fdt_txn_cmp(&txn->edits[mid], node, type, key) < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+static struct fdt_txn_edit *fdt_txn_find(struct fdt_txn *txn, int node,
+					 int type, int key)
+{
+	int i = fdt_txn_lower(txn, node, type, key);
+
+	if (i < txn->count && !fdt_txn_cmp(&txn->edits[i], node, type, key))
+		return &txn->edits[i];
+
+	return NULL;
+}
+
+/* Add an edit in its place, returning NULL if out of memory */
+static struct fdt_txn_edit *fdt_txn_insert(struct fdt_txn *txn, int node,
+					   int type, int key)
+{
+	struct fdt_txn_edit *edit;
+	int i;
+
+	if (!fdt_txn_grow(&txn->edits, &txn->size, txn->count, 1,
+			  sizeof(*edit)))
+		return NULL;
+	i = fdt_txn_lower(txn, node, type, key);
+	edit = &txn->edits[i];
+	memmove(edit + 1, edit, (txn->count - i) * sizeof(*edit));
+	txn->count++;
+	memset(edit, '\0', sizeof(*edit));
+	edit->node = node;
+	edit->type = type;
+	edit->key = key;
+
+	return edit;
+}
+
+static void fdt_txn_remove(struct fdt_txn *txn, struct fdt_txn_edit *edit)
+{
+	txn->count--;
+	memmove(edit, edit + 1,
+		(txn->edits + txn->count - edit) * sizeof(*edit));
+}
+
+/* Copy a value into the batch, returning its offset in txn->data */
+static int fdt_txn_store(struct fdt_txn *txn, const void *val, int len)
+{
+	const char *src = val;
+	int offset = txn->data_len;
+	int from = -1;
+
+	/* The value may have come from fdt_txn_getprop() */
+	if (src >= txn->data && src < txn->data + txn->data_len)
+		from = src - txn->data;
+	if (!fdt_txn_grow(&txn->data, &txn->data_size, offset, len, 1))
+		return -FDT_ERR_NOSPACE;
+	if (from >= 0)
+		src = txn->data + from;
+	if (len)
+		memcpy(txn->data + offset, src, len);
+	txn->data_len += len;
+
+	return offset;
+}
+
+/* Find a string in a strings block, as libfdt does */
+static int fdt_txn_find_string(const char *strtab, int size, const char *s)
+{
+	int len = strlen(s) + 1;
+	int i;
+
+	for (i = 0; i + len <= size; i++) {
+		if (!memcmp(strtab + i, s, len))
+			return i;
+	}
+
+	return -1;
+}
+
+/* Return the offset of a string, adding it after the strings of the tree */
+static int fdt_txn_add_string(struct fdt_txn *txn, const char *s)
+{
+	const char *strtab = txn->fdt + fdt_off_dt_strings(txn->fdt);
+	int size = fdt_size_dt_strings(txn->fdt);
+	int len = strlen(s) + 1;
+	int offset;
+
+	offset = fdt_txn_find_string(strtab, size, s);
+	if (offset >= 0)
+		return offset;
+	offset = fdt_txn_find_string(txn->strings, txn->strings_len, s);
+	if (offset >= 0)
+		return size + offset;
+	if (!fdt_txn_grow(&txn->strings, &txn->strings_size, txn->strings_len,
+			  len, 1))
+		return -FDT_ERR_NOSPACE;
+	offset = txn->strings_len;
+	memcpy(txn->strings + offset, s, len);
+	txn->strings_len += len;
+
+	return size + offset;
+}
+
+static const char *fdt_txn_string(struct fdt_txn *txn, int offset)
+{
+	int size = fdt_size_dt_strings(txn->fdt);
+
+	if (offset < size)
+		return fdt_string(txn->fdt, offset);
+
+	return txn->strings + offset - size;
+}
+
+/* Return the offset just past the end of a node of the tree */
+static int fdt_txn_node_end(const void *fdt, int offset)
+{
+	int depth = 0, next;
+	uint32_t tag;
+
+	do {
+		tag = fdt_next_tag(fdt, offset, &next);
+		if (next < 0)
+			return next;
+		if (tag == FDT_BEGIN_NODE)
+			depth++;
+		else if (tag == FDT_END_NODE)
+			depth--;
+		else if (tag == FDT_END)
+			return -FDT_ERR_BADSTRUCTURE;
+		offset = next;
+	} while (depth);
+
+	return offset;
+}
+
+/* Check a node offset or handle, including that the node is not deleted */
+static int fdt_txn_check_node(struct fdt_txn *txn, int node)
+{
+	const struct fdt_txn_edit *edit;
+
+	if (node >= txn->base) {
+		if (node > txn->base + txn->seq * (int)FDT_TAGSIZE ||
+		    node % FDT_TAGSIZE)
+			return -FDT_ERR_BADOFFSET;
+		return 0;
+	}
+	if (node < 0 || !fdt_get_name(txn->fdt, node, NULL))
+		return -FDT_ERR_BADOFFSET;
+	for (edit = txn->edits; txn->deleted && edit < txn->edits + txn->count;
+	     edit++) {
+		if (edit->type == FDT_TXN_DEL_NODE && node >= edit->node &&
+		    node < edit->len)
+			return -FDT_ERR_BADOFFSET;
+	}
+
+	return 0;
+}
+
+/*
+ * Look up a property, returning its edit if it has one. *@offsetp is set to
+ * the offset of the property in the tree, or -FDT_ERR_NOTFOUND.
+ */
+static struct fdt_txn_edit *fdt_txn_find_prop(struct fdt_txn *txn, int node,
+					      const char *name, int *offsetp)
+{
+	const struct fdt_property *prop;
+	struct fdt_txn_edit *edit;
+	int i;
+
+	*offsetp = -FDT_ERR_NOTFOUND;
+	for (i = fdt_txn_lower(txn, node, FDT_TXN_ADD_PROP, INT_MIN);
+	     i < txn->count; i++) {
+		edit = &txn->edits[i];
+		if (edit->node != node || edit->type != FDT_TXN_ADD_PROP)
+			break;
+		if (!strcmp(fdt_txn_string(txn, edit->ref), name))
+			return edit;
+	}
+	if (node >= txn->base)
+		return NULL;
+	prop = fdt_get_property(txn->fdt, node, name, NULL);
+	if (!prop)
+		return NULL;
+	*offsetp = (const char *)prop - (const char *)txn->fdt -
+		fdt_off_dt_struct(txn->fdt);
+
+	return fdt_txn_find(txn, node, FDT_TXN_SET_PROP, *offsetp);
+}
+
+const void *fdt_txn_getprop(struct fdt_txn *txn, int nodeoffset,
+			    const char *name, int *lenp)
+{
+	struct fdt_txn_edit *edit = NULL;
+	int offset, len;
+
+	if (txn->direct)
+		return fdt_getprop(txn->fdt, nodeoffset, name, lenp);
+	len = fdt_txn_check_node(txn, nodeoffset);
+	if (!len) {
+		edit = fdt_txn_find_prop(txn, nodeoffset, name, &offset);
+		if (!edit && offset >= 0)
+			return fdt_getprop(txn->fdt, nodeoffset, name, lenp);
+		len = edit && edit->len >= 0 ? edit->len : -FDT_ERR_NOTFOUND;
+	}
+	if (lenp)
+		*lenp = len;
+
+	return len >= 0 ? txn->data + edit->data : NULL;
+}
+
+int fdt_txn_setprop(struct fdt_txn *txn, int nodeoffset, const char *name,
+		    const void *val, int len)
+{
+	struct fdt_txn_edit *edit;
+	int data, nameoff, offset;
+
+	if (txn->direct)
+		return fdt_setprop(txn->fdt, nodeoffset, name, val, len);
+	data = fdt_txn_check_node(txn, nodeoffset);
+	if (data)
+		return data;
+	data = fdt_txn_store(txn, val, len);
+	if (data < 0)
+		return data;
+
+	edit = fdt_txn_find_prop(txn, nodeoffset, name, &offset);
+	if (!edit && offset >= 0) {
+		edit = fdt_txn_insert(txn, nodeoffset, FDT_TXN_SET_PROP,
+				      offset);
+	} else if (!edit || edit->len < 0) {
+		/* A deleted property is added again, as a new property */
+		nameoff = fdt_txn_add_string(txn, name);
+		if (nameoff < 0)
+			return nameoff;
+		edit = fdt_txn_insert(txn, nodeoffset, FDT_TXN_ADD_PROP,
+				      -(txn->seq + 1));
+		if (edit) {
+			edit->ref = nameoff;
+			txn->seq++;
+		}
+	}
+	if (!edit)
+		return -FDT_ERR_NOSPACE;
+	edit->data = data;
+	edit->len = len;
+
+	return 0;
+}
+
+int fdt_txn_delprop(struct fdt_txn *txn, int nodeoffset, const char *name)
+{
+	struct fdt_txn_edit *edit;
+	int offset, ret;
+
+	if (txn->direct)
+		return fdt_delprop(txn->fdt, nodeoffset, name);
+	ret = fdt_txn_check_node(txn, nodeoffset);
+	if (ret)
+		return ret;
+
+	edit = fdt_txn_find_prop(txn, nodeoffset, name, &offset);
+	if (edit && edit->type == FDT_TXN_ADD_PROP) {
+		fdt_txn_remove(txn, edit);
+		return 0;
+	}
+	if (edit ? edit->len < 0 : offset < 0)
+		return -FDT_ERR_NOTFOUND;
+	if (!edit)
+		edit = fdt_txn_insert(txn, nodeoffset, FDT_TXN_SET_PROP,
+				      offset);
+	if (!edit)
+		return -FDT_ERR_NOSPACE;
+	edit->len = -1;
+
+	return 0;
+}
+
+/* Match a node name as libfdt does, ignoring a unit address not in @name */
+static bool fdt_txn_name_eq(const char *node_name, const char *name,
+			    int len)
+{
+	if (strncmp(node_name, name, len))
+		return false;
+
+	return !node_name[len] ||
+	       (node_name[len] == '@' && !memchr(name, '@', len));
+}
+
+int fdt_txn_subnode_offset_namelen(struct fdt_txn *txn, int parentoffset,
+				   const char *name, int namelen)
+{
+	const struct fdt_txn_edit *edit;
+	int node, i;
+
+	if (txn->direct)
+		return fdt_subnode_offset_namelen(txn->fdt, parentoffset, name,
+						  namelen);
+	node = fdt_txn_check_node(txn, parentoffset);
+	if (node)
+		return node;
+
+	/* New subnodes come first, newest first */
+	for (i = fdt_txn_lower(txn, parentoffset, FDT_TXN_ADD_NODE, INT_MIN);
+	     i < txn->count; i++) {
+		edit = &txn->edits[i];
+		if (edit->node != parentoffset)
+			break;
+		if (fdt_txn_name_eq(txn->data + edit->data, name, namelen))
+			return edit->ref;
+	}
+	if (parentoffset >= txn->base)
+		return -FDT_ERR_NOTFOUND;
+	fdt_for_each_subnode(node, txn->fdt, parentoffset) {
+		if (fdt_txn_name_eq(fdt_get_name(txn->fdt, node, NULL), name,
+				    namelen) &&
+		    !fdt_txn_check_node(txn, node))
+			return node;
+	}
+
+	return node == -FDT_ERR_NOTFOUND ? node : -FDT_ERR_BADSTRUCTURE;
+}
+
+int fdt_txn_subnode_offset(struct fdt_txn *txn, int parentoffset,
+			   const char *name)
+{
+	return fdt_txn_subnode_offset_namelen(txn, parentoffset, name,
+					      strlen(name));
+}
+
+int fdt_txn_add_subnode(struct fdt_txn *txn, int parentoffset,
+			const char *name)
+{
+	struct fdt_txn_edit *edit;
+	int ret, data;
+
+	if (txn->direct)
+		return fdt_add_subnode(txn->fdt, parentoffset, name);
+	ret = fdt_txn_subnode_offset(txn, parentoffset, name);
+	if (ret >= 0)
+		return -FDT_ERR_EXISTS;
+	else if (ret != -FDT_ERR_NOTFOUND)
+		return ret;
+
+	data = fdt_txn_store(txn, name, strlen(name) + 1);
+	if (data < 0)
+		return data;
+	edit = fdt_txn_insert(txn, parentoffset, FDT_TXN_ADD_NODE,
+			      -(txn->seq + 1));
+	if (!edit)
+		return -FDT_ERR_NOSPACE;
+	txn->seq++;
+	edit->ref = txn->base + txn->seq * FDT_TAGSIZE;
+	edit->data = data;
+	edit->len = strlen(name);
+
+	return edit->ref;
+}
+
+int fdt_txn_del_node(struct fdt_txn *txn, int nodeoffset)
+{
+	struct fdt_txn_edit *edit;
+	int ret;
+
+	if (txn->direct)
+		return fdt_del_node(txn->fdt, nodeoffset);
+	ret = fdt_txn_check_node(txn, nodeoffset);
+	if (ret)
+		return ret;
+
+	if (nodeoffset >= txn->base) {
+		for (edit = txn->edits; edit < txn->edits + txn->count;
+		     edit++) {
+			if (edit->type == FDT_TXN_ADD_NODE &&
+			    edit->ref == nodeoffset) {
+				fdt_txn_remove(txn, edit);
+				return 0;
+			}
+		}
+		return -FDT_ERR_BADOFFSET;
+	}
+	ret = fdt_txn_node_end(txn->fdt, nodeoffset);
+	if (ret < 0)
+		return ret;
+	edit = fdt_txn_insert(txn, nodeoffset, FDT_TXN_DEL_NODE, 0);
+	if (!edit)
+		return -FDT_ERR_NOSPACE;
+	edit->len = ret;
+	txn->deleted++;
+
+	return 0;
+}
+
+int fdt_txn_path_offset(struct fdt_txn *txn, const char *path)
+{
+	int node = fdt_path_offset(txn->fdt, path);
+
+	if (node < 0 || txn->direct)
+		return node;
+
+	return fdt_txn_check_node(txn, node) ? -FDT_ERR_NOTFOUND : node;
+}
+
+/* Write out @len bytes, padded with zeroes to a whole tag */
+static int fdt_txn_put(struct fdt_txn_out *out, const void *p, int len)
+{
+	int padded = ALIGN(len, FDT_TAGSIZE);
+
+	if (out->pos + padded > out->size)
+		return -FDT_ERR_NOSPACE;
+	memcpy(out->buf + out->pos, p, len);
+	memset(out->buf + out->pos + len, '\0', padded - len);
+	out->pos += padded;
+
+	return 0;
+}
+
+static int fdt_txn_put_tag(struct fdt_txn_out *out, uint32_t tag)
+{
+	fdt32_t val = cpu_to_fdt32(tag);
+
+	return fdt_txn_put(out, &val, sizeof(val));
+}
+
+/* Copy part of the structure block of the tree */
+static int fdt_txn_copy(struct fdt_txn_out *out, int offset, int next)
+{
+	if (next < 0)
+		return next;
+
+	return fdt_txn_put(out, fdt_offset_ptr(out->txn->fdt, offset,
+					       next - offset), next - offset);
+}
+
+static int fdt_txn_put_prop(struct fdt_txn_out *out, int nameoff,
+			    const void *val, int len)
+{
+	struct fdt_property prop;
+	int ret;
+
+	prop.tag = cpu_to_fdt32(FDT_PROP);
+	prop.len = cpu_to_fdt32(len);
+	prop.nameoff = cpu_to_fdt32(nameoff);
+	ret = fdt_txn_put(out, &prop, sizeof(prop));
+	if (ret)
+		return ret;
+
+	return fdt_txn_put(out, val, len);
+}
+
+/* Write out the properties or subnodes added to a node */
+static int fdt_txn_put_added(struct fdt_txn_out *out, int node, int type)
+{
+	struct fdt_txn *txn = out->txn;
+	const struct fdt_txn_edit *edit;
+	int ret = 0, i;
+
+	for (i = fdt_txn_lower(txn, node, type, INT_MIN);
+	     !ret && i < txn->count; i++) {
+		edit = &txn->edits[i];
+		if (edit->node != node || edit->type != type)
+			break;
+		if (type == FDT_TXN_ADD_PROP) {
+			ret = fdt_txn_put_prop(out, edit->ref,
+					       txn->data + edit->data,
+					       edit->len);
+			continue;
+		}
+		ret = fdt_txn_put_tag(out, FDT_BEGIN_NODE);
+		if (!ret)
+			ret = fdt_txn_put(out, txn->data + edit->data,
+					  edit->len + 1);
+		if (!ret)
+			ret = fdt_txn_put_added(out, edit->ref,
+						FDT_TXN_ADD_PROP);
+		if (!ret)
+			ret = fdt_txn_put_added(out, edit->ref,
+						FDT_TXN_ADD_NODE);
+		if (!ret)
+			ret = fdt_txn_put_tag(out, FDT_END_NODE);
+	}
+
+	return ret;
+}
+
+/* Write out a node of the tree, returning the offset of what follows it */
+static int fdt_txn_put_node(struct fdt_txn_out *out, int offset)
+{
+	struct fdt_txn *txn = out->txn;
+	const struct fdt_property *prop;
+	const struct fdt_txn_edit *edit;
+	int node = offset, next, ret;
+	uint32_t tag = FDT_END;
+
+	if (fdt_txn_find(txn, node, FDT_TXN_DEL_NODE, 0))
+		return fdt_txn_node_end(txn->fdt, node);
+	fdt_next_tag(txn->fdt, offset, &next);
+	ret = fdt_txn_copy(out, offset, next);
+	if (!ret)
+		ret = fdt_txn_put_added(out, node, FDT_TXN_ADD_PROP);
+
+	/* Properties are changed or deleted where they are */
+	for (offset = next; !ret; offset = next) {
+		tag = fdt_next_tag(txn->fdt, offset, &next);
+		if (tag != FDT_PROP && tag != FDT_NOP)
+			break;
+		edit = NULL;
+		if (tag == FDT_PROP)
+			edit = fdt_txn_find(txn, node, FDT_TXN_SET_PROP,
+					    offset);
+		if (!edit) {
+			ret = fdt_txn_copy(out, offset, next);
+		} else if (edit->len >= 0) {
+			prop = fdt_get_property_by_offset(txn->fdt, offset,
+							  NULL);
+			ret = fdt_txn_put_prop(out, fdt32_to_cpu(prop->nameoff),
+					       txn->data + edit->data,
+					       edit->len);
+		}
+	}
+	if (!ret)
+		ret = fdt_txn_put_added(out, node, FDT_TXN_ADD_NODE);
+
+	/* Then the subnodes of the tree */
+	while (!ret && (tag == FDT_BEGIN_NODE || tag == FDT_NOP)) {
+		if (tag == FDT_BEGIN_NODE)
+			next = fdt_txn_put_node(out, offset);
+		else
+			ret = fdt_txn_copy(out, offset, next);
+		if (next < 0)
+			return next;
+		offset = next;
+		tag = fdt_next_tag(txn->fdt, offset, &next);
+	}
+	if (ret)
+		return ret;
+	if (tag != FDT_END_NODE)
+		return -FDT_ERR_BADSTRUCTURE;
+	ret = fdt_txn_copy(out, offset, next);
+
+	return ret ? ret : next;
+}
+
+int fdt_txn_commit(struct fdt_txn *txn, void *buf, int bufsize)
+{
+	const void *fdt = txn->fdt;
+	struct fdt_txn_out out;
+	int rsv_off, rsv_size, struct_off, strings_off, strings_size;
+	int offset, next;
+
+	if (txn->direct)
+		return fdt_open_into(fdt, buf, bufsize);
+
+	rsv_off = ALIGN(sizeof(struct fdt_header), 8);
+	rsv_size = (fdt_num_mem_rsv(fdt) + 1) *
+		sizeof(struct fdt_reserve_entry);
+	struct_off = rsv_off + rsv_size;
+	if (struct_off > bufsize)
+		return -FDT_ERR_NOSPACE;
+	memset(buf, '\0', rsv_off);
+	memcpy(buf + rsv_off, fdt + fdt_off_mem_rsvmap(fdt), rsv_size);
+
+	out.txn = txn;
+	out.buf = buf + struct_off;
+	out.pos = 0;
+	out.size = bufsize - struct_off;
+	offset = fdt_txn_put_node(&out, 0);
+	if (offset < 0)
+		return offset;
+	if (fdt_next_tag(fdt, offset, &next) != FDT_END)
+		return -FDT_ERR_BADSTRUCTURE;
+	offset = fdt_txn_copy(&out, offset, next);
+	if (offset)
+		return offset;
+
+	strings_off = struct_off + out.pos;
+	strings_size = fdt_size_dt_strings(fdt) + txn->strings_len;
+	if (strings_off + strings_size > bufsize)
+		return -FDT_ERR_NOSPACE;
+	memcpy(buf + strings_off, fdt + fdt_off_dt_strings(fdt),
+	       fdt_size_dt_strings(fdt));
+	memcpy(buf + strings_off + fdt_size_dt_strings(fdt), txn->strings,
+	       txn->strings_len);
+
+	fdt_set_magic(buf, FDT_MAGIC);
+	fdt_set_totalsize(buf, bufsize);
+	fdt_set_off_dt_struct(buf, struct_off);
+	fdt_set_off_dt_strings(buf, strings_off);
+	fdt_set_off_mem_rsvmap(buf, rsv_off);
+	fdt_set_version(buf, 17);
+	fdt_set_last_comp_version(buf, 16);
+	fdt_set_boot_cpuid_phys(buf, fdt_boot_cpuid_phys(fdt));
+	fdt_set_size_dt_strings(buf, strings_size);
+	fdt_set_size_dt_struct(buf, out.pos);
+
+	return 0;
+}
@@ -14,13 +14,10 @@
 #include <errno.h>
 #include <image.h>
 #include <libfdt.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <asm/io.h>
 
-#ifndef CONFIG_SYS_FDT_PAD
-#define CONFIG_SYS_FDT_PAD 0x3000
-#endif
-
 DECLARE_GLOBAL_DATA_PTR;
 
 static void fdt_error(const char *msg)
@@ -458,28 +455,65 @@ __weak int ft_verify_fdt(void *fdt)
 	return 1;
 }
 
-int image_setup_libfdt(bootm_headers_t *images, void *blob,
-		       int of_size, struct lmb *lmb)
+/*
+ * Make the generic fix-ups to the device tree. With CONFIG_OF_FIXUP_BATCH they
+ * are made as one batch and the tree is written out once, into a copy.
+ */
+static int image_fixup_fdt(void *blob)
 {
-	ulong *initrd_start = &images->initrd_start;
-	ulong *initrd_end = &images->initrd_end;
+	struct fdt_txn txn;
+	void *buf = NULL;
 	int ret = -EPERM;
-	int fdt_ret;
 
-	if (fdt_root(blob) < 0) {
+	if (IS_ENABLED(CONFIG_OF_FIXUP_BATCH) && !fdt_txn_init(&txn, blob))
+		buf = malloc(fdt_totalsize(blob));
+	if (!buf)
+		fdt_txn_init_direct(&txn, blob);
+
+	if (fdt_txn_root(&txn) < 0) {
 		printf("ERROR: root node setup failed\n");
 		goto err;
 	}
-	if (fdt_chosen(blob) < 0) {
+	if (fdt_txn_chosen(&txn) < 0) {
 		printf("ERROR: /chosen node create failed\n");
 		goto err;
 	}
+	/* Update ethernet nodes */
+	fdt_txn_fixup_ethernet(&txn);
+
+	ret = 0;
+	if (buf) {
+		ret = fdt_txn_commit(&txn, buf, fdt_totalsize(blob));
+		if (ret) {
+			printf("ERROR: fdt fixup failed: %s\n",
+			       fdt_strerror(ret));
+			ret = -EPERM;
+			goto err;
+		}
+		memcpy(blob, buf,
+		       fdt_off_dt_strings(buf) + fdt_size_dt_strings(buf));
+	}
+err:
+	fdt_txn_free(&txn);
+	free(buf);
+
+	return ret;
+}
+
+int image_setup_libfdt(bootm_headers_t *images, void *blob,
+		       int of_size, struct lmb *lmb)
+{
+	ulong *initrd_start = &images->initrd_start;
+	ulong *initrd_end = &images->initrd_end;
+	int ret = -EPERM;
+	int fdt_ret;
+
+	if (image_fixup_fdt(blob))
+		goto err;
 	if (arch_fixup_fdt(blob) < 0) {
 		printf("ERROR: arch-specific fdt fixup failed\n");
 		goto err;
 	}
-	/* Update ethernet nodes */
-	fdt_fixup_ethernet(blob);
 	if (IMAGE_OF_BOARD_SETUP) {
 		fdt_ret = ft_board_setup(blob, gd->bd);
 		if (fdt_ret) {
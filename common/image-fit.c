@@ -391,7 +391,7 @@ void fit_image_print(const void *fit, int image_noffset, const char *p)
 	fit_image_get_comp(fit, image_noffset, &comp);
 	printf("%s  Compression:  %s\n", p, genimg_get_comp_name(comp));
 
-	ret = fit_image_get_data(fit, image_noffset, &data, &size);
+	ret = fit_image_get_data_and_size(fit, image_noffset, &data, &size);
 
 #ifndef USE_HOSTCC
 	printf("%s  Data Start:   ", p);
@@ -825,6 +825,69 @@ int fit_image_get_data_size(const void *fit, int noffset, int *data_size)
 	return 0;
 }
 
+/**
+ * Get 'data-position' property from a given image node.
+ *
+ * @fit: pointer to the FIT image header
+ * @noffset: component image node offset
+ * @data_position: holds the data-position property
+ *
+ * returns:
+ *     0, on success
+ *     -ENOENT if the property could not be found
+ */
+int fit_image_get_data_position(const void *fit, int noffset,
+				int *data_position)
+{
+	const fdt32_t *val;
+
+	val = fdt_getprop(fit, noffset, FIT_DATA_POSITION_PROP, NULL);
+	if (!val)
+		return -ENOENT;
+
+	*data_position = fdt32_to_cpu(*val);
+
+	return 0;
+}
+
+/**
+ * fit_image_get_data_and_size - get data and its size, wherever it is
+ * @fit: pointer to the FIT format image header
+ * @noffset: component image node offset
+ * @data: double pointer to void, will hold data's address
+ * @size: pointer to size_t, will hold data's size
+ *
+ * The data of an image node is either in its data property or, for a FIT
+ * with external data, after the FIT itself. In that case 'data-position'
+ * gives its offset from the start of the FIT and 'data-offset' its offset
+ * from the end of the FIT, rounded up to 4 bytes. The external data must
+ * have been loaded along with the FIT.
+ *
+ * returns:
+ *     0, on success
+ *     -1 or -ENOENT, on failure
+ */
+int fit_image_get_data_and_size(const void *fit, int noffset,
+				const void **data, size_t *size)
+{
+	int offset, len;
+
+	if (fit_image_get_data_position(fit, noffset, &offset)) {
+		if (fit_image_get_data_offset(fit, noffset, &offset))
+			return fit_image_get_data(fit, noffset, data, size);
+		offset += (fdt_totalsize(fit) + 3) & ~3;
+	}
+
+	if (fit_image_get_data_size(fit, noffset, &len)) {
+		*size = 0;
+		return -ENOENT;
+	}
+	*data = fit + offset;
+	*size = len;
+
+	return 0;
+}
+
 /**
  * fit_image_hash_get_algo - get hash algorithm name
  * @fit: pointer to the FIT format image header
@@ -1061,7 +1124,7 @@ int fit_image_verify(const void *fit, int image_noffset)
 	int ret;
 
 	/* Get image data and data length */
-	if (fit_image_get_data(fit, image_noffset, &data, &size)) {
+	if (fit_image_get_data_and_size(fit, image_noffset, &data, &size)) {
 		err_msg = "Can't get image data/size";
 		goto error;
 	}
@@ -1633,6 +1696,62 @@ static const char *fit_get_image_type_property(int type)
 	return "unknown";
 }
 
+#if defined(CONFIG_FIT_IN_PLACE) && defined(CONFIG_LMB) && !defined(USE_HOSTCC)
+/**
+ * fit_image_in_place() - check whether a subimage can be used where it is
+ * @images: images being booted
+ * @image_type: type of the subimage
+ * @data: address of the subimage data within the FIT
+ * @len: size of the subimage data
+ *
+ * A device tree or ramdisk need not be moved to its load address if it is
+ * aligned where it is and lies in memory that is free for the OS to use
+ * and that loading the kernel cannot overwrite. The memory is reserved so
+ * that nothing else is placed there later. A device tree also needs room
+ * for the CONFIG_SYS_FDT_PAD bytes that boot_relocate_fdt() grows it by,
+ * since it does that in place if fdt_high is 0xffffffff.
+ *
+ * returns:
+ *     true, if the subimage can be used in place
+ */
+static bool fit_image_in_place(bootm_headers_t *images, int image_type,
+			       ulong data, ulong len)
+{
+	const image_info_t *os = &images->os;
+	ulong align, size = len;
+
+	switch (image_type) {
+	case IH_TYPE_FLATDT:
+		align = 8;
+		size += CONFIG_SYS_FDT_PAD;
+		break;
+	case IH_TYPE_RAMDISK:
+		align = 4096;
+		break;
+	default:
+		return false;
+	}
+
+	if (data & (align - 1) || lmb_get_free_size(&images->lmb, data) < size)
+		return false;
+
+	/* The size of a compressed kernel is only known once it is loaded */
+	if (data + size > os->load &&
+	    (os->comp != IH_COMP_NONE || data < os->load + os->image_len))
+		return false;
+
+	lmb_reserve(&images->lmb, data, size);
+
+	return true;
+}
+#else
+static inline bool fit_image_in_place(bootm_headers_t *images, int image_type,
+				      ulong data, ulong len)
+{
+	return false;
+}
+#endif
+
 int fit_image_load(bootm_headers_t *images, ulong addr,
 		   const char **fit_unamep, const char **fit_uname_configp,
 		   int arch, int image_type, int bootstage_id,
@@ -1775,7 +1894,7 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 	bootstage_mark(bootstage_id + BOOTSTAGE_SUB_CHECK_ALL_OK);
 
 	/* get image data address and length */
-	if (fit_image_get_data(fit, noffset, &buf, &size)) {
+	if (fit_image_get_data_and_size(fit, noffset, &buf, &size)) {
 		printf("Could not find %s subimage data!\n", prop_name);
 		bootstage_error(bootstage_id + BOOTSTAGE_SUB_GET_DATA);
 		return -ENOENT;
@@ -1816,9 +1935,17 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 			bootstage_error(bootstage_id + BOOTSTAGE_SUB_LOAD);
 			return -EBADF;
 		}
-	} else if (load_op != FIT_LOAD_OPTIONAL_NON_ZERO || load) {
+	} else if (load_op == FIT_LOAD_OPTIONAL_NON_ZERO && !load) {
+		/* Don't load */
+	} else if (data == load ||
+		   fit_image_in_place(images, image_type, data, len)) {
+		/* The hash was checked where the data is, so use it there */
+		printf("   Using %s in place at 0x%08lx\n", prop_name, data);
+		bootstage_prof_add(BOOTSTAGE_PROF_COPY, prop_name,
+				   bootstage_prof_start(), 0, 0);
+	} else {
 		ulong image_start, image_end;
-		ulong load_end;
+		ulong load_end, start;
 		void *dst;
 
 		/*
@@ -1827,6 +1954,8 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 		 */
 		image_start = addr;
 		image_end = addr + fit_get_size(fit);
+		if (data + len > image_end)
+			image_end = data + len;	/* external data */
 
 		load_end = load + len;
 		if (image_type != IH_TYPE_KERNEL &&
@@ -1838,8 +1967,11 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 		printf("   Loading %s from 0x%08lx to 0x%08lx\n",
 		       prop_name, data, load);
 
+		start = bootstage_prof_start();
 		dst = map_sysmem(load, len);
 		memmove(dst, buf, len);
+		bootstage_prof_add(BOOTSTAGE_PROF_COPY, prop_name, start, 0,
+				   len);
 		data = load;
 	}
 	bootstage_mark(bootstage_id + BOOTSTAGE_SUB_LOAD);
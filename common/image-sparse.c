@@ -38,10 +38,10 @@
 #include <common.h>
 #include <image-sparse.h>
 #include <div64.h>
+#include <errno.h>
 #include <malloc.h>
 #include <part.h>
 #include <sparse_format.h>
-#include <fastboot.h>
 
 #include <linux/math64.h>
 
@@ -49,27 +49,207 @@
 #define CONFIG_FASTBOOT_FLASH_FILLBUF_SIZE (1024 * 512)
 #endif
 
-void write_sparse_image(
-		struct sparse_storage *info, const char *part_name,
-		void *data, unsigned sz)
+/*
+ * Consecutive RAW chunks are collected into one run and written with a
+ * single call to info->write() once a chunk of another type (or the end
+ * of the image) is reached. A run of one chunk is written straight from
+ * the image. Further chunks are gathered into a buffer of
+ * CONFIG_FASTBOOT_FLASH_FILLBUF_SIZE bytes, and a run that would not fit
+ * in it is written out first, so the image itself is never modified.
+ */
+struct sparse_run {
+	lbaint_t	blk;		/* first block of the run */
+	lbaint_t	blkcnt;		/* number of blocks in the run */
+	void		*data;		/* run data, in the image or in buf */
+	void		*buf;		/* gather buffer */
+	lbaint_t	buf_blks;	/* its size in storage blocks */
+};
+
+/* Reusable buffer holding a FILL pattern */
+struct sparse_fill {
+	uint32_t	*buf;
+	lbaint_t	blkcnt;		/* buffer size in storage blocks */
+	uint32_t	val;		/* pattern currently in the buffer */
+	bool		valid;
+};
+
+static void sparse_fail(struct sparse_storage *info, const char *reason)
+{
+	if (info->mssg)
+		info->mssg(reason);
+}
+
+static int sparse_run_flush(struct sparse_storage *info,
+			    struct sparse_run *run, lbaint_t *blk)
+{
+	lbaint_t blks;
+
+	if (!run->blkcnt)
+		return 0;
+
+	blks = info->write(info, run->blk, run->blkcnt, run->data);
+	/* blks might be > blkcnt (eg. NAND bad-blocks) */
+	if (blks < run->blkcnt) {
+		printf("%s: %s" LBAFU " [" LBAFU "]\n", __func__,
+		       "Write failed, block #", run->blk, blks);
+		sparse_fail(info, "flash write failure");
+		return -EIO;
+	}
+	*blk = run->blk + blks;
+	run->blkcnt = 0;
+
+	return 0;
+}
+
+/* Add RAW chunk data to the run, which ends at storage block blk */
+static int sparse_run_add(struct sparse_storage *info,
+			  struct sparse_run *run, lbaint_t *blk, void *data,
+			  lbaint_t blkcnt)
+{
+	int ret;
+
+	if (run->blkcnt && !run->buf) {
+		run->buf_blks = CONFIG_FASTBOOT_FLASH_FILLBUF_SIZE /
+				info->blksz;
+		run->buf = memalign(ARCH_DMA_MINALIGN,
+				    ROUNDUP(info->blksz * run->buf_blks,
+					    ARCH_DMA_MINALIGN));
+		/* Without the buffer, each chunk is written on its own */
+		if (!run->buf)
+			run->buf_blks = 0;
+	}
+
+	if (run->blkcnt && run->blkcnt + blkcnt > run->buf_blks) {
+		ret = sparse_run_flush(info, run, blk);
+		if (ret)
+			return ret;
+	}
+
+	if (!run->blkcnt) {
+		run->blk = *blk;
+		run->blkcnt = blkcnt;
+		run->data = data;
+		return 0;
+	}
+
+	if (run->data != run->buf) {
+		memcpy(run->buf, run->data, run->blkcnt * info->blksz);
+		run->data = run->buf;
+	}
+	memcpy(run->data + run->blkcnt * info->blksz, data,
+	       blkcnt * info->blksz);
+	run->blkcnt += blkcnt;
+
+	return 0;
+}
+
+static int sparse_write_fill(struct sparse_storage *info,
+			     struct sparse_fill *fill, uint32_t fill_val,
+			     lbaint_t *blk, lbaint_t blkcnt)
+{
+	lbaint_t blks, i, j;
+
+	if (!fill->buf) {
+		fill->blkcnt = CONFIG_FASTBOOT_FLASH_FILLBUF_SIZE / info->blksz;
+		fill->buf = memalign(ARCH_DMA_MINALIGN,
+				     ROUNDUP(info->blksz * fill->blkcnt,
+					     ARCH_DMA_MINALIGN));
+		if (!fill->buf) {
+			sparse_fail(info, "Malloc failed for: CHUNK_TYPE_FILL");
+			return -ENOMEM;
+		}
+	}
+
+	if (!fill->valid || fill->val != fill_val) {
+		for (i = 0; i < info->blksz * fill->blkcnt / sizeof(fill_val);
+		     i++)
+			fill->buf[i] = fill_val;
+		fill->val = fill_val;
+		fill->valid = true;
+	}
+
+	for (i = 0; i < blkcnt; i += j) {
+		j = min(blkcnt - i, fill->blkcnt);
+		blks = info->write(info, *blk, j, fill->buf);
+		/* blks might be > j (eg. NAND bad-blocks) */
+		if (blks < j) {
+			printf("%s: %s " LBAFU " [" LBAFU "]\n", __func__,
+			       "Write failed, block #", *blk, j);
+			sparse_fail(info, "flash write failure");
+			return -EIO;
+		}
+		*blk += blks;
+	}
+
+	return 0;
+}
+
+/*
+ * Erase the part of [blk, blk + blkcnt) that is aligned to the erase
+ * group size, so that neighbouring data is never touched. Returns the
+ * number of leading blocks left unerased in @head and the erased block
+ * count in @erased.
+ */
+static int sparse_erase(struct sparse_storage *info, lbaint_t blk,
+			lbaint_t blkcnt, lbaint_t *head, lbaint_t *erased)
+{
+	lbaint_t grp = info->erase_grp ? info->erase_grp : 1;
+	lbaint_t first, last;
+
+	first = lldiv(blk + grp - 1, grp) * grp;
+	last = lldiv(blk + blkcnt, grp) * grp;
+
+	*head = blkcnt;
+	*erased = 0;
+	if (first >= last)
+		return 0;
+
+	if (info->erase(info, first, last - first) != last - first)
+		return -EIO;
+
+	*head = first - blk;
+	*erased = last - first;
+
+	return 0;
+}
+
+static int sparse_zero_fill(struct sparse_storage *info,
+			    struct sparse_fill *fill, lbaint_t *blk,
+			    lbaint_t blkcnt)
 {
+	lbaint_t head, erased;
+	int ret;
+
+	if (!info->erase || !info->erase_zeroes ||
+	    sparse_erase(info, *blk, blkcnt, &head, &erased))
+		return sparse_write_fill(info, fill, 0, blk, blkcnt);
+
+	ret = sparse_write_fill(info, fill, 0, blk, head);
+	if (ret)
+		return ret;
+	*blk += erased;
+
+	return sparse_write_fill(info, fill, 0, blk, blkcnt - head - erased);
+}
+
+int write_sparse_image(struct sparse_storage *info, const char *part_name,
+		       void *data, unsigned sz)
+{
+	struct sparse_run run = { .blkcnt = 0 };
+	struct sparse_fill fill = { .buf = NULL };
 	lbaint_t blk;
 	lbaint_t blkcnt;
-	lbaint_t blks;
-	uint32_t bytes_written = 0;
+	lbaint_t head, erased;
+	uint64_t bytes_written = 0;
 	unsigned int chunk;
 	unsigned int offset;
 	unsigned int chunk_data_sz;
-	uint32_t *fill_buf = NULL;
 	uint32_t fill_val;
 	sparse_header_t *sparse_header;
 	chunk_header_t *chunk_header;
 	uint32_t total_blocks = 0;
-	int fill_buf_num_blks;
-	int i;
-	int j;
-
-	fill_buf_num_blks = CONFIG_FASTBOOT_FLASH_FILLBUF_SIZE / info->blksz;
+	void *end = data + sz;
+	int ret;
 
 	/* Read and skip over sparse image header */
 	sparse_header = (sparse_header_t *)data;
@@ -101,8 +281,8 @@ void write_sparse_image(
 	if (offset) {
 		printf("%s: Sparse image block size issue [%u]\n",
 		       __func__, sparse_header->blk_sz);
-		fastboot_fail("sparse image block size issue");
-		return;
+		sparse_fail(info, "sparse image block size issue");
+		return -EINVAL;
 	}
 
 	puts("Flashing Sparse Image\n");
@@ -130,37 +310,48 @@ void write_sparse_image(
 				 sizeof(chunk_header_t));
 		}
 
+		if (data + chunk_header->total_sz -
+		    sparse_header->chunk_hdr_sz > end) {
+			sparse_fail(info, "sparse image truncated");
+			ret = -EINVAL;
+			goto out;
+		}
+
 		chunk_data_sz = sparse_header->blk_sz * chunk_header->chunk_sz;
 		blkcnt = chunk_data_sz / info->blksz;
+
+		/* Only RAW and CRC32 chunks keep the pending run open */
+		if (chunk_header->chunk_type != CHUNK_TYPE_RAW &&
+		    chunk_header->chunk_type != CHUNK_TYPE_CRC32) {
+			ret = sparse_run_flush(info, &run, &blk);
+			if (ret)
+				goto out;
+		}
+
 		switch (chunk_header->chunk_type) {
 		case CHUNK_TYPE_RAW:
 			if (chunk_header->total_sz !=
 			    (sparse_header->chunk_hdr_sz + chunk_data_sz)) {
-				fastboot_fail(
-					"Bogus chunk size for chunk type Raw");
-				return;
+				sparse_fail(info,
+					    "Bogus chunk size for chunk type Raw");
+				ret = -EINVAL;
+				goto out;
 			}
 
-			if (blk + blkcnt > info->start + info->size) {
+			if ((run.blkcnt ? run.blk + run.blkcnt : blk) +
+			    blkcnt > info->start + info->size) {
 				printf(
 				    "%s: Request would exceed partition size!\n",
 				    __func__);
-				fastboot_fail(
-				    "Request would exceed partition size!");
-				return;
+				sparse_fail(info,
+					    "Request would exceed partition size!");
+				ret = -EINVAL;
+				goto out;
 			}
 
-			blks = info->write(info, blk, blkcnt, data);
-			/* blks might be > blkcnt (eg. NAND bad-blocks) */
-			if (blks < blkcnt) {
-				printf("%s: %s" LBAFU " [" LBAFU "]\n",
-				       __func__, "Write failed, block #",
-				       blk, blks);
-				fastboot_fail(
-					      "flash write failure");
-				return;
-			}
-			blk += blks;
+			ret = sparse_run_add(info, &run, &blk, data, blkcnt);
+			if (ret)
+				goto out;
 			bytes_written += blkcnt * info->blksz;
 			total_blocks += chunk_header->chunk_sz;
 			data += chunk_data_sz;
@@ -169,65 +360,44 @@ void write_sparse_image(
 		case CHUNK_TYPE_FILL:
 			if (chunk_header->total_sz !=
 			    (sparse_header->chunk_hdr_sz + sizeof(uint32_t))) {
-				fastboot_fail(
-					"Bogus chunk size for chunk type FILL");
-				return;
-			}
-
-			fill_buf = (uint32_t *)
-				   memalign(ARCH_DMA_MINALIGN,
-					    ROUNDUP(
-						info->blksz * fill_buf_num_blks,
-						ARCH_DMA_MINALIGN));
-			if (!fill_buf) {
-				fastboot_fail(
-					"Malloc failed for: CHUNK_TYPE_FILL");
-				return;
+				sparse_fail(info,
+					    "Bogus chunk size for chunk type FILL");
+				ret = -EINVAL;
+				goto out;
 			}
 
 			fill_val = *(uint32_t *)data;
 			data = (char *)data + sizeof(uint32_t);
 
-			for (i = 0;
-			     i < (info->blksz * fill_buf_num_blks /
-				  sizeof(fill_val));
-			     i++)
-				fill_buf[i] = fill_val;
-
 			if (blk + blkcnt > info->start + info->size) {
 				printf(
 				    "%s: Request would exceed partition size!\n",
 				    __func__);
-				fastboot_fail(
-				    "Request would exceed partition size!");
-				return;
+				sparse_fail(info,
+					    "Request would exceed partition size!");
+				ret = -EINVAL;
+				goto out;
 			}
 
-			for (i = 0; i < blkcnt;) {
-				j = blkcnt - i;
-				if (j > fill_buf_num_blks)
-					j = fill_buf_num_blks;
-				blks = info->write(info, blk, j, fill_buf);
-				/* blks might be > j (eg. NAND bad-blocks) */
-				if (blks < j) {
-					printf("%s: %s " LBAFU " [%d]\n",
-					       __func__,
-					       "Write failed, block #",
-					       blk, j);
-					fastboot_fail(
-						      "flash write failure");
-					free(fill_buf);
-					return;
-				}
-				blk += blks;
-				i += j;
-			}
+			if (fill_val)
+				ret = sparse_write_fill(info, &fill, fill_val,
+							&blk, blkcnt);
+			else
+				ret = sparse_zero_fill(info, &fill, &blk,
+						       blkcnt);
+			if (ret)
+				goto out;
 			bytes_written += blkcnt * info->blksz;
 			total_blocks += chunk_data_sz / sparse_header->blk_sz;
-			free(fill_buf);
 			break;
 
 		case CHUNK_TYPE_DONT_CARE:
+			/* Discard stale data where the device allows it */
+			if (info->erase && blk + blkcnt <=
+			    info->start + info->size &&
+			    sparse_erase(info, blk, blkcnt, &head, &erased))
+				debug("%s: discard of " LBAFU " blocks failed\n",
+				      __func__, blkcnt);
 			blk += info->reserve(info, blk, blkcnt);
 			total_blocks += chunk_header->chunk_sz;
 			break;
@@ -235,9 +405,10 @@ void write_sparse_image(
 		case CHUNK_TYPE_CRC32:
 			if (chunk_header->total_sz !=
 			    sparse_header->chunk_hdr_sz) {
-				fastboot_fail(
-					"Bogus chunk size for chunk type Dont Care");
-				return;
+				sparse_fail(info,
+					    "Bogus chunk size for chunk type Dont Care");
+				ret = -EINVAL;
+				goto out;
 			}
 			total_blocks += chunk_header->chunk_sz;
 			data += chunk_data_sz;
@@ -246,19 +417,27 @@ void write_sparse_image(
 		default:
 			printf("%s: Unknown chunk type: %x\n", __func__,
 			       chunk_header->chunk_type);
-			fastboot_fail("Unknown chunk type");
-			return;
+			sparse_fail(info, "Unknown chunk type");
+			ret = -EINVAL;
+			goto out;
 		}
 	}
 
+	ret = sparse_run_flush(info, &run, &blk);
+	if (ret)
+		goto out;
+
 	debug("Wrote %d blocks, expected to write %d blocks\n",
 	      total_blocks, sparse_header->total_blks);
-	printf("........ wrote %u bytes to '%s'\n", bytes_written, part_name);
+	printf("........ wrote %llu bytes to '%s'\n", bytes_written, part_name);
 
-	if (total_blocks != sparse_header->total_blks)
-		fastboot_fail("sparse image write failure");
-	else
-		fastboot_okay("");
+	if (total_blocks != sparse_header->total_blks) {
+		sparse_fail(info, "sparse image write failure");
+		ret = -EIO;
+	}
 
-	return;
+out:
+	free(run.buf);
+	free(fill.buf);
+	return ret;
 }
@@ -0,0 +1,74 @@
+/*
+ * Write a raw image to storage while it is being received
+ *
+ * Copyright (c) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <div64.h>
+#include <errno.h>
+#include <image-stream.h>
+
+void image_stream_init(struct image_stream *stream,
+		       struct stream_storage *info, void *buf,
+		       unsigned int chunk_size)
+{
+	memset(stream, '\0', sizeof(*stream));
+	stream->info = info;
+	stream->buf = buf;
+	stream->chunk_size = chunk_size;
+}
+
+void *image_stream_next(struct image_stream *stream, unsigned int *room)
+{
+	if (room)
+		*room = stream->chunk_size - stream->fill;
+
+	return stream->buf + stream->cur * stream->chunk_size + stream->fill;
+}
+
+void *image_stream_rx(struct image_stream *stream, unsigned int len,
+		      bool last, unsigned int *chunk_len)
+{
+	void *chunk = stream->buf + stream->cur * stream->chunk_size;
+
+	stream->fill += len;
+	if (!stream->fill ||
+	    (!last && stream->fill < stream->chunk_size))
+		return NULL;
+
+	*chunk_len = stream->fill;
+	stream->cur ^= 1;
+	stream->fill = 0;
+
+	return chunk;
+}
+
+int image_stream_write(struct image_stream *stream, const void *chunk,
+		       unsigned int len)
+{
+	struct stream_storage *info = stream->info;
+	lbaint_t blkcnt;
+
+	if (stream->err)
+		return stream->err;
+
+	blkcnt = lldiv(len + info->blksz - 1, info->blksz);
+	if (stream->blk + blkcnt > info->size) {
+		error("too large for partition\n");
+		stream->err = -EFBIG;
+		return stream->err;
+	}
+
+	if (info->write(info, info->start + stream->blk, blkcnt,
+			chunk) != blkcnt) {
+		error("failed writing to device\n");
+		stream->err = -EIO;
+		return stream->err;
+	}
+	stream->blk += blkcnt;
+
+	return 0;
+}
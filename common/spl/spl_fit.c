@@ -215,7 +215,9 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 	board_fit_image_post_process((void **)&src, (size_t *)&data_size);
 #endif
 
-	memcpy(dst, src, data_size);
+	/* Nothing to copy if the image started on a block boundary */
+	if (src != dst)
+		memcpy(dst, src, data_size);
 
 	/* Figure out which device tree the board wants to use */
 	fdt_len = spl_fit_select_fdt(fit, images, &fdt_offset);
@@ -251,7 +253,8 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 	board_fit_image_post_process((void **)&src, (size_t *)&fdt_len);
 #endif
 
-	memcpy(dst, src, fdt_len);
+	if (src != dst)
+		memcpy(dst, src, fdt_len);
 
 	return 0;
 }
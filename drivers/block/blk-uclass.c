@@ -7,9 +7,11 @@
 
 #include <common.h>
 #include <blk.h>
+#include <bootstage.h>
 #include <dm.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
+#include <watchdog.h>
 
 static const char *if_typename_str[IF_TYPE_COUNT] = {
 	[IF_TYPE_IDE]		= "ide",
@@ -386,38 +388,139 @@ int blk_get_device(int if_type, int devnum, struct udevice **devp)
 	return -ENODEV;
 }
 
+/* Account a transfer to the bootstage profile record of the device */
+static void blk_prof_add(struct blk_desc *desc, ulong start, ulong blkcnt)
+{
+	if (IS_ERR_VALUE(blkcnt))
+		blkcnt = 0;
+	bootstage_prof_add(BOOTSTAGE_PROF_BLK, desc->bdev->name, start, blkcnt,
+			   (u64)blkcnt * desc->blksz);
+}
+
 unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 			lbaint_t blkcnt, void *buffer)
 {
 	struct udevice *dev = block_dev->bdev;
 	const struct blk_ops *ops = blk_get_ops(dev);
+	lbaint_t miss, misscnt;
 	ulong blks_read;
+	ulong prof;
+	void *dest;
 
 	if (!ops->read)
 		return -ENOSYS;
 
+	/* Only the blocks which are not cached are read from the device */
+	prof = bootstage_prof_start();
 	if (blkcache_read(block_dev->if_type, block_dev->devnum,
-			  start, blkcnt, block_dev->blksz, buffer))
-		return blkcnt;
-	blks_read = ops->read(dev, start, blkcnt, buffer);
-	if (blks_read == blkcnt)
-		blkcache_fill(block_dev->if_type, block_dev->devnum,
-			      start, blkcnt, block_dev->blksz, buffer);
+			  start, blkcnt, block_dev->blksz, buffer,
+			  &miss, &misscnt)) {
+		blks_read = blkcnt;
+	} else {
+		dest = buffer + (miss - start) * block_dev->blksz;
+		if (blkreadahead_read(block_dev, miss, misscnt, dest)) {
+			blks_read = blkcnt;
+		} else {
+			blks_read = ops->read(dev, miss, misscnt, dest);
+			if (blks_read == misscnt) {
+				blkcache_fill(block_dev->if_type,
+					      block_dev->devnum, miss, misscnt,
+					      block_dev->blksz, dest);
+				blks_read = blkcnt;
+			} else if (!IS_ERR_VALUE(blks_read)) {
+				blks_read += miss - start;
+			}
+		}
+	}
+	blk_prof_add(block_dev, prof, blks_read);
 
 	return blks_read;
 }
 
+static int blk_stream_wait(struct udevice *dev)
+{
+	const struct blk_ops *ops = blk_get_ops(dev);
+	int ret;
+
+	do {
+		WATCHDOG_RESET();
+		ret = ops->read_poll(dev);
+	} while (ret == -EBUSY);
+
+	return ret;
+}
+
+int blk_dread_stream(struct blk_desc *desc, lbaint_t start, lbaint_t blkcnt,
+		     lbaint_t chunk, void *buffer,
+		     int (*consume)(void *priv, ulong avail), void *priv)
+{
+	struct udevice *dev = desc->bdev;
+	const struct blk_ops *ops = blk_get_ops(dev);
+	bool async = ops->read_start && ops->read_poll;
+	lbaint_t done = 0, n;
+	ulong prof;
+	int ret;
+
+	if (!ops->read)
+		return -ENOSYS;
+	if (!chunk)
+		return -EINVAL;
+
+	/* Nothing else may be using the device while a read is in flight */
+	blkreadahead_invalidate(desc);
+
+	n = min(chunk, blkcnt);
+	prof = bootstage_prof_start();
+	if (async && n && ops->read_start(dev, start, n, buffer))
+		async = false;
+	while (done < blkcnt) {
+		if (async) {
+			ret = blk_stream_wait(dev);
+			if (ret)
+				return ret;
+			blk_prof_add(desc, prof, n);
+		} else if (blk_dread(desc, start + done, n,
+				     buffer + done * desc->blksz) != n) {
+			return -EIO;
+		}
+		done += n;
+
+		n = min(chunk, blkcnt - done);
+		prof = bootstage_prof_start();
+		if (async && n && ops->read_start(dev, start + done, n,
+						  buffer + done * desc->blksz))
+			return -EIO;
+
+		ret = consume(priv, done * desc->blksz);
+		if (ret < 0) {
+			if (async && n)
+				blk_stream_wait(dev);
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
 unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 			 lbaint_t blkcnt, const void *buffer)
 {
 	struct udevice *dev = block_dev->bdev;
 	const struct blk_ops *ops = blk_get_ops(dev);
 
+	ulong blks_written;
+	ulong prof;
+
 	if (!ops->write)
 		return -ENOSYS;
 
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
-	return ops->write(dev, start, blkcnt, buffer);
+	blkreadahead_invalidate(block_dev);
+	prof = bootstage_prof_start();
+	blks_written = ops->write(dev, start, blkcnt, buffer);
+	blk_prof_add(block_dev, prof, blks_written);
+
+	return blks_written;
 }
 
 unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
@@ -426,11 +529,20 @@ unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 	struct udevice *dev = block_dev->bdev;
 	const struct blk_ops *ops = blk_get_ops(dev);
 
+	ulong blks_erased;
+	ulong prof;
+
 	if (!ops->erase)
 		return -ENOSYS;
 
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
-	return ops->erase(dev, start, blkcnt);
+	blkreadahead_invalidate(block_dev);
+	prof = bootstage_prof_start();
+	blks_erased = ops->erase(dev, start, blkcnt);
+	/* Nothing is transferred, but the time taken still counts */
+	blk_prof_add(block_dev, prof, 0);
+
+	return blks_erased;
 }
 
 int blk_prepare_device(struct udevice *dev)
@@ -542,8 +654,16 @@ int blk_unbind_all(int if_type)
 	return 0;
 }
 
+static int blk_pre_remove(struct udevice *dev)
+{
+	blkreadahead_invalidate(dev_get_uclass_platdata(dev));
+
+	return 0;
+}
+
 UCLASS_DRIVER(blk) = {
 	.id		= UCLASS_BLK,
 	.name		= "blk",
+	.pre_remove	= blk_pre_remove,
 	.per_device_platdata_auto_alloc_size = sizeof(struct blk_desc),
 };
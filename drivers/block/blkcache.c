@@ -12,63 +12,218 @@
 #include <linux/ctype.h>
 #include <linux/list.h>
 
-struct block_cache_node {
+/*
+ * The cache holds single blocks, so that a request can be served whatever
+ * requests the blocks were originally read with. Blocks are found through a
+ * hash of (device, block number) and evicted least recently used first.
+ * They are kept in a pool of slots, allocated on first use to fill the
+ * budget of bytes, each slot holding a block of the largest size seen.
+ */
+#define BLOCK_CACHE_HASH_BITS	8
+#define BLOCK_CACHE_HASH_SIZE	(1 << BLOCK_CACHE_HASH_BITS)
+
+struct block_cache_dev {
 	struct list_head lh;
 	int iftype;
 	int devnum;
-	lbaint_t start;
-	lbaint_t blkcnt;
+	unsigned hits;
+	unsigned partial;
+	unsigned misses;
+	unsigned entries;
+};
+
+struct block_cache_node {
+	struct hlist_node hn;
+	struct list_head lh;	/* in the LRU list, or the free list */
+	struct block_cache_dev *dev;
+	lbaint_t blk;
 	unsigned long blksz;
-	char *cache;
+	char *cache;		/* this node's slot */
 };
 
 static LIST_HEAD(block_cache);
+static LIST_HEAD(block_cache_free);
+static LIST_HEAD(block_cache_devs);
+static struct hlist_head block_cache_hash[BLOCK_CACHE_HASH_SIZE];
+
+/* pool of slots */
+static struct block_cache_node *block_cache_nodes;
+static char *block_cache_data;
+static unsigned long block_cache_slot_size;
 
 static struct block_cache_stats _stats = {
-	.max_blocks_per_entry = 2,
-	.max_entries = 32
+	.max_blocks_per_entry = 32,
+	.max_size = CONFIG_BLOCK_CACHE_SIZE,
 };
 
-static struct block_cache_node *cache_find(int iftype, int devnum,
-					   lbaint_t start, lbaint_t blkcnt,
-					   unsigned long blksz)
+static struct block_cache_dev *cache_dev(int iftype, int devnum, bool add)
+{
+	struct block_cache_dev *dev;
+
+	list_for_each_entry(dev, &block_cache_devs, lh)
+		if ((dev->iftype == iftype) && (dev->devnum == devnum))
+			return dev;
+
+	if (!add)
+		return NULL;
+
+	dev = calloc(1, sizeof(*dev));
+	if (!dev)
+		return NULL;
+	dev->iftype = iftype;
+	dev->devnum = devnum;
+	list_add_tail(&dev->lh, &block_cache_devs);
+
+	return dev;
+}
+
+static struct hlist_head *cache_bucket(struct block_cache_dev *dev,
+				       lbaint_t blk)
+{
+	ulong key = (ulong)blk ^ ((ulong)dev->iftype << 24) ^
+		    ((ulong)dev->devnum << 16);
+
+	/* Fibonacci hashing spreads runs of consecutive blocks */
+	key *= 0x9e3779b1;
+
+	return &block_cache_hash[(u32)key >> (32 - BLOCK_CACHE_HASH_BITS)];
+}
+
+static struct block_cache_node *cache_find(struct block_cache_dev *dev,
+					   lbaint_t blk, unsigned long blksz)
 {
 	struct block_cache_node *node;
+	struct hlist_node *pos;
 
-	list_for_each_entry(node, &block_cache, lh)
-		if ((node->iftype == iftype) &&
-		    (node->devnum == devnum) &&
-		    (node->blksz == blksz) &&
-		    (node->start <= start) &&
-		    (node->start + node->blkcnt >= start + blkcnt)) {
-			if (block_cache.next != &node->lh) {
-				/* maintain MRU ordering */
-				list_del(&node->lh);
-				list_add(&node->lh, &block_cache);
-			}
+	hlist_for_each(pos, cache_bucket(dev, blk)) {
+		node = hlist_entry(pos, struct block_cache_node, hn);
+		if ((node->dev == dev) && (node->blk == blk) &&
+		    (node->blksz == blksz))
 			return node;
-		}
+	}
+
+	return NULL;
+}
+
+static void cache_drop(struct block_cache_node *node)
+{
+	debug("drop: block " LBAF "\n", node->blk);
+	hlist_del(&node->hn);
+	list_del(&node->lh);
+	node->dev->entries--;
+	_stats.entries--;
+	_stats.size -= node->blksz;
+}
+
+static void cache_free(struct block_cache_node *node)
+{
+	cache_drop(node);
+	node->dev = NULL;
+	list_add(&node->lh, &block_cache_free);
+}
+
+static void cache_pool_free(void)
+{
+	struct block_cache_node *node, *n;
+
+	list_for_each_entry_safe(node, n, &block_cache, lh)
+		cache_drop(node);
+	INIT_LIST_HEAD(&block_cache_free);
+	free(block_cache_nodes);
+	free(block_cache_data);
+	block_cache_nodes = NULL;
+	block_cache_data = NULL;
+	block_cache_slot_size = 0;
+}
+
+/* Make sure that the pool exists and that its slots fit @blksz */
+static int cache_pool(unsigned long blksz)
+{
+	unsigned long i, count;
+
+	if (block_cache_nodes && blksz <= block_cache_slot_size)
+		return 0;
+
+	/* Blocks of a new, larger size: start again with larger slots */
+	cache_pool_free();
+	count = _stats.max_size / blksz;
+	if (!count)
+		return -ENOSPC;
+	block_cache_nodes = calloc(count, sizeof(*block_cache_nodes));
+	block_cache_data = malloc(count * blksz);
+	if (!block_cache_nodes || !block_cache_data) {
+		cache_pool_free();
+		return -ENOMEM;
+	}
+	block_cache_slot_size = blksz;
+
+	for (i = 0; i < count; i++) {
+		block_cache_nodes[i].cache = block_cache_data + i * blksz;
+		list_add_tail(&block_cache_nodes[i].lh, &block_cache_free);
+	}
+
 	return 0;
 }
 
+static void cache_copy(struct block_cache_node *node, void *buffer)
+{
+	memcpy(buffer, node->cache, node->blksz);
+	/* maintain LRU ordering */
+	list_move(&node->lh, &block_cache);
+}
+
 int blkcache_read(int iftype, int devnum,
 		  lbaint_t start, lbaint_t blkcnt,
-		  unsigned long blksz, void *buffer)
+		  unsigned long blksz, void *buffer,
+		  lbaint_t *miss_start, lbaint_t *miss_cnt)
 {
-	struct block_cache_node *node = cache_find(iftype, devnum, start,
-						   blkcnt, blksz);
-	if (node) {
-		const char *src = node->cache + (start - node->start) * blksz;
-		memcpy(buffer, src, blksz * blkcnt);
+	struct block_cache_dev *dev = cache_dev(iftype, devnum, true);
+	struct block_cache_node *node;
+	lbaint_t head, tail;
+
+	*miss_start = start;
+	*miss_cnt = blkcnt;
+	if (!dev || blkcnt > _stats.max_blocks_per_entry)
+		goto miss;
+
+	/* Serve the cached blocks at either end, leaving the gap between */
+	for (head = 0; head < blkcnt; head++) {
+		node = cache_find(dev, start + head, blksz);
+		if (!node)
+			break;
+		cache_copy(node, buffer + head * blksz);
+	}
+	for (tail = blkcnt; tail > head; tail--) {
+		node = cache_find(dev, start + tail - 1, blksz);
+		if (!node)
+			break;
+		cache_copy(node, buffer + (tail - 1) * blksz);
+	}
+
+	if (head == blkcnt) {
 		debug("hit: start " LBAF ", count " LBAFU "\n",
 		      start, blkcnt);
 		++_stats.hits;
+		++dev->hits;
 		return 1;
 	}
 
+	*miss_start = start + head;
+	*miss_cnt = tail - head;
+	if (head || tail < blkcnt) {
+		debug("partial: start " LBAF ", count " LBAFU ", read "
+		      LBAFU "\n", start, blkcnt, *miss_cnt);
+		++_stats.partial;
+		++dev->partial;
+		return 0;
+	}
+
+miss:
 	debug("miss: start " LBAF ", count " LBAFU "\n",
 	      start, blkcnt);
 	++_stats.misses;
+	if (dev)
+		++dev->misses;
 	return 0;
 }
 
@@ -76,98 +231,114 @@ void blkcache_fill(int iftype, int devnum,
 		   lbaint_t start, lbaint_t blkcnt,
 		   unsigned long blksz, void const *buffer)
 {
-	lbaint_t bytes;
+	struct block_cache_dev *dev;
 	struct block_cache_node *node;
+	lbaint_t i;
 
 	/* don't cache big stuff */
 	if (blkcnt > _stats.max_blocks_per_entry)
 		return;
 
-	if (_stats.max_entries == 0)
+	if (_stats.max_size < blksz)
 		return;
 
-	bytes = blksz * blkcnt;
-	if (_stats.max_entries <= _stats.entries) {
-		/* pop LRU */
-		node = (struct block_cache_node *)block_cache.prev;
-		list_del(&node->lh);
-		_stats.entries--;
-		debug("drop: start " LBAF ", count " LBAFU "\n",
-		      node->start, node->blkcnt);
-		if (node->blkcnt * node->blksz < bytes) {
-			free(node->cache);
-			node->cache = 0;
-		}
-	} else {
-		node = malloc(sizeof(*node));
-		if (!node)
-			return;
-		node->cache = 0;
-	}
+	dev = cache_dev(iftype, devnum, true);
+	if (!dev || cache_pool(blksz))
+		return;
 
-	if (!node->cache) {
-		node->cache = malloc(bytes);
-		if (!node->cache) {
-			free(node);
-			return;
+	for (i = 0; i < blkcnt; i++, buffer += blksz) {
+		node = cache_find(dev, start + i, blksz);
+		if (!node) {
+			/* take a free slot, or else the least recently used */
+			if (list_empty(&block_cache_free))
+				node = list_last_entry(&block_cache,
+						       struct block_cache_node,
+						       lh);
+			else
+				node = list_first_entry(&block_cache_free,
+							struct block_cache_node,
+							lh);
 		}
-	}
-
-	debug("fill: start " LBAF ", count " LBAFU "\n",
-	      start, blkcnt);
+		if (node->dev)
+			cache_drop(node);
+		else
+			list_del(&node->lh);
 
-	node->iftype = iftype;
-	node->devnum = devnum;
-	node->start = start;
-	node->blkcnt = blkcnt;
-	node->blksz = blksz;
-	memcpy(node->cache, buffer, bytes);
-	list_add(&node->lh, &block_cache);
-	_stats.entries++;
+		debug("fill: block " LBAF "\n", start + i);
+		node->dev = dev;
+		node->blk = start + i;
+		node->blksz = blksz;
+		memcpy(node->cache, buffer, blksz);
+		hlist_add_head(&node->hn, cache_bucket(dev, node->blk));
+		list_add(&node->lh, &block_cache);
+		dev->entries++;
+		_stats.entries++;
+		_stats.size += blksz;
+	}
 }
 
 void blkcache_invalidate(int iftype, int devnum)
 {
-	struct list_head *entry, *n;
-	struct block_cache_node *node;
+	struct block_cache_dev *dev = cache_dev(iftype, devnum, false);
+	struct block_cache_node *node, *n;
 
-	list_for_each_safe(entry, n, &block_cache) {
-		node = (struct block_cache_node *)entry;
-		if ((node->iftype == iftype) &&
-		    (node->devnum == devnum)) {
-			list_del(entry);
-			free(node->cache);
-			free(node);
-			--_stats.entries;
-		}
-	}
+	if (!dev || !dev->entries)
+		return;
+
+	list_for_each_entry_safe(node, n, &block_cache, lh)
+		if (node->dev == dev)
+			cache_free(node);
 }
 
-void blkcache_configure(unsigned blocks, unsigned entries)
+void blkcache_configure(unsigned blocks, unsigned long size)
 {
-	struct block_cache_node *node;
+	struct block_cache_dev *dev;
+
 	if ((blocks != _stats.max_blocks_per_entry) ||
-	    (entries != _stats.max_entries)) {
-		/* invalidate cache */
-		while (!list_empty(&block_cache)) {
-			node = (struct block_cache_node *)block_cache.next;
-			list_del(&node->lh);
-			free(node->cache);
-			free(node);
-		}
-		_stats.entries = 0;
+	    (size != _stats.max_size)) {
+		/* invalidate cache, the pool is sized again on next use */
+		cache_pool_free();
 	}
 
 	_stats.max_blocks_per_entry = blocks;
-	_stats.max_entries = entries;
+	_stats.max_size = size;
 
 	_stats.hits = 0;
+	_stats.partial = 0;
 	_stats.misses = 0;
+	list_for_each_entry(dev, &block_cache_devs, lh) {
+		dev->hits = 0;
+		dev->partial = 0;
+		dev->misses = 0;
+	}
 }
 
 void blkcache_stats(struct block_cache_stats *stats)
 {
 	memcpy(stats, &_stats, sizeof(*stats));
 	_stats.hits = 0;
+	_stats.partial = 0;
 	_stats.misses = 0;
 }
+
+int blkcache_dev_stats(int index, struct block_cache_dev_stats *stats)
+{
+	struct block_cache_dev *dev;
+
+	list_for_each_entry(dev, &block_cache_devs, lh) {
+		if (index--)
+			continue;
+		stats->iftype = dev->iftype;
+		stats->devnum = dev->devnum;
+		stats->hits = dev->hits;
+		stats->partial = dev->partial;
+		stats->misses = dev->misses;
+		stats->entries = dev->entries;
+		dev->hits = 0;
+		dev->partial = 0;
+		dev->misses = 0;
+		return 0;
+	}
+
+	return -ENOENT;
+}
@@ -0,0 +1,300 @@
+/*
+ * Read-ahead for sequential block device reads
+ *
+ * Copyright (C) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <dm.h>
+#include <malloc.h>
+#include <watchdog.h>
+#include <linux/list.h>
+
+/*
+ * Filesystem loaders read a file a cluster or an extent at a time. Once two
+ * requests in a row are contiguous, the rest of the file is fetched in large
+ * windows instead, and requests are copied out of them, while the window
+ * following the one being consumed is fetched in the background. This needs
+ * a driver which can start a read without waiting for it (blk_ops
+ * read_start/read_poll); other devices are left alone, as are devices whose
+ * read_start() fails, which are then read directly until invalidated.
+ */
+struct readahead_window {
+	void *buf;
+	lbaint_t start;
+	lbaint_t blkcnt;	/* 0 if the window holds nothing */
+	bool busy;		/* started with read_start(), not yet complete */
+};
+
+struct readahead_stream {
+	struct list_head lh;
+	struct udevice *dev;
+	int hwpart;
+	lbaint_t last;		/* block following the last request */
+	lbaint_t next;		/* block following the last sequential request */
+	bool off;		/* read_start() failed, so read-ahead is off */
+	struct readahead_window win[2];
+};
+
+static LIST_HEAD(readahead_streams);
+
+static struct block_readahead_stats _stats;
+
+/* No request starts here, so a new stream matches nothing */
+#define READAHEAD_NONE	((lbaint_t)-1)
+
+static struct readahead_stream *readahead_find(struct udevice *dev)
+{
+	struct readahead_stream *s;
+
+	list_for_each_entry(s, &readahead_streams, lh)
+		if (s->dev == dev)
+			return s;
+
+	return NULL;
+}
+
+static lbaint_t readahead_blocks(struct blk_desc *desc)
+{
+	return CONFIG_BLOCK_READAHEAD_SIZE / desc->blksz;
+}
+
+static int readahead_wait(struct udevice *dev, struct readahead_window *w)
+{
+	const struct blk_ops *ops = blk_get_ops(dev);
+	int ret;
+
+	if (!w->busy)
+		return 0;
+
+	do {
+		WATCHDOG_RESET();
+		ret = ops->read_poll(dev);
+	} while (ret == -EBUSY);
+
+	w->busy = false;
+	if (ret) {
+		debug("%s: read-ahead of " LBAFU " blocks at " LBAFU
+		      " failed: %d\n", __func__, w->blkcnt, w->start, ret);
+		w->blkcnt = 0;
+	}
+
+	return ret;
+}
+
+static void readahead_wait_all(struct readahead_stream *s)
+{
+	readahead_wait(s->dev, &s->win[0]);
+	readahead_wait(s->dev, &s->win[1]);
+}
+
+static void readahead_drop(struct readahead_stream *s)
+{
+	int i;
+
+	readahead_wait_all(s);
+	for (i = 0; i < ARRAY_SIZE(s->win); i++)
+		s->win[i].blkcnt = 0;
+}
+
+/* Start fetching the window starting at @start */
+static int readahead_fill(struct readahead_stream *s, struct blk_desc *desc,
+			  struct readahead_window *w, lbaint_t start)
+{
+	struct udevice *dev = desc->bdev;
+	const struct blk_ops *ops = blk_get_ops(dev);
+	lbaint_t blkcnt = min(readahead_blocks(desc), desc->lba - start);
+	int ret;
+
+	w->blkcnt = 0;
+	if (start >= desc->lba)
+		return -ENOSPC;
+	if (!w->buf) {
+		w->buf = memalign(ARCH_DMA_MINALIGN,
+				  CONFIG_BLOCK_READAHEAD_SIZE);
+		if (!w->buf)
+			return -ENOMEM;
+	}
+
+	ret = ops->read_start(dev, start, blkcnt, w->buf);
+	if (ret) {
+		/* Not supported here (e.g. no DMA), or not working: stop */
+		debug("%s: read_start() failed: %d\n", __func__, ret);
+		s->off = true;
+		return ret;
+	}
+	_stats.windows++;
+	w->start = start;
+	w->blkcnt = blkcnt;
+	w->busy = true;
+
+	return 0;
+}
+
+/* Pick a window that holds nothing at or beyond block @pos */
+static struct readahead_window *readahead_free(struct readahead_stream *s,
+					       lbaint_t pos)
+{
+	struct readahead_window *w;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(s->win); i++) {
+		w = &s->win[i];
+		if (!w->busy && (!w->blkcnt || w->start + w->blkcnt <= pos))
+			return w;
+	}
+
+	return NULL;
+}
+
+/* Start fetching the window after the data buffered for block @pos */
+static void readahead_kick(struct readahead_stream *s, struct blk_desc *desc,
+			   lbaint_t pos)
+{
+	struct readahead_window *w;
+	lbaint_t next = pos;
+	int i;
+
+	/* Two passes, as the windows need not be in order */
+	for (i = 0; i < 2 * ARRAY_SIZE(s->win); i++) {
+		w = &s->win[i % ARRAY_SIZE(s->win)];
+		if (w->busy)
+			return;
+		if (w->blkcnt && w->start <= next &&
+		    next < w->start + w->blkcnt)
+			next = w->start + w->blkcnt;
+	}
+
+	/* Only a window which has been consumed up to @pos may be reused */
+	w = readahead_free(s, pos);
+	if (w && next < desc->lba)
+		readahead_fill(s, desc, w, next);
+}
+
+/* Copy out what the windows hold from @pos onwards, returning the count */
+static lbaint_t readahead_copy(struct readahead_stream *s,
+			       struct blk_desc *desc, lbaint_t pos,
+			       lbaint_t blkcnt, void *buffer)
+{
+	struct readahead_window *w;
+	lbaint_t done = 0, n;
+	int i;
+
+	while (done < blkcnt) {
+		for (i = 0; i < ARRAY_SIZE(s->win); i++) {
+			w = &s->win[i];
+			if (w->blkcnt && w->start <= pos &&
+			    pos < w->start + w->blkcnt)
+				break;
+		}
+		if (i == ARRAY_SIZE(s->win) || readahead_wait(s->dev, w))
+			break;
+
+		n = min(blkcnt - done, w->start + w->blkcnt - pos);
+		memcpy(buffer + done * desc->blksz,
+		       w->buf + (pos - w->start) * desc->blksz,
+		       n * desc->blksz);
+		done += n;
+		pos += n;
+	}
+
+	return done;
+}
+
+int blkreadahead_read(struct blk_desc *desc, lbaint_t start, lbaint_t blkcnt,
+		      void *buffer)
+{
+	struct udevice *dev = desc->bdev;
+	const struct blk_ops *ops = blk_get_ops(dev);
+	struct readahead_stream *s;
+	struct readahead_window *w;
+	lbaint_t done, pos;
+	bool seq;
+
+	if (!ops->read_start || !ops->read_poll)
+		return 0;
+
+	s = readahead_find(dev);
+	if (!s) {
+		s = calloc(1, sizeof(*s));
+		if (!s)
+			return 0;
+		s->dev = dev;
+		s->hwpart = desc->hwpart;
+		s->last = READAHEAD_NONE;
+		s->next = READAHEAD_NONE;
+		list_add(&s->lh, &readahead_streams);
+	}
+	if (s->hwpart != desc->hwpart) {
+		readahead_drop(s);
+		s->hwpart = desc->hwpart;
+	}
+	if (s->off)
+		return 0;
+
+	/*
+	 * Track the stream separately from the last request, so that reads of
+	 * filesystem metadata between two clusters do not break it.
+	 */
+	seq = start == s->next || start == s->last;
+	s->last = start + blkcnt;
+
+	done = readahead_copy(s, desc, start, blkcnt, buffer);
+	if (!done && !seq) {
+		/* Random access: the caller reads it, so nothing may be busy */
+		readahead_wait_all(s);
+		_stats.misses++;
+		return 0;
+	}
+	s->next = s->last;
+
+	pos = start + done;
+	if (done < blkcnt) {
+		buffer += done * desc->blksz;
+		readahead_wait_all(s);
+		if (blkcnt - done >= readahead_blocks(desc)) {
+			/* Large enough to go straight into the caller's buffer */
+			if (ops->read(dev, pos, blkcnt - done, buffer) !=
+			    blkcnt - done)
+				return 0;
+		} else {
+			w = readahead_free(s, pos);
+			if (!w)
+				w = &s->win[0];
+			if (readahead_fill(s, desc, w, pos) ||
+			    readahead_copy(s, desc, pos, blkcnt - done,
+					   buffer) != blkcnt - done)
+				return 0;
+		}
+		pos = start + blkcnt;
+	}
+
+	_stats.hits++;
+	readahead_kick(s, desc, pos);
+
+	return 1;
+}
+
+void blkreadahead_invalidate(struct blk_desc *desc)
+{
+	struct readahead_stream *s = readahead_find(desc->bdev);
+	int i;
+
+	if (!s)
+		return;
+
+	readahead_wait_all(s);
+	for (i = 0; i < ARRAY_SIZE(s->win); i++)
+		free(s->win[i].buf);
+	list_del(&s->lh);
+	free(s);
+}
+
+void blkreadahead_stats(struct block_readahead_stats *stats)
+{
+	memcpy(stats, &_stats, sizeof(_stats));
+	memset(&_stats, 0, sizeof(_stats));
+}
@@ -88,6 +88,54 @@ static unsigned long host_block_write(struct blk_desc *block_dev,
 }
 
 #ifdef CONFIG_BLK
+/* Blocks read by each call to read_poll() */
+#define HOST_POLL_BLOCKS	16
+
+/*
+ * The read is only recorded here and done a piece at a time by
+ * read_poll(), as a controller moving the data by DMA would.
+ */
+static int host_block_read_start(struct udevice *dev, lbaint_t start,
+				 lbaint_t blkcnt, void *buffer)
+{
+	struct host_block_dev *host_dev = dev_get_priv(dev);
+
+	if (host_dev->read_busy)
+		return -EBUSY;
+
+	host_dev->read_busy = true;
+	host_dev->read_pos = start;
+	host_dev->read_left = blkcnt;
+	host_dev->read_buf = buffer;
+
+	return 0;
+}
+
+static int host_block_read_poll(struct udevice *dev)
+{
+	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
+	struct host_block_dev *host_dev = dev_get_priv(dev);
+	lbaint_t n;
+
+	if (!host_dev->read_busy)
+		return -EINVAL;
+
+	n = min_t(lbaint_t, host_dev->read_left, HOST_POLL_BLOCKS);
+	if (host_block_read(dev, host_dev->read_pos, n,
+			    host_dev->read_buf) != n) {
+		host_dev->read_busy = false;
+		return -EIO;
+	}
+	host_dev->read_pos += n;
+	host_dev->read_left -= n;
+	host_dev->read_buf += n * block_dev->blksz;
+	if (host_dev->read_left)
+		return -EBUSY;
+	host_dev->read_busy = false;
+
+	return 0;
+}
+
 int host_dev_bind(int devnum, char *filename)
 {
 	struct host_block_dev *host_dev;
@@ -221,6 +269,8 @@ int host_get_dev_err(int devnum, struct blk_desc **blk_devp)
 static const struct blk_ops sandbox_host_blk_ops = {
 	.read	= host_block_read,
 	.write	= host_block_write,
+	.read_start	= host_block_read_start,
+	.read_poll	= host_block_read_poll,
 };
 
 U_BOOT_DRIVER(sandbox_host_blk) = {
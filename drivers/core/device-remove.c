@@ -91,6 +91,7 @@ int device_unbind(struct udevice *dev)
 	ret = device_chld_unbind(dev);
 	if (ret)
 		return ret;
+	dm_lazy_drop(dev);
 
 	if (dev->flags & DM_FLAG_ALLOC_PDATA) {
 		free(dev->platdata);
@@ -198,7 +199,7 @@ int device_remove(struct udevice *dev, uint flags)
 	    (flags & (drv->flags & DM_FLAG_ACTIVE_DMA))) {
 		device_free(dev);
 
-		dev->seq = -1;
+		uclass_set_seq(dev, -1);
 		dev->flags &= ~DM_FLAG_ACTIVATED;
 	}
 
@@ -11,9 +11,11 @@
 
 #include <common.h>
 #include <asm/io.h>
+#include <bootstage.h>
 #include <fdtdec.h>
 #include <fdt_support.h>
 #include <malloc.h>
+#include <of_live.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
@@ -295,6 +297,7 @@ static void *alloc_priv(int size, uint flags)
 int device_probe(struct udevice *dev)
 {
 	const struct driver *drv;
+	ulong start;
 	int size = 0;
 	int ret;
 	int seq;
@@ -344,23 +347,26 @@ int device_probe(struct udevice *dev)
 		ret = device_probe(dev->parent);
 		if (ret)
 			goto fail;
-
-		/*
-		 * The device might have already been probed during
-		 * the call to device_probe() on its parent device
-		 * (e.g. PCI bridge devices). Test the flags again
-		 * so that we don't mess up the device.
-		 */
-		if (dev->flags & DM_FLAG_ACTIVATED)
-			return 0;
 	}
 
+	/* Reading the timer may probe the timer device, perhaps this one */
+	start = bootstage_prof_start();
+
+	/*
+	 * The device might have already been probed during the call to
+	 * device_probe() on its parent device (e.g. PCI bridge devices), or
+	 * while reading the timer. Test the flags again so that we don't mess
+	 * up the device.
+	 */
+	if (dev->flags & DM_FLAG_ACTIVATED)
+		return 0;
+
 	seq = uclass_resolve_seq(dev);
 	if (seq < 0) {
 		ret = seq;
 		goto fail;
 	}
-	dev->seq = seq;
+	uclass_set_seq(dev, seq);
 
 	dev->flags |= DM_FLAG_ACTIVATED;
 
@@ -404,6 +410,8 @@ int device_probe(struct udevice *dev)
 	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL)
 		pinctrl_select_state(dev, "default");
 
+	bootstage_prof_add(BOOTSTAGE_PROF_PROBE, dev->name, start, 0, 0);
+
 	return 0;
 fail_uclass:
 	if (device_remove(dev, DM_REMOVE_NORMAL)) {
@@ -413,7 +421,7 @@ fail_uclass:
 fail:
 	dev->flags &= ~DM_FLAG_ACTIVATED;
 
-	dev->seq = -1;
+	uclass_set_seq(dev, -1);
 	device_free(dev);
 
 	return ret;
@@ -479,6 +487,19 @@ void *dev_get_parent_priv(struct udevice *dev)
 	return dev->parent_priv;
 }
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+void dev_set_of_offset(struct udevice *dev, int of_offset)
+{
+	bool bound = !list_empty(&dev->uclass_node);
+
+	if (bound)
+		uclass_of_index_del(dev);
+	dev->of_offset = of_offset;
+	if (bound)
+		uclass_of_index_add(dev);
+}
+#endif
+
 static int device_get_device_tail(struct udevice *dev, int ret,
 				  struct udevice **devp)
 {
@@ -498,6 +519,7 @@ int device_get_child(struct udevice *parent, int index, struct udevice **devp)
 {
 	struct udevice *dev;
 
+	dm_lazy_bind_children(parent);
 	list_for_each_entry(dev, &parent->child_head, sibling_node) {
 		if (!index--)
 			return device_get_device_tail(dev, 0, devp);
@@ -515,6 +537,7 @@ int device_find_child_by_seq(struct udevice *parent, int seq_or_req_seq,
 	if (seq_or_req_seq == -1)
 		return -ENODEV;
 
+	dm_lazy_bind_children(parent);
 	list_for_each_entry(dev, &parent->child_head, sibling_node) {
 		if ((find_req_seq ? dev->req_seq : dev->seq) ==
 				seq_or_req_seq) {
@@ -551,6 +574,7 @@ int device_find_child_by_of_offset(struct udevice *parent, int of_offset,
 
 	*devp = NULL;
 
+	dm_lazy_bind_children(parent);
 	list_for_each_entry(dev, &parent->child_head, sibling_node) {
 		if (dev_of_offset(dev) == of_offset) {
 			*devp = dev;
@@ -594,11 +618,26 @@ int device_get_global_by_of_offset(int of_offset, struct udevice **devp)
 	struct udevice *dev;
 
 	dev = _device_find_global_by_of_offset(gd->dm_root, of_offset);
+	if (!dev)
+		dm_lazy_bind_node(of_offset, &dev);
+	return device_get_device_tail(dev, dev ? 0 : -ENOENT, devp);
+}
+
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+int device_get_by_driver_info(const struct driver_info *info,
+			      struct udevice **devp)
+{
+	struct udevice *dev = info ? info->dev : NULL;
+
+	*devp = NULL;
+
 	return device_get_device_tail(dev, dev ? 0 : -ENOENT, devp);
 }
+#endif
 
 int device_find_first_child(struct udevice *parent, struct udevice **devp)
 {
+	dm_lazy_bind_children(parent);
 	if (list_empty(&parent->child_head)) {
 		*devp = NULL;
 	} else {
@@ -678,8 +717,8 @@ fdt_addr_t dev_get_addr_index(struct udevice *dev, int index)
 			return FDT_ADDR_T_NONE;
 		}
 
-		reg = fdt_getprop(gd->fdt_blob, dev_of_offset(dev), "reg",
-				  &len);
+		reg = of_live_getprop(gd->fdt_blob, dev_of_offset(dev), "reg",
+				      &len);
 		if (!reg || (len <= (index * sizeof(fdt32_t) * (na + ns)))) {
 			debug("Req index out of range\n");
 			return FDT_ADDR_T_NONE;
@@ -782,6 +821,7 @@ void *dev_map_physmem(struct udevice *dev, unsigned long size)
 
 bool device_has_children(struct udevice *dev)
 {
+	dm_lazy_bind_children(dev);
 	return !list_empty(&dev->child_head);
 }
 
@@ -7,7 +7,9 @@
 #include <common.h>
 #include <dm.h>
 #include <mapmem.h>
+#include <dm/device-internal.h>
 #include <dm/root.h>
+#include <dm/util.h>
 
 static void show_devices(struct udevice *dev, int depth, int last_flag)
 {
@@ -37,6 +39,7 @@ static void show_devices(struct udevice *dev, int depth, int last_flag)
 
 	printf("%s\n", dev->name);
 
+	dm_lazy_bind_children(dev);
 	list_for_each_entry(child, &dev->child_head, sibling_node) {
 		is_last = list_is_last(&child->sibling_node, &dev->child_head);
 		show_devices(child, depth + 1, (last_flag << 1) | is_last);
@@ -94,3 +97,62 @@ void dm_dump_uclass(void)
 		puts("\n");
 	}
 }
+
+/* Return the size of the memory allocated for a device and its data */
+static ulong dm_device_size(struct udevice *dev)
+{
+	struct uclass_driver *uc_drv = dev->uclass->uc_drv;
+	bool active = dev->flags & DM_FLAG_ACTIVATED;
+	struct uclass_driver *parent_uc;
+	const struct driver *parent_drv;
+	ulong size = sizeof(*dev);
+
+	if (dev->flags & DM_FLAG_ALLOC_PDATA)
+		size += dev->driver->platdata_auto_alloc_size;
+	if (dev->flags & DM_FLAG_ALLOC_UCLASS_PDATA)
+		size += uc_drv->per_device_platdata_auto_alloc_size;
+	if (active)
+		size += dev->driver->priv_auto_alloc_size +
+			uc_drv->per_device_auto_alloc_size;
+	if (!dev->parent)
+		return size;
+
+	/* As device_bind() and device_probe(), the driver comes first */
+	parent_drv = dev->parent->driver;
+	parent_uc = dev->parent->uclass->uc_drv;
+	if (dev->flags & DM_FLAG_ALLOC_PARENT_PDATA)
+		size += parent_drv->per_child_platdata_auto_alloc_size ?:
+			parent_uc->per_child_platdata_auto_alloc_size;
+	if (active)
+		size += parent_drv->per_child_auto_alloc_size ?:
+			parent_uc->per_child_auto_alloc_size;
+
+	return size;
+}
+
+static void dm_count_devices(struct udevice *dev, int *boundp, int *probedp,
+			     ulong *sizep)
+{
+	struct udevice *child;
+
+	(*boundp)++;
+	if (dev->flags & DM_FLAG_ACTIVATED)
+		(*probedp)++;
+	*sizep += dm_device_size(dev);
+	list_for_each_entry(child, &dev->child_head, sibling_node)
+		dm_count_devices(child, boundp, probedp, sizep);
+}
+
+void dm_dump_info(void)
+{
+	struct udevice *root = dm_root();
+	int bound = 0, probed = 0;
+	ulong size = 0;
+
+	if (!root)
+		return;
+	dm_count_devices(root, &bound, &probed, &size);
+	printf("Devices: %d bound, %d probed, about %lu bytes\n", bound,
+	       probed, size);
+	dm_dump_lazy();
+}
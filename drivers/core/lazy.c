@@ -0,0 +1,325 @@
+/*
+ * Binding device tree nodes on demand
+ *
+ * Copyright (C) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <bootstage.h>
+#include <errno.h>
+#include <fdtdec.h>
+#include <malloc.h>
+#include <of_live.h>
+#include <dm/device.h>
+#include <dm/device-internal.h>
+#include <dm/lists.h>
+#include <dm/root.h>
+#include <dm/uclass.h>
+#include <dm/util.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/*
+ * Once dm_lazy_init() has been called, a device tree node found by a scan is
+ * not bound if its driver cannot refuse to bind and binds no children (it has
+ * no bind() method and its uclass has no post_bind() method). Instead the node
+ * goes into a table with its parent device and driver, and is bound the first
+ * time its uclass is looked up, which is also how phandles are resolved, when
+ * a device is looked up by its offset, or when the children of its parent are
+ * looked up, as a bus does to find a device at an address. All waiting nodes
+ * of a uclass, or of a parent, are bound together, in device tree order.
+ */
+#define DM_LAZY_MIN	32
+
+/**
+ * struct dm_lazy_node - A node waiting to be bound
+ *
+ * @parent: Parent device
+ * @drv: Driver matching the node, or NULL once the node is bound or dropped
+ * @driver_data: Data from the matching of_match entry
+ * @offset: Offset of the node in gd->fdt_blob
+ */
+struct dm_lazy_node {
+	struct udevice *parent;
+	struct driver *drv;
+	ulong driver_data;
+	int offset;
+};
+
+/**
+ * struct dm_lazy - Table of nodes waiting to be bound
+ *
+ * @nodes: Nodes, in the order they were found
+ * @count: Number of entries used in @nodes
+ * @size: Number of entries allocated in @nodes
+ * @pending: Number of nodes waiting to be bound
+ * @bound: Number of nodes bound on demand so far
+ * @depth: Nesting depth of binding on demand
+ * @timed: true if the time taken by the outermost binding is being recorded
+ * @uclass_pending: Number of nodes waiting to be bound, by uclass ID
+ * @busy: Set while the nodes of a uclass are being bound, by uclass ID
+ */
+struct dm_lazy {
+	struct dm_lazy_node *nodes;
+	int count;
+	int size;
+	int pending;
+	int bound;
+	int depth;
+	bool timed;
+	u16 uclass_pending[UCLASS_COUNT];
+	u8 busy[UCLASS_COUNT];
+};
+
+int dm_lazy_init(void)
+{
+	struct dm_lazy *lazy;
+
+	dm_lazy_uninit();
+	lazy = calloc(1, sizeof(*lazy));
+	if (!lazy)
+		return -ENOMEM;
+	gd->dm_lazy = lazy;
+
+	return 0;
+}
+
+void dm_lazy_uninit(void)
+{
+	struct dm_lazy *lazy = gd->dm_lazy;
+
+	if (!lazy)
+		return;
+	free(lazy->nodes);
+	free(lazy);
+	gd->dm_lazy = NULL;
+}
+
+/* Return the driver that lists_bind_fdt() would try first for a node */
+static struct driver *dm_lazy_match(const void *blob, int offset,
+				    ulong *datap)
+{
+	const struct udevice_id *id;
+	const char *compat;
+	struct driver *drv;
+	int len, i;
+
+	compat = of_live_getprop(blob, offset, "compatible", &len);
+	for (i = 0; compat && i < len; i += strlen(compat + i) + 1) {
+		drv = lists_driver_lookup_compat(compat + i, &id);
+		if (drv) {
+			*datap = id->data;
+			return drv;
+		}
+	}
+
+	return NULL;
+}
+
+bool dm_lazy_add(struct udevice *parent, const void *blob, int offset)
+{
+	struct dm_lazy *lazy = gd->dm_lazy;
+	struct dm_lazy_node *nodes, *node;
+	struct uclass_driver *uc_drv;
+	struct driver *drv;
+	ulong data;
+	int size;
+
+	if (!lazy || blob != gd->fdt_blob)
+		return false;
+	drv = dm_lazy_match(blob, offset, &data);
+	if (!drv || drv->bind || (uint)drv->id >= UCLASS_COUNT)
+		return false;
+	uc_drv = lists_uclass_lookup(drv->id);
+	if (!uc_drv || uc_drv->post_bind)
+		return false;
+	if (lazy->uclass_pending[drv->id] == U16_MAX)
+		return false;
+
+	if (lazy->count == lazy->size) {
+		size = max(lazy->size * 2, DM_LAZY_MIN);
+		nodes = realloc(lazy->nodes, size * sizeof(*nodes));
+		/* Without room the node is simply bound now */
+		if (!nodes)
+			return false;
+		lazy->nodes = nodes;
+		lazy->size = size;
+	}
+	node = &lazy->nodes[lazy->count++];
+	node->parent = parent;
+	node->drv = drv;
+	node->driver_data = data;
+	node->offset = offset;
+	lazy->pending++;
+	lazy->uclass_pending[drv->id]++;
+	parent->flags |= DM_FLAG_LAZY_CHILDREN;
+
+	return true;
+}
+
+/* Bind entry @i of the table, which must be waiting */
+static int dm_lazy_bind_entry(struct dm_lazy *lazy, int i,
+			      struct udevice **devp)
+{
+	struct dm_lazy_node *node = &lazy->nodes[i];
+	struct driver *drv = node->drv;
+	int ret;
+
+	node->drv = NULL;
+	lazy->pending--;
+	lazy->uclass_pending[drv->id]--;
+	dm_dbg("bind node %s on demand\n",
+	       fdt_get_name(gd->fdt_blob, node->offset, NULL));
+	ret = device_bind_with_driver_data(node->parent, drv,
+			fdt_get_name(gd->fdt_blob, node->offset, NULL),
+			node->driver_data, node->offset, devp);
+	if (ret) {
+		dm_warn("Error binding driver '%s': %d\n", drv->name, ret);
+		return ret;
+	}
+	lazy->bound++;
+
+	return 0;
+}
+
+/*
+ * Reading the time may probe the timer, binding nodes, so the time taken is
+ * only recorded once the timer is running
+ */
+static bool dm_lazy_timed(void)
+{
+#ifdef CONFIG_TIMER
+	return gd->timer;
+#else
+	return true;
+#endif
+}
+
+static void dm_lazy_start(struct dm_lazy *lazy)
+{
+	if (!lazy->depth++ && dm_lazy_timed()) {
+		bootstage_start(BOOTSTAGE_ID_ACCUM_DM_LAZY, "dm_lazy");
+		lazy->timed = true;
+	}
+}
+
+static void dm_lazy_end(struct dm_lazy *lazy)
+{
+	if (!--lazy->depth && lazy->timed) {
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_DM_LAZY);
+		lazy->timed = false;
+	}
+}
+
+int dm_lazy_bind_uclass(enum uclass_id id)
+{
+	struct dm_lazy *lazy = gd->dm_lazy;
+	struct udevice *dev;
+	int ret = 0, err;
+	int i;
+
+	/* Binding a device looks up its uclass, so ignore that */
+	if (!lazy || (uint)id >= UCLASS_COUNT || !lazy->uclass_pending[id] ||
+	    lazy->busy[id])
+		return 0;
+
+	dm_lazy_start(lazy);
+	lazy->busy[id] = 1;
+	/* Binding may add nodes to the table, so look them up each time */
+	for (i = 0; i < lazy->count && lazy->uclass_pending[id]; i++) {
+		if (!lazy->nodes[i].drv || lazy->nodes[i].drv->id != id)
+			continue;
+		err = dm_lazy_bind_entry(lazy, i, &dev);
+		if (err && !ret)
+			ret = err;
+	}
+	lazy->busy[id] = 0;
+	dm_lazy_end(lazy);
+
+	return ret;
+}
+
+int dm_lazy_bind_children(struct udevice *parent)
+{
+	struct dm_lazy *lazy = gd->dm_lazy;
+	struct udevice *dev;
+	int ret = 0, err;
+	int i;
+
+	if (!(parent->flags & DM_FLAG_LAZY_CHILDREN))
+		return 0;
+	parent->flags &= ~DM_FLAG_LAZY_CHILDREN;
+	if (!lazy)
+		return 0;
+
+	dm_lazy_start(lazy);
+	for (i = 0; i < lazy->count && lazy->pending; i++) {
+		if (!lazy->nodes[i].drv || lazy->nodes[i].parent != parent)
+			continue;
+		err = dm_lazy_bind_entry(lazy, i, &dev);
+		if (err && !ret)
+			ret = err;
+	}
+	dm_lazy_end(lazy);
+
+	return ret;
+}
+
+int dm_lazy_bind_node(int offset, struct udevice **devp)
+{
+	struct dm_lazy *lazy = gd->dm_lazy;
+	int ret;
+	int i;
+
+	*devp = NULL;
+	if (!lazy)
+		return -ENOENT;
+	for (i = 0; i < lazy->count; i++) {
+		if (lazy->nodes[i].drv && lazy->nodes[i].offset == offset)
+			break;
+	}
+	if (i == lazy->count)
+		return -ENOENT;
+
+	dm_lazy_start(lazy);
+	ret = dm_lazy_bind_entry(lazy, i, devp);
+	dm_lazy_end(lazy);
+
+	return ret;
+}
+
+void dm_lazy_drop(struct udevice *parent)
+{
+	struct dm_lazy *lazy = gd->dm_lazy;
+	struct dm_lazy_node *node;
+
+	if (!lazy || !lazy->pending)
+		return;
+	for (node = lazy->nodes; node < lazy->nodes + lazy->count; node++) {
+		if (node->drv && node->parent == parent) {
+			lazy->pending--;
+			lazy->uclass_pending[node->drv->id]--;
+			node->drv = NULL;
+		}
+	}
+}
+
+int dm_lazy_pending(void)
+{
+	return gd->dm_lazy ? gd->dm_lazy->pending : 0;
+}
+
+void dm_dump_lazy(void)
+{
+	struct dm_lazy *lazy = gd->dm_lazy;
+
+	if (!lazy) {
+		printf("Lazy binding: off\n");
+		return;
+	}
+	printf("Lazy binding: %d nodes waiting, %d bound on demand, %lu bytes\n",
+	       lazy->pending, lazy->bound,
+	       (ulong)(sizeof(*lazy) + lazy->size * sizeof(*lazy->nodes)));
+}
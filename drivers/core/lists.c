@@ -16,7 +16,133 @@
 #include <dm/uclass.h>
 #include <dm/util.h>
 #include <fdtdec.h>
+#include <malloc.h>
+#include <of_live.h>
 #include <linux/compiler.h>
+#include <linux/err.h>
+#include <linux/log2.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#if CONFIG_IS_ENABLED(DM_BIND_INDEX)
+/*
+ * Drivers are found by name and by compatible string through two hash
+ * tables with linear probing, built the first time they are needed after
+ * relocation. Before that the driver list is searched, so that the small
+ * pre-relocation malloc() pool is not spent on the index. Slots hold the
+ * position of a driver in the linker list plus one (0 for an empty slot);
+ * compatible string slots also hold the position of the string in the
+ * driver's of_match table. Where two drivers have the same name or
+ * compatible string, the first one wins, as it would when searching the
+ * linker list.
+ */
+struct dm_bind_index {
+	struct driver *drv;
+	uint name_mask;
+	uint compat_mask;
+	u16 *name;
+	u32 *compat;	/* driver << 16 | of_match entry */
+};
+
+static u32 lists_hash(const char *str)
+{
+	u32 hash = 2166136261U;
+
+	/* FNV-1a */
+	while (*str) {
+		hash ^= (u8)*str++;
+		hash *= 16777619;
+	}
+
+	return hash;
+}
+
+static void lists_index_add_name(struct dm_bind_index *idx, int i)
+{
+	const char *name = idx->drv[i].name;
+	uint slot = lists_hash(name) & idx->name_mask;
+
+	for (; idx->name[slot]; slot = (slot + 1) & idx->name_mask) {
+		if (!strcmp(idx->drv[idx->name[slot] - 1].name, name))
+			return;
+	}
+	idx->name[slot] = i + 1;
+}
+
+static void lists_index_add_compat(struct dm_bind_index *idx, int i, int j)
+{
+	const char *compat = idx->drv[i].of_match[j].compatible;
+	uint slot = lists_hash(compat) & idx->compat_mask;
+	const struct udevice_id *id;
+	u32 val;
+
+	for (; (val = idx->compat[slot]);
+	     slot = (slot + 1) & idx->compat_mask) {
+		id = &idx->drv[(val >> 16) - 1].of_match[val & 0xffff];
+		if (!strcmp(id->compatible, compat))
+			return;
+	}
+	idx->compat[slot] = (i + 1) << 16 | j;
+}
+
+/*
+ * Return the index, building it if needed, or NULL if it is not to be used:
+ * before relocation, or once building it has failed for lack of memory.
+ */
+static struct dm_bind_index *lists_index(void)
+{
+	struct driver *drv = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	struct dm_bind_index *idx = gd->dm_bind_index;
+	const struct udevice_id *id;
+	struct driver *entry;
+	int n_compat = 0;
+
+	if (IS_ERR(idx))
+		return NULL;
+	if (idx)
+		return idx;
+	if (!(gd->flags & GD_FLG_RELOC))
+		return NULL;
+
+	for (entry = drv; entry != drv + n_ents; entry++) {
+		for (id = entry->of_match; id && id->compatible; id++)
+			n_compat++;
+	}
+
+	/* Keep the tables at most half full */
+	idx = calloc(1, sizeof(*idx));
+	if (!idx)
+		goto err;
+	idx->name_mask = roundup_pow_of_two(2 * n_ents) - 1;
+	idx->compat_mask = roundup_pow_of_two(2 * n_compat + 1) - 1;
+	idx->name = calloc(idx->name_mask + 1, sizeof(*idx->name));
+	idx->compat = calloc(idx->compat_mask + 1, sizeof(*idx->compat));
+	if (!idx->name || !idx->compat) {
+		free(idx->name);
+		free(idx->compat);
+		free(idx);
+		goto err;
+	}
+
+	idx->drv = drv;
+	for (entry = drv; entry != drv + n_ents; entry++) {
+		lists_index_add_name(idx, entry - drv);
+		for (id = entry->of_match; id && id->compatible; id++)
+			lists_index_add_compat(idx, entry - drv,
+					       id - entry->of_match);
+	}
+	gd->dm_bind_index = idx;
+
+	return idx;
+
+err:
+	/* Do not try again on every lookup */
+	gd->dm_bind_index = ERR_PTR(-ENOMEM);
+
+	return NULL;
+}
+#endif
 
 struct driver *lists_driver_lookup_name(const char *name)
 {
@@ -24,6 +150,21 @@ struct driver *lists_driver_lookup_name(const char *name)
 		ll_entry_start(struct driver, driver);
 	const int n_ents = ll_entry_count(struct driver, driver);
 	struct driver *entry;
+#if CONFIG_IS_ENABLED(DM_BIND_INDEX)
+	struct dm_bind_index *idx = lists_index();
+	uint slot;
+
+	if (idx) {
+		slot = lists_hash(name) & idx->name_mask;
+		for (; idx->name[slot]; slot = (slot + 1) & idx->name_mask) {
+			entry = idx->drv + idx->name[slot] - 1;
+			if (!strcmp(name, entry->name))
+				return entry;
+		}
+
+		return NULL;
+	}
+#endif
 
 	for (entry = drv; entry != drv + n_ents; entry++) {
 		if (!strcmp(name, entry->name))
@@ -66,6 +207,9 @@ int lists_bind_drivers(struct udevice *parent, bool pre_reloc_only)
 			if (!result || ret != -ENOENT)
 				result = ret;
 		}
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+		entry->dev = ret ? NULL : dev;
+#endif
 	}
 
 	return result;
@@ -126,11 +270,45 @@ static int driver_check_compatible(const struct udevice_id *of_match,
 	return -ENOENT;
 }
 
-int lists_bind_fdt(struct udevice *parent, const void *blob, int offset,
-		   struct udevice **devp)
+struct driver *lists_driver_lookup_compat(const char *compat,
+					  const struct udevice_id **of_idp)
 {
 	struct driver *driver = ll_entry_start(struct driver, driver);
 	const int n_ents = ll_entry_count(struct driver, driver);
+	struct driver *entry;
+#if CONFIG_IS_ENABLED(DM_BIND_INDEX)
+	struct dm_bind_index *idx = lists_index();
+	const struct udevice_id *id;
+	uint slot;
+	u32 val;
+
+	if (idx) {
+		slot = lists_hash(compat) & idx->compat_mask;
+		for (; (val = idx->compat[slot]);
+		     slot = (slot + 1) & idx->compat_mask) {
+			entry = idx->drv + (val >> 16) - 1;
+			id = &entry->of_match[val & 0xffff];
+			if (!strcmp(id->compatible, compat)) {
+				*of_idp = id;
+				return entry;
+			}
+		}
+
+		return NULL;
+	}
+#endif
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		if (!driver_check_compatible(entry->of_match, of_idp, compat))
+			return entry;
+	}
+
+	return NULL;
+}
+
+int lists_bind_fdt(struct udevice *parent, const void *blob, int offset,
+		   struct udevice **devp)
+{
 	const struct udevice_id *id;
 	struct driver *entry;
 	struct udevice *dev;
@@ -145,7 +323,8 @@ int lists_bind_fdt(struct udevice *parent, const void *blob, int offset,
 	if (devp)
 		*devp = NULL;
 
-	compat_list = fdt_getprop(blob, offset, "compatible", &compat_length);
+	compat_list = of_live_getprop(blob, offset, "compatible",
+				      &compat_length);
 	if (!compat_list) {
 		if (compat_length == -FDT_ERR_NOTFOUND) {
 			dm_dbg("Device '%s' has no compatible string\n", name);
@@ -166,13 +345,8 @@ int lists_bind_fdt(struct udevice *parent, const void *blob, int offset,
 		dm_dbg("   - attempt to match compatible string '%s'\n",
 		       compat);
 
-		for (entry = driver; entry != driver + n_ents; entry++) {
-			ret = driver_check_compatible(entry->of_match, &id,
-						      compat);
-			if (!ret)
-				break;
-		}
-		if (entry == driver + n_ents)
+		entry = lists_driver_lookup_compat(compat, &id);
+		if (!entry)
 			continue;
 
 		dm_dbg("   - found match at '%s'\n", entry->name);
@@ -0,0 +1,72 @@
+/*
+ * Reading device tree properties of a device
+ *
+ * Copyright (C) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <fdtdec.h>
+#include <of_live.h>
+#include <dm/read.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+const void *dev_read_prop(struct udevice *dev, const char *propname,
+			  int *lenp)
+{
+	return of_live_getprop(gd->fdt_blob, dev_of_offset(dev), propname,
+			       lenp);
+}
+
+int dev_read_u32_default(struct udevice *dev, const char *propname, int def)
+{
+	return fdtdec_get_int(gd->fdt_blob, dev_of_offset(dev), propname, def);
+}
+
+int dev_read_u32_array(struct udevice *dev, const char *propname, u32 *out,
+		       int count)
+{
+	return fdtdec_get_int_array(gd->fdt_blob, dev_of_offset(dev),
+				    propname, out, count);
+}
+
+const char *dev_read_string(struct udevice *dev, const char *propname)
+{
+	const char *str;
+	int len;
+
+	str = dev_read_prop(dev, propname, &len);
+	if (!str || len < 1 || str[len - 1])
+		return NULL;
+
+	return str;
+}
+
+bool dev_read_bool(struct udevice *dev, const char *propname)
+{
+	return dev_read_prop(dev, propname, NULL) != NULL;
+}
+
+bool dev_read_enabled(struct udevice *dev)
+{
+	return fdtdec_get_is_enabled(gd->fdt_blob, dev_of_offset(dev));
+}
+
+int dev_read_phandle(struct udevice *dev, const char *propname)
+{
+	return fdtdec_lookup_phandle(gd->fdt_blob, dev_of_offset(dev),
+				     propname);
+}
+
+int dev_read_first_subnode(struct udevice *dev)
+{
+	return of_live_first_subnode(gd->fdt_blob, dev_of_offset(dev));
+}
+
+int dev_read_next_subnode(int node)
+{
+	return of_live_next_subnode(gd->fdt_blob, node);
+}
@@ -11,6 +11,7 @@
 #include <libfdt.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <of_live.h>
 #include <regmap.h>
 
 #include <asm/io.h>
@@ -77,7 +78,7 @@ int regmap_init_mem(struct udevice *dev, struct regmap **mapp)
 	size_len = fdt_size_cells(blob, parent);
 	both_len = addr_len + size_len;
 
-	cell = fdt_getprop(blob, dev_of_offset(dev), "reg", &len);
+	cell = of_live_getprop(blob, dev_of_offset(dev), "reg", &len);
 	len /= sizeof(*cell);
 	count = len / both_len;
 	if (!cell || !count)
@@ -12,6 +12,7 @@
 #include <fdtdec.h>
 #include <malloc.h>
 #include <libfdt.h>
+#include <of_live.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
@@ -156,6 +157,10 @@ int dm_init(void)
 		return -EINVAL;
 	}
 	INIT_LIST_HEAD(&DM_UCLASS_ROOT_NON_CONST);
+	dm_lazy_uninit();
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	memset(gd->uclass_table, '\0', sizeof(gd->uclass_table));
+#endif
 
 #if defined(CONFIG_NEEDS_MANUAL_RELOC)
 	fix_drivers();
@@ -167,7 +172,7 @@ int dm_init(void)
 	if (ret)
 		return ret;
 #if CONFIG_IS_ENABLED(OF_CONTROL)
-	DM_ROOT_NON_CONST->of_offset = 0;
+	dev_set_of_offset(DM_ROOT_NON_CONST, 0);
 #endif
 	ret = device_probe(DM_ROOT_NON_CONST);
 	if (ret)
@@ -178,6 +183,7 @@ int dm_init(void)
 
 int dm_uninit(void)
 {
+	dm_lazy_uninit();
 	device_remove(dm_root(), DM_REMOVE_NORMAL);
 	device_unbind(dm_root());
 
@@ -212,9 +218,9 @@ int dm_scan_fdt_node(struct udevice *parent, const void *blob, int offset,
 {
 	int ret = 0, err;
 
-	for (offset = fdt_first_subnode(blob, offset);
+	for (offset = of_live_first_subnode(blob, offset);
 	     offset > 0;
-	     offset = fdt_next_subnode(blob, offset)) {
+	     offset = of_live_next_subnode(blob, offset)) {
 		if (pre_reloc_only &&
 		    !dm_fdt_pre_reloc(blob, offset))
 			continue;
@@ -222,6 +228,8 @@ int dm_scan_fdt_node(struct udevice *parent, const void *blob, int offset,
 			dm_dbg("   - ignoring disabled device\n");
 			continue;
 		}
+		if (!pre_reloc_only && dm_lazy_add(parent, blob, offset))
+			continue;
 		err = lists_bind_fdt(parent, blob, offset, NULL);
 		if (err && !ret) {
 			ret = err;
@@ -271,6 +279,10 @@ int dm_init_and_scan(bool pre_reloc_only)
 		return ret;
 	}
 
+	/* Without memory for it, nodes are bound as usual */
+	if (!pre_reloc_only && dm_lazy_init())
+		debug("dm_lazy_init() failed\n");
+
 	if (CONFIG_IS_ENABLED(OF_CONTROL) && !CONFIG_IS_ENABLED(OF_PLATDATA)) {
 		ret = dm_scan_fdt(gd->fdt_blob, pre_reloc_only);
 		if (ret) {
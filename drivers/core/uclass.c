@@ -16,20 +16,195 @@
 #include <dm/uclass.h>
 #include <dm/uclass-internal.h>
 #include <dm/util.h>
+#include <linux/log2.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+/*
+ * Each uclass indexes its probed devices by sequence number, in an array, and
+ * all its devices by device tree offset, in a hash table with linear probing.
+ * Where devices share an offset, the one earliest in the uclass list is
+ * indexed, being the one a search of the list would find. If an index cannot
+ * be grown it is dropped and the list is searched instead. Before relocation
+ * the lists are always searched: the indexes would be grown from the small
+ * pre-relocation malloc() pool, which is never given back.
+ */
+#define UCLASS_INDEX_MIN	8
+
+static struct udevice **uclass_index_alloc(int size)
+{
+	return calloc(size, sizeof(struct udevice *));
+}
+
+void uclass_set_seq(struct udevice *dev, int seq)
+{
+	struct uclass *uc = dev->uclass;
+	struct udevice **table;
+	int size;
+
+	if (dev->seq >= 0 && dev->seq < uc->seq_size &&
+	    uc->seq_dev[dev->seq] == dev)
+		uc->seq_dev[dev->seq] = NULL;
+	dev->seq = seq;
+	if (seq < 0 || uc->seq_size < 0)
+		return;
+
+	if (seq >= uc->seq_size) {
+		/* realloc() is not available before relocation */
+		size = max_t(int, roundup_pow_of_two(seq + 1),
+			     UCLASS_INDEX_MIN);
+		table = uclass_index_alloc(size);
+		if (table && uc->seq_size)
+			memcpy(table, uc->seq_dev,
+			       uc->seq_size * sizeof(*table));
+		free(uc->seq_dev);
+		uc->seq_dev = table;
+		uc->seq_size = table ? size : -1;
+		if (!table)
+			return;
+	}
+	uc->seq_dev[seq] = dev;
+}
+
+static uint uclass_of_slot(struct uclass *uc, int node)
+{
+	u32 key = (u32)node * 0x9e3779b1;
+
+	return (key ^ (key >> 16)) & uc->of_mask;
+}
+
+/* Return the slot holding @node, or the empty slot where it would go */
+static uint uclass_of_find_slot(struct uclass *uc, int node)
+{
+	uint slot = uclass_of_slot(uc, node);
+
+	while (uc->of_dev[slot] && dev_of_offset(uc->of_dev[slot]) != node)
+		slot = (slot + 1) & uc->of_mask;
+
+	return slot;
+}
+
+static struct udevice *uclass_of_find(struct uclass *uc, int node)
+{
+	if (!uc->of_dev)
+		return NULL;
+
+	return uc->of_dev[uclass_of_find_slot(uc, node)];
+}
+
+/* Check whether @dev comes before @other in their uclass's list */
+static bool uclass_dev_before(struct udevice *dev, struct udevice *other)
+{
+	struct uclass *uc = dev->uclass;
+
+	list_for_each_entry_continue(dev, &uc->dev_head, uclass_node) {
+		if (dev == other)
+			return true;
+	}
+
+	return false;
+}
+
+static int uclass_of_grow(struct uclass *uc)
+{
+	struct udevice **old = uc->of_dev;
+	int old_size = old ? uc->of_mask + 1 : 0;
+	int size = max(old_size * 2, UCLASS_INDEX_MIN);
+	int i;
+
+	uc->of_dev = uclass_index_alloc(size);
+	if (!uc->of_dev) {
+		free(old);
+		uc->of_mask = -1;
+		return -ENOMEM;
+	}
+	uc->of_mask = size - 1;
+	for (i = 0; i < old_size; i++) {
+		if (old[i])
+			uc->of_dev[uclass_of_find_slot(uc,
+					dev_of_offset(old[i]))] = old[i];
+	}
+	free(old);
+
+	return 0;
+}
+
+void uclass_of_index_add(struct udevice *dev)
+{
+	struct uclass *uc = dev->uclass;
+	int node = dev_of_offset(dev);
+	struct udevice *other;
+	uint slot;
+
+	if (node < 0 || uc->of_mask < 0)
+		return;
+	if (!uc->of_dev || (uc->of_count + 1) * 2 > uc->of_mask + 1) {
+		if (uclass_of_grow(uc))
+			return;
+	}
+
+	slot = uclass_of_find_slot(uc, node);
+	other = uc->of_dev[slot];
+	if (!other)
+		uc->of_count++;
+	else if (!uclass_dev_before(dev, other))
+		return;
+	uc->of_dev[slot] = dev;
+}
+
+void uclass_of_index_del(struct udevice *dev)
+{
+	struct uclass *uc = dev->uclass;
+	int node = dev_of_offset(dev);
+	struct udevice *other;
+	uint slot, next, home;
+
+	if (node < 0 || uclass_of_find(uc, node) != dev)
+		return;
+
+	/* Another device with this offset takes over the slot */
+	list_for_each_entry(other, &uc->dev_head, uclass_node) {
+		if (other != dev && dev_of_offset(other) == node) {
+			uc->of_dev[uclass_of_find_slot(uc, node)] = other;
+			return;
+		}
+	}
+
+	/* Shift back entries after the slot, so that probing still works */
+	slot = uclass_of_find_slot(uc, node);
+	uc->of_dev[slot] = NULL;
+	uc->of_count--;
+	for (next = (slot + 1) & uc->of_mask; uc->of_dev[next];
+	     next = (next + 1) & uc->of_mask) {
+		home = uclass_of_slot(uc, dev_of_offset(uc->of_dev[next]));
+		if (((next - home) & uc->of_mask) >=
+		    ((next - slot) & uc->of_mask)) {
+			uc->of_dev[slot] = uc->of_dev[next];
+			uc->of_dev[next] = NULL;
+			slot = next;
+		}
+	}
+}
+
+static void uclass_index_free(struct uclass *uc)
+{
+	gd->uclass_table[uc->uc_drv->id] = NULL;
+	free(uc->seq_dev);
+	free(uc->of_dev);
+}
+#endif
+
 struct uclass *uclass_find(enum uclass_id key)
 {
 	struct uclass *uc;
 
 	if (!gd->dm_root)
 		return NULL;
-	/*
-	 * TODO(sjg@chromium.org): Optimise this, perhaps moving the found
-	 * node to the start of the list, or creating a linear array mapping
-	 * id to node.
-	 */
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	if ((uint)key < UCLASS_COUNT)
+		return gd->uclass_table[key];
+#endif
 	list_for_each_entry(uc, &gd->uclass_root, sibling_node) {
 		if (uc->uc_drv->id == key)
 			return uc;
@@ -79,6 +254,14 @@ static int uclass_add(enum uclass_id id, struct uclass **ucp)
 	INIT_LIST_HEAD(&uc->sibling_node);
 	INIT_LIST_HEAD(&uc->dev_head);
 	list_add(&uc->sibling_node, &DM_UCLASS_ROOT_NON_CONST);
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	if ((uint)id < UCLASS_COUNT)
+		gd->uclass_table[id] = uc;
+	if (!(gd->flags & GD_FLG_RELOC)) {
+		uc->seq_size = -1;
+		uc->of_mask = -1;
+	}
+#endif
 
 	if (uc_drv->init) {
 		ret = uc_drv->init(uc);
@@ -95,6 +278,9 @@ fail:
 		uc->priv = NULL;
 	}
 	list_del(&uc->sibling_node);
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	uclass_index_free(uc);
+#endif
 fail_mem:
 	free(uc);
 
@@ -128,6 +314,9 @@ int uclass_destroy(struct uclass *uc)
 	if (uc_drv->destroy)
 		uc_drv->destroy(uc);
 	list_del(&uc->sibling_node);
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	uclass_index_free(uc);
+#endif
 	if (uc_drv->priv_auto_alloc_size)
 		free(uc->priv);
 	free(uc);
@@ -138,12 +327,18 @@ int uclass_destroy(struct uclass *uc)
 int uclass_get(enum uclass_id id, struct uclass **ucp)
 {
 	struct uclass *uc;
+	int ret;
 
 	*ucp = NULL;
 	uc = uclass_find(id);
-	if (!uc)
-		return uclass_add(id, ucp);
+	if (!uc) {
+		ret = uclass_add(id, &uc);
+		if (ret)
+			return ret;
+	}
 	*ucp = uc;
+	/* Any failure has been reported, and the other devices are usable */
+	dm_lazy_bind_uclass(id);
 
 	return 0;
 }
@@ -249,6 +444,15 @@ int uclass_find_device_by_seq(enum uclass_id id, int seq_or_req_seq,
 	if (ret)
 		return ret;
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	/* Requested sequence numbers may be changed by drivers at any time */
+	if (!find_req_seq && uc->seq_size >= 0) {
+		if (seq_or_req_seq >= 0 && seq_or_req_seq < uc->seq_size)
+			*devp = uc->seq_dev[seq_or_req_seq];
+		debug("   - %s\n", *devp ? "found" : "not found");
+		return *devp ? 0 : -ENODEV;
+	}
+#endif
 	list_for_each_entry(dev, &uc->dev_head, uclass_node) {
 		debug("   - %d %d '%s'\n", dev->req_seq, dev->seq, dev->name);
 		if ((find_req_seq ? dev->req_seq : dev->seq) ==
@@ -277,6 +481,12 @@ int uclass_find_device_by_of_offset(enum uclass_id id, int node,
 	if (ret)
 		return ret;
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	if (uc->of_mask >= 0) {
+		*devp = uclass_of_find(uc, node);
+		return *devp ? 0 : -ENODEV;
+	}
+#endif
 	list_for_each_entry(dev, &uc->dev_head, uclass_node) {
 		if (dev_of_offset(dev) == node) {
 			*devp = dev;
@@ -464,6 +674,7 @@ int uclass_bind_device(struct udevice *dev)
 
 	uc = dev->uclass;
 	list_add_tail(&dev->uclass_node, &uc->dev_head);
+	uclass_of_index_add(dev);
 
 	if (dev->parent) {
 		struct uclass_driver *uc_drv = dev->parent->uclass->uc_drv;
@@ -478,6 +689,7 @@ int uclass_bind_device(struct udevice *dev)
 	return 0;
 err:
 	/* There is no need to undo the parent's post_bind call */
+	uclass_of_index_del(dev);
 	list_del(&dev->uclass_node);
 
 	return ret;
@@ -496,6 +708,8 @@ int uclass_unbind_device(struct udevice *dev)
 			return ret;
 	}
 
+	uclass_set_seq(dev, -1);
+	uclass_of_index_del(dev);
 	list_del(&dev->uclass_node);
 	return 0;
 }
@@ -14,6 +14,8 @@ DECLARE_GLOBAL_DATA_PTR;
 static int sandbox_spl_probe(struct udevice *dev)
 {
 	struct dtd_sandbox_spl_test *plat = dev_get_platdata(dev);
+	struct dtd_sandbox_spl_test *target_plat;
+	struct udevice *target;
 	int i;
 
 	printf("of-platdata probe:\n");
@@ -42,6 +44,15 @@ static int sandbox_spl_probe(struct udevice *dev)
 		printf(" \"%s\"", plat->stringarray[i]);
 	printf("\n");
 
+	printf("clocks");
+	for (i = 0; i < ARRAY_SIZE(plat->clocks) && plat->clocks[i].node; i++) {
+		if (device_get_by_driver_info(plat->clocks[i].node, &target))
+			return -ENOENT;
+		target_plat = dev_get_platdata(target);
+		printf(" %d:%d", target_plat->intval, plat->clocks[i].id);
+	}
+	printf("\n");
+
 	return 0;
 }
 
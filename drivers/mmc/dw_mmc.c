@@ -16,6 +16,12 @@
 
 #define PAGE_SIZE 4096
 
+/* Blocks described by one IDMAC descriptor (PAGE_SIZE for 512-byte blocks) */
+#define DWMCI_IDMAC_BLOCKS	8
+
+/* Longest wait for the data of a transfer */
+#define DWMCI_DATA_TIMEOUT_MS	240000
+
 static int dwmci_wait_reset(struct dwmci_host *host, u32 value)
 {
 	unsigned long timeout = 1000;
@@ -42,6 +48,31 @@ static void dwmci_set_idma_desc(struct dwmci_idmac *idmac,
 	desc->next_addr = (ulong)desc + sizeof(struct dwmci_idmac);
 }
 
+/*
+ * Make sure the descriptor pool can describe @blocks blocks. The pool is
+ * kept across commands and only grows, so a multi-megabyte transfer is
+ * set up in one go without putting its descriptors on the stack.
+ */
+static int dwmci_idmac_reserve(struct dwmci_host *host, unsigned int blocks)
+{
+	unsigned int count = DIV_ROUND_UP(blocks, DWMCI_IDMAC_BLOCKS);
+
+	if (count <= host->idmac_count)
+		return 0;
+
+	free(host->idmac);
+	host->idmac = memalign(ARCH_DMA_MINALIGN,
+			       ALIGN(count * sizeof(struct dwmci_idmac),
+				     ARCH_DMA_MINALIGN));
+	if (!host->idmac) {
+		host->idmac_count = 0;
+		return -ENOMEM;
+	}
+	host->idmac_count = count;
+
+	return 0;
+}
+
 static void dwmci_prepare_data(struct dwmci_host *host,
 			       struct mmc_data *data,
 			       struct dwmci_idmac *cur_idmac,
@@ -62,18 +93,19 @@ static void dwmci_prepare_data(struct dwmci_host *host,
 	do {
 		flags = DWMCI_IDMAC_OWN | DWMCI_IDMAC_CH ;
 		flags |= (i == 0) ? DWMCI_IDMAC_FS : 0;
-		if (blk_cnt <= 8) {
+		if (blk_cnt <= DWMCI_IDMAC_BLOCKS) {
 			flags |= DWMCI_IDMAC_LD;
 			cnt = data->blocksize * blk_cnt;
 		} else
-			cnt = data->blocksize * 8;
+			cnt = data->blocksize * DWMCI_IDMAC_BLOCKS;
 
 		dwmci_set_idma_desc(cur_idmac, flags, cnt,
-				    (ulong)bounce_buffer + (i * PAGE_SIZE));
+				    (ulong)bounce_buffer + i *
+				    data->blocksize * DWMCI_IDMAC_BLOCKS);
 
-		if (blk_cnt <= 8)
+		if (blk_cnt <= DWMCI_IDMAC_BLOCKS)
 			break;
-		blk_cnt -= 8;
+		blk_cnt -= DWMCI_IDMAC_BLOCKS;
 		cur_idmac++;
 		i++;
 	} while(1);
@@ -96,7 +128,7 @@ static void dwmci_prepare_data(struct dwmci_host *host,
 static int dwmci_data_transfer(struct dwmci_host *host, struct mmc_data *data)
 {
 	int ret = 0;
-	u32 timeout = 240000;
+	u32 timeout = DWMCI_DATA_TIMEOUT_MS;
 	u32 mask, size, i, len = 0;
 	u32 *buf = NULL;
 	ulong start = get_timer(0);
@@ -184,25 +216,29 @@ static int dwmci_set_transfer_mode(struct dwmci_host *host,
 	return mode;
 }
 
-#ifdef CONFIG_DM_MMC_OPS
-static int dwmci_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
-		   struct mmc_data *data)
+/* Turn the IDMAC off after a transfer and give the buffer back */
+static void dwmci_dma_end(struct dwmci_host *host)
 {
-	struct mmc *mmc = mmc_get_mmc_dev(dev);
-#else
-static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
-		struct mmc_data *data)
+	u32 ctrl;
+
+	ctrl = dwmci_readl(host, DWMCI_CTRL);
+	ctrl &= ~(DWMCI_DMA_EN);
+	dwmci_writel(host, DWMCI_CTRL, ctrl);
+	bounce_buffer_stop(&host->bbstate);
+}
+
+/*
+ * Send a command and wait for its response. A DMA data transfer is set up
+ * and left running: the caller waits for it and then calls dwmci_dma_end().
+ */
+static int dwmci_cmd_start(struct dwmci_host *host, struct mmc_cmd *cmd,
+			   struct mmc_data *data)
 {
-#endif
-	struct dwmci_host *host = mmc->priv;
-	ALLOC_CACHE_ALIGN_BUFFER(struct dwmci_idmac, cur_idmac,
-				 data ? DIV_ROUND_UP(data->blocks, 8) : 0);
 	int ret = 0, flags = 0, i;
 	unsigned int timeout = 500;
 	u32 retry = 100000;
-	u32 mask, ctrl;
+	u32 mask;
 	ulong start = get_timer(0);
-	struct bounce_buffer bbstate;
 
 	while (dwmci_readl(host, DWMCI_STATUS) & DWMCI_BUSY) {
 		if (get_timer(start) > timeout) {
@@ -213,6 +249,9 @@ static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 
 	dwmci_writel(host, DWMCI_RINTSTS, DWMCI_INTMSK_ALL);
 
+	if ((cmd->resp_type & MMC_RSP_136) && (cmd->resp_type & MMC_RSP_BUSY))
+		return -1;
+
 	if (data) {
 		if (host->fifo_mode) {
 			dwmci_writel(host, DWMCI_BLKSIZ, data->blocksize);
@@ -220,17 +259,23 @@ static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 				     data->blocksize * data->blocks);
 			dwmci_wait_reset(host, DWMCI_CTRL_FIFO_RESET);
 		} else {
-			if (data->flags == MMC_DATA_READ) {
-				bounce_buffer_start(&bbstate, (void*)data->dest,
+			ret = dwmci_idmac_reserve(host, data->blocks);
+			if (ret)
+				return ret;
+			if (data->flags == MMC_DATA_READ)
+				ret = bounce_buffer_start(&host->bbstate,
+						(void *)data->dest,
 						data->blocksize *
 						data->blocks, GEN_BB_WRITE);
-			} else {
-				bounce_buffer_start(&bbstate, (void*)data->src,
+			else
+				ret = bounce_buffer_start(&host->bbstate,
+						(void *)data->src,
 						data->blocksize *
 						data->blocks, GEN_BB_READ);
-			}
-			dwmci_prepare_data(host, data, cur_idmac,
-					   bbstate.bounce_buffer);
+			if (ret)
+				return ret;
+			dwmci_prepare_data(host, data, host->idmac,
+					   host->bbstate.bounce_buffer);
 		}
 	}
 
@@ -239,9 +284,6 @@ static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 	if (data)
 		flags = dwmci_set_transfer_mode(host, data);
 
-	if ((cmd->resp_type & MMC_RSP_136) && (cmd->resp_type & MMC_RSP_BUSY))
-		return -1;
-
 	if (cmd->cmdidx == MMC_CMD_STOP_TRANSMISSION)
 		flags |= DWMCI_CMD_ABORT_STOP;
 	else
@@ -273,10 +315,8 @@ static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 
 	if (i == retry) {
 		debug("%s: Timeout.\n", __func__);
-		return -ETIMEDOUT;
-	}
-
-	if (mask & DWMCI_INTMSK_RTO) {
+		ret = -ETIMEDOUT;
+	} else if (mask & DWMCI_INTMSK_RTO) {
 		/*
 		 * Timeout here is not necessarily fatal. (e)MMC cards
 		 * will splat here when they receive CMD55 as they do
@@ -286,12 +326,16 @@ static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 		 * CMD8, please keep that in mind.
 		 */
 		debug("%s: Response Timeout.\n", __func__);
-		return -ETIMEDOUT;
+		ret = -ETIMEDOUT;
 	} else if (mask & DWMCI_INTMSK_RE) {
 		debug("%s: Response Error.\n", __func__);
-		return -EIO;
+		ret = -EIO;
+	}
+	if (ret) {
+		if (data && !host->fifo_mode)
+			dwmci_dma_end(host);
+		return ret;
 	}
-
 
 	if (cmd->resp_type & MMC_RSP_PRESENT) {
 		if (cmd->resp_type & MMC_RSP_136) {
@@ -304,16 +348,32 @@ static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 		}
 	}
 
+	return 0;
+}
+
+#ifdef CONFIG_DM_MMC_OPS
+static int dwmci_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
+		   struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+#else
+static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
+		struct mmc_data *data)
+{
+#endif
+	struct dwmci_host *host = mmc->priv;
+	int ret;
+
+	ret = dwmci_cmd_start(host, cmd, data);
+	if (ret)
+		return ret;
+
 	if (data) {
 		ret = dwmci_data_transfer(host, data);
 
 		/* only dma mode need it */
-		if (!host->fifo_mode) {
-			ctrl = dwmci_readl(host, DWMCI_CTRL);
-			ctrl &= ~(DWMCI_DMA_EN);
-			dwmci_writel(host, DWMCI_CTRL, ctrl);
-			bounce_buffer_stop(&bbstate);
-		}
+		if (!host->fifo_mode)
+			dwmci_dma_end(host);
 	}
 
 	udelay(100);
@@ -321,6 +381,57 @@ static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 	return ret;
 }
 
+#ifdef CONFIG_DM_MMC_OPS
+/*
+ * Start a DMA transfer and return once the card has answered the command,
+ * so that the caller can get on with other work while the data moves.
+ */
+static int dwmci_send_cmd_start(struct udevice *dev, struct mmc_cmd *cmd,
+				struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct dwmci_host *host = mmc->priv;
+	int ret;
+
+	/* In FIFO mode the CPU moves the data itself */
+	if (host->fifo_mode)
+		return -ENOSYS;
+
+	ret = dwmci_cmd_start(host, cmd, data);
+	if (ret)
+		return ret;
+	host->data_start = get_timer(0);
+
+	return 0;
+}
+
+static int dwmci_send_cmd_poll(struct udevice *dev)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct dwmci_host *host = mmc->priv;
+	u32 mask;
+	int ret;
+
+	mask = dwmci_readl(host, DWMCI_RINTSTS);
+	if (mask & (DWMCI_DATA_ERR | DWMCI_DATA_TOUT)) {
+		debug("%s: DATA ERROR!\n", __func__);
+		ret = -EINVAL;
+	} else if (mask & DWMCI_INTMSK_DTO) {
+		ret = 0;
+	} else if (get_timer(host->data_start) > DWMCI_DATA_TIMEOUT_MS) {
+		debug("%s: Timeout waiting for data!\n", __func__);
+		ret = -ETIMEDOUT;
+	} else {
+		return -EBUSY;
+	}
+
+	dwmci_writel(host, DWMCI_RINTSTS, mask);
+	dwmci_dma_end(host);
+
+	return ret;
+}
+#endif
+
 static int dwmci_setup_bus(struct dwmci_host *host, u32 freq)
 {
 	u32 div, status;
@@ -474,8 +585,22 @@ int dwmci_probe(struct udevice *dev)
 	return dwmci_init(mmc);
 }
 
+int dwmci_remove(struct udevice *dev)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct dwmci_host *host = mmc->priv;
+
+	free(host->idmac);
+	host->idmac = NULL;
+	host->idmac_count = 0;
+
+	return 0;
+}
+
 const struct dm_mmc_ops dm_dwmci_ops = {
 	.send_cmd	= dwmci_send_cmd,
+	.send_cmd_start	= dwmci_send_cmd_start,
+	.send_cmd_poll	= dwmci_send_cmd_poll,
 	.set_ios	= dwmci_set_ios,
 };
 
@@ -510,7 +635,7 @@ void dwmci_setup_cfg(struct mmc_config *cfg, struct dwmci_host *host,
 	}
 	cfg->host_caps |= MMC_MODE_HS | MMC_MODE_HS_52MHz;
 
-	cfg->b_max = CONFIG_SYS_MMC_MAX_BLK_COUNT;
+	cfg->b_max = CONFIG_MMC_DW_MAX_BLK_COUNT;
 }
 
 #ifdef CONFIG_BLK
@@ -299,6 +299,7 @@ U_BOOT_DRIVER(exynos_dwmmc_drv) = {
 	.bind		= exynos_dwmmc_bind,
 	.ops		= &dm_dwmci_ops,
 	.probe		= exynos_dwmmc_probe,
+	.remove		= dwmci_remove,
 	.priv_auto_alloc_size	= sizeof(struct dwmci_exynos_priv_data),
 	.platdata_auto_alloc_size = sizeof(struct exynos_mmc_plat),
 };
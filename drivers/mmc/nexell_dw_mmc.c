@@ -293,6 +293,7 @@ U_BOOT_DRIVER(nexell_dwmmc_drv) = {
 	.bind		= nexell_dwmmc_bind,
 	.ops		= &dm_dwmci_ops,
 	.probe		= nexell_dwmmc_probe,
+	.remove		= dwmci_remove,
 	.priv_auto_alloc_size = sizeof(struct nx_dwmci_dat),
 	.platdata_auto_alloc_size = sizeof(struct nx_mmc_plat),
 };
@@ -158,6 +158,7 @@ U_BOOT_DRIVER(rockchip_dwmmc_drv) = {
 	.ops		= &dm_dwmci_ops,
 	.bind		= rockchip_dwmmc_bind,
 	.probe		= rockchip_dwmmc_probe,
+	.remove		= dwmci_remove,
 	.priv_auto_alloc_size = sizeof(struct rockchip_dwmmc_priv),
 	.platdata_auto_alloc_size = sizeof(struct rockchip_mmc_plat),
 };
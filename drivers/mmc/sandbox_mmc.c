@@ -17,13 +17,14 @@ DECLARE_GLOBAL_DATA_PTR;
 struct sandbox_mmc_plat {
 	struct mmc_config cfg;
 	struct mmc mmc;
+	bool busy;		/* transfer started by send_cmd_start() */
 };
 
 /**
  * sandbox_mmc_send_cmd() - Emulate SD commands
  *
- * This emulate an SD card version 2. Single-block reads result in zero data.
- * Multiple-block reads return a test string.
+ * This emulate an SD card version 2. Every block read holds a test string,
+ * followed by zeroes, whether it is read on its own or with others.
  */
 static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 				struct mmc_data *data)
@@ -54,11 +55,16 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		break;
 	}
 	case MMC_CMD_READ_SINGLE_BLOCK:
-		memset(data->dest, '\0', data->blocksize);
-		break;
-	case MMC_CMD_READ_MULTIPLE_BLOCK:
-		strcpy(data->dest, "this is a test");
+	case MMC_CMD_READ_MULTIPLE_BLOCK: {
+		char *buf = data->dest;
+		int i;
+
+		for (i = 0; i < data->blocks; i++, buf += data->blocksize) {
+			memset(buf, '\0', data->blocksize);
+			strcpy(buf, "this is a test");
+		}
 		break;
+	}
 	case MMC_CMD_STOP_TRANSMISSION:
 		break;
 	case SD_CMD_APP_SEND_OP_COND:
@@ -85,6 +91,33 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	return 0;
 }
 
+/* The data is moved right away, but only reported by send_cmd_poll() */
+static int sandbox_mmc_send_cmd_start(struct udevice *dev,
+				      struct mmc_cmd *cmd,
+				      struct mmc_data *data)
+{
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+	int ret;
+
+	ret = sandbox_mmc_send_cmd(dev, cmd, data);
+	if (ret)
+		return ret;
+	plat->busy = true;
+
+	return 0;
+}
+
+static int sandbox_mmc_send_cmd_poll(struct udevice *dev)
+{
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
+	if (!plat->busy)
+		return -EINVAL;
+	plat->busy = false;
+
+	return 0;
+}
+
 static int sandbox_mmc_set_ios(struct udevice *dev)
 {
 	return 0;
@@ -97,6 +130,8 @@ static int sandbox_mmc_get_cd(struct udevice *dev)
 
 static const struct dm_mmc_ops sandbox_mmc_ops = {
 	.send_cmd = sandbox_mmc_send_cmd,
+	.send_cmd_start = sandbox_mmc_send_cmd_start,
+	.send_cmd_poll = sandbox_mmc_send_cmd_poll,
 	.set_ios = sandbox_mmc_set_ios,
 	.get_cd = sandbox_mmc_get_cd,
 };
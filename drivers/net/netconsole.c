@@ -129,8 +129,10 @@ void nc_start(void)
 		pkt = (uchar *)net_tx_packet + net_eth_hdr_size() +
 			IP_UDP_HDR_SIZE;
 		memcpy(pkt, output_packet, output_packet_len);
-		net_send_udp_packet(nc_ether, nc_ip, nc_out_port, nc_in_port,
-				    output_packet_len);
+		/* sent at once if the address is in the ARP cache */
+		if (!net_send_udp_packet(nc_ether, nc_ip, nc_out_port,
+					 nc_in_port, output_packet_len))
+			net_set_state(NETLOOP_SUCCESS);
 	}
 }
 
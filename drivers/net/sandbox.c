@@ -11,27 +11,39 @@
 #include <dm.h>
 #include <malloc.h>
 #include <net.h>
+#include <asm/eth.h>
 #include <asm/test.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/* Number of packets which can be waiting to be received */
+#define SANDBOX_ETH_RECV_QUEUE	32
+
 /**
  * struct eth_sandbox_priv - memory for sandbox mock driver
  *
  * fake_host_hwaddr: MAC address of mocked machine
  * fake_host_ipaddr: IP address of mocked machine
- * recv_packet_buffer: buffer of the packet returned as received
- * recv_packet_length: length of the packet returned as received
+ * recv_packet_buffer: buffers of the packets to be returned as received
+ * recv_packet_length: lengths of the packets to be returned as received
+ * recv_head: index of the next packet to be returned as received
+ * recv_count: number of packets waiting to be returned as received
+ * recv_busy: true if the packet at recv_head has been returned and is
+ *	still in use by the caller
  */
 struct eth_sandbox_priv {
 	uchar fake_host_hwaddr[ARP_HLEN];
 	struct in_addr fake_host_ipaddr;
-	uchar *recv_packet_buffer;
-	int recv_packet_length;
+	uchar recv_packet_buffer[SANDBOX_ETH_RECV_QUEUE][PKTSIZE_ALIGN];
+	int recv_packet_length[SANDBOX_ETH_RECV_QUEUE];
+	int recv_head;
+	int recv_count;
+	bool recv_busy;
 };
 
 static bool disabled[8] = {false};
 static bool skip_timeout;
+static sandbox_eth_tx_hand_f *tx_handler[8];
 
 /*
  * sandbox_eth_disable_response()
@@ -54,6 +66,45 @@ void sandbox_eth_skip_timeout(void)
 	skip_timeout = true;
 }
 
+void sandbox_eth_set_tx_handler(int index, sandbox_eth_tx_hand_f *handler)
+{
+	tx_handler[index] = handler;
+}
+
+/* Get the buffer for the next packet to be received, or NULL if none */
+static uchar *sb_eth_recv_buffer(struct eth_sandbox_priv *priv)
+{
+	if (priv->recv_count == SANDBOX_ETH_RECV_QUEUE)
+		return NULL;
+
+	return priv->recv_packet_buffer[(priv->recv_head + priv->recv_count) %
+					SANDBOX_ETH_RECV_QUEUE];
+}
+
+/* Add the packet in the buffer given by sb_eth_recv_buffer() to the queue */
+static void sb_eth_recv_push(struct eth_sandbox_priv *priv, int length)
+{
+	priv->recv_packet_length[(priv->recv_head + priv->recv_count) %
+				 SANDBOX_ETH_RECV_QUEUE] = length;
+	priv->recv_count++;
+}
+
+int sandbox_eth_recv_packet(struct udevice *dev, const void *packet,
+			    unsigned int length)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	uchar *buf = sb_eth_recv_buffer(priv);
+
+	if (!buf)
+		return -ENOSPC;
+	if (length > PKTSIZE_ALIGN)
+		return -E2BIG;
+	memcpy(buf, packet, length);
+	sb_eth_recv_push(priv, length);
+
+	return 0;
+}
+
 static int sb_eth_start(struct udevice *dev)
 {
 	struct eth_sandbox_priv *priv = dev_get_priv(dev);
@@ -63,7 +114,9 @@ static int sb_eth_start(struct udevice *dev)
 	fdtdec_get_byte_array(gd->fdt_blob, dev_of_offset(dev),
 			      "fake-host-hwaddr", priv->fake_host_hwaddr,
 			      ARP_HLEN);
-	priv->recv_packet_buffer = net_rx_packets[0];
+	priv->recv_head = 0;
+	priv->recv_count = 0;
+	priv->recv_busy = false;
 	return 0;
 }
 
@@ -71,6 +124,8 @@ static int sb_eth_send(struct udevice *dev, void *packet, int length)
 {
 	struct eth_sandbox_priv *priv = dev_get_priv(dev);
 	struct ethernet_hdr *eth = packet;
+	uchar *buf;
+	int ret;
 
 	debug("eth_sandbox: Send packet %d\n", length);
 
@@ -78,6 +133,17 @@ static int sb_eth_send(struct udevice *dev, void *packet, int length)
 	    disabled[dev->seq])
 		return 0;
 
+	if (dev->seq >= 0 && dev->seq < ARRAY_SIZE(tx_handler) &&
+	    tx_handler[dev->seq]) {
+		ret = tx_handler[dev->seq](dev, packet, length);
+		if (ret != -ENOENT)
+			return ret;
+	}
+
+	buf = sb_eth_recv_buffer(priv);
+	if (!buf)
+		return 0;
+
 	if (ntohs(eth->et_protlen) == PROT_ARP) {
 		struct arp_hdr *arp = packet + ETHER_HDR_SIZE;
 
@@ -88,14 +154,13 @@ static int sb_eth_send(struct udevice *dev, void *packet, int length)
 			/* store this as the assumed IP of the fake host */
 			priv->fake_host_ipaddr = net_read_ip(&arp->ar_tpa);
 			/* Formulate a fake response */
-			eth_recv = (void *)priv->recv_packet_buffer;
+			eth_recv = (void *)buf;
 			memcpy(eth_recv->et_dest, eth->et_src, ARP_HLEN);
 			memcpy(eth_recv->et_src, priv->fake_host_hwaddr,
 			       ARP_HLEN);
 			eth_recv->et_protlen = htons(PROT_ARP);
 
-			arp_recv = (void *)priv->recv_packet_buffer +
-				ETHER_HDR_SIZE;
+			arp_recv = (void *)buf + ETHER_HDR_SIZE;
 			arp_recv->ar_hrd = htons(ARP_ETHER);
 			arp_recv->ar_pro = htons(PROT_IP);
 			arp_recv->ar_hln = ARP_HLEN;
@@ -107,8 +172,7 @@ static int sb_eth_send(struct udevice *dev, void *packet, int length)
 			memcpy(&arp_recv->ar_tha, &arp->ar_sha, ARP_HLEN);
 			net_copy_ip(&arp_recv->ar_tpa, &arp->ar_spa);
 
-			priv->recv_packet_length = ETHER_HDR_SIZE +
-				ARP_HDR_SIZE;
+			sb_eth_recv_push(priv, ETHER_HDR_SIZE + ARP_HDR_SIZE);
 		}
 	} else if (ntohs(eth->et_protlen) == PROT_IP) {
 		struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
@@ -122,11 +186,9 @@ static int sb_eth_send(struct udevice *dev, void *packet, int length)
 				struct icmp_hdr *icmpr;
 
 				/* reply to the ping */
-				memcpy(priv->recv_packet_buffer, packet,
-				       length);
-				eth_recv = (void *)priv->recv_packet_buffer;
-				ipr = (void *)priv->recv_packet_buffer +
-					ETHER_HDR_SIZE;
+				memcpy(buf, packet, length);
+				eth_recv = (void *)buf;
+				ipr = (void *)buf + ETHER_HDR_SIZE;
 				icmpr = (struct icmp_hdr *)&ipr->udp_src;
 				memcpy(eth_recv->et_dest, eth->et_src,
 				       ARP_HLEN);
@@ -134,9 +196,9 @@ static int sb_eth_send(struct udevice *dev, void *packet, int length)
 				       ARP_HLEN);
 				ipr->ip_sum = 0;
 				ipr->ip_off = 0;
+				/* reply from the address pinged */
 				net_copy_ip((void *)&ipr->ip_dst, &ip->ip_src);
-				net_write_ip((void *)&ipr->ip_src,
-					     priv->fake_host_ipaddr);
+				net_copy_ip((void *)&ipr->ip_src, &ip->ip_dst);
 				ipr->ip_sum = compute_ip_checksum(ipr,
 					IP_HDR_SIZE);
 
@@ -145,7 +207,7 @@ static int sb_eth_send(struct udevice *dev, void *packet, int length)
 				icmpr->checksum = compute_ip_checksum(icmpr,
 					ICMP_HDR_SIZE);
 
-				priv->recv_packet_length = length;
+				sb_eth_recv_push(priv, length);
 			}
 		}
 	}
@@ -162,13 +224,22 @@ static int sb_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 		skip_timeout = false;
 	}
 
-	if (priv->recv_packet_length) {
-		int lcl_recv_packet_length = priv->recv_packet_length;
+	/* The packet returned last time is finished with now */
+	if (priv->recv_busy) {
+		priv->recv_head = (priv->recv_head + 1) %
+			SANDBOX_ETH_RECV_QUEUE;
+		priv->recv_count--;
+		priv->recv_busy = false;
+	}
+
+	if (priv->recv_count) {
+		int lcl_recv_packet_length =
+			priv->recv_packet_length[priv->recv_head];
 
 		debug("eth_sandbox: received packet %d\n",
-		      priv->recv_packet_length);
-		priv->recv_packet_length = 0;
-		*packetp = priv->recv_packet_buffer;
+		      lcl_recv_packet_length);
+		priv->recv_busy = true;
+		*packetp = priv->recv_packet_buffer[priv->recv_head];
 		return lcl_recv_packet_length;
 	}
 	return 0;
@@ -10,6 +10,8 @@
 #include <console.h>
 #include <dm.h>
 #include <dm/uclass-internal.h>
+#include <malloc.h>
+#include <memalign.h>
 #include <usb.h>
 #include <linux/io.h>
 #include <mach/usb.h>
@@ -26,10 +28,26 @@ DECLARE_GLOBAL_DATA_PTR;
 #define	FULL_MAX_PKT_SIZE_EP1		64		/* bulk */
 #define	FULL_MAX_PKT_SIZE_EP2		64		/* bulk */
 
+/* FIFO sizes are in 32-bit words */
 #define RX_FIFO_SIZE			512
-#define NPTX_FIFO_START_ADDR		RX_FIFO_SIZE
 #define NPTX_FIFO_SIZE			512
-#define PTX_FIFO_SIZE			512
+
+/*
+ * FIFO layout in DMA mode: two bulk IN packets of transmit FIFO, a minimal
+ * periodic FIFO as no periodic endpoint is used, and the rest of the FIFO
+ * RAM to receive, so that bulk OUT packets keep flowing while the DMA is
+ * waiting for the bus.
+ */
+#define DMA_NPTX_FIFO_SIZE		(2 * HIGH_MAX_PKT_SIZE_EP1 / 4)
+#define DMA_PTX_FIFO_SIZE		16
+#define DMA_RX_FIFO_MIN_SIZE		RX_FIFO_SIZE
+
+/* bulk OUT packets received per DMA transfer, at most 1023 */
+#define DMA_CHUNK_PKTS			512
+
+/* size of each of the two buffers bulk OUT data is received into */
+#define DMA_RX_BUF_SIZE			ALIGN(HIGH_MAX_PKT_SIZE_EP2 * \
+					      DMA_CHUNK_PKTS, ARCH_DMA_MINALIGN)
 
 #define	DEVICE_DESCRIPTOR_SIZE		(18)
 #define	CONFIG_DESCRIPTOR_SIZE		(9 + 9 + 7 + 7)
@@ -285,6 +303,12 @@ struct nx_usb_otg_reg {
 #define AHB_MASTER_IDLE			(1u<<31)
 #define CORE_SOFT_RESET			(0x1<<0)
 
+/* NX_OTG_GHWCFG3 */
+#define DFIFO_DEPTH(x)			((x)>>16)
+
+/* NX_OTG_DOEPTSIZn */
+#define DEPTSIZ_XFER_SIZE_MASK		(0x7ffff)
+
 /* NX_OTG_GINTSTS/NX_OTG_GINTMSK core interrupt register */
 #define INT_RESUME			(1u<<31)
 #define INT_DISCONN			(0x1<<29)
@@ -600,6 +624,12 @@ struct nx_usbdown_priv {
 	void __iomem *reg_ecid;
 	struct nx_usbboot_status ustatus;
 	struct nx_otg_phy phy;
+	bool dma;			/* core in DMA mode, else slave mode */
+	u8 *setup_buf;			/* DMA: setup packets received */
+	u8 *in_buf;			/* DMA: IN data to send */
+	u8 *rx_buf[2];			/* DMA: bulk OUT ping-pong buffers */
+	int rx_cur;			/* DMA: buffer being received into */
+	u32 dma_len;			/* DMA: size of the bulk OUT transfer */
 };
 
 static void nx_usb_get_usbid(void __iomem *ecid, u16 *vid, u16 *pid)
@@ -637,22 +667,121 @@ static void nx_usb_read_out_fifo(struct nx_usb_otg_reg *reg_otg,
 		dwbuf[i] = readl(&reg_otg->epfifo[ep][0]);
 }
 
-static void nx_usb_ep0_int_hndlr(struct nx_usbdown_priv *priv)
+/* Send @num bytes on IN endpoint @ep, enabling it with @ctl */
+static void nx_usb_ep_in(struct nx_usbdown_priv *priv, u32 ep,
+			 const void *buf, s32 num, u32 ctl)
+{
+	struct nx_usb_otg_reg *reg_otg = priv->reg_otg;
+
+	writel((1<<19)|(num<<0), &reg_otg->dcsr.depir[ep].dieptsiz);
+	if (priv->dma) {
+		memcpy(priv->in_buf, buf, num);
+		flush_dcache_range((ulong)priv->in_buf,
+				   (ulong)priv->in_buf +
+				   ALIGN(num, ARCH_DMA_MINALIGN));
+		writel((u32)(ulong)priv->in_buf,
+		       &reg_otg->dcsr.depir[ep].diepdma);
+		writel(ctl, &reg_otg->dcsr.depir[ep].diepctl);
+	} else {
+		writel(ctl, &reg_otg->dcsr.depir[ep].diepctl);
+		nx_usb_write_in_fifo(reg_otg, ep, (u8 *)buf, num);
+	}
+}
+
+/* DMA: get ready for the next setup packet on the control endpoint */
+static void nx_usb_ep0_out_start(struct nx_usbdown_priv *priv)
+{
+	struct nx_usb_otg_reg *reg_otg = priv->reg_otg;
+
+	writel((1<<29)|(1<<19)|(8<<0),
+	       &reg_otg->dcsr.depor[CONTROL_EP].doeptsiz);
+	invalidate_dcache_range((ulong)priv->setup_buf,
+				(ulong)priv->setup_buf + ARCH_DMA_MINALIGN);
+	writel((u32)(ulong)priv->setup_buf,
+	       &reg_otg->dcsr.depor[CONTROL_EP].doepdma);
+	/*ep0 enable, clear nak */
+	writel(DEPCTL_EPENA|DEPCTL_CNAK,
+	       &reg_otg->dcsr.depor[CONTROL_EP].doepctl);
+}
+
+static u32 nx_usb_dma_chunk(struct nx_usbboot_status *ustatus, s32 remain)
+{
+	u32 mps = ustatus->bulkout_max_pktsize;
+
+	if (remain <= 0)
+		return 0;
+
+	return min_t(u32, ALIGN(remain, mps), mps * DMA_CHUNK_PKTS);
+}
+
+/* DMA: receive the next chunk of the download into the current buffer */
+static void nx_usb_bulkout_dma_start(struct nx_usbdown_priv *priv)
 {
 	struct nx_usbboot_status *ustatus = &priv->ustatus;
 	struct nx_usb_otg_reg *reg_otg = priv->reg_otg;
-	struct nx_setup_packet *setup_packet;
-	u32 buf[2];
+	u32 mps = ustatus->bulkout_max_pktsize;
+	u32 len = nx_usb_dma_chunk(ustatus, ustatus->rx_size);
+	ulong buf = (ulong)priv->rx_buf[priv->rx_cur];
+
+	priv->dma_len = len;
+	invalidate_dcache_range(buf, buf + ALIGN(len, ARCH_DMA_MINALIGN));
+	writel((len / mps)<<19 | len<<0,
+	       &reg_otg->dcsr.depor[BULK_OUT_EP].doeptsiz);
+	writel((u32)buf, &reg_otg->dcsr.depor[BULK_OUT_EP].doepdma);
+	/* ep2 enable, clear nak, bulk, usb active, max pkt */
+	writel(DEPCTL_EPENA|DEPCTL_CNAK|DEPCTL_BULK_TYPE|DEPCTL_USBACTEP|
+	       mps<<0, &reg_otg->dcsr.depor[BULK_OUT_EP].doepctl);
+}
+
+/*
+ * DMA: a chunk is complete. The next chunk is received into the other
+ * buffer while this one is copied out to the download address.
+ */
+static void nx_usb_bulkout_dma_done(struct nx_usbdown_priv *priv)
+{
+	struct nx_usbboot_status *ustatus = &priv->ustatus;
+	struct nx_usb_otg_reg *reg_otg = priv->reg_otg;
+	u32 left, received, len, inval;
+	ulong buf;
+
+	left = readl(&reg_otg->dcsr.depor[BULK_OUT_EP].doeptsiz) &
+		DEPTSIZ_XFER_SIZE_MASK;
+	received = priv->dma_len - left;
+	len = min_t(u32, received, ustatus->rx_size);
+	buf = (ulong)priv->rx_buf[priv->rx_cur];
+
+	ustatus->rx_size -= len;
+	priv->rx_cur ^= 1;
+
+	/* A short packet ends the download early */
+	if (ustatus->rx_size > 0 && !left) {
+		nx_usb_bulkout_dma_start(priv);
+	} else {
+		debug("Download completed!\n");
+		ustatus->downloading = false;
+	}
+
+	inval = min_t(u32, ALIGN(received, ARCH_DMA_MINALIGN),
+		      DMA_RX_BUF_SIZE);
+	invalidate_dcache_range(buf, buf + inval);
+	memcpy(ustatus->rx_buf_addr, (void *)buf, len);
+	ustatus->rx_buf_addr += len;
+}
+
+static void nx_usb_ep0_int_hndlr(struct nx_usbdown_priv *priv,
+				 const u32 *buf)
+{
+	struct nx_usbboot_status *ustatus = &priv->ustatus;
+	struct nx_usb_otg_reg *reg_otg = priv->reg_otg;
+	const struct nx_setup_packet *setup_packet;
+	u32 val;
 	u16 addr;
 
-	setup_packet = (struct nx_setup_packet *)buf;
+	setup_packet = (const struct nx_setup_packet *)buf;
 	debug("Event EP0\n");
 	dmb();
 
 	if (ustatus->ep0_state == EP0_STATE_INIT) {
-		buf[0] = readl(&reg_otg->epfifo[CONTROL_EP][0]);
-		buf[1] = readl(&reg_otg->epfifo[CONTROL_EP][0]);
-
 		debug("Req: %x  %x %d %x %d\n",
 		      setup_packet->requesttype,
 		      setup_packet->request,
@@ -685,13 +814,10 @@ static void nx_usb_ep0_int_hndlr(struct nx_usbdown_priv *priv)
 
 		case STANDARD_GET_CONFIGURATION:
 			debug("STANDARD_GET_CONFIGURATION\n");
-			writel((1<<19)|(1<<0),
-			       &reg_otg->dcsr.depir[CONTROL_EP].dieptsiz);
 			/*ep0 enable, clear nak, next ep0, 8byte */
-			writel(EPEN_CNAK_EP0_8,
-			       &reg_otg->dcsr.depir[CONTROL_EP].diepctl);
-			writel(ustatus->cur_config,
-			       &reg_otg->epfifo[CONTROL_EP][0]);
+			val = ustatus->cur_config;
+			nx_usb_ep_in(priv, CONTROL_EP, &val, 1,
+				     EPEN_CNAK_EP0_8);
 			ustatus->ep0_state = EP0_STATE_INIT;
 			break;
 
@@ -792,45 +918,31 @@ static void nx_usb_ep0_int_hndlr(struct nx_usbdown_priv *priv)
 static void nx_usb_transfer_ep0(struct nx_usbdown_priv *priv)
 {
 	struct nx_usbboot_status *ustatus = &priv->ustatus;
-	struct nx_usb_otg_reg *reg_otg = priv->reg_otg;
+	u32 ctl, val;
 
 	switch (ustatus->ep0_state) {
 	case EP0_STATE_INIT:
-		writel((1<<19)|(0<<0),
-		       &reg_otg->dcsr.depir[CONTROL_EP].dieptsiz);
 		/*ep0 enable, clear nak, next ep0, 8byte */
-		writel(EPEN_CNAK_EP0_8,
-		       &reg_otg->dcsr.depir[CONTROL_EP].diepctl);
+		nx_usb_ep_in(priv, CONTROL_EP, NULL, 0, EPEN_CNAK_EP0_8);
 		debug("EP0_STATE_INIT\n");
 		break;
 
 	/* GET_DESCRIPTOR:DEVICE */
 	case EP0_STATE_GET_DSCPT:
 		debug("EP0_STATE_GD_DEV_0 :");
-		if (ustatus->speed == USB_HIGH) {
+		if (ustatus->speed == USB_HIGH)
 			/*ep0 enable, clear nak, next ep0, max 64byte */
-			writel(EPEN_CNAK_EP0_64,
-			       &reg_otg->dcsr.depir[CONTROL_EP].diepctl);
-		} else {
-			writel(EPEN_CNAK_EP0_8,
-			       &reg_otg->dcsr.depir[CONTROL_EP].diepctl);
-		}
+			ctl = EPEN_CNAK_EP0_64;
+		else
+			ctl = EPEN_CNAK_EP0_8;
 		if (ustatus->current_fifo_size
 		   >= ustatus->remain_size) {
-			writel((1<<19)|(ustatus->remain_size<<0),
-			       &reg_otg->dcsr.depir[CONTROL_EP].dieptsiz);
-			nx_usb_write_in_fifo(priv->reg_otg,
-					     CONTROL_EP,
-					     ustatus->current_ptr,
-					     ustatus->remain_size);
+			nx_usb_ep_in(priv, CONTROL_EP, ustatus->current_ptr,
+				     ustatus->remain_size, ctl);
 			ustatus->ep0_state = EP0_STATE_INIT;
 		} else {
-			writel((1<<19)|(ustatus->current_fifo_size<<0),
-			       &reg_otg->dcsr.depir[CONTROL_EP].dieptsiz);
-			nx_usb_write_in_fifo(priv->reg_otg,
-					     CONTROL_EP,
-					     ustatus->current_ptr,
-					     ustatus->current_fifo_size);
+			nx_usb_ep_in(priv, CONTROL_EP, ustatus->current_ptr,
+				     ustatus->current_fifo_size, ctl);
 			ustatus->remain_size -=
 				ustatus->current_fifo_size;
 			ustatus->current_ptr +=
@@ -844,19 +956,13 @@ static void nx_usb_transfer_ep0(struct nx_usbdown_priv *priv)
 		debug("EP0_STATE_INTERFACE_GET\n");
 		debug("EP0_STATE_GET_STATUS\n");
 
-		writel((1<<19)|(1<<0),
-		       &reg_otg->dcsr.depir[CONTROL_EP].dieptsiz);
-		writel(EPEN_CNAK_EP0_8,
-		       &reg_otg->dcsr.depir[CONTROL_EP].diepctl);
-
 		if (ustatus->ep0_state == EP0_STATE_GET_INTERFACE)
-			writel(ustatus->cur_interface,
-			       &reg_otg->epfifo[CONTROL_EP][0]);
+			val = ustatus->cur_interface;
 		else if (ustatus->ep0_state == EP0_STATE_GET_CONFIG)
-			writel(ustatus->cur_config,
-			       &reg_otg->epfifo[CONTROL_EP][0]);
+			val = ustatus->cur_config;
 		else
-			writel(0, &reg_otg->epfifo[CONTROL_EP][0]);
+			val = 0;
+		nx_usb_ep_in(priv, CONTROL_EP, &val, 1, EPEN_CNAK_EP0_8);
 		ustatus->ep0_state = EP0_STATE_INIT;
 		break;
 
@@ -880,33 +986,21 @@ static void nx_usb_int_bulkin(struct nx_usbdown_priv *priv)
 			       ustatus->up_addr)));
 
 	if (remain_cnt > ustatus->bulkin_max_pktsize) {
-		writel((1<<19) | (ustatus->bulkin_max_pktsize<<0),
-		       &reg_otg->dcsr.depir[BULK_IN_EP].dieptsiz);
-
 		/* ep1 enable, clear nak, bulk, usb active,
 		   next ep2, max pkt 64 */
-		writel(1u<<31 | 1<<26 | 2<<18 | 1<<15 |
-			ustatus->bulkin_max_pktsize<<0,
-		       &reg_otg->dcsr.depir[BULK_IN_EP].diepctl);
-
-		nx_usb_write_in_fifo(priv->reg_otg,
-				     BULK_IN_EP, bulkin_buf,
-				     ustatus->bulkin_max_pktsize);
+		nx_usb_ep_in(priv, BULK_IN_EP, bulkin_buf,
+			     ustatus->bulkin_max_pktsize,
+			     1u<<31 | 1<<26 | 2<<18 | 1<<15 |
+			     ustatus->bulkin_max_pktsize<<0);
 
 		ustatus->up_ptr += ustatus->bulkin_max_pktsize;
 
 	} else if (remain_cnt > 0) {
-		writel((1<<19)|(remain_cnt<<0),
-		       &reg_otg->dcsr.depir[BULK_IN_EP].dieptsiz);
-
 		/* ep1 enable, clear nak, bulk, usb active,
 		  next ep2, max pkt 64 */
-		writel(1u<<31 | 1<<26 | 2<<18 | 1<<15 |
-			ustatus->bulkin_max_pktsize<<0,
-		       &reg_otg->dcsr.depir[BULK_IN_EP].diepctl);
-
-		nx_usb_write_in_fifo(priv->reg_otg,
-				     BULK_IN_EP, bulkin_buf, remain_cnt);
+		nx_usb_ep_in(priv, BULK_IN_EP, bulkin_buf, remain_cnt,
+			     1u<<31 | 1<<26 | 2<<18 | 1<<15 |
+			     ustatus->bulkin_max_pktsize<<0);
 
 		ustatus->up_ptr += remain_cnt;
 
@@ -945,6 +1039,31 @@ static void nx_usb_int_bulkout(struct nx_usbdown_priv *priv,
 	       &reg_otg->dcsr.depor[BULK_OUT_EP].doepctl);
 }
 
+static void nx_usb_fifo_init(struct nx_usbdown_priv *priv)
+{
+	struct nx_usb_otg_reg *reg_otg = priv->reg_otg;
+	u32 depth = DFIFO_DEPTH(readl(&reg_otg->gcsr.ghwcfg3));
+	u32 rx_size = RX_FIFO_SIZE, nptx_size = NPTX_FIFO_SIZE;
+
+	if (priv->dma && depth >= DMA_RX_FIFO_MIN_SIZE +
+	    DMA_NPTX_FIFO_SIZE + DMA_PTX_FIFO_SIZE) {
+		nptx_size = DMA_NPTX_FIFO_SIZE;
+		rx_size = depth - nptx_size - DMA_PTX_FIFO_SIZE;
+
+		/* Periodic Tx FIFO Size */
+		writel(DMA_PTX_FIFO_SIZE<<16 | (rx_size + nptx_size)<<0,
+		       &reg_otg->gcsr.dieptxf[0]);
+	}
+	debug("%s: fifo %u words: rx %u nptx %u\n", __func__, depth,
+	      rx_size, nptx_size);
+
+	/* Rx FIFO Size */
+	writel(rx_size, &reg_otg->gcsr.grxfsiz);
+
+	/* Non Periodic Tx FIFO Size */
+	writel(nptx_size<<16 | rx_size<<0, &reg_otg->gcsr.gnptxfsiz);
+}
+
 static void nx_usb_reset(struct nx_usbdown_priv *priv)
 {
 	struct nx_usbboot_status *ustatus = &priv->ustatus;
@@ -965,19 +1084,18 @@ static void nx_usb_reset(struct nx_usbdown_priv *priv)
 	writel(INTKN_TXFEMP|NON_ISO_IN_EP_TIMEOUT|AHB_ERROR|TRANSFER_DONE,
 	       &reg_otg->dcsr.diepmsk);
 
-	/* Rx FIFO Size */
-	writel(RX_FIFO_SIZE, &reg_otg->gcsr.grxfsiz);
-
-
-	/* Non Periodic Tx FIFO Size */
-	writel(NPTX_FIFO_SIZE<<16 | NPTX_FIFO_START_ADDR<<0,
-	       &reg_otg->gcsr.gnptxfsiz);
+	nx_usb_fifo_init(priv);
 
-	/* clear all out ep nak */
-	for (i = 0; i < 16; i++)
-		writel(readl(&reg_otg->dcsr.depor[i].doepctl) |
-		       (DEPCTL_EPENA|DEPCTL_CNAK),
-		       &reg_otg->dcsr.depor[i].doepctl);
+	if (priv->dma) {
+		/* other endpoints are enabled once configured */
+		nx_usb_ep0_out_start(priv);
+	} else {
+		/* clear all out ep nak */
+		for (i = 0; i < 16; i++)
+			writel(readl(&reg_otg->dcsr.depor[i].doepctl) |
+			       (DEPCTL_EPENA|DEPCTL_CNAK),
+			       &reg_otg->dcsr.depor[i].doepctl);
+	}
 
 	/*clear device address */
 	writel(readl(&reg_otg->dcsr.dcfg) & ~(0x7F<<4),
@@ -1043,8 +1161,11 @@ static bool nx_usb_set_init(struct nx_usbdown_priv *priv)
 		writel(((1<<26)|(CONTROL_EP<<11)|(0<<0)),
 		       &reg_otg->dcsr.depir[CONTROL_EP].diepctl);
 		/*ep0 enable, clear nak */
-		writel((1u<<31)|(1<<26)|(0<<0),
-		       &reg_otg->dcsr.depor[CONTROL_EP].doepctl);
+		if (priv->dma)
+			nx_usb_ep0_out_start(priv);
+		else
+			writel((1u<<31)|(1<<26)|(0<<0),
+			       &reg_otg->dcsr.depor[CONTROL_EP].doepctl);
 	} else {
 		ustatus->ctrl_max_pktsize = FULL_MAX_PKT_SIZE_EP0;
 		ustatus->bulkin_max_pktsize = FULL_MAX_PKT_SIZE_EP1;
@@ -1056,26 +1177,46 @@ static bool nx_usb_set_init(struct nx_usbdown_priv *priv)
 		writel(((1<<26)|(CONTROL_EP<<11)|(3<<0)),
 		       &reg_otg->dcsr.depir[CONTROL_EP].diepctl);
 		/*ep0 enable, clear nak */
-		writel((1u<<31)|(1<<26)|(3<<0),
-		       &reg_otg->dcsr.depor[CONTROL_EP].doepctl);
+		if (priv->dma)
+			nx_usb_ep0_out_start(priv);
+		else
+			writel((1u<<31)|(1<<26)|(3<<0),
+			       &reg_otg->dcsr.depor[CONTROL_EP].doepctl);
 	}
 
 	/* set_opmode */
-	writel(INT_RESUME|INT_OUT_EP|INT_IN_EP|INT_ENUMDONE|
-	       INT_RESET|INT_SUSPEND|INT_RX_FIFO_NOT_EMPTY,
-	       &reg_otg->gcsr.gintmsk);
+	if (priv->dma) {
+		writel(INT_RESUME|INT_OUT_EP|INT_IN_EP|INT_ENUMDONE|
+		       INT_RESET|INT_SUSPEND, &reg_otg->gcsr.gintmsk);
 
-	writel(MODE_SLAVE|BURST_SINGLE|GBL_INT_UNMASK,
-	       &reg_otg->gcsr.gahbcfg);
+		writel(MODE_DMA|BURST_INCR16|GBL_INT_UNMASK,
+		       &reg_otg->gcsr.gahbcfg);
 
-	writel((1<<19)|(ustatus->bulkout_max_pktsize<<0),
-	       &reg_otg->dcsr.depor[BULK_OUT_EP].doeptsiz);
+		writel((1<<19)|(0<<0),
+		       &reg_otg->dcsr.depor[BULK_IN_EP].doeptsiz);
 
-	writel((1<<19)|(0<<0), &reg_otg->dcsr.depor[BULK_IN_EP].doeptsiz);
+		priv->rx_cur = 0;
+		nx_usb_bulkout_dma_start(priv);
+	} else {
+		writel(INT_RESUME|INT_OUT_EP|INT_IN_EP|INT_ENUMDONE|
+		       INT_RESET|INT_SUSPEND|INT_RX_FIFO_NOT_EMPTY,
+		       &reg_otg->gcsr.gintmsk);
 
-	/* bulk out ep enable, clear nak, bulk, usb active, next ep2, max pkt */
-	writel(1u<<31|1<<26|2<<18|1<<15|ustatus->bulkout_max_pktsize<<0,
-	       &reg_otg->dcsr.depor[BULK_OUT_EP].doepctl);
+		writel(MODE_SLAVE|BURST_SINGLE|GBL_INT_UNMASK,
+		       &reg_otg->gcsr.gahbcfg);
+
+		writel((1<<19)|(ustatus->bulkout_max_pktsize<<0),
+		       &reg_otg->dcsr.depor[BULK_OUT_EP].doeptsiz);
+
+		writel((1<<19)|(0<<0),
+		       &reg_otg->dcsr.depor[BULK_IN_EP].doeptsiz);
+
+		/* bulk out ep enable, clear nak, bulk, usb active, next ep2,
+		   max pkt */
+		writel(1u<<31|1<<26|2<<18|1<<15|
+		       ustatus->bulkout_max_pktsize<<0,
+		       &reg_otg->dcsr.depor[BULK_OUT_EP].doepctl);
+	}
 
 	/* bulk in ep enable, clear nak, bulk, usb active, next ep1, max pkt */
 	writel(0u<<31|1<<26|2<<18|1<<15|ustatus->bulkin_max_pktsize<<0,
@@ -1090,12 +1231,15 @@ static void nx_usb_pkt_receive(struct nx_usbdown_priv *priv)
 {
 	struct nx_usb_otg_reg *reg_otg = priv->reg_otg;
 	u32 rx_status, fifo_cnt_byte;
+	u32 buf[2];
 
 	rx_status = readl(&reg_otg->gcsr.grxstsp);
 
 	if ((rx_status & (0xf<<17)) == SETUP_PKT_RECEIVED) {
 		debug("SETUP_PKT_RECEIVED\n");
-		nx_usb_ep0_int_hndlr(priv);
+		buf[0] = readl(&reg_otg->epfifo[CONTROL_EP][0]);
+		buf[1] = readl(&reg_otg->epfifo[CONTROL_EP][0]);
+		nx_usb_ep0_int_hndlr(priv, buf);
 	} else if ((rx_status & (0xf<<17)) == OUT_PKT_RECEIVED) {
 		fifo_cnt_byte = (rx_status & 0x7ff0)>>4;
 		debug("OUT_PKT_RECEIVED\n");
@@ -1151,14 +1295,28 @@ static void nx_usb_transfer(struct nx_usbdown_priv *priv)
 		ep_int_status =
 			readl(&reg_otg->dcsr.depor[CONTROL_EP].doepint);
 
-		writel((1<<29)|(1<<19)|(8<<0),
-		       &reg_otg->dcsr.depor[CONTROL_EP].doeptsiz);
-		/*ep0 enable, clear nak */
-		writel(1u<<31|1<<26,
-		       &reg_otg->dcsr.depor[CONTROL_EP].doepctl);
-		/* Interrupt Clear */
-		writel(ep_int_status,
-		       &reg_otg->dcsr.depor[CONTROL_EP].doepint);
+		if (priv->dma) {
+			/* Interrupt Clear */
+			writel(ep_int_status,
+			       &reg_otg->dcsr.depor[CONTROL_EP].doepint);
+			if (ep_int_status & CTRL_OUT_EP_SETUP_PHASE_DONE) {
+				invalidate_dcache_range((ulong)priv->setup_buf,
+					(ulong)priv->setup_buf +
+					ARCH_DMA_MINALIGN);
+				nx_usb_ep0_int_hndlr(priv,
+					(u32 *)priv->setup_buf);
+			}
+			nx_usb_ep0_out_start(priv);
+		} else {
+			writel((1<<29)|(1<<19)|(8<<0),
+			       &reg_otg->dcsr.depor[CONTROL_EP].doeptsiz);
+			/*ep0 enable, clear nak */
+			writel(1u<<31|1<<26,
+			       &reg_otg->dcsr.depor[CONTROL_EP].doepctl);
+			/* Interrupt Clear */
+			writel(ep_int_status,
+			       &reg_otg->dcsr.depor[CONTROL_EP].doepint);
+		}
 	}
 
 	if (ep_int & (1<<BULK_IN_EP)) {
@@ -1179,6 +1337,9 @@ static void nx_usb_transfer(struct nx_usbdown_priv *priv)
 		/* Interrupt Clear */
 		writel(ep_int_status,
 		       &reg_otg->dcsr.depor[BULK_OUT_EP].doepint);
+
+		if (priv->dma && (ep_int_status & TRANSFER_DONE))
+			nx_usb_bulkout_dma_done(priv);
 	}
 }
 
@@ -1212,7 +1373,7 @@ static void nx_udc_int_hndlr(struct nx_usbdown_priv *priv)
 	if (int_status & INT_SUSPEND)
 		debug("INT_SUSPEND\n");
 
-	if (int_status & INT_RX_FIFO_NOT_EMPTY) {
+	if (!priv->dma && (int_status & INT_RX_FIFO_NOT_EMPTY)) {
 		debug("INT_RX_FIFO_NOT_EMPTY\n");
 		/* Read only register field */
 
@@ -1288,10 +1449,14 @@ static bool nx_usb_down(struct udevice *dev, ulong buffer)
 	struct nx_usbboot_status *ustatus = &priv->ustatus;
 	struct nx_usb_otg_reg *reg_otg = priv->reg_otg;
 	unsigned int *nsih = (unsigned int *)ustatus->rx_buf_addr;
+	ulong start, ms, kbps;
+	u32 size;
 
 	ustatus->rx_buf_addr = (u8 *)buffer;
 	nsih = (unsigned int *)buffer;
 
+	priv->dma = IS_ENABLED(CONFIG_USB_GADGET_DWC2_NEXELL_DOWNLOADER_DMA);
+
 	nx_otg_phy_init(&priv->phy);
 
 	/* usb core soft reset */
@@ -1305,8 +1470,12 @@ static bool nx_usb_down(struct udevice *dev, ulong buffer)
 	dmb();
 
 	/* init_core */
-	writel(PTXFE_HALF|NPTXFE_HALF|MODE_SLAVE|
-		BURST_SINGLE|GBL_INT_UNMASK, &reg_otg->gcsr.gahbcfg);
+	if (priv->dma)
+		writel(MODE_DMA|BURST_INCR16|GBL_INT_UNMASK,
+		       &reg_otg->gcsr.gahbcfg);
+	else
+		writel(PTXFE_HALF|NPTXFE_HALF|MODE_SLAVE|
+			BURST_SINGLE|GBL_INT_UNMASK, &reg_otg->gcsr.gahbcfg);
 	writel(0<<15		/* PHY Low Power Clock sel */
 		|1<<14		/* Non-Periodic TxFIFO Rewind Enable */
 		|5<<10		/* Turnaround time */
@@ -1336,7 +1505,8 @@ static bool nx_usb_down(struct udevice *dev, ulong buffer)
 							0:high speed] */
 		writel(INT_RESUME|INT_OUT_EP|INT_IN_EP|
 			INT_ENUMDONE|INT_RESET|INT_SUSPEND|
-			INT_RX_FIFO_NOT_EMPTY, &reg_otg->gcsr.gintmsk);
+			(priv->dma ? 0 : INT_RX_FIFO_NOT_EMPTY),
+		       &reg_otg->gcsr.gintmsk);
 		udelay(10);
 	}
 	dmb();
@@ -1366,11 +1536,18 @@ static bool nx_usb_down(struct udevice *dev, ulong buffer)
 
 	ustatus->rx_buf_addr -= 512;
 	ustatus->rx_size = nsih[17];
+	size = ustatus->rx_size;
 
 	ustatus->downloading = true;
 	printf(" Size  %d(hex : %x)\n", ustatus->rx_size, ustatus->rx_size);
 	dmb();
 
+	start = get_timer(0);
+	if (priv->dma) {
+		priv->rx_cur = 0;
+		nx_usb_bulkout_dma_start(priv);
+	}
+
 	while (ustatus->downloading) {
 		if (ctrlc())
 			goto _exit;
@@ -1383,6 +1560,11 @@ static bool nx_usb_down(struct udevice *dev, ulong buffer)
 		}
 	}
 
+	ms = max(get_timer(start), 1UL);
+	kbps = size / ms;	/* bytes per ms is KB/s */
+	printf(" %u bytes in %lu ms, %lu.%02lu MB/s (%s)\n", size, ms,
+	       kbps / 1000, kbps % 1000 / 10, priv->dma ? "dma" : "slave");
+
 _exit:
 	dmb();
 	/* usb core soft reset */
@@ -1422,6 +1604,19 @@ static int nx_usb_probe(struct udevice *dev)
 
 	priv->phy.addr = priv->reg_phy;
 
+	if (IS_ENABLED(CONFIG_USB_GADGET_DWC2_NEXELL_DOWNLOADER_DMA)) {
+		priv->setup_buf = memalign(ARCH_DMA_MINALIGN,
+					   ARCH_DMA_MINALIGN);
+		priv->in_buf = memalign(ARCH_DMA_MINALIGN,
+					ALIGN(HIGH_MAX_PKT_SIZE_EP1,
+					      ARCH_DMA_MINALIGN));
+		priv->rx_buf[0] = memalign(ARCH_DMA_MINALIGN, DMA_RX_BUF_SIZE);
+		priv->rx_buf[1] = memalign(ARCH_DMA_MINALIGN, DMA_RX_BUF_SIZE);
+		if (!priv->setup_buf || !priv->in_buf || !priv->rx_buf[0] ||
+		    !priv->rx_buf[1])
+			return -ENOMEM;
+	}
+
 	debug("%s: otg %p phy %p\n", __func__, priv->reg_otg, priv->reg_phy);
 
 	return 0;
@@ -27,6 +27,11 @@
 #ifdef CONFIG_FASTBOOT_FLASH_NAND_DEV
 #include <fb_nand.h>
 #endif
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+#include <div64.h>
+#include <image-sparse.h>
+#include <image-stream.h>
+#endif
 
 #define FASTBOOT_VERSION		"0.4"
 
@@ -62,6 +67,40 @@ static struct f_fastboot *fastboot_func;
 static unsigned int download_size;
 static unsigned int download_bytes;
 
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+#define STREAM_CHUNK_SIZE	CONFIG_FASTBOOT_STREAM_CHUNK_SIZE
+
+#ifndef CONFIG_FASTBOOT_FLASH_MMC_DEV
+#error "Fastboot streaming needs CONFIG_FASTBOOT_FLASH_MMC_DEV"
+#endif
+
+#if 2 * STREAM_CHUNK_SIZE > CONFIG_FASTBOOT_BUF_SIZE
+#error "Fastboot stream buffers do not fit in CONFIG_FASTBOOT_BUF_SIZE"
+#endif
+
+/*
+ * Streaming download state. Once armed with "oem stream:<partition>", the
+ * next download is received straight into two chunk buffers placed at
+ * CONFIG_FASTBOOT_BUF_ADDR. When one is full, the single OUT request is
+ * re-queued on the other one before the full chunk is written to the
+ * partition, so the UDC receives the next chunk while the flash is
+ * written.
+ */
+struct fb_stream {
+	char part[32 + 1];	/* partition the stream was armed for */
+	bool armed;		/* next download is streamed */
+	bool done;		/* streamed download waiting for "flash" */
+	u64 part_bytes;		/* partition size, bounds the download */
+	struct stream_storage info;	/* the partition */
+	struct image_stream img;	/* writer, keeps the first error */
+	void *cmd_buf;		/* OUT request buffer used for commands */
+	ulong start;		/* download start time in ms */
+	u64 written;		/* bytes written to the partition */
+};
+
+static struct fb_stream fb_stream;
+#endif
+
 static struct usb_endpoint_descriptor fs_ep_in = {
 	.bLength            = USB_DT_ENDPOINT_SIZE,
 	.bDescriptorType    = USB_DT_ENDPOINT,
@@ -232,6 +271,13 @@ static void fastboot_disable(struct usb_function *f)
 	usb_ep_disable(f_fb->in_ep);
 
 	if (f_fb->out_req) {
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+		/* a streamed download may have left it on a stream buffer */
+		if (fb_stream.cmd_buf) {
+			f_fb->out_req->buf = fb_stream.cmd_buf;
+			fb_stream.cmd_buf = NULL;
+		}
+#endif
 		free(f_fb->out_req->buf);
 		usb_ep_free_request(f_fb->out_ep, f_fb->out_req);
 		f_fb->out_req = NULL;
@@ -422,8 +468,13 @@ static void cb_getvar(struct usb_ep *ep, struct usb_request *req)
 	} else if (!strcmp_l1("downloadsize", cmd) ||
 		!strcmp_l1("max-download-size", cmd)) {
 		char str_num[12];
+		unsigned int max_size = CONFIG_FASTBOOT_BUF_SIZE;
 
-		sprintf(str_num, "0x%08x", CONFIG_FASTBOOT_BUF_SIZE);
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+		if (fb_stream.armed)
+			max_size = min_t(u64, fb_stream.part_bytes, UINT_MAX);
+#endif
+		sprintf(str_num, "0x%08x", max_size);
 		strncat(response, str_num, chars_left);
 	} else if (!strcmp_l1("serialno", cmd)) {
 		s = getenv("serial#");
@@ -471,13 +522,27 @@ static unsigned int rx_bytes_expected(struct usb_ep *ep)
 }
 
 #define BYTES_PER_DOT	0x20000
+static void rx_progress(unsigned int transfer_size)
+{
+	unsigned int pre_dot_num, now_dot_num;
+
+	pre_dot_num = download_bytes / BYTES_PER_DOT;
+	download_bytes += transfer_size;
+	now_dot_num = download_bytes / BYTES_PER_DOT;
+
+	if (pre_dot_num != now_dot_num) {
+		putc('.');
+		if (!(now_dot_num % 74))
+			putc('\n');
+	}
+}
+
 static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 {
 	char response[FASTBOOT_RESPONSE_LEN];
 	unsigned int transfer_size = download_size - download_bytes;
 	const unsigned char *buffer = req->buf;
 	unsigned int buffer_size = req->actual;
-	unsigned int pre_dot_num, now_dot_num;
 
 	if (req->status != 0) {
 		printf("Bad status: %d\n", req->status);
@@ -490,15 +555,7 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 	memcpy((void *)CONFIG_FASTBOOT_BUF_ADDR + download_bytes,
 	       buffer, transfer_size);
 
-	pre_dot_num = download_bytes / BYTES_PER_DOT;
-	download_bytes += transfer_size;
-	now_dot_num = download_bytes / BYTES_PER_DOT;
-
-	if (pre_dot_num != now_dot_num) {
-		putc('.');
-		if (!(now_dot_num % 74))
-			putc('\n');
-	}
+	rx_progress(transfer_size);
 
 	/* Check if transfer is done */
 	if (download_bytes >= download_size) {
@@ -522,6 +579,147 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 	usb_ep_queue(ep, req, 0);
 }
 
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+static unsigned int stream_bytes_expected(struct usb_ep *ep)
+{
+	unsigned int rx_remain = download_size - download_bytes;
+	unsigned int room, rem;
+
+	image_stream_next(&fb_stream.img, &room);
+	if (rx_remain > room)
+		return room;
+
+	/* Keep OUT transfers a multiple of maxpacket, see rx_bytes_expected */
+	rem = rx_remain % ep->maxpacket;
+	if (rem > 0)
+		rx_remain += ep->maxpacket - rem;
+
+	return rx_remain;
+}
+
+static void rx_handler_dl_stream(struct usb_ep *ep, struct usb_request *req)
+{
+	struct fb_stream *stream = &fb_stream;
+	unsigned int transfer_size = download_size - download_bytes;
+	unsigned int chunk_len;
+	void *chunk;
+	ulong ms;
+	bool done;
+
+	if (req->status != 0) {
+		printf("Bad status: %d\n", req->status);
+		return;
+	}
+
+	if (req->actual < transfer_size)
+		transfer_size = req->actual;
+
+	if (!download_bytes && is_sparse_image(req->buf)) {
+		error("sparse images cannot be streamed");
+		stream->img.err = -EPROTONOSUPPORT;
+	}
+
+	rx_progress(transfer_size);
+	done = download_bytes >= download_size;
+	chunk = image_stream_rx(&stream->img, transfer_size, done, &chunk_len);
+
+	/* Hand the other buffer to the UDC before writing out this chunk */
+	if (done) {
+		download_size = 0;
+		req->buf = stream->cmd_buf;
+		stream->cmd_buf = NULL;
+		req->complete = rx_handler_command;
+		req->length = EP_BUFFER_SIZE;
+	} else {
+		req->buf = image_stream_next(&stream->img, NULL);
+		req->length = stream_bytes_expected(ep);
+	}
+	req->actual = 0;
+	usb_ep_queue(ep, req, 0);
+
+	/* After an error this does nothing, the error is kept for "flash" */
+	if (chunk)
+		image_stream_write(&stream->img, chunk, chunk_len);
+
+	if (!done)
+		return;
+
+	stream->written = image_stream_written(&stream->img);
+	stream->armed = false;
+	stream->done = true;
+
+	ms = max(get_timer(stream->start), 1UL);
+	printf("\nstreaming of %d bytes to '%s' finished in %lu ms (%lu KiB/s)\n",
+	       download_bytes, stream->part, ms,
+	       (ulong)lldiv((u64)download_bytes * 1000, ms * 1024));
+
+	fastboot_tx_write_str("OKAY");
+}
+
+static void stream_download_start(struct usb_ep *ep, struct usb_request *req)
+{
+	struct fb_stream *stream = &fb_stream;
+
+	image_stream_init(&stream->img, &stream->info,
+			  (void *)CONFIG_FASTBOOT_BUF_ADDR, STREAM_CHUNK_SIZE);
+	stream->written = 0;
+	stream->start = get_timer(0);
+	stream->cmd_buf = req->buf;
+
+	req->complete = rx_handler_dl_stream;
+	req->buf = image_stream_next(&stream->img, NULL);
+	req->length = stream_bytes_expected(ep);
+}
+
+static void stream_arm(const char *part)
+{
+	struct fb_stream *stream = &fb_stream;
+	int ret;
+
+	stream->armed = false;
+	stream->done = false;
+
+	if (!*part) {
+		fastboot_tx_write_str("FAILmissing partition name");
+		return;
+	}
+
+	ret = fb_mmc_stream_begin(part, &stream->info);
+	if (ret) {
+		fastboot_tx_write_str("FAILcannot find partition");
+		return;
+	}
+	stream->part_bytes = (u64)stream->info.size * stream->info.blksz;
+
+	strlcpy(stream->part, part, sizeof(stream->part));
+	stream->armed = true;
+	printf("Next download streams to '%s'\n", stream->part);
+	fastboot_tx_write_str("OKAY");
+}
+
+static void stream_flash(const char *part, char *response)
+{
+	struct fb_stream *stream = &fb_stream;
+
+	stream->done = false;
+
+	if (strcmp(part, stream->part)) {
+		error("download was streamed to '%s'", stream->part);
+		strcpy(response, "FAILdownload streamed to other partition");
+	} else if (stream->img.err == -EPROTONOSUPPORT) {
+		strcpy(response, "FAILsparse image cannot be streamed");
+	} else if (stream->img.err == -EFBIG) {
+		strcpy(response, "FAILtoo large for partition");
+	} else if (stream->img.err) {
+		strcpy(response, "FAILfailed writing to device");
+	} else {
+		printf("........ wrote %llu bytes to '%s'\n",
+		       stream->written, part);
+		strcpy(response, "OKAY");
+	}
+}
+#endif
+
 static void cb_download(struct usb_ep *ep, struct usb_request *req)
 {
 	char *cmd = req->buf;
@@ -533,6 +731,21 @@ static void cb_download(struct usb_ep *ep, struct usb_request *req)
 
 	printf("Starting download of %d bytes\n", download_size);
 
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+	fb_stream.done = false;
+	if (fb_stream.armed && download_size) {
+		if (download_size > fb_stream.part_bytes) {
+			download_size = 0;
+			strcpy(response, "FAILdata too large");
+		} else {
+			sprintf(response, "DATA%08x", download_size);
+			stream_download_start(ep, req);
+		}
+		fastboot_tx_write_str(response);
+		return;
+	}
+#endif
+
 	if (0 == download_size) {
 		strcpy(response, "FAILdata invalid size");
 	} else if (download_size > CONFIG_FASTBOOT_BUF_SIZE) {
@@ -590,6 +803,14 @@ static void cb_flash(struct usb_ep *ep, struct usb_request *req)
 		return;
 	}
 
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+	if (fb_stream.done) {
+		stream_flash(cmd, response);
+		fastboot_tx_write_str(response);
+		return;
+	}
+#endif
+
 	/* initialize the response buffer */
 	fb_response_str = response;
 
@@ -620,6 +841,14 @@ static void cb_oem(struct usb_ep *ep, struct usb_request *req)
                 else
 			fastboot_tx_write_str("OKAY");
 	} else
+#endif
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+	if (strncmp("stream", cmd + 4, 6) == 0) {
+		cmd += 10;
+		if (*cmd == ':' || *cmd == ' ')
+			cmd++;
+		stream_arm(cmd);
+	} else
 #endif
 	if (strncmp("unlock", cmd + 4, 8) == 0) {
 		fastboot_tx_write_str("FAILnot implemented");
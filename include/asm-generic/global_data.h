@@ -22,6 +22,7 @@
 
 #ifndef __ASSEMBLY__
 #include <membuff.h>
+#include <dm/uclass-id.h>
 #include <linux/list.h>
 
 typedef struct global_data {
@@ -64,12 +65,25 @@ typedef struct global_data {
 	struct udevice	*dm_root;	/* Root instance for Driver Model */
 	struct udevice	*dm_root_f;	/* Pre-relocation root instance */
 	struct list_head uclass_root;	/* Head of core tree */
+#if CONFIG_IS_ENABLED(DM_BIND_INDEX)
+	/* Hash index of drivers by name and compatible string */
+	struct dm_bind_index *dm_bind_index;
+#endif
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	struct uclass *uclass_table[UCLASS_COUNT];	/* uclasses by ID */
+#endif
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+	struct dm_lazy *dm_lazy;	/* Nodes waiting to be bound, or NULL */
+#endif
 #endif
 #ifdef CONFIG_TIMER
 	struct udevice	*timer;		/* Timer instance for Driver Model */
 #endif
 
 	const void *fdt_blob;		/* Our device tree, NULL if none */
+#if CONFIG_IS_ENABLED(OF_LIVE)
+	struct of_live *of_live;	/* Live copy of fdt_blob, or NULL */
+#endif
 	void *new_fdt;			/* Relocated FDT */
 	unsigned long fdt_size;		/* Space reserved for relocated FDT */
 	struct jt_funcs *jt;		/* jump table */
@@ -93,18 +93,25 @@ struct blk_desc {
 /**
  * blkcache_read() - attempt to read a set of blocks from cache
  *
+ * If only some blocks are cached, those at the start and at the end of the
+ * range are still copied to @buf, and the caller only needs to read the
+ * blocks in between from the device.
+ *
  * @param iftype - IF_TYPE_x for type of device
  * @param dev - device index of particular type
  * @param start - starting block number
  * @param blkcnt - number of blocks to read
  * @param blksz - size in bytes of each block
  * @param buf - buffer to contain cached data
+ * @param miss_start - returns the first block still to be read
+ * @param miss_cnt - returns the number of blocks still to be read
  *
- * @return - '1' if block returned from cache, '0' otherwise.
+ * @return - '1' if all blocks returned from cache, '0' otherwise.
  */
 int blkcache_read(int iftype, int dev,
 		  lbaint_t start, lbaint_t blkcnt,
-		  unsigned long blksz, void *buffer);
+		  unsigned long blksz, void *buffer,
+		  lbaint_t *miss_start, lbaint_t *miss_cnt);
 
 /**
  * blkcache_fill() - make data read from a block device available
@@ -134,20 +141,22 @@ void blkcache_invalidate(int iftype, int dev);
 /**
  * blkcache_configure() - configure block cache
  *
- * @param blocks - maximum blocks per entry
- * @param entries - maximum entries in cache
+ * @param blocks - maximum blocks per request to cache
+ * @param size - maximum size of the cache in bytes
  */
-void blkcache_configure(unsigned blocks, unsigned entries);
+void blkcache_configure(unsigned blocks, unsigned long size);
 
 /*
  * statistics of the block cache
  */
 struct block_cache_stats {
 	unsigned hits;
+	unsigned partial; /* requests only partly served */
 	unsigned misses;
-	unsigned entries; /* current entry count */
+	unsigned entries; /* current count of cached blocks */
 	unsigned max_blocks_per_entry;
-	unsigned max_entries;
+	unsigned long size; /* current size in bytes */
+	unsigned long max_size;
 };
 
 /**
@@ -157,12 +166,37 @@ struct block_cache_stats {
  */
 void blkcache_stats(struct block_cache_stats *stats);
 
+/*
+ * statistics of the block cache for one device
+ */
+struct block_cache_dev_stats {
+	int iftype;
+	int devnum;
+	unsigned hits;
+	unsigned partial;
+	unsigned misses;
+	unsigned entries; /* current count of cached blocks */
+};
+
+/**
+ * blkcache_dev_stats() - return statistics of a device and reset
+ *
+ * @param index - index of the device, in the order first cached
+ * @param stats - statistics are copied here
+ *
+ * @return - 0 if OK, -ENOENT if there is no device with this index
+ */
+int blkcache_dev_stats(int index, struct block_cache_dev_stats *stats);
+
 #else
 
 static inline int blkcache_read(int iftype, int dev,
 				lbaint_t start, lbaint_t blkcnt,
-				unsigned long blksz, void *buffer)
+				unsigned long blksz, void *buffer,
+				lbaint_t *miss_start, lbaint_t *miss_cnt)
 {
+	*miss_start = start;
+	*miss_cnt = blkcnt;
 	return 0;
 }
 
@@ -174,6 +208,55 @@ static inline void blkcache_invalidate(int iftype, int dev) {}
 
 #endif
 
+#ifdef CONFIG_BLOCK_READAHEAD
+/**
+ * blkreadahead_read() - attempt to read a set of blocks via read-ahead
+ *
+ * Requests which continue a sequential stream are served from read-ahead
+ * windows, which are fetched in the background. Only devices which support
+ * read_start() are read ahead.
+ *
+ * @desc:	Block device to read from
+ * @start:	Start block number to read (0=first)
+ * @blkcnt:	Number of blocks to read
+ * @buffer:	Destination buffer for data read
+ * @return 1 if the blocks were read, 0 if the caller must read them
+ */
+int blkreadahead_read(struct blk_desc *desc, lbaint_t start, lbaint_t blkcnt,
+		      void *buffer);
+
+/**
+ * blkreadahead_invalidate() - discard read-ahead data of a block device
+ *
+ * Waits for any read still in progress and frees the read-ahead windows.
+ *
+ * @desc:	Block device written to, reinitialised or removed
+ */
+void blkreadahead_invalidate(struct blk_desc *desc);
+
+/* statistics of the read-ahead */
+struct block_readahead_stats {
+	unsigned hits;		/* requests served by read-ahead */
+	unsigned misses;	/* random requests left to the caller */
+	unsigned windows;	/* windows fetched */
+};
+
+/**
+ * blkreadahead_stats() - return statistics and reset
+ *
+ * @stats:	statistics are copied here
+ */
+void blkreadahead_stats(struct block_readahead_stats *stats);
+#else
+static inline int blkreadahead_read(struct blk_desc *desc, lbaint_t start,
+				    lbaint_t blkcnt, void *buffer)
+{
+	return 0;
+}
+
+static inline void blkreadahead_invalidate(struct blk_desc *desc) {}
+#endif
+
 #ifdef CONFIG_BLK
 struct udevice;
 
@@ -235,6 +318,32 @@ struct blk_ops {
 	 * @return 0 if OK, -ve on error
 	 */
 	int (*select_hwpart)(struct udevice *dev, int hwpart);
+
+	/**
+	 * read_start() - start reading from a block device, without waiting
+	 *
+	 * This is optional, and used for read-ahead and blk_dread_stream().
+	 * Once a read is started, the uclass does not call any other
+	 * operation on the device until read_poll() reports that the read is
+	 * complete.
+	 *
+	 * @dev:	Device to read from
+	 * @start:	Start block number to read (0=first)
+	 * @blkcnt:	Number of blocks to read
+	 * @buffer:	Destination buffer for data read
+	 * @return 0 if the read was started, -ve on error
+	 */
+	int (*read_start)(struct udevice *dev, lbaint_t start,
+			  lbaint_t blkcnt, void *buffer);
+
+	/**
+	 * read_poll() - check a read started with read_start()
+	 *
+	 * @dev:	Device being read
+	 * @return 0 if all blocks have been read, -EBUSY if the read is still
+	 * in progress, other -ve on error
+	 */
+	int (*read_poll)(struct udevice *dev);
 };
 
 #define blk_get_ops(dev)	((struct blk_ops *)(dev)->driver->ops)
@@ -252,6 +361,28 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 			 lbaint_t blkcnt);
 
+/**
+ * blk_dread_stream() - read blocks, handing on each chunk as it arrives
+ *
+ * The blocks are read @chunk at a time into @buffer. After each chunk
+ * @consume is called with the number of bytes at the start of @buffer which
+ * have been read so far. If the device supports read_start(), the next chunk
+ * is being read meanwhile, so that processing of the data (for example
+ * decompression) overlaps with the read.
+ *
+ * @desc:	Block device to read from
+ * @start:	Start block number to read (0=first)
+ * @blkcnt:	Number of blocks to read
+ * @chunk:	Number of blocks to read at a time
+ * @buffer:	Destination buffer for data read
+ * @consume:	Called after each chunk, returns -ve to stop the read
+ * @priv:	Passed to @consume
+ * @return 0 if OK, -ve on error
+ */
+int blk_dread_stream(struct blk_desc *desc, lbaint_t start, lbaint_t blkcnt,
+		     lbaint_t chunk, void *buffer,
+		     int (*consume)(void *priv, ulong avail), void *priv);
+
 /**
  * blk_get_device() - Find and probe a block device ready for use
  *
@@ -366,6 +497,7 @@ int blk_select_hwpart(struct udevice *dev, int hwpart);
 
 #else
 #include <errno.h>
+#include <linux/err.h>
 /*
  * These functions should take struct udevice instead of struct blk_desc,
  * but this is convenient for migration to driver model. Add a 'd' prefix
@@ -375,9 +507,13 @@ int blk_select_hwpart(struct udevice *dev, int hwpart);
 static inline ulong blk_dread(struct blk_desc *block_dev, lbaint_t start,
 			      lbaint_t blkcnt, void *buffer)
 {
+	lbaint_t miss, misscnt;
 	ulong blks_read;
+	void *dest;
+
 	if (blkcache_read(block_dev->if_type, block_dev->devnum,
-			  start, blkcnt, block_dev->blksz, buffer))
+			  start, blkcnt, block_dev->blksz, buffer,
+			  &miss, &misscnt))
 		return blkcnt;
 
 	/*
@@ -385,12 +521,15 @@ static inline ulong blk_dread(struct blk_desc *block_dev, lbaint_t start,
 	 * bloats the code slightly (cause some board to fail to build), and
 	 * it would be an error to try an operation that does not exist.
 	 */
-	blks_read = block_dev->block_read(block_dev, start, blkcnt, buffer);
-	if (blks_read == blkcnt)
-		blkcache_fill(block_dev->if_type, block_dev->devnum,
-			      start, blkcnt, block_dev->blksz, buffer);
-
-	return blks_read;
+	dest = buffer + (miss - start) * block_dev->blksz;
+	blks_read = block_dev->block_read(block_dev, miss, misscnt, dest);
+	if (blks_read != misscnt)
+		return IS_ERR_VALUE(blks_read) ? blks_read :
+			miss - start + blks_read;
+	blkcache_fill(block_dev->if_type, block_dev->devnum,
+		      miss, misscnt, block_dev->blksz, dest);
+
+	return blkcnt;
 }
 
 static inline ulong blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
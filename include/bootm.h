@@ -15,6 +15,11 @@
 #define BOOTM_ERR_OVERLAP		(-2)
 #define BOOTM_ERR_UNIMPLEMENTED	(-3)
 
+#ifndef CONFIG_SYS_BOOTM_LEN
+/* use 8MByte as default max gunzip size */
+#define CONFIG_SYS_BOOTM_LEN	0x800000
+#endif
+
 /*
  *  Continue booting an OS image; caller already has:
  *  - copied image header to global variable `header'
@@ -73,4 +78,130 @@ int bootm_decomp_image(int comp, ulong load, ulong image_start, int type,
 		       void *load_buf, void *image_buf, ulong image_len,
 		       uint unc_len, ulong *load_end);
 
+#ifndef USE_HOSTCC
+/**
+ * struct bootm_decomp_stream - an OS image decompressed as it is loaded
+ *
+ * @comp:	Compression algorithm that is used (IH_COMP_...)
+ * @load_buf:	Place to decompress to
+ * @image_buf:	Address to decompress from, filled in by the loader
+ * @unc_len:	Available space for decompression
+ * @avail:	Number of bytes of @image_buf passed on so far
+ * @err:	First error seen, reported by bootm_decomp_stream_end()
+ */
+struct bootm_decomp_stream {
+	int comp;
+	void *load_buf;
+	const void *image_buf;
+	ulong unc_len;
+	ulong avail;
+	int err;
+	union {
+		struct gunzip_stream gz;
+		struct ulz4_stream lz4;
+	};
+};
+
+/**
+ * bootm_decomp_stream_start() - prepare to decompress an image as it loads
+ *
+ * Only algorithms which can work on a partial image are supported: the
+ * caller must load the whole image and use bootm_decomp_image() for the
+ * others.
+ *
+ * @ds:		Stream state to set up
+ * @comp:	Compression algorithm that is used (IH_COMP_...)
+ * @load_buf:	Place to decompress to
+ * @image_buf:	Address the image is being loaded to
+ * @unc_len:	Available space for decompression
+ * @return 0 if OK, -EPROTONOSUPPORT if @comp cannot be streamed, other -ve
+ * on error
+ */
+int bootm_decomp_stream_start(struct bootm_decomp_stream *ds, int comp,
+			      void *load_buf, const void *image_buf,
+			      ulong unc_len);
+
+/**
+ * bootm_decomp_stream_feed() - decompress the part of the image loaded so far
+ *
+ * @ds:		Stream state
+ * @avail:	Number of bytes at the start of the image which are loaded
+ * @return 1 if the end of the compressed data is reached, 0 if more is
+ * needed, -ve on error
+ */
+int bootm_decomp_stream_feed(struct bootm_decomp_stream *ds, ulong avail);
+
+/**
+ * bootm_decomp_stream_end() - finish decompressing a completely loaded image
+ *
+ * @ds:		Stream state
+ * @image_len:	Number of bytes in the image
+ * @load_len:	Returns the number of bytes decompressed
+ * @return 0 if OK, -ve on error (BOOTM_ERR_...)
+ */
+int bootm_decomp_stream_end(struct bootm_decomp_stream *ds, ulong image_len,
+			    ulong *load_len);
+
+#ifdef CONFIG_BLK
+struct blk_desc;
+
+/**
+ * bootm_decomp_blk() - read an OS image, decompressing it as it is read
+ *
+ * The blocks are read into @buf and each part is decompressed while the
+ * next one is being read, if the device supports it.
+ *
+ * @desc:	Block device to read from
+ * @start:	Start block number of the image
+ * @blkcnt:	Number of blocks to read
+ * @buf:	Place to read the blocks to
+ * @offset:	Offset of the compressed data from @buf
+ * @image_len:	Number of bytes of compressed data
+ * @comp:	Compression algorithm that is used (IH_COMP_...)
+ * @type:	OS type (IH_OS_...)
+ * @load_buf:	Place to decompress to
+ * @unc_len:	Available space for decompression
+ * @load_len:	Returns the number of bytes decompressed
+ * @return 0 if OK, -EPROTONOSUPPORT if @comp cannot be streamed (nothing is
+ * read then), -EIO if the read failed, other -ve on error (BOOTM_ERR_...)
+ */
+int bootm_decomp_blk(struct blk_desc *desc, lbaint_t start, lbaint_t blkcnt,
+		     void *buf, ulong offset, ulong image_len, int comp,
+		     int type, void *load_buf, ulong unc_len, ulong *load_len);
+#endif
+
+/**
+ * bootm_decomp_set_loaded() - note an OS image decompressed while loading
+ *
+ * This lets bootm use the decompressed image rather than decompress it
+ * again. The legacy image header before @image_start is kept, so that only
+ * the same image is recognised, but the data is not checked: the caller must
+ * only do this when asked to, as nothing may touch the image or the
+ * decompressed data until bootm.
+ *
+ * @comp:	Compression algorithm that is used (IH_COMP_...)
+ * @load:	Address the image was decompressed to
+ * @image_start	Address of the compressed data
+ * @image_len:	Number of bytes of compressed data
+ * @load_end:	End address of the decompressed data
+ */
+void bootm_decomp_set_loaded(int comp, ulong load, ulong image_start,
+			     ulong image_len, ulong load_end);
+
+/**
+ * bootm_decomp_get_loaded() - check for an OS image decompressed already
+ *
+ * The note left by bootm_decomp_set_loaded() is dropped in any case.
+ *
+ * @comp:	Compression algorithm that is used (IH_COMP_...)
+ * @load:	Destination load address in U-Boot memory
+ * @image_start	Address of the compressed data
+ * @image_len:	Number of bytes of compressed data
+ * @load_end:	Returns the end address of the decompressed data
+ * @return true if the image was noted as decompressed, false if not
+ */
+bool bootm_decomp_get_loaded(int comp, ulong load, ulong image_start,
+			     ulong image_len, ulong *load_end);
+#endif
+
 #endif
@@ -198,6 +198,7 @@ enum bootstage_id {
 	BOOTSTAGE_ID_ACCUM_SCSI,
 	BOOTSTAGE_ID_ACCUM_SPI,
 	BOOTSTAGE_ID_ACCUM_DECOMP,
+	BOOTSTAGE_ID_ACCUM_DM_LAZY,
 	BOOTSTAGE_ID_FPGA_INIT,
 
 	/* a few spare for the user, from here */
@@ -206,6 +207,31 @@ enum bootstage_id {
 	BOOTSTAGE_ID_ALLOC,
 };
 
+/* Kinds of activity timed by CONFIG_BOOTSTAGE_PROFILE */
+enum bootstage_prof_kind {
+	BOOTSTAGE_PROF_INITCALL,	/* an initcall, named by its address */
+	BOOTSTAGE_PROF_PROBE,		/* probe of a device */
+	BOOTSTAGE_PROF_BLK,		/* transfers of a block device */
+	BOOTSTAGE_PROF_COPY,		/* copy of an image to where it runs */
+
+	BOOTSTAGE_PROF_KIND_COUNT,
+};
+
+#define BOOTSTAGE_PROF_NAME_LEN	24
+
+/* Time (and for block devices and copies, traffic) accounted to one activity */
+struct bootstage_prof {
+	uint32_t kind;		/* enum bootstage_prof_kind */
+	uint32_t count;		/* number of times it happened */
+	uint32_t time_us;	/* total time taken */
+	uint32_t blocks;	/* blocks transferred */
+	uint64_t bytes;		/* bytes transferred */
+	char name[BOOTSTAGE_PROF_NAME_LEN];
+};
+
+/* Returned by bootstage_prof_start() when the timer cannot be used yet */
+#define BOOTSTAGE_PROF_NONE	(~0UL)
+
 /*
  * Return the time since boot in microseconds, This is needed for bootstage
  * and should be defined in CPU- or board-specific code. If undefined then
@@ -392,6 +418,67 @@ static inline int bootstage_unstash(void *base, int size)
 }
 #endif /* CONFIG_BOOTSTAGE */
 
+#if defined(CONFIG_BOOTSTAGE_PROFILE) && !defined(CONFIG_SPL_BUILD) && \
+	!defined(USE_HOSTCC)
+/**
+ * Get the start time of an activity to be profiled
+ *
+ * Before the first bootstage mark of a boot phase (pre- or post-relocation)
+ * the timer may not work, so nothing is timed.
+ *
+ * @return current time in microseconds, or BOOTSTAGE_PROF_NONE
+ */
+ulong bootstage_prof_start(void);
+
+/**
+ * Account the time since @start to a profile record
+ *
+ * The record for @kind and @name is created on first use. Names longer
+ * than BOOTSTAGE_PROF_NAME_LEN - 1 are truncated.
+ *
+ * @param kind		Kind of activity (enum bootstage_prof_kind)
+ * @param name		Name of the device or initcall
+ * @param start		Value returned by bootstage_prof_start()
+ * @param blocks	Number of blocks transferred, if any
+ * @param bytes		Number of bytes transferred, if any
+ */
+void bootstage_prof_add(enum bootstage_prof_kind kind, const char *name,
+			ulong start, ulong blocks, uint64_t bytes);
+
+/**
+ * Look up a profile record
+ *
+ * @param kind		Kind of activity (enum bootstage_prof_kind)
+ * @param name		Name of the device or initcall
+ * @param prof		Returns a copy of the record
+ * @return 0 if found, -ENOENT if there is no such record
+ */
+int bootstage_prof_get(enum bootstage_prof_kind kind, const char *name,
+		       struct bootstage_prof *prof);
+
+/**
+ * Drop all profile records
+ *
+ * This is for tests, which need room in the table for their own records.
+ */
+void bootstage_prof_reset(void);
+#else
+static inline ulong bootstage_prof_start(void)
+{
+	return BOOTSTAGE_PROF_NONE;
+}
+
+static inline void bootstage_prof_add(enum bootstage_prof_kind kind,
+				      const char *name, ulong start,
+				      ulong blocks, uint64_t bytes)
+{
+}
+
+static inline void bootstage_prof_reset(void)
+{
+}
+#endif /* CONFIG_BOOTSTAGE_PROFILE */
+
 /* Helper macro for adding a bootstage to a line of code */
 #define BOOTSTAGE_MARKER()	\
 		bootstage_mark_code(__FILE__, __func__, __LINE__)
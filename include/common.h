@@ -800,6 +800,51 @@ int gunzip(void *, int, unsigned char *, unsigned long *);
 int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
 						int stoponerr, int offset);
 
+/**
+ * struct gunzip_stream - state of a gzip image inflated as it arrives
+ *
+ * @zs:		zlib state
+ * @src:	start of the gzip image
+ * @in:		offset in @src of the next byte to inflate, 0 before the
+ *		header is read
+ */
+struct gunzip_stream {
+	struct z_stream_s *zs;
+	const unsigned char *src;
+	unsigned long in;
+	bool done;
+};
+
+/**
+ * gunzip_stream_init() - start inflating a gzip image
+ *
+ * @gs:		stream state to set up
+ * @src:	start of the gzip image, which need not have arrived yet
+ * @dst:	output buffer
+ * @dstlen:	size of the output buffer
+ * @return 0 if OK, -ve on error
+ */
+int gunzip_stream_init(struct gunzip_stream *gs, const unsigned char *src,
+		       void *dst, int dstlen);
+
+/**
+ * gunzip_stream_feed() - inflate the part of a gzip image which has arrived
+ *
+ * @gs:		stream state
+ * @avail:	number of bytes at the start of the image which are available
+ * @return 1 once the end of the deflate stream is reached, 0 if more input
+ * is needed, -ve on error
+ */
+int gunzip_stream_feed(struct gunzip_stream *gs, unsigned long avail);
+
+/**
+ * gunzip_stream_end() - release the state of a gzip stream
+ *
+ * @gs:		stream state
+ * @lenp:	if not NULL, returns the number of bytes inflated
+ */
+void gunzip_stream_end(struct gunzip_stream *gs, unsigned long *lenp);
+
 /**
  * gzwrite progress indicators: defined weak to allow board-specific
  * overrides:
@@ -842,6 +887,47 @@ int gzwrite(unsigned char *src, int len,
 /* lib/lz4_wrapper.c */
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn);
 
+/**
+ * struct ulz4_stream - state of an LZ4 frame decompressed as it arrives
+ *
+ * @src:	start of the frame
+ * @dst:	output buffer
+ * @dstn:	size of the output buffer
+ * @in:		offset in @src of the next block, 0 before the header is read
+ * @out:	bytes written to @dst so far
+ */
+struct ulz4_stream {
+	const void *src;
+	void *dst;
+	size_t dstn;
+	size_t in;
+	size_t out;
+	bool has_block_checksum;
+	bool done;
+};
+
+/**
+ * ulz4_stream_init() - start decompressing an LZ4 frame
+ *
+ * @s:		stream state to set up
+ * @src:	start of the frame, which need not have arrived yet
+ * @dst:	output buffer
+ * @dstn:	size of the output buffer
+ * @return 0
+ */
+int ulz4_stream_init(struct ulz4_stream *s, const void *src, void *dst,
+		     size_t dstn);
+
+/**
+ * ulz4_stream_feed() - decompress the blocks of a frame which have arrived
+ *
+ * @s:		stream state
+ * @avail:	number of bytes at the start of the frame which are available
+ * @return 1 once the end of the frame is reached, 0 if more input is
+ * needed, -ve on error
+ */
+int ulz4_stream_feed(struct ulz4_stream *s, size_t avail);
+
 /* lib/qsort.c */
 void qsort(void *base, size_t nmemb, size_t size,
 	   int(*compar)(const void *, const void *));
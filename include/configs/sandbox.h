@@ -26,6 +26,7 @@
 #endif
 
 #define CONFIG_LMB
+#define CONFIG_BOUNCE_BUFFER
 #define CONFIG_ANDROID_BOOT_IMAGE
 
 #define CONFIG_CMD_PCI
@@ -11,6 +11,9 @@
 #ifndef _DM_DEVICE_INTERNAL_H
 #define _DM_DEVICE_INTERNAL_H
 
+#include <errno.h>
+#include <dm/uclass-id.h>
+
 struct udevice;
 
 /**
@@ -173,4 +176,81 @@ static inline void devres_release_all(struct udevice *dev)
 }
 
 #endif /* ! CONFIG_DEVRES */
+
+/* binding device tree nodes on demand */
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+
+/**
+ * dm_lazy_add() - Put off binding a device tree node, if possible
+ *
+ * @parent: Parent device for the node
+ * @blob: Device tree blob
+ * @offset: Offset of the node
+ * @return true if the node will be bound on demand, false if it must be
+ * bound now
+ */
+bool dm_lazy_add(struct udevice *parent, const void *blob, int offset);
+
+/**
+ * dm_lazy_bind_uclass() - Bind the waiting nodes of a uclass
+ *
+ * @id: Uclass ID
+ * @return 0 if OK, -ve on error (the other nodes are still bound)
+ */
+int dm_lazy_bind_uclass(enum uclass_id id);
+
+/**
+ * dm_lazy_bind_children() - Bind the waiting child nodes of a device
+ *
+ * @parent: Parent device
+ * @return 0 if OK, -ve on error (the other nodes are still bound)
+ */
+int dm_lazy_bind_children(struct udevice *parent);
+
+/**
+ * dm_lazy_bind_node() - Bind a waiting node
+ *
+ * @offset: Offset of the node
+ * @devp: Returns the new device
+ * @return 0 if OK, -ENOENT if the node is not waiting, other -ve on error
+ */
+int dm_lazy_bind_node(int offset, struct udevice **devp);
+
+/**
+ * dm_lazy_drop() - Forget the waiting nodes of a device being unbound
+ *
+ * @parent: Device being unbound
+ */
+void dm_lazy_drop(struct udevice *parent);
+
+#else
+
+static inline bool dm_lazy_add(struct udevice *parent, const void *blob,
+			       int offset)
+{
+	return false;
+}
+
+static inline int dm_lazy_bind_uclass(enum uclass_id id)
+{
+	return 0;
+}
+
+static inline int dm_lazy_bind_children(struct udevice *parent)
+{
+	return 0;
+}
+
+static inline int dm_lazy_bind_node(int offset, struct udevice **devp)
+{
+	*devp = NULL;
+
+	return -ENOENT;
+}
+
+static inline void dm_lazy_drop(struct udevice *parent)
+{
+}
+
+#endif
 #endif
@@ -54,6 +54,9 @@ struct driver_info;
  */
 #define DM_FLAG_ACTIVE_DMA		(1 << 9)
 
+/* Device has child nodes waiting to be bound on demand */
+#define DM_FLAG_LAZY_CHILDREN		(1 << 10)
+
 /*
  * One or multiple of these flags are passed to device_remove() so that
  * a selective device removal as specified by the remove-stage and the
@@ -152,10 +155,15 @@ static inline int dev_of_offset(const struct udevice *dev)
 	return dev->of_offset;
 }
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+/* This keeps the uclass index of device tree offsets up to date */
+void dev_set_of_offset(struct udevice *dev, int of_offset);
+#else
 static inline void dev_set_of_offset(struct udevice *dev, int of_offset)
 {
 	dev->of_offset = of_offset;
 }
+#endif
 
 /**
  * struct udevice_id - Lists the compatible strings supported by a driver
@@ -471,6 +479,22 @@ int device_get_child_by_of_offset(struct udevice *parent, int of_offset,
  */
 int device_get_global_by_of_offset(int of_offset, struct udevice **devp);
 
+/**
+ * device_get_by_driver_info() - Get the device created from a driver_info
+ *
+ * With of-platdata this resolves a phandle reference (see struct
+ * phandle_2_cell) to the device declared for the target node.
+ *
+ * The device is probed to activate it ready for use.
+ *
+ * @info: Information the device was bound from, with U_BOOT_DEVICE()
+ * @devp: Returns pointer to device if found, otherwise this is set to NULL
+ * @return 0 if OK, -ENOENT if no device was bound from @info, other -ve on
+ *	   error
+ */
+int device_get_by_driver_info(const struct driver_info *info,
+			      struct udevice **devp);
+
 /**
  * device_find_first_child() - Find the first child of a device
  *
@@ -23,6 +23,19 @@
  */
 struct driver *lists_driver_lookup_name(const char *name);
 
+/**
+ * lists_driver_lookup_compat() - Return the driver for a compatible string
+ *
+ * If more than one driver lists the string, the first one in the linker
+ * list is returned.
+ *
+ * @compat:	Compatible string to look up
+ * @of_idp:	Returns the driver's of_match entry for the string
+ * @return pointer to driver, or NULL if not found
+ */
+struct driver *lists_driver_lookup_compat(const char *compat,
+					  const struct udevice_id **of_idp);
+
 /**
  * lists_uclass_lookup() - Return uclass_driver based on ID of the class
  * id:		ID of the class
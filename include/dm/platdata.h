@@ -23,13 +23,15 @@
  * @name:	Driver name
  * @platdata:	Driver-specific platform data
  * @platdata_size: Size of platform data structure
- * @flags:	Platform data flags (DM_FLAG_...)
+ * @dev:	Device created from this information, set when it is bound.
+ *		This allows of-platdata phandles to be resolved to devices.
  */
 struct driver_info {
 	const char *name;
 	const void *platdata;
 #if CONFIG_IS_ENABLED(OF_PLATDATA)
 	uint platdata_size;
+	struct udevice *dev;
 #endif
 };
 
@@ -45,4 +47,13 @@ struct driver_info {
 #define U_BOOT_DEVICES(__name)						\
 	ll_entry_declare_list(struct driver_info, __name, driver_info)
 
+/*
+ * Declare a device defined elsewhere with U_BOOT_DEVICE(), and refer to it.
+ * These can be used in static initialisers, unlike ll_entry_get().
+ */
+#define U_BOOT_DEVICE_DECL(__name)					\
+	extern struct driver_info _u_boot_list_2_driver_info_2_##__name
+#define U_BOOT_DEVICE_REF(__name)					\
+	(&_u_boot_list_2_driver_info_2_##__name)
+
 #endif
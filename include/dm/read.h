@@ -0,0 +1,107 @@
+/*
+ * Reading device tree properties of a device
+ *
+ * Copyright (C) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef _DM_READ_H
+#define _DM_READ_H
+
+#include <fdtdec.h>
+
+struct udevice;
+
+/*
+ * These read the node of a device in the control device tree. After
+ * relocation they use the live tree if there is one (see of_live.h), and
+ * before it, or without one, the flat blob. Drivers should prefer them to
+ * calling fdtdec with gd->fdt_blob and dev_of_offset().
+ */
+
+/**
+ * dev_read_prop() - Get a property of a device's node
+ *
+ * @dev: Device to read from
+ * @propname: Name of the property
+ * @lenp: If not NULL, returns the length of the property, or -ve on error
+ * @return the property value, or NULL if not found
+ */
+const void *dev_read_prop(struct udevice *dev, const char *propname,
+			  int *lenp);
+
+/**
+ * dev_read_u32_default() - Read a 32-bit integer property
+ *
+ * @dev: Device to read from
+ * @propname: Name of the property
+ * @def: Value to return if the property is missing or too short
+ * @return the value of the first cell, or @def
+ */
+int dev_read_u32_default(struct udevice *dev, const char *propname, int def);
+
+/**
+ * dev_read_u32_array() - Read an array of 32-bit integers
+ *
+ * @dev: Device to read from
+ * @propname: Name of the property
+ * @out: Returns the values
+ * @count: Number of values to read
+ * @return 0 if OK, -FDT_ERR_NOTFOUND if missing, -FDT_ERR_BADLAYOUT if short
+ */
+int dev_read_u32_array(struct udevice *dev, const char *propname, u32 *out,
+		       int count);
+
+/**
+ * dev_read_string() - Read a string property
+ *
+ * @dev: Device to read from
+ * @propname: Name of the property
+ * @return the string, or NULL if the property is missing or not a string
+ */
+const char *dev_read_string(struct udevice *dev, const char *propname);
+
+/**
+ * dev_read_bool() - Check whether a device's node has a property
+ *
+ * @dev: Device to read from
+ * @propname: Name of the property
+ * @return true if the property is present
+ */
+bool dev_read_bool(struct udevice *dev, const char *propname);
+
+/**
+ * dev_read_enabled() - Check the status property of a device's node
+ *
+ * @dev: Device to read from
+ * @return true if the node is enabled
+ */
+bool dev_read_enabled(struct udevice *dev);
+
+/**
+ * dev_read_phandle() - Follow a phandle property to its node
+ *
+ * @dev: Device to read from
+ * @propname: Name of the phandle property
+ * @return offset of the node it refers to, or -ve on error
+ */
+int dev_read_phandle(struct udevice *dev, const char *propname);
+
+/**
+ * dev_read_first_subnode() - Get the first subnode of a device's node
+ *
+ * @dev: Device to read from
+ * @return offset of the subnode, or -ve if there is none
+ */
+int dev_read_first_subnode(struct udevice *dev);
+
+/**
+ * dev_read_next_subnode() - Get the next sibling of a subnode
+ *
+ * @node: Offset of a subnode, from dev_read_first_subnode() or this
+ * @return offset of the next subnode, or -ve if there is none
+ */
+int dev_read_next_subnode(int node);
+
+#endif
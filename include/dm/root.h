@@ -115,6 +115,35 @@ int dm_init(void);
  */
 int dm_uninit(void);
 
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+/**
+ * dm_lazy_init() - Bind device tree nodes on demand from now on
+ *
+ * Nodes found by later scans are bound the first time their uclass is looked
+ * up, where their driver allows it. See CONFIG_DM_LAZY_BIND. This must not be
+ * called before relocation.
+ *
+ * @return 0 if OK, -ENOMEM if out of memory
+ */
+int dm_lazy_init(void);
+
+/**
+ * dm_lazy_uninit() - Forget any waiting nodes and bind nodes when found
+ */
+void dm_lazy_uninit(void);
+
+/**
+ * dm_lazy_pending() - Get the number of nodes waiting to be bound
+ *
+ * @return number of nodes
+ */
+int dm_lazy_pending(void);
+#else
+static inline int dm_lazy_init(void) { return 0; }
+static inline void dm_lazy_uninit(void) {}
+static inline int dm_lazy_pending(void) { return 0; }
+#endif
+
 #if CONFIG_IS_ENABLED(DM_DEVICE_REMOVE)
 /**
  * dm_remove_devices_flags - Call remove function of all drivers with
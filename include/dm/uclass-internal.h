@@ -114,6 +114,43 @@ int uclass_find_device_by_seq(enum uclass_id id, int seq_or_req_seq,
 int uclass_find_device_by_of_offset(enum uclass_id id, int node,
 				    struct udevice **devp);
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+/**
+ * uclass_set_seq() - Set the sequence number of a device
+ *
+ * This updates dev->seq and the uclass's index of sequence numbers.
+ *
+ * @dev:	Pointer to the device
+ * @seq:	New sequence number, or -1 if the device no longer has one
+ */
+void uclass_set_seq(struct udevice *dev, int seq);
+
+/**
+ * uclass_of_index_add() - Add a device to its uclass's device tree index
+ *
+ * @dev:	Pointer to the device, which must be in its uclass's list
+ */
+void uclass_of_index_add(struct udevice *dev);
+
+/**
+ * uclass_of_index_del() - Remove a device from its uclass's device tree index
+ *
+ * If another device in the uclass has the same device tree offset it takes
+ * the place of @dev in the index.
+ *
+ * @dev:	Pointer to the device
+ */
+void uclass_of_index_del(struct udevice *dev);
+#else
+static inline void uclass_set_seq(struct udevice *dev, int seq)
+{
+	dev->seq = seq;
+}
+
+static inline void uclass_of_index_add(struct udevice *dev) {}
+static inline void uclass_of_index_del(struct udevice *dev) {}
+#endif
+
 /**
  * uclass_bind_device() - Associate device with a uclass
  *
@@ -30,12 +30,25 @@
  * @dev_head: List of devices in this uclass (devices are attached to their
  * uclass when their bind method is called)
  * @sibling_node: Next uclass in the linked list of uclasses
+ * @seq_dev: Probed devices indexed by sequence number (NULL if none yet)
+ * @seq_size: Number of entries in @seq_dev, or -1 if the index could not be
+ * grown and the device list must be searched instead
+ * @of_dev: Hash table of devices by device tree offset, with linear probing
+ * @of_mask: Number of slots in @of_dev minus one, or -1 as for @seq_size
+ * @of_count: Number of devices held in @of_dev
  */
 struct uclass {
 	void *priv;
 	struct uclass_driver *uc_drv;
 	struct list_head dev_head;
 	struct list_head sibling_node;
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	struct udevice **seq_dev;
+	int seq_size;
+	struct udevice **of_dev;
+	int of_mask;
+	int of_count;
+#endif
 };
 
 struct driver;
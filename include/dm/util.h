@@ -39,6 +39,18 @@ void dm_dump_all(void);
 /* Dump out a list of uclasses and their devices */
 void dm_dump_uclass(void);
 
+/* Dump out counts of devices and the memory they use */
+void dm_dump_info(void);
+
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+/* Dump out counts of nodes waiting to be bound */
+void dm_dump_lazy(void);
+#else
+static inline void dm_dump_lazy(void)
+{
+}
+#endif
+
 #ifdef CONFIG_DEBUG_DEVRES
 /* Dump out a list of device resources */
 void dm_dump_devres(void);
@@ -9,8 +9,16 @@
 
 /* These structures may only be used in SPL */
 #if CONFIG_IS_ENABLED(OF_PLATDATA)
+struct driver_info;
+
+/**
+ * struct phandle_2_cell - A phandle reference with up to one argument
+ *
+ * @node: Device declared for the target node, or NULL for an unused entry
+ * @id: Argument, or 0 if the target takes no arguments
+ */
 struct phandle_2_cell {
-	const void *node;
+	const struct driver_info *node;
 	int id;
 };
 #include <generated/dt-structs.h>
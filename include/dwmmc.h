@@ -9,6 +9,7 @@
 #define __DWMMC_HW_H
 
 #include <asm/io.h>
+#include <bouncebuf.h>
 #include <mmc.h>
 
 #define DWMCI_CTRL		0x000
@@ -186,6 +187,15 @@ struct dwmci_host {
 
 	/* use fifo mode to read and write data */
 	bool fifo_mode;
+
+	/* IDMAC descriptor pool, grown to fit the largest transfer so far */
+	struct dwmci_idmac *idmac;
+	unsigned int idmac_count;
+
+	/* buffer of the DMA transfer in progress */
+	struct bounce_buffer bbstate;
+	/* time the transfer started by send_cmd_start() was started */
+	ulong data_start;
 };
 
 struct dwmci_idmac {
@@ -294,6 +304,7 @@ int add_dwmci(struct dwmci_host *host, u32 max_clk, u32 min_clk);
 #ifdef CONFIG_DM_MMC_OPS
 /* Export the operations to drivers */
 int dwmci_probe(struct udevice *dev);
+int dwmci_remove(struct udevice *dev);
 extern const struct dm_mmc_ops dm_dwmci_ops;
 #endif
 
@@ -224,6 +224,12 @@ int env_import(const char *buf, int check);
 /* Export from hash table into binary representation */
 int env_export(env_t *env_out);
 
+/* Note that the stored environment now matches the hash table */
+void env_set_clean(void);
+
+/* Check whether the hash table has changed since it was loaded or saved */
+bool env_is_dirty(void);
+
 #endif /* DO_DEPS_ONLY */
 
 #endif /* _ENVIRONMENT_H_ */
@@ -7,3 +7,14 @@
 void fb_mmc_flash_write(const char *cmd, void *download_buffer,
 			unsigned int download_bytes);
 void fb_mmc_erase(const char *cmd);
+
+struct stream_storage;
+
+/**
+ * fb_mmc_stream_begin() - prepare to write a download as it arrives
+ *
+ * @cmd:	partition name (or alias) to write to
+ * @info:	returns the partition as storage for image_stream_init()
+ * @return 0 if OK, -ve on error
+ */
+int fb_mmc_stream_begin(const char *cmd, struct stream_storage *info);
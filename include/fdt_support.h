@@ -11,6 +11,7 @@
 #ifdef CONFIG_OF_LIBFDT
 
 #include <libfdt.h>
+#include <fdt_txn.h>
 
 u32 fdt_getprop_u32_default_node(const void *fdt, int off, int cell,
 				const char *prop, const u32 dflt);
@@ -26,6 +27,7 @@ u32 fdt_getprop_u32_default(const void *fdt, const char *path,
  * @return 0 if ok, or -FDT_ERR_... on error
  */
 int fdt_root(void *fdt);
+int fdt_txn_root(struct fdt_txn *txn);
 
 /**
  * Add chosen data the FDT before booting the OS.
@@ -36,6 +38,7 @@ int fdt_root(void *fdt);
  * @return 0 if ok, or -FDT_ERR_... on error
  */
 int fdt_chosen(void *fdt);
+int fdt_txn_chosen(struct fdt_txn *txn);
 
 /**
  * Add initrd information to the FDT before booting the OS.
@@ -95,15 +98,24 @@ int fdt_fixup_memory(void *blob, u64 start, u64 size);
  */
 #ifdef CONFIG_ARCH_FIXUP_FDT_MEMORY
 int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks);
+int fdt_txn_fixup_memory_banks(struct fdt_txn *txn, u64 start[], u64 size[],
+			       int banks);
 #else
 static inline int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[],
 					 int banks)
 {
 	return 0;
 }
+
+static inline int fdt_txn_fixup_memory_banks(struct fdt_txn *txn, u64 start[],
+					     u64 size[], int banks)
+{
+	return 0;
+}
 #endif
 
 void fdt_fixup_ethernet(void *fdt);
+void fdt_txn_fixup_ethernet(struct fdt_txn *txn);
 int fdt_find_and_setprop(void *fdt, const char *node, const char *prop,
 			 const void *val, int len, int create);
 void fdt_fixup_qe_firmware(void *fdt);
@@ -139,6 +151,8 @@ int fdt_pci_dma_ranges(void *blob, int phb_off, struct pci_controller *hose);
 #endif
 
 int fdt_find_or_add_subnode(void *fdt, int parentoffset, const char *name);
+int fdt_txn_find_or_add_subnode(struct fdt_txn *txn, int parentoffset,
+				const char *name);
 
 /**
  * Add board-specific data to the FDT before booting the OS.
@@ -219,6 +233,8 @@ enum fdt_status {
 };
 int fdt_set_node_status(void *fdt, int nodeoffset,
 			enum fdt_status status, unsigned int error_code);
+int fdt_txn_set_node_status(struct fdt_txn *txn, int nodeoffset,
+			    enum fdt_status status, unsigned int error_code);
 static inline int fdt_status_okay(void *fdt, int nodeoffset)
 {
 	return fdt_set_node_status(fdt, nodeoffset, FDT_STATUS_OKAY, 0);
@@ -247,6 +263,22 @@ static inline int fdt_status_fail_by_alias(void *fdt, const char *alias)
 	return fdt_set_status_by_alias(fdt, alias, FDT_STATUS_FAIL, 0);
 }
 
+/**
+ * fdt_overlay_apply_list() - Apply a list of overlays to a device tree
+ *
+ * This gives the same tree as calling fdt_overlay_apply() for each overlay
+ * in turn, but indexes the tree once and writes it out once, which is much
+ * quicker for a large tree or several overlays. The tree is laid out as by
+ * fdt_pack() but keeps its total size. It needs a temporary copy of the
+ * tree.
+ *
+ * @fdt: Device tree to change
+ * @fdtos: Overlays to apply, in order, which are damaged by being applied
+ * @count: Number of overlays
+ * @return 0 if OK, -FDT_ERR_... on error, in which case @fdt is unchanged
+ */
+int fdt_overlay_apply_list(void *fdt, void *const fdtos[], int count);
+
 /* Helper to read a big number; size is in cells (not bytes) */
 static inline u64 of_read_number(const fdt32_t *cell, int size)
 {
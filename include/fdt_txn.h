@@ -0,0 +1,154 @@
+/*
+ * Batches of edits to a flattened device tree
+ *
+ * Copyright (C) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __FDT_TXN_H
+#define __FDT_TXN_H
+
+#include <libfdt.h>
+
+struct fdt_txn_edit;
+
+/**
+ * struct fdt_txn - A batch of edits to a device tree
+ *
+ * Each fdt_setprop() or fdt_add_subnode() moves everything after the edit
+ * along, so a long series of edits to a large tree is slow. A batch instead
+ * records the edits without touching the tree and fdt_txn_commit() then
+ * writes out the edited tree in one pass. The result is the same, byte for
+ * byte, as making the edits in place and calling fdt_pack(), apart from the
+ * padding after property values, which is zeroed.
+ *
+ * Nodes which were in the tree keep their offsets for the whole batch. A node
+ * added by the batch is given a handle past the end of the structure block,
+ * which can be passed to the fdt_txn_...() functions but not to libfdt.
+ *
+ * A direct batch makes each edit in place as it is made, which lets code be
+ * written once for both cases.
+ *
+ * @fdt: Device tree, which is only written to by a direct batch
+ * @direct: true to make each edit in place immediately
+ * @edits: Edits, sorted by node so that they can be written out in order
+ * @count: Number of entries used in @edits
+ * @size: Number of entries allocated in @edits
+ * @data: Property values and node names
+ * @data_len: Number of bytes used in @data
+ * @data_size: Number of bytes allocated in @data
+ * @strings: Property names not in the strings block of @fdt
+ * @strings_len: Number of bytes used in @strings
+ * @strings_size: Number of bytes allocated in @strings
+ * @seq: Number of properties and nodes added so far
+ * @base: Handle of the first node added
+ * @deleted: Number of nodes of @fdt deleted
+ */
+struct fdt_txn {
+	void *fdt;
+	bool direct;
+	struct fdt_txn_edit *edits;
+	int count;
+	int size;
+	char *data;
+	int data_len;
+	int data_size;
+	char *strings;
+	int strings_len;
+	int strings_size;
+	int seq;
+	int base;
+	int deleted;
+};
+
+/**
+ * fdt_txn_init() - Start a batch of edits
+ *
+ * @txn: Batch to set up
+ * @fdt: Device tree to edit, which is not changed
+ * @return 0 if OK, -FDT_ERR_... if the tree is not valid or is older than
+ * version 17
+ */
+int fdt_txn_init(struct fdt_txn *txn, const void *fdt);
+
+/**
+ * fdt_txn_init_direct() - Start a batch which edits the tree in place
+ *
+ * Such a batch allocates nothing and need not be committed or freed.
+ *
+ * @txn: Batch to set up
+ * @fdt: Device tree to edit
+ */
+void fdt_txn_init_direct(struct fdt_txn *txn, void *fdt);
+
+/**
+ * fdt_txn_free() - Forget the edits of a batch
+ *
+ * @txn: Batch to free
+ */
+void fdt_txn_free(struct fdt_txn *txn);
+
+/**
+ * fdt_txn_commit() - Write out the tree with the edits of a batch
+ *
+ * The tree is written in the layout that fdt_pack() gives, with its total
+ * size set to @bufsize so that it can be edited further.
+ *
+ * @txn: Batch to commit
+ * @buf: Buffer for the edited tree, which must not overlap the tree
+ * @bufsize: Size of @buf in bytes
+ * @return 0 if OK, -FDT_ERR_NOSPACE if @buf is too small, -FDT_ERR_... if the
+ * tree is not valid
+ */
+int fdt_txn_commit(struct fdt_txn *txn, void *buf, int bufsize);
+
+/* Each of these acts as the libfdt function of the same name, or nearly */
+const void *fdt_txn_getprop(struct fdt_txn *txn, int nodeoffset,
+			    const char *name, int *lenp);
+int fdt_txn_setprop(struct fdt_txn *txn, int nodeoffset, const char *name,
+		    const void *val, int len);
+int fdt_txn_delprop(struct fdt_txn *txn, int nodeoffset, const char *name);
+int fdt_txn_subnode_offset_namelen(struct fdt_txn *txn, int parentoffset,
+				   const char *name, int namelen);
+int fdt_txn_subnode_offset(struct fdt_txn *txn, int parentoffset,
+			   const char *name);
+int fdt_txn_add_subnode(struct fdt_txn *txn, int parentoffset,
+			const char *name);
+int fdt_txn_del_node(struct fdt_txn *txn, int nodeoffset);
+
+/**
+ * fdt_txn_path_offset() - Find a node by path
+ *
+ * Nodes added by the batch are not found, nor are nodes under a node deleted
+ * by the batch.
+ *
+ * @txn: Batch to look in
+ * @path: Path or alias of the node
+ * @return node offset, or -FDT_ERR_... if not found
+ */
+int fdt_txn_path_offset(struct fdt_txn *txn, const char *path);
+
+static inline int fdt_txn_setprop_u32(struct fdt_txn *txn, int nodeoffset,
+				      const char *name, uint32_t val)
+{
+	fdt32_t tmp = cpu_to_fdt32(val);
+
+	return fdt_txn_setprop(txn, nodeoffset, name, &tmp, sizeof(tmp));
+}
+
+static inline int fdt_txn_setprop_u64(struct fdt_txn *txn, int nodeoffset,
+				      const char *name, uint64_t val)
+{
+	fdt64_t tmp = cpu_to_fdt64(val);
+
+	return fdt_txn_setprop(txn, nodeoffset, name, &tmp, sizeof(tmp));
+}
+
+static inline int fdt_txn_setprop_string(struct fdt_txn *txn, int nodeoffset,
+					 const char *name, const char *str)
+{
+	return fdt_txn_setprop(txn, nodeoffset, name, str, strlen(str) + 1);
+}
+
+#endif /* __FDT_TXN_H */
@@ -23,6 +23,20 @@ struct sparse_storage {
 	lbaint_t	(*reserve)(struct sparse_storage *info,
 				 lbaint_t blk,
 				 lbaint_t blkcnt);
+
+	/*
+	 * Optional erase (discard) of whole blocks, used for DONT_CARE
+	 * chunks and, if erased blocks read back as zero, for zero FILL
+	 * chunks. Only ranges aligned to erase_grp blocks are passed in.
+	 */
+	lbaint_t	erase_grp;
+	bool		erase_zeroes;
+	lbaint_t	(*erase)(struct sparse_storage *info,
+				 lbaint_t blk,
+				 lbaint_t blkcnt);
+
+	/* Optional callback to report the reason of a failure */
+	void		(*mssg)(const char *str);
 };
 
 static inline int is_sparse_image(void *buf)
@@ -36,5 +50,14 @@ static inline int is_sparse_image(void *buf)
 	return 0;
 }
 
-void write_sparse_image(struct sparse_storage *info, const char *part_name,
-			void *data, unsigned sz);
+/**
+ * write_sparse_image() - write an Android sparse image to storage
+ *
+ * @info:	storage description and callbacks
+ * @part_name:	partition name, for messages
+ * @data:	sparse image, which is left unchanged
+ * @sz:		size of the sparse image in bytes
+ * @return 0 if OK, -ve on error
+ */
+int write_sparse_image(struct sparse_storage *info, const char *part_name,
+		       void *data, unsigned sz);
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __IMAGE_STREAM_H
+#define __IMAGE_STREAM_H
+
+#include <part.h>
+
+/* Storage a streamed image is written to, from block @start onwards */
+struct stream_storage {
+	lbaint_t	blksz;
+	lbaint_t	start;
+	lbaint_t	size;
+	void		*priv;
+
+	lbaint_t	(*write)(struct stream_storage *info,
+				 lbaint_t blk,
+				 lbaint_t blkcnt,
+				 const void *buffer);
+};
+
+/*
+ * A raw image written to storage while it is being received. It is
+ * received into one of two chunk buffers; once that is full, reception
+ * moves on to the other one while the full chunk is written out.
+ */
+struct image_stream {
+	struct stream_storage *info;
+	void		*buf;		/* two buffers of chunk_size bytes */
+	unsigned int	chunk_size;
+	int		cur;		/* buffer being received into */
+	unsigned int	fill;		/* bytes received into it */
+	lbaint_t	blk;		/* next block to write, from start */
+	int		err;		/* first write error */
+};
+
+/**
+ * image_stream_init() - start streaming an image to storage
+ *
+ * @stream:	stream to set up
+ * @info:	storage to write to
+ * @buf:	space for the two chunk buffers, 2 * @chunk_size bytes
+ * @chunk_size:	size of each chunk buffer, a multiple of the block size
+ */
+void image_stream_init(struct image_stream *stream,
+		       struct stream_storage *info, void *buf,
+		       unsigned int chunk_size);
+
+/**
+ * image_stream_next() - get where the next data is to be received
+ *
+ * @stream:	stream
+ * @room:	if non-NULL, returns the number of bytes the current chunk
+ *		buffer can still take
+ * @return address to receive the next data at
+ */
+void *image_stream_next(struct image_stream *stream, unsigned int *room);
+
+/**
+ * image_stream_rx() - account data received at image_stream_next()
+ *
+ * Once the current chunk buffer is full, or at the end of the image,
+ * reception moves on to the other buffer and the full chunk is returned.
+ * The caller should restart reception before writing the chunk out with
+ * image_stream_write(), so that the two overlap.
+ *
+ * @stream:	stream
+ * @len:	number of bytes received
+ * @last:	true if this is the end of the image
+ * @chunk_len:	returns the length of the chunk to write
+ * @return chunk to write, or NULL if the current one is not full yet
+ */
+void *image_stream_rx(struct image_stream *stream, unsigned int len,
+		      bool last, unsigned int *chunk_len);
+
+/**
+ * image_stream_write() - write out a chunk returned by image_stream_rx()
+ *
+ * Chunks are written back to back. Only the last one may end on a partial
+ * block, which is written in full. Once a write has failed, the following
+ * ones are skipped and return the same error.
+ *
+ * @stream:	stream
+ * @chunk:	chunk data
+ * @len:	chunk length in bytes
+ * @return 0 if OK, -EFBIG if the image is larger than the storage, -EIO
+ *	if the write failed
+ */
+int image_stream_write(struct image_stream *stream, const void *chunk,
+		       unsigned int len);
+
+/**
+ * image_stream_written() - get the number of bytes written so far
+ *
+ * @stream:	stream
+ * @return bytes written, a whole number of blocks
+ */
+static inline u64 image_stream_written(struct image_stream *stream)
+{
+	return (u64)stream->blk * stream->info->blksz;
+}
+
+#endif /* __IMAGE_STREAM_H */
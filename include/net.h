@@ -152,6 +152,42 @@ struct eth_ops {
 
 #define eth_get_ops(dev) ((struct eth_ops *)(dev)->driver->ops)
 
+/**
+ * struct eth_stats - Counters kept by the uclass for an Ethernet device
+ *
+ * They are cleared when the device is probed.
+ *
+ * @rx_packets: Packets received
+ * @rx_bytes: Bytes received
+ * @rx_errors: Errors returned by recv()
+ * @rx_dropped: Packets dropped as too long for a receive buffer
+ * @rx_polls: Calls to eth_rx() which received at least one packet
+ * @rx_full: Times the receive queue filled up, leaving packets in the
+ *	driver's ring until the next call
+ * @rx_queue_max: Most packets taken from the driver in one call
+ * @tx_packets: Packets sent
+ * @tx_errors: Errors returned by send()
+ */
+struct eth_stats {
+	unsigned long rx_packets;
+	unsigned long rx_bytes;
+	unsigned long rx_errors;
+	unsigned long rx_dropped;
+	unsigned long rx_polls;
+	unsigned long rx_full;
+	unsigned long rx_queue_max;
+	unsigned long tx_packets;
+	unsigned long tx_errors;
+};
+
+/**
+ * eth_get_stats() - Get the counters of an Ethernet device
+ *
+ * @dev: Device, which must be probed
+ * @return pointer to its counters
+ */
+struct eth_stats *eth_get_stats(struct udevice *dev);
+
 struct udevice *eth_get_dev(void); /* get the current device */
 /*
  * The devname can be either an exact name given by the driver or device tree
@@ -357,6 +393,7 @@ struct vlan_ethernet_hdr {
 #define PROT_PPP_SES	0x8864		/* PPPoE session messages	*/
 
 #define IPPROTO_ICMP	 1	/* Internet Control Message Protocol	*/
+#define IPPROTO_TCP	 6	/* Transmission Control Protocol	*/
 #define IPPROTO_UDP	17	/* User Datagram Protocol		*/
 
 /*
@@ -542,7 +579,7 @@ extern int		net_restart_wrap;	/* Tried all network devices */
 
 enum proto_t {
 	BOOTP, RARP, ARP, TFTPGET, DHCP, PING, DNS, NFS, CDP, NETCONS, SNTP,
-	TFTPSRV, TFTPPUT, LINKLOCAL
+	TFTPSRV, TFTPPUT, LINKLOCAL, WGET
 };
 
 extern char	net_boot_file_name[1024];/* Boot File name */
@@ -677,6 +714,17 @@ static inline void net_send_packet(uchar *pkt, int len)
 int net_send_udp_packet(uchar *ether, struct in_addr dest, int dport,
 			int sport, int payload_len);
 
+/*
+ * Transmit "net_tx_packet", which holds a complete IP packet, performing ARP
+ * request if needed (ether will be populated)
+ *
+ * @param ether Raw packet buffer
+ * @param dest IP address to send the packet to
+ * @param len Length of the packet, including the ethernet header
+ * @return 0 if transmitted, 1 if waiting for the ARP reply
+ */
+int net_send_ip_packet(uchar *ether, struct in_addr dest, int len);
+
 /* Processes a received packet */
 void net_process_received_packet(uchar *in_packet, int len);
 
@@ -0,0 +1,132 @@
+/*
+ * Minimal TCP client, enough to fetch a file over HTTP
+ *
+ * Copyright (c) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __TCP_H__
+#define __TCP_H__
+
+/*
+ *	Internet Protocol (IP) + TCP header.
+ */
+struct ip_tcp_hdr {
+	u8		ip_hl_v;	/* header length and version	*/
+	u8		ip_tos;		/* type of service		*/
+	u16		ip_len;		/* total length			*/
+	u16		ip_id;		/* identification		*/
+	u16		ip_off;		/* fragment offset field	*/
+	u8		ip_ttl;		/* time to live			*/
+	u8		ip_p;		/* protocol			*/
+	u16		ip_sum;		/* checksum			*/
+	struct in_addr	ip_src;		/* Source IP address		*/
+	struct in_addr	ip_dst;		/* Destination IP address	*/
+	u16		tcp_src;	/* TCP source port		*/
+	u16		tcp_dst;	/* TCP destination port		*/
+	u32		tcp_seq;	/* Sequence number		*/
+	u32		tcp_ack;	/* Acknowledgment number	*/
+	u8		tcp_off;	/* Data offset, in 32-bit words	*/
+	u8		tcp_flags;	/* Control bits			*/
+	u16		tcp_win;	/* Receive window		*/
+	u16		tcp_xsum;	/* Checksum			*/
+	u16		tcp_urg;	/* Urgent pointer		*/
+};
+
+#define IP_TCP_HDR_SIZE		(sizeof(struct ip_tcp_hdr))
+#define TCP_HDR_SIZE		(IP_TCP_HDR_SIZE - IP_HDR_SIZE)
+
+#define TCP_FIN			0x01
+#define TCP_SYN			0x02
+#define TCP_RST			0x04
+#define TCP_PSH			0x08
+#define TCP_ACK			0x10
+
+#define TCP_OPT_END		0
+#define TCP_OPT_NOP		1
+#define TCP_OPT_MSS		2
+#define TCP_OPT_WSCALE		3
+
+/* Largest segment we accept, for a 1500-byte ethernet MTU */
+#define TCP_MSS			1460
+/* Window scale we ask for, as a shift of the 16-bit window field */
+#define TCP_WSCALE		4
+/* Most data that can be sent on a connection */
+#define TCP_TX_SIZE		2048
+
+/**
+ * typedef rxhand_tcp_f - Called for the data received on a connection
+ *
+ * The data is passed as soon as it arrives, which may be ahead of data
+ * still missing. The handler must store it where it belongs in the stream;
+ * data it refuses is dropped and sent again by the peer later.
+ *
+ * @offset:	Offset of the data in the stream, from 0
+ * @data:	Data received
+ * @len:	Number of bytes of data
+ * @return 0 if the data was stored, -ve to drop it
+ */
+typedef int rxhand_tcp_f(u32 offset, uchar *data, unsigned int len);
+
+/**
+ * typedef thand_tcp_f - Called when a connection ends
+ *
+ * @err:	0 if the peer closed it after sending all its data,
+ *		-ECONNRESET if it was reset, -ETIMEDOUT if the peer stopped
+ *		answering
+ */
+typedef void thand_tcp_f(int err);
+
+/**
+ * tcp_connect() - Open a connection
+ *
+ * This sends the SYN, and returns without waiting for the answer. The data
+ * passed to tcp_send() is sent as soon as the connection is established.
+ *
+ * @dest:	IP address to connect to
+ * @dport:	Port to connect to
+ * @sport:	Our port
+ * @rx:	Handler for the data received
+ * @done:	Handler for the end of the connection
+ * @return 0 if OK, -EBUSY if a connection is already open
+ */
+int tcp_connect(struct in_addr dest, int dport, int sport, rxhand_tcp_f *rx,
+		thand_tcp_f *done);
+
+/**
+ * tcp_send() - Send data on the connection
+ *
+ * The data is copied, and sent again until the peer acknowledges it. All
+ * the data sent is kept until the connection ends, so at most TCP_TX_SIZE
+ * bytes can be sent on a connection; this is meant for requests.
+ *
+ * @data:	Data to send
+ * @len:	Number of bytes to send
+ * @return 0 if OK, -ENOSPC if it does not fit, -ENOTCONN if no connection
+ *	is open
+ */
+int tcp_send(const void *data, int len);
+
+/**
+ * tcp_close() - Close the connection
+ *
+ * This sends a FIN and forgets the connection, without waiting for the
+ * peer to acknowledge it.
+ */
+void tcp_close(void);
+
+/**
+ * tcp_reset() - Forget the connection without telling the peer
+ */
+void tcp_reset(void);
+
+/**
+ * tcp_receive() - Handle a TCP packet received
+ *
+ * @ip:	IP packet, whose IP header has been checked
+ * @len:	Length of the IP packet
+ */
+void tcp_receive(struct ip_tcp_hdr *ip, int len);
+
+#endif /* __TCP_H__ */
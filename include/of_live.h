@@ -0,0 +1,175 @@
+/*
+ * Unflattened (live) copy of the control device tree
+ *
+ * Copyright (C) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __OF_LIVE_H
+#define __OF_LIVE_H
+
+#include <libfdt.h>
+
+/*
+ * The live tree is built from the control FDT after relocation. Nodes are
+ * still identified by their offset in the flat blob, so that callers of the
+ * of_live_*() functions below need not know whether it exists: with no live
+ * tree for @blob (before relocation, or for any other blob) they fall back to
+ * libfdt. Property values point into the blob, so the tree is not used once
+ * the blob's header shows that it has been resized or rearranged. Code which
+ * changes or moves the control FDT calls of_live_sync() to rebuild it.
+ */
+
+/**
+ * struct of_live_prop - A property of a node
+ *
+ * @name: Property name, interned: equal names have equal pointers
+ * @value: Property value, within the flat blob
+ * @len: Length of @value in bytes
+ */
+struct of_live_prop {
+	const char *name;
+	const void *value;
+	int len;
+};
+
+/**
+ * struct of_live_node - A node in the live tree
+ *
+ * @offset: Offset of the node in the flat blob
+ * @phandle: Phandle of the node, or 0 if none
+ * @name: Node name, including any unit address
+ * @parent: Parent node, or NULL for the root
+ * @child: First child node, or NULL if none
+ * @sibling: Next sibling node, or NULL if none
+ * @props: Properties of the node, in blob order
+ * @prop_count: Number of entries in @props
+ */
+struct of_live_node {
+	int offset;
+	uint32_t phandle;
+	const char *name;
+	struct of_live_node *parent;
+	struct of_live_node *child;
+	struct of_live_node *sibling;
+	struct of_live_prop *props;
+	int prop_count;
+};
+
+/**
+ * struct of_live - A live tree
+ *
+ * @blob: Flat blob that the tree was built from
+ * @hdr: Header of @blob when the tree was built
+ * @nodes: All nodes, in blob order and therefore sorted by offset
+ * @node_count: Number of entries in @nodes
+ * @names: Hash table of interned property names
+ * @name_mask: Number of slots in @names minus one
+ * @phandles: Hash table of nodes with a phandle
+ * @phandle_mask: Number of slots in @phandles minus one
+ */
+struct of_live {
+	const void *blob;
+	struct fdt_header hdr;
+	struct of_live_node *nodes;
+	int node_count;
+	const char **names;
+	uint name_mask;
+	struct of_live_node **phandles;
+	uint phandle_mask;
+};
+
+/**
+ * of_live_build() - Build a live tree from a flat blob
+ *
+ * @blob: Flat device tree blob
+ * @treep: Returns the new tree
+ * @return 0 if OK, -EINVAL if the blob is not valid, -ENOMEM if out of memory
+ */
+int of_live_build(const void *blob, struct of_live **treep);
+
+/**
+ * of_live_free() - Free a live tree
+ *
+ * @tree: Tree to free, or NULL
+ */
+void of_live_free(struct of_live *tree);
+
+/**
+ * of_live_find_node() - Find the node at a given offset
+ *
+ * @tree: Live tree
+ * @offset: Offset of the node in the flat blob
+ * @return the node, or NULL if there is no node at @offset
+ */
+struct of_live_node *of_live_find_node(const struct of_live *tree,
+				       int offset);
+
+/**
+ * of_live_find_prop() - Find a property of a live node
+ *
+ * @tree: Live tree
+ * @node: Node to look in
+ * @name: Property name
+ * @return the property, or NULL if the node does not have it
+ */
+const struct of_live_prop *of_live_find_prop(const struct of_live *tree,
+					     const struct of_live_node *node,
+					     const char *name);
+
+#if CONFIG_IS_ENABLED(OF_LIVE)
+/**
+ * of_live_sync() - Rebuild the live tree from the control FDT
+ *
+ * This drops gd->of_live and, after relocation, builds it again from
+ * gd->fdt_blob. If that fails the flat tree is used.
+ */
+void of_live_sync(void);
+
+/* The of_live_*() equivalents of fdt_getprop() and friends */
+const void *of_live_getprop(const void *blob, int node, const char *name,
+			    int *lenp);
+int of_live_parent_offset(const void *blob, int node);
+int of_live_path_offset(const void *blob, const char *path);
+int of_live_node_by_phandle(const void *blob, uint32_t phandle);
+int of_live_first_subnode(const void *blob, int node);
+int of_live_next_subnode(const void *blob, int node);
+#else
+static inline void of_live_sync(void)
+{
+}
+
+static inline const void *of_live_getprop(const void *blob, int node,
+					  const char *name, int *lenp)
+{
+	return fdt_getprop(blob, node, name, lenp);
+}
+
+static inline int of_live_parent_offset(const void *blob, int node)
+{
+	return fdt_parent_offset(blob, node);
+}
+
+static inline int of_live_path_offset(const void *blob, const char *path)
+{
+	return fdt_path_offset(blob, path);
+}
+
+static inline int of_live_node_by_phandle(const void *blob, uint32_t phandle)
+{
+	return fdt_node_offset_by_phandle(blob, phandle);
+}
+
+static inline int of_live_first_subnode(const void *blob, int node)
+{
+	return fdt_first_subnode(blob, node);
+}
+
+static inline int of_live_next_subnode(const void *blob, int node)
+{
+	return fdt_next_subnode(blob, node);
+}
+#endif
+
+#endif /* __OF_LIVE_H */
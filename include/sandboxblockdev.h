@@ -13,6 +13,13 @@ struct host_block_dev {
 #endif
 	char *filename;
 	int fd;
+#ifdef CONFIG_BLK
+	/* Read started by read_start(), done piecewise by read_poll() */
+	bool read_busy;
+	lbaint_t read_pos;
+	lbaint_t read_left;
+	void *read_buf;
+#endif
 };
 
 int host_dev_bind(int dev, char *filename);
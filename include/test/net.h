@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __TEST_NET_H__
+#define __TEST_NET_H__
+
+#include <net.h>
+#include <asm/eth.h>
+#include <test/test.h>
+
+/*
+ * Helpers for tests which download a file from a fake server. The server is
+ * a sandbox_eth_tx_hand_f handler, which answers the packets U-Boot sends on
+ * the first sandbox ethernet device, as the host at 1.1.2.2. The file it
+ * serves is NET_TEST_SIZE bytes long, with net_test_byte() at each offset,
+ * and is loaded to NET_TEST_ADDR.
+ */
+#define NET_TEST_ADDR		0x100000
+#define NET_TEST_SIZE		((1 << 20) + 123)
+/* Most environment variables net_test_run() can restore */
+#define NET_TEST_MAX_ENV	4
+/* Most IP payload in one ethernet frame */
+#define NET_TEST_MTU		1500
+/* Largest UDP payload the server sends, in IP fragments if needed */
+#define NET_TEST_MAX_UDP	(8192 + 256)
+/* Most UDP datagrams net_test_udp_queue() can hold */
+#define NET_TEST_MAX_DGRAMS	16
+
+/**
+ * net_test_byte() - Get a byte of the test file
+ *
+ * @offset: Offset of the byte in the file
+ * @return the byte
+ */
+u8 net_test_byte(int offset);
+
+/**
+ * net_test_ip_hdr() - Fill in the headers of a reply from the server
+ *
+ * This sets up the ethernet and IP headers of a packet going back to the
+ * client which sent @request, with @len bytes of IP payload.
+ *
+ * @buf: Packet to fill in
+ * @request: Packet received from the client, starting with its ethernet
+ *	header
+ * @proto: IP protocol of the reply (IPPROTO_...)
+ * @len: Length of the IP payload
+ */
+void net_test_ip_hdr(void *buf, void *request, int proto, int len);
+
+/**
+ * net_test_udp_queue() - Prepare a UDP datagram from the server to the client
+ *
+ * The datagram is held until net_test_udp_flush() is called.
+ *
+ * @request: Packet received from the client
+ * @port: Port the server sends from
+ * @data: UDP payload
+ * @len: Length of @data, at most NET_TEST_MAX_UDP
+ * @return 0 if OK, -ENOSPC if NET_TEST_MAX_DGRAMS are held already, -E2BIG
+ *	if @len is too large
+ */
+int net_test_udp_queue(void *request, int port, const void *data, int len);
+
+/**
+ * net_test_udp_flush() - Send the datagrams held by net_test_udp_queue()
+ *
+ * A datagram which does not fit in NET_TEST_MTU is sent in IP fragments.
+ * The fragments of the datagrams are interleaved, as they would be if each
+ * took its own path through the network.
+ *
+ * @dev: Device to receive the datagrams
+ * @return 0 if OK, -ve on error
+ */
+int net_test_udp_flush(struct udevice *dev);
+
+/**
+ * net_test_udp_reply() - Send a UDP datagram from the server to the client
+ *
+ * This is net_test_udp_queue() followed by net_test_udp_flush().
+ *
+ * @dev: Device to receive the datagram
+ * @request: Packet received from the client
+ * @port: Port the server sends from
+ * @data: UDP payload
+ * @len: Length of @data
+ * @return 0 if OK, -ve on error
+ */
+int net_test_udp_reply(struct udevice *dev, void *request, int port,
+		       const void *data, int len);
+
+/**
+ * net_test_get() - Download the test file and check it
+ *
+ * @uts: Test state
+ * @proto: Protocol to download with
+ * @name: Name of the file to ask for
+ * @msecs: Returns the time the download took
+ * @return 0 if the file arrived intact, 1 if it arrived damaged, or the
+ *	negative value returned by net_loop() if the download failed
+ */
+int net_test_get(struct unit_test_state *uts, enum proto_t proto,
+		 const char *name, ulong *msecs);
+
+/**
+ * net_test_run() - Run a test against a fake server
+ *
+ * This selects the first sandbox ethernet device, points it at the server
+ * and runs @test. Afterwards it restores the device and each environment
+ * variable in @env, whether or not the test passed.
+ *
+ * @uts: Test state
+ * @tx: Server, which answers the packets sent by U-Boot
+ * @env: NULL-terminated list of up to NET_TEST_MAX_ENV environment
+ *	variables which @test may change
+ * @test: Test to run
+ * @return the return value of @test
+ */
+int net_test_run(struct unit_test_state *uts, sandbox_eth_tx_hand_f *tx,
+		 const char *const env[],
+		 int (*test)(struct unit_test_state *uts));
+
+#endif /* __TEST_NET_H__ */
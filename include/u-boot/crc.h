@@ -17,6 +17,13 @@ uint32_t crc32 (uint32_t, const unsigned char *, uint);
 uint32_t crc32_wd (uint32_t, const unsigned char *, uint, uint);
 uint32_t crc32_no_comp (uint32_t, const unsigned char *, uint);
 
+/*
+ * The implementations crc32_no_comp() chooses from (CONFIG_CRC32_...), for
+ * comparison
+ */
+uint32_t crc32_no_comp_byte(uint32_t, const unsigned char *, uint);
+uint32_t crc32_no_comp_slice8(uint32_t, const unsigned char *, uint);
+
 /**
  * crc32_wd_buf - Perform CRC32 on a buffer and return result in buffer
  *
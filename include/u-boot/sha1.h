@@ -53,6 +53,31 @@ void sha1_starts( sha1_context *ctx );
 void sha1_update(sha1_context *ctx, const unsigned char *input,
 		 unsigned int ilen);
 
+/**
+ * \brief	   SHA-1 block functions, which add whole 64-byte blocks to
+ *		   the hash. sha1_update() uses the fastest one built; the
+ *		   others are exported so that they can be checked against the
+ *		   reference.
+ *
+ * \param ctx	   SHA-1 context
+ * \param data    blocks of data
+ * \param blocks  number of blocks
+ */
+void sha1_blocks_ref(sha1_context *ctx, const unsigned char *data,
+		     unsigned int blocks);
+void sha1_blocks_unrolled(sha1_context *ctx, const unsigned char *data,
+			  unsigned int blocks);
+void sha1_blocks_simd(sha1_context *ctx, const unsigned char *data,
+		      unsigned int blocks);
+
+/**
+ * \brief	   Check whether the SIMD unit can be used, enabling it if
+ *		   needed
+ *
+ * \return	   1 if it can, 0 if not
+ */
+int sha_simd_usable(void);
+
 /**
  * \brief	   SHA-1 final digest
  *
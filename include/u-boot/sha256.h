@@ -19,6 +19,21 @@ void sha256_starts(sha256_context * ctx);
 void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length);
 void sha256_finish(sha256_context * ctx, uint8_t digest[SHA256_SUM_LEN]);
 
+/*
+ * Block functions, which add @blocks 64-byte blocks at @data to the hash.
+ * sha256_update() uses the fastest one built; the others are exported so
+ * that they can be checked against the reference.
+ */
+void sha256_blocks_ref(sha256_context *ctx, const uint8_t *data,
+		       unsigned int blocks);
+void sha256_blocks_unrolled(sha256_context *ctx, const uint8_t *data,
+			    unsigned int blocks);
+void sha256_blocks_simd(sha256_context *ctx, const uint8_t *data,
+			unsigned int blocks);
+
+/* Check whether the SIMD unit can be used, enabling it if needed */
+int sha_simd_usable(void);
+
 void sha256_csum_wd(const unsigned char *input, unsigned int ilen,
 		unsigned char *output, unsigned int chunk_sz);
 
@@ -173,10 +173,8 @@ const uint32_t * ZEXPORT get_crc_table()
 
 /* ========================================================================= */
 
-/* No ones complement version. JFFS2 (and other things ?)
- * don't use ones compliment in their CRC calculations.
- */
-uint32_t ZEXPORT crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
+/* Table lookup for each byte, with the data read a word at a time */
+uint32_t ZEXPORT crc32_no_comp_byte(uint32_t crc, const Bytef *buf, uInt len)
 {
     const uint32_t *tab = crc_table;
     const uint32_t *b =(const uint32_t *)buf;
@@ -218,6 +216,49 @@ uint32_t ZEXPORT crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
 }
 #undef DO_CRC
 
+#include "crc32_slice8.h"
+
+/*
+ * Slice-by-8: eight table lookups for each 8 bytes, which do not depend on
+ * one another, instead of a chain of eight dependent lookups
+ */
+uint32_t ZEXPORT crc32_no_comp_slice8(uint32_t crc, const Bytef *buf, uInt len)
+{
+    const uint32_t (*tab)[256] = crc32_table_slice8;
+    uint32_t one, two;
+
+    /* Align it */
+    for (; len && ((long)buf & 3); len--)
+	crc = tab[0][(crc ^ *buf++) & 255] ^ (crc >> 8);
+
+    for (; len >= 8; len -= 8, buf += 8) {
+	one = le32_to_cpu(*(const uint32_t *)buf) ^ crc;
+	two = le32_to_cpu(*(const uint32_t *)(buf + 4));
+	crc = tab[7][one & 255] ^ tab[6][(one >> 8) & 255] ^
+	      tab[5][(one >> 16) & 255] ^ tab[4][one >> 24] ^
+	      tab[3][two & 255] ^ tab[2][(two >> 8) & 255] ^
+	      tab[1][(two >> 16) & 255] ^ tab[0][two >> 24];
+    }
+
+    /* And the last few bytes */
+    while (len--)
+	crc = tab[0][(crc ^ *buf++) & 255] ^ (crc >> 8);
+
+    return crc;
+}
+
+/* No ones complement version. JFFS2 (and other things ?)
+ * don't use ones compliment in their CRC calculations.
+ */
+uint32_t ZEXPORT crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
+{
+#if defined(CONFIG_CRC32_SLICE_BY_8) && !defined(CONFIG_SPL_BUILD)
+    return crc32_no_comp_slice8(crc, buf, len);
+#else
+    return crc32_no_comp_byte(crc, buf, len);
+#endif
+}
+
 uint32_t ZEXPORT crc32 (uint32_t crc, const Bytef *p, uInt len)
 {
      return crc32_no_comp(crc ^ 0xffffffffL, p, len) ^ 0xffffffffL;
@@ -11,6 +11,7 @@
 #include <libfdt.h>
 #include <fdt_support.h>
 #include <fdtdec.h>
+#include <of_live.h>
 #include <asm/sections.h>
 #include <linux/ctype.h>
 
@@ -104,7 +105,7 @@ fdt_addr_t fdtdec_get_addr_size_fixed(const void *blob, int node,
 		return FDT_ADDR_T_NONE;
 	}
 
-	prop = fdt_getprop(blob, node, prop_name, &len);
+	prop = of_live_getprop(blob, node, prop_name, &len);
 	if (!prop) {
 		debug("(not found)\n");
 		return FDT_ADDR_T_NONE;
@@ -172,7 +173,7 @@ fdt_addr_t fdtdec_get_addr_size_auto_noparent(const void *blob, int node,
 
 	debug("%s: ", __func__);
 
-	parent = fdt_parent_offset(blob, node);
+	parent = of_live_parent_offset(blob, node);
 	if (parent < 0) {
 		debug("(no parent found)\n");
 		return FDT_ADDR_T_NONE;
@@ -214,7 +215,7 @@ int fdtdec_get_pci_addr(const void *blob, int node, enum fdt_pci_space type,
 	 * #size-cells. They need to be 3 and 2 accordingly. However,
 	 * for simplicity we skip the check here.
 	 */
-	cell = fdt_getprop(blob, node, prop_name, &len);
+	cell = of_live_getprop(blob, node, prop_name, &len);
 	if (!cell)
 		goto fail;
 
@@ -258,7 +259,7 @@ int fdtdec_get_pci_vendev(const void *blob, int node, u16 *vendor, u16 *device)
 	const char *list, *end;
 	int len;
 
-	list = fdt_getprop(blob, node, "compatible", &len);
+	list = of_live_getprop(blob, node, "compatible", &len);
 	if (!list)
 		return -ENOENT;
 
@@ -314,7 +315,7 @@ uint64_t fdtdec_get_uint64(const void *blob, int node, const char *prop_name,
 	const uint64_t *cell64;
 	int length;
 
-	cell64 = fdt_getprop(blob, node, prop_name, &length);
+	cell64 = of_live_getprop(blob, node, prop_name, &length);
 	if (!cell64 || length < sizeof(*cell64))
 		return default_val;
 
@@ -332,7 +333,7 @@ int fdtdec_get_is_enabled(const void *blob, int node)
 	 *
 	 * http://www.mail-archive.com/u-boot@lists.denx.de/msg71598.html
 	 */
-	cell = fdt_getprop(blob, node, "status", NULL);
+	cell = of_live_getprop(blob, node, "status", NULL);
 	if (cell)
 		return 0 == strcmp(cell, "okay");
 	return 1;
@@ -381,7 +382,7 @@ int fdtdec_next_alias(const void *blob, const char *name,
 	/* snprintf() is not available */
 	assert(strlen(name) < MAX_STR_LEN);
 	sprintf(str, "%.*s%d", MAX_STR_LEN, name, *upto);
-	node = fdt_path_offset(blob, str);
+	node = of_live_path_offset(blob, str);
 	if (node < 0)
 		return node;
 	err = fdt_node_check_compatible(blob, node, compat_names[id]);
@@ -414,7 +415,7 @@ int fdtdec_add_aliases_for_id(const void *blob, const char *name,
 	int i, j;
 
 	/* find the alias node if present */
-	alias_node = fdt_path_offset(blob, "/aliases");
+	alias_node = of_live_path_offset(blob, "/aliases");
 
 	/*
 	 * start with nothing, and we can assume that the root node can't
@@ -445,7 +446,7 @@ int fdtdec_add_aliases_for_id(const void *blob, const char *name,
 		prop = fdt_get_property_by_offset(blob, offset, NULL);
 		path = fdt_string(blob, fdt32_to_cpu(prop->nameoff));
 		if (prop->len && 0 == strncmp(path, name, name_len))
-			node = fdt_path_offset(blob, prop->data);
+			node = of_live_path_offset(blob, prop->data);
 		if (node <= 0)
 			continue;
 
@@ -528,7 +529,7 @@ int fdtdec_get_alias_seq(const void *blob, const char *base, int offset,
 	find_name = fdt_get_name(blob, offset, &find_namelen);
 	debug("Looking for '%s' at %d, name %s\n", base, offset, find_name);
 
-	aliases = fdt_path_offset(blob, "/aliases");
+	aliases = of_live_path_offset(blob, "/aliases");
 	for (prop_offset = fdt_first_property_offset(blob, aliases);
 	     prop_offset > 0;
 	     prop_offset = fdt_next_property_offset(blob, prop_offset)) {
@@ -564,8 +565,8 @@ const char *fdtdec_get_chosen_prop(const void *blob, const char *name)
 
 	if (!blob)
 		return NULL;
-	chosen_node = fdt_path_offset(blob, "/chosen");
-	return fdt_getprop(blob, chosen_node, name, NULL);
+	chosen_node = of_live_path_offset(blob, "/chosen");
+	return of_live_getprop(blob, chosen_node, name, NULL);
 }
 
 int fdtdec_get_chosen_node(const void *blob, const char *name)
@@ -575,7 +576,7 @@ int fdtdec_get_chosen_node(const void *blob, const char *name)
 	prop = fdtdec_get_chosen_prop(blob, name);
 	if (!prop)
 		return -FDT_ERR_NOTFOUND;
-	return fdt_path_offset(blob, prop);
+	return of_live_path_offset(blob, prop);
 }
 
 int fdtdec_check_fdt(void)
@@ -622,11 +623,11 @@ int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name)
 	int lookup;
 
 	debug("%s: %s\n", __func__, prop_name);
-	phandle = fdt_getprop(blob, node, prop_name, NULL);
+	phandle = of_live_getprop(blob, node, prop_name, NULL);
 	if (!phandle)
 		return -FDT_ERR_NOTFOUND;
 
-	lookup = fdt_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
+	lookup = of_live_node_by_phandle(blob, fdt32_to_cpu(*phandle));
 	return lookup;
 }
 
@@ -648,7 +649,7 @@ static const void *get_prop_check_min_len(const void *blob, int node,
 	int len;
 
 	debug("%s: %s\n", __func__, prop_name);
-	cell = fdt_getprop(blob, node, prop_name, &len);
+	cell = of_live_getprop(blob, node, prop_name, &len);
 	if (!cell)
 		*err = -FDT_ERR_NOTFOUND;
 	else if (len < min_len)
@@ -682,7 +683,7 @@ int fdtdec_get_int_array_count(const void *blob, int node,
 	int i;
 
 	debug("%s: %s\n", __func__, prop_name);
-	cell = fdt_getprop(blob, node, prop_name, &len);
+	cell = of_live_getprop(blob, node, prop_name, &len);
 	if (!cell)
 		return -FDT_ERR_NOTFOUND;
 	elems = len / sizeof(u32);
@@ -711,7 +712,7 @@ int fdtdec_get_bool(const void *blob, int node, const char *prop_name)
 	int len;
 
 	debug("%s: %s\n", __func__, prop_name);
-	cell = fdt_getprop(blob, node, prop_name, &len);
+	cell = of_live_getprop(blob, node, prop_name, &len);
 	return cell != NULL;
 }
 
@@ -728,7 +729,7 @@ int fdtdec_parse_phandle_with_args(const void *blob, int src_node,
 	int phandle;
 
 	/* Retrieve the phandle list property */
-	list = fdt_getprop(blob, src_node, list_name, &size);
+	list = of_live_getprop(blob, src_node, list_name, &size);
 	if (!list)
 		return -ENOENT;
 	list_end = list + size / sizeof(*list);
@@ -754,8 +755,8 @@ int fdtdec_parse_phandle_with_args(const void *blob, int src_node,
 			 * below.
 			 */
 			if (cells_name || cur_index == index) {
-				node = fdt_node_offset_by_phandle(blob,
-								  phandle);
+				node = of_live_node_by_phandle(blob,
+							       phandle);
 				if (!node) {
 					debug("%s: could not find phandle\n",
 					      fdt_get_name(blob, src_node,
@@ -880,7 +881,7 @@ int fdtdec_get_config_int(const void *blob, const char *prop_name,
 	int config_node;
 
 	debug("%s: %s\n", __func__, prop_name);
-	config_node = fdt_path_offset(blob, "/config");
+	config_node = of_live_path_offset(blob, "/config");
 	if (config_node < 0)
 		return default_val;
 	return fdtdec_get_int(blob, config_node, prop_name, default_val);
@@ -892,7 +893,7 @@ int fdtdec_get_config_bool(const void *blob, const char *prop_name)
 	const void *prop;
 
 	debug("%s: %s\n", __func__, prop_name);
-	config_node = fdt_path_offset(blob, "/config");
+	config_node = of_live_path_offset(blob, "/config");
 	if (config_node < 0)
 		return 0;
 	prop = fdt_get_property(blob, config_node, prop_name, NULL);
@@ -907,11 +908,11 @@ char *fdtdec_get_config_string(const void *blob, const char *prop_name)
 	int len;
 
 	debug("%s: %s\n", __func__, prop_name);
-	nodeoffset = fdt_path_offset(blob, "/config");
+	nodeoffset = of_live_path_offset(blob, "/config");
 	if (nodeoffset < 0)
 		return NULL;
 
-	nodep = fdt_getprop(blob, nodeoffset, prop_name, &len);
+	nodep = of_live_getprop(blob, nodeoffset, prop_name, &len);
 	if (!nodep)
 		return NULL;
 
@@ -926,7 +927,7 @@ int fdtdec_decode_region(const void *blob, int node, const char *prop_name,
 
 	debug("%s: %s: %s\n", __func__, fdt_get_name(blob, node, NULL),
 	      prop_name);
-	cell = fdt_getprop(blob, node, prop_name, &len);
+	cell = of_live_getprop(blob, node, prop_name, &len);
 	if (!cell || (len < sizeof(fdt_addr_t) * 2)) {
 		debug("cell=%p, len=%d\n", cell, len);
 		return -1;
@@ -962,10 +963,10 @@ int fdtdec_read_fmap_entry(const void *blob, int node, const char *name,
 	entry->offset = reg[0];
 	entry->length = reg[1];
 	entry->used = fdtdec_get_int(blob, node, "used", entry->length);
-	prop = fdt_getprop(blob, node, "compress", NULL);
+	prop = of_live_getprop(blob, node, "compress", NULL);
 	entry->compress_algo = prop && !strcmp(prop, "lzo") ?
 		FMAP_COMPRESS_LZO : FMAP_COMPRESS_NONE;
-	prop = fdt_getprop(blob, node, "hash", &entry->hash_size);
+	prop = of_live_getprop(blob, node, "hash", &entry->hash_size);
 	entry->hash_algo = prop ? FMAP_HASH_SHA256 : FMAP_HASH_NONE;
 	entry->hash = (uint8_t *)prop;
 
@@ -989,14 +990,14 @@ int fdt_get_resource(const void *fdt, int node, const char *property,
 	int na, ns, len, parent;
 	unsigned int i = 0;
 
-	parent = fdt_parent_offset(fdt, node);
+	parent = of_live_parent_offset(fdt, node);
 	if (parent < 0)
 		return parent;
 
 	na = fdt_address_cells(fdt, parent);
 	ns = fdt_size_cells(fdt, parent);
 
-	ptr = fdt_getprop(fdt, node, property, &len);
+	ptr = of_live_getprop(fdt, node, property, &len);
 	if (!ptr)
 		return len;
 
@@ -1040,7 +1041,7 @@ int fdtdec_decode_memory_region(const void *blob, int config_node,
 	int node;
 
 	if (config_node == -1) {
-		config_node = fdt_path_offset(blob, "/config");
+		config_node = of_live_path_offset(blob, "/config");
 		if (config_node < 0) {
 			debug("%s: Cannot find /config node\n", __func__);
 			return -ENOENT;
@@ -1051,14 +1052,14 @@ int fdtdec_decode_memory_region(const void *blob, int config_node,
 
 	snprintf(prop_name, sizeof(prop_name), "%s-memory%s", mem_type,
 		 suffix);
-	mem = fdt_getprop(blob, config_node, prop_name, NULL);
+	mem = of_live_getprop(blob, config_node, prop_name, NULL);
 	if (!mem) {
 		debug("%s: No memory type for '%s', using /memory\n", __func__,
 		      prop_name);
 		mem = "/memory";
 	}
 
-	node = fdt_path_offset(blob, mem);
+	node = of_live_path_offset(blob, mem);
 	if (node < 0) {
 		debug("%s: Failed to find node '%s': %s\n", __func__, mem,
 		      fdt_strerror(node));
@@ -1096,7 +1097,7 @@ static int decode_timing_property(const void *blob, int node, const char *name,
 	int length, ret = 0;
 	const u32 *prop;
 
-	prop = fdt_getprop(blob, node, name, &length);
+	prop = of_live_getprop(blob, node, name, &length);
 	if (!prop) {
 		debug("%s: could not find property %s\n",
 		      fdt_get_name(blob, node, NULL), name);
@@ -1125,9 +1126,9 @@ int fdtdec_decode_display_timing(const void *blob, int parent, int index,
 	if (timings_node < 0)
 		return timings_node;
 
-	for (i = 0, node = fdt_first_subnode(blob, timings_node);
+	for (i = 0, node = of_live_first_subnode(blob, timings_node);
 	     node > 0 && i != index;
-	     node = fdt_next_subnode(blob, node))
+	     node = of_live_next_subnode(blob, node))
 		i++;
 
 	if (node < 0)
@@ -1187,7 +1188,7 @@ int fdtdec_setup_memory_size(void)
 	int ret, mem;
 	struct fdt_resource res;
 
-	mem = fdt_path_offset(gd->fdt_blob, "/memory");
+	mem = of_live_path_offset(gd->fdt_blob, "/memory");
 	if (mem < 0) {
 		debug("%s: Missing /memory node\n", __func__);
 		return -EINVAL;
@@ -1211,7 +1212,7 @@ int fdtdec_setup_memory_banksize(void)
 	int bank, ret, mem;
 	struct fdt_resource res;
 
-	mem = fdt_path_offset(gd->fdt_blob, "/memory");
+	mem = of_live_path_offset(gd->fdt_blob, "/memory");
 	if (mem < 0) {
 		debug("%s: Missing /memory node\n", __func__);
 		return -EINVAL;
@@ -42,28 +42,48 @@ void gzfree(void *x, void *addr, unsigned nb)
 	free (addr);
 }
 
-int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
+/*
+ * Return the length of the gzip header at @src, -EAGAIN if it runs past @len
+ * bytes or -EINVAL if it is not valid
+ */
+static int gunzip_header_len(const unsigned char *src, unsigned long len)
 {
-	int i, flags;
+	unsigned long i;
+	int flags;
 
 	/* skip header */
 	i = 10;
+	if (len < i)
+		return -EAGAIN;
 	flags = src[3];
-	if (src[2] != DEFLATED || (flags & RESERVED) != 0) {
-		puts ("Error: Bad gzipped data\n");
-		return (-1);
-	}
+	if (src[2] != DEFLATED || (flags & RESERVED) != 0)
+		return -EINVAL;
 	if ((flags & EXTRA_FIELD) != 0)
 		i = 12 + src[10] + (src[11] << 8);
 	if ((flags & ORIG_NAME) != 0)
-		while (src[i++] != 0)
+		while (i < len && src[i++] != 0)
 			;
 	if ((flags & COMMENT) != 0)
-		while (src[i++] != 0)
+		while (i < len && src[i++] != 0)
 			;
 	if ((flags & HEAD_CRC) != 0)
 		i += 2;
-	if (i >= *lenp) {
+	if (i >= len)
+		return -EAGAIN;
+
+	return i;
+}
+
+int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
+{
+	int i;
+
+	i = gunzip_header_len(src, *lenp);
+	if (i == -EINVAL) {
+		puts ("Error: Bad gzipped data\n");
+		return (-1);
+	}
+	if (i < 0) {
 		puts ("Error: gunzip out of data in header\n");
 		return (-1);
 	}
@@ -71,6 +91,89 @@ int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
 	return zunzip(dst, dstlen, src, lenp, 1, i);
 }
 
+int gunzip_stream_init(struct gunzip_stream *gs, const unsigned char *src,
+		       void *dst, int dstlen)
+{
+	z_stream *s;
+	int r;
+
+	memset(gs, '\0', sizeof(*gs));
+	s = calloc(1, sizeof(*s));
+	if (!s)
+		return -ENOMEM;
+	s->zalloc = gzalloc;
+	s->zfree = gzfree;
+
+	r = inflateInit2(s, -MAX_WBITS);
+	if (r != Z_OK) {
+		printf("Error: inflateInit2() returned %d\n", r);
+		free(s);
+		return -EIO;
+	}
+	s->next_out = dst;
+	s->avail_out = dstlen;
+	gs->zs = s;
+	gs->src = src;
+
+	return 0;
+}
+
+int gunzip_stream_feed(struct gunzip_stream *gs, unsigned long avail)
+{
+	z_stream *s = gs->zs;
+	int r;
+
+	if (gs->done)
+		return 1;
+
+	if (!gs->in) {
+		r = gunzip_header_len(gs->src, avail);
+		if (r == -EAGAIN)
+			return 0;
+		if (r < 0) {
+			puts("Error: Bad gzipped data\n");
+			return r;
+		}
+		gs->in = r;
+	}
+	if (avail <= gs->in)
+		return 0;
+
+	s->next_in = (unsigned char *)gs->src + gs->in;
+	s->avail_in = avail - gs->in;
+	do {
+		r = inflate(s, Z_NO_FLUSH);
+	} while (r == Z_OK && s->avail_in);
+	gs->in = s->next_in - gs->src;
+
+	switch (r) {
+	case Z_STREAM_END:
+		gs->done = true;
+		return 1;
+	case Z_OK:
+		return 0;
+	case Z_BUF_ERROR:
+		/* No progress: either output is full or input is used up */
+		return s->avail_out ? 0 : -ENOBUFS;
+	default:
+		printf("Error: inflate() returned %d\n", r);
+		return -EPROTO;
+	}
+}
+
+void gunzip_stream_end(struct gunzip_stream *gs, unsigned long *lenp)
+{
+	z_stream *s = gs->zs;
+
+	if (!s)
+		return;
+	if (lenp)
+		*lenp = s->total_out;
+	inflateEnd(s);
+	free(s);
+	gs->zs = NULL;
+}
+
 #ifdef CONFIG_CMD_UNZIP
 __weak
 void gzwrite_progress_init(u64 expectedsize)
@@ -88,6 +88,19 @@ static int isprime(unsigned int number)
 	return number % div != 0;
 }
 
+/* Change nel to the first prime number not smaller as nel. */
+static unsigned int hsize(size_t nel)
+{
+	/* double hashing needs at least 3 slots */
+	if (nel < 5)
+		nel = 5;
+	nel |= 1;		/* make odd */
+	while (!isprime(nel))
+		nel += 2;
+
+	return nel;
+}
+
 /*
  * Before using the hash table we must allocate memory for it.
  * Test for an existing table are done. We allocate one element
@@ -109,13 +122,9 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 	if (htab->table != NULL)
 		return 0;
 
-	/* Change nel to the first prime number not smaller as nel. */
-	nel |= 1;		/* make odd */
-	while (!isprime(nel))
-		nel += 2;
-
-	htab->size = nel;
+	htab->size = hsize(nel);
 	htab->filled = 0;
+	htab->deleted = 0;
 
 	/* allocate memory and zero out */
 	htab->table = (_ENTRY *) calloc(htab->size + 1, sizeof(_ENTRY));
@@ -159,6 +168,7 @@ void hdestroy_r(struct hsearch_data *htab)
 
 	/* the sign for an existing table is an value != NULL in htable */
 	htab->table = NULL;
+	htab->changes++;
 }
 
 /*
@@ -168,18 +178,22 @@ void hdestroy_r(struct hsearch_data *htab)
 /*
  * This is the search function. It uses double hashing with open addressing.
  * The argument item.key has to be a pointer to an zero terminated, most
- * probably strings of chars. The function for generating a number of the
- * strings is simple but fast. It can be replaced by a more complex function
- * like ajw (see [Aho,Sethi,Ullman]) if the needs are shown.
+ * probably strings of chars. The strings are hashed with FNV-1a.
  *
  * We use an trick to speed up the lookup. The table is created by hcreate
  * with one more element available. This enables us to use the index zero
- * special. This index will never be used because we store the first hash
- * index in the field used where zero means not used. Every other value
- * means used. The used field can be used as a first fast comparison for
- * equality of the stored and the parameter value. This helps to prevent
+ * special. This index will never be used because we store the hash of the
+ * key, which is never zero, in the field used where zero means not used and
+ * -1 means deleted. The used field can be used as a first fast comparison
+ * for equality of the stored and the parameter value. This helps to prevent
  * unnecessary expensive calls of strcmp.
  *
+ * Before a new entry makes the table three quarters full, counting deleted
+ * entries, the entries are moved to a new table. This is twice the size if
+ * at least half of the slots are in use, else it is the same size and just
+ * leaves the deleted entries behind. So ENTRY pointers and indexes returned
+ * for a table are only valid until the next entry is added to it.
+ *
  * This implementation differs from the standard library version of
  * this function in a number of ways:
  *
@@ -204,7 +218,7 @@ int hmatch_r(const char *match, int last_idx, ENTRY ** retval,
 	unsigned int idx;
 	size_t key_len = strlen(match);
 
-	for (idx = last_idx + 1; idx < htab->size; ++idx) {
+	for (idx = last_idx + 1; idx <= htab->size; ++idx) {
 		if (htab->table[idx].used <= 0)
 			continue;
 		if (!strncmp(match, htab->table[idx].entry.key, key_len)) {
@@ -218,18 +232,107 @@ int hmatch_r(const char *match, int last_idx, ENTRY ** retval,
 	return 0;
 }
 
+/* FNV-1a hash of a key, made positive and non-zero to mark a used slot */
+static int hhash(const char *key)
+{
+	unsigned int hash = 2166136261U;
+
+	while (*key)
+		hash = (hash ^ (unsigned char)*key++) * 16777619U;
+	hash &= 0x7fffffff;
+
+	return hash ? hash : 1;
+}
+
+/* First slot to try for a hash, which is never zero */
+static inline unsigned int hfirst(struct hsearch_data *htab, int hval)
+{
+	unsigned int idx = (unsigned int)hval % htab->size;
+
+	return idx ? idx : 1;
+}
+
+/* Distance between the slots tried, as suggested in [Knuth] */
+static inline unsigned int hstep(struct hsearch_data *htab, int hval)
+{
+	return 1 + (unsigned int)hval / htab->size % (htab->size - 2);
+}
+
+static inline unsigned int hnext(struct hsearch_data *htab, unsigned int idx,
+				 unsigned int step)
+{
+	/* Because SIZE is prime this steps through all available indices. */
+	return idx <= step ? htab->size + idx - step : idx - step;
+}
+
+/* Find a free or deleted slot for a new entry */
+static unsigned int hfree(struct hsearch_data *htab, int hval)
+{
+	unsigned int idx = hfirst(htab, hval), step = hstep(htab, hval);
+
+	while (htab->table[idx].used > 0)
+		idx = hnext(htab, idx, step);
+
+	return idx;
+}
+
+/*
+ * Move the entries to a new table of at least nel slots, leaving the
+ * deleted ones behind.
+ */
+static int hresize(struct hsearch_data *htab, size_t nel)
+{
+	_ENTRY *old = htab->table;
+	unsigned int old_size = htab->size;
+	unsigned int i;
+
+	nel = hsize(nel);
+	debug("Resize Hash Table: %p, N=%u to %u, %u deleted\n", htab,
+	      old_size, (unsigned int)nel, htab->deleted);
+	htab->table = calloc(nel + 1, sizeof(_ENTRY));
+	if (!htab->table) {
+		htab->table = old;
+		return 0;
+	}
+	htab->size = nel;
+	htab->deleted = 0;
+
+	for (i = 1; i <= old_size; ++i) {
+		if (old[i].used > 0)
+			htab->table[hfree(htab, old[i].used)] = old[i];
+	}
+	free(old);
+
+	return 1;
+}
+
+/* Find an entry again after a callback, which may have moved the table */
+static unsigned int hrefind(struct hsearch_data *htab, const char *key,
+			    _ENTRY *table, unsigned int idx)
+{
+	ENTRY e, *ep;
+
+	if (htab->table == table)
+		return idx;
+	e.key = key;
+
+	return hsearch_r(e, FIND, &ep, htab, 0);
+}
+
 /*
  * Compare an existing entry with the desired key, and overwrite if the action
  * is ENTER.  This is simply a helper function for hsearch_r().
  */
 static inline int _compare_and_overwrite_entry(ENTRY item, ACTION action,
 	ENTRY **retval, struct hsearch_data *htab, int flag,
-	unsigned int hval, unsigned int idx)
+	int hval, unsigned int idx)
 {
 	if (htab->table[idx].used == hval
 	    && strcmp(item.key, htab->table[idx].entry.key) == 0) {
 		/* Overwrite existing value? */
 		if ((action == ENTER) && (item.data != NULL)) {
+			_ENTRY *table = htab->table;
+
 			/* check for permission */
 			if (htab->change_ok != NULL && htab->change_ok(
 			    &htab->table[idx].entry, item.data,
@@ -252,6 +355,13 @@ static inline int _compare_and_overwrite_entry(ENTRY item, ACTION action,
 				return 0;
 			}
 
+			idx = hrefind(htab, item.key, table, idx);
+			if (!idx) {
+				*retval = NULL;
+				return 0;
+			}
+			if (strcmp(item.data, htab->table[idx].entry.data))
+				htab->changes++;
 			free(htab->table[idx].entry.data);
 			htab->table[idx].entry.data = strdup(item.data);
 			if (!htab->table[idx].entry.data) {
@@ -271,82 +381,44 @@ static inline int _compare_and_overwrite_entry(ENTRY item, ACTION action,
 int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 	      struct hsearch_data *htab, int flag)
 {
-	unsigned int hval;
-	unsigned int count;
-	unsigned int len = strlen(item.key);
-	unsigned int idx;
+	int hval = hhash(item.key);
+	unsigned int first, step, idx;
 	unsigned int first_deleted = 0;
+	_ENTRY *table;
 	int ret;
 
-	/* Compute an value for the given string. Perhaps use a better method. */
-	hval = len;
-	count = len;
-	while (count-- > 0) {
-		hval <<= 4;
-		hval += item.key[count];
-	}
+	first = hfirst(htab, hval);
+	step = hstep(htab, hval);
+	idx = first;
 
-	/*
-	 * First hash function:
-	 * simply take the modul but prevent zero.
-	 */
-	hval %= htab->size;
-	if (hval == 0)
-		++hval;
-
-	/* The first index tried. */
-	idx = hval;
-
-	if (htab->table[idx].used) {
-		/*
-		 * Further action might be required according to the
-		 * action value.
-		 */
-		unsigned hval2;
-
-		if (htab->table[idx].used == -1
-		    && !first_deleted)
-			first_deleted = idx;
-
-		ret = _compare_and_overwrite_entry(item, action, retval, htab,
-			flag, hval, idx);
-		if (ret != -1)
-			return ret;
-
-		/*
-		 * Second hash function:
-		 * as suggested in [Knuth]
-		 */
-		hval2 = 1 + hval % (htab->size - 2);
-
-		do {
-			/*
-			 * Because SIZE is prime this guarantees to
-			 * step through all available indices.
-			 */
-			if (idx <= hval2)
-				idx = htab->size + idx - hval2;
-			else
-				idx -= hval2;
-
-			/*
-			 * If we visited all entries leave the loop
-			 * unsuccessfully.
-			 */
-			if (idx == hval)
-				break;
-
-			/* If entry is found use it. */
+	while (htab->table[idx].used) {
+		if (htab->table[idx].used == -1) {
+			if (!first_deleted)
+				first_deleted = idx;
+		} else {
 			ret = _compare_and_overwrite_entry(item, action, retval,
 				htab, flag, hval, idx);
 			if (ret != -1)
 				return ret;
 		}
-		while (htab->table[idx].used);
+
+		idx = hnext(htab, idx, step);
+
+		/* If we visited all entries leave the loop unsuccessfully. */
+		if (idx == first)
+			break;
 	}
 
 	/* An empty bucket has been found. */
 	if (action == ENTER) {
+		/* Grow the table or drop deleted entries, if needed */
+		if ((htab->filled + htab->deleted + 1) * 4 > htab->size * 3 &&
+		    hresize(htab, htab->filled * 2 >= htab->size ?
+				  htab->size * 2 : htab->size)) {
+			idx = hfree(htab, hval);
+			first_deleted = 0;
+		}
+
 		/*
 		 * If table is full and another entry should be
 		 * entered return with error.
@@ -361,8 +433,10 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 		 * Create new entry;
 		 * create copies of item.key and item.data
 		 */
-		if (first_deleted)
+		if (first_deleted) {
 			idx = first_deleted;
+			--htab->deleted;
+		}
 
 		htab->table[idx].used = hval;
 		htab->table[idx].entry.key = strdup(item.key);
@@ -375,6 +449,7 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 		}
 
 		++htab->filled;
+		htab->changes++;
 
 		/* This is a new entry, so look up a possible callback */
 		env_callback_init(&htab->table[idx].entry);
@@ -393,16 +468,25 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 		}
 
 		/* If there is a callback, call it */
+		table = htab->table;
 		if (htab->table[idx].entry.callback &&
 		    htab->table[idx].entry.callback(item.key, item.data,
 		    env_op_create, flag)) {
 			debug("callback() rejected setting variable "
 				"%s, skipping it!\n", item.key);
-			_hdelete(item.key, htab, &htab->table[idx].entry, idx);
+			idx = hrefind(htab, item.key, table, idx);
+			if (idx)
+				_hdelete(item.key, htab,
+					 &htab->table[idx].entry, idx);
 			__set_errno(EINVAL);
 			*retval = NULL;
 			return 0;
 		}
+		idx = hrefind(htab, item.key, table, idx);
+		if (!idx) {
+			*retval = NULL;
+			return 0;
+		}
 
 		/* return new entry */
 		*retval = &htab->table[idx].entry;
@@ -437,6 +521,8 @@ static void _hdelete(const char *key, struct hsearch_data *htab, ENTRY *ep,
 	htab->table[idx].used = -1;
 
 	--htab->filled;
+	++htab->deleted;
+	htab->changes++;
 }
 
 int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
@@ -474,6 +560,10 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 
 	_hdelete(key, htab, ep, idx);
 
+	/* Drop deleted entries once they slow down searches */
+	if (htab->deleted * 4 > htab->size)
+		hresize(htab, htab->size);
+
 	return 1;
 }
 
@@ -591,7 +681,7 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		 char **resp, size_t size,
 		 int argc, char * const argv[])
 {
-	ENTRY *list[htab->size];
+	ENTRY **list;
 	char *res, *p;
 	size_t totlen;
 	int i, n;
@@ -604,6 +694,12 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 
 	debug("EXPORT  table = %p, htab.size = %d, htab.filled = %d, size = %lu\n",
 	      htab, htab->size, htab->filled, (ulong)size);
+	/* The table grows, so keep the list off the stack */
+	list = malloc((htab->filled + 1) * sizeof(ENTRY *));
+	if (!list) {
+		__set_errno(ENOMEM);
+		return (-1);
+	}
 	/*
 	 * Pass 1:
 	 * search used entries,
@@ -623,7 +719,7 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 
 			list[n++] = ep;
 
-			totlen += strlen(ep->key) + 2;
+			totlen += strlen(ep->key);
 
 			if (sep == '\0') {
 				totlen += strlen(ep->data);
@@ -659,6 +755,7 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		if (size < totlen + 1) {	/* provided buffer too small */
 			printf("Env export buffer too small: %lu, but need %lu\n",
 			       (ulong)size, (ulong)totlen + 1);
+			free(list);
 			__set_errno(ENOMEM);
 			return (-1);
 		}
@@ -675,6 +772,7 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		/* no, allocate and clear one */
 		*resp = res = calloc(1, size);
 		if (res == NULL) {
+			free(list);
 			__set_errno(ENOMEM);
 			return (-1);
 		}
@@ -701,6 +799,7 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		*p++ = sep;
 	}
 	*p = '\0';		/* terminate result */
+	free(list);
 
 	return size;
 }
@@ -825,7 +924,8 @@ int himport_r(struct hsearch_data *htab,
 	 * environment size), so we clip it to a reasonable value.
 	 * On the other hand we need to add some more entries for free
 	 * space when importing very small buffers. Both boundaries can
-	 * be overwritten in the board config file if needed.
+	 * be overwritten in the board config file if needed. They only
+	 * set the starting size, as the table grows when it fills up.
 	 */
 
 	if (!htab->table) {
@@ -5,6 +5,7 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
 #include <initcall.h>
 #include <efi.h>
 
@@ -16,6 +17,7 @@ int initcall_run_list(const init_fnc_t init_sequence[])
 
 	for (init_fnc_ptr = init_sequence; *init_fnc_ptr; ++init_fnc_ptr) {
 		unsigned long reloc_ofs = 0;
+		ulong start;
 		int ret;
 
 		if (gd->flags & GD_FLG_RELOC)
@@ -28,7 +30,16 @@ int initcall_run_list(const init_fnc_t init_sequence[])
 			debug(" (relocated to %p)\n", (char *)*init_fnc_ptr);
 		else
 			debug("\n");
+		start = bootstage_prof_start();
 		ret = (*init_fnc_ptr)();
+		if (start != BOOTSTAGE_PROF_NONE) {
+			char name[20];
+
+			snprintf(name, sizeof(name), "%p",
+				 (char *)*init_fnc_ptr - reloc_ofs);
+			bootstage_prof_add(BOOTSTAGE_PROF_INITCALL, name, start,
+					   0, 0);
+		}
 		if (ret) {
 			printf("initcall sequence %p failed at call %p (err=%d)\n",
 			       init_sequence,
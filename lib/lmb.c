@@ -322,6 +322,35 @@ phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align, phy
 	return 0;
 }
 
+/*
+ * Return the number of bytes from addr to the end of the memory region
+ * holding it or to the next reserved region, whichever comes first, or 0 if
+ * addr is not free.
+ */
+phys_size_t lmb_get_free_size(struct lmb *lmb, phys_addr_t addr)
+{
+	phys_addr_t end;
+	long rgn;
+	int i;
+
+	rgn = lmb_overlaps_region(&lmb->memory, addr, 1);
+	if (rgn < 0)
+		return 0;
+	end = lmb->memory.region[rgn].base + lmb->memory.region[rgn].size;
+
+	for (i = 0; i < lmb->reserved.cnt; i++) {
+		phys_addr_t base = lmb->reserved.region[i].base;
+
+		if (lmb_addrs_overlap(addr, 1, base,
+				      lmb->reserved.region[i].size))
+			return 0;
+		if (base > addr && base < end)
+			end = base;
+	}
+
+	return end - addr;
+}
+
 int lmb_is_reserved(struct lmb *lmb, phys_addr_t addr)
 {
 	int i;
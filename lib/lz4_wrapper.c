@@ -63,49 +63,79 @@ struct lz4_block_header {
 	/* + u32 block_checksum iff has_block_checksum is set */
 } __packed;
 
-int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
+int ulz4_stream_init(struct ulz4_stream *s, const void *src, void *dst,
+		     size_t dstn)
+{
+	memset(s, '\0', sizeof(*s));
+	s->src = src;
+	s->dst = dst;
+	s->dstn = dstn;
+
+	return 0;
+}
+
+static int ulz4_stream_header(struct ulz4_stream *s, size_t avail)
 {
-	const void *end = dst + *dstn;
-	const void *in = src;
-	void *out = dst;
-	int has_block_checksum;
+	/* With in-place decompression the header may become invalid later. */
+	const struct lz4_frame_header *h = s->src;
+
+	if (avail < sizeof(*h) + sizeof(u64) + sizeof(u8))
+		return -EAGAIN;	/* input overrun */
+
+	/* We assume there's always only a single, standard frame. */
+	if (le32_to_cpu(h->magic) != LZ4F_MAGIC || h->version != 1)
+		return -EPROTONOSUPPORT;	/* unknown format */
+	if (h->reserved0 || h->reserved1 || h->reserved2)
+		return -EINVAL;	/* reserved must be zero */
+	if (!h->independent_blocks)
+		return -EPROTONOSUPPORT; /* we can't support this yet */
+	s->has_block_checksum = h->has_block_checksum;
+
+	s->in = sizeof(*h);
+	if (h->has_content_size)
+		s->in += sizeof(u64);
+	s->in += sizeof(u8);
+
+	return 0;
+}
+
+int ulz4_stream_feed(struct ulz4_stream *s, size_t avail)
+{
+	const void *end = s->dst + s->dstn;
+	const void *in;
+	void *out = s->dst + s->out;
 	int ret;
-	*dstn = 0;
-
-	{ /* With in-place decompression the header may become invalid later. */
-		const struct lz4_frame_header *h = in;
-
-		if (srcn < sizeof(*h) + sizeof(u64) + sizeof(u8))
-			return -EINVAL;	/* input overrun */
-
-		/* We assume there's always only a single, standard frame. */
-		if (le32_to_cpu(h->magic) != LZ4F_MAGIC || h->version != 1)
-			return -EPROTONOSUPPORT;	/* unknown format */
-		if (h->reserved0 || h->reserved1 || h->reserved2)
-			return -EINVAL;	/* reserved must be zero */
-		if (!h->independent_blocks)
-			return -EPROTONOSUPPORT; /* we can't support this yet */
-		has_block_checksum = h->has_block_checksum;
-
-		in += sizeof(*h);
-		if (h->has_content_size)
-			in += sizeof(u64);
-		in += sizeof(u8);
+
+	if (s->done)
+		return 1;
+
+	if (!s->in) {
+		ret = ulz4_stream_header(s, avail);
+		if (ret)
+			return ret == -EAGAIN ? 0 : ret;
 	}
 
+	/* Only blocks which have fully arrived are decompressed */
 	while (1) {
 		struct lz4_block_header b;
 
+		in = s->src + s->in;
+		if (s->in + sizeof(struct lz4_block_header) > avail) {
+			ret = 0;	/* wait for more input */
+			break;
+		}
 		b.raw = le32_to_cpu(*(u32 *)in);
 		in += sizeof(struct lz4_block_header);
 
-		if (in - src + b.size > srcn) {
-			ret = -EINVAL;		/* input overrun */
+		if (!b.size) {
+			s->done = true;
+			ret = 1;	/* decompression successful */
 			break;
 		}
 
-		if (!b.size) {
-			ret = 0;	/* decompression successful */
+		if (in - s->src + b.size +
+		    (s->has_block_checksum ? sizeof(u32) : 0) > avail) {
+			ret = 0;	/* wait for more input */
 			break;
 		}
 
@@ -130,10 +160,27 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 		}
 
 		in += b.size;
-		if (has_block_checksum)
+		if (s->has_block_checksum)
 			in += sizeof(u32);
+		s->in = in - s->src;
 	}
 
-	*dstn = out - dst;
+	s->out = out - s->dst;
+	return ret;
+}
+
+int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
+{
+	struct ulz4_stream s;
+	int ret;
+
+	ulz4_stream_init(&s, src, dst, *dstn);
+	ret = ulz4_stream_feed(&s, srcn);
+	if (!ret)
+		ret = -EINVAL;		/* input overrun */
+	else if (ret == 1)
+		ret = 0;
+
+	*dstn = s.out;
 	return ret;
 }
@@ -0,0 +1,400 @@
+/*
+ * Unflattened (live) copy of the control device tree
+ *
+ * Copyright (C) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <of_live.h>
+#include <linux/log2.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/*
+ * libfdt finds a property by comparing the name of each property of the node
+ * in turn, the parent of a node by walking the tree from the root, and a
+ * phandle by walking the whole tree. Here nodes have parent, child and
+ * sibling pointers, nodes with phandles are in a hash table, and property
+ * names are interned, so that a property is found by comparing pointers.
+ */
+#define OF_LIVE_HASH_MIN	16
+
+static uint of_live_hash(const char *str)
+{
+	uint hash = 2166136261U;
+
+	while (*str)
+		hash = (hash ^ (u8)*str++) * 16777619U;
+
+	return hash;
+}
+
+static bool of_live_is_phandle(const char *name)
+{
+	return !strcmp(name, "phandle") || !strcmp(name, "linux,phandle");
+}
+
+static uint of_live_hash_size(int count)
+{
+	return max_t(uint, roundup_pow_of_two(count * 2), OF_LIVE_HASH_MIN);
+}
+
+/* Return the interned copy of @name, adding it if @add */
+static const char *of_live_intern(const struct of_live *tree,
+				  const char *name, bool add)
+{
+	uint slot = of_live_hash(name) & tree->name_mask;
+
+	for (; tree->names[slot]; slot = (slot + 1) & tree->name_mask) {
+		if (!strcmp(tree->names[slot], name))
+			return tree->names[slot];
+	}
+	if (add)
+		tree->names[slot] = name;
+
+	return add ? name : NULL;
+}
+
+static void of_live_add_phandle(struct of_live *tree,
+				struct of_live_node *node)
+{
+	uint slot = node->phandle & tree->phandle_mask;
+
+	/* As fdt_node_offset_by_phandle(), the first node wins */
+	for (; tree->phandles[slot]; slot = (slot + 1) & tree->phandle_mask) {
+		if (tree->phandles[slot]->phandle == node->phandle)
+			return;
+	}
+	tree->phandles[slot] = node;
+}
+
+/*
+ * Walk the structure block, counting nodes, properties and phandles if @tree
+ * is NULL and filling in @tree if not
+ */
+static int of_live_walk(const void *blob, struct of_live *tree, int *nodesp,
+			int *propsp, int *phandlesp)
+{
+	struct of_live_node *node = NULL, *prev = NULL, *parent;
+	struct of_live_prop *base = tree ? tree->nodes[0].props : NULL;
+	const struct fdt_property *fprop;
+	struct of_live_prop *prop;
+	int offset = 0, next, depth = 0;
+	int nodes = 0, props = 0, phandles = 0;
+	const char *name;
+	uint32_t tag;
+
+	do {
+		tag = fdt_next_tag(blob, offset, &next);
+		if (next < 0)
+			return -EINVAL;
+		switch (tag) {
+		case FDT_BEGIN_NODE:
+			if (tree) {
+				parent = node;
+				node = &tree->nodes[nodes];
+				node->offset = offset;
+				node->name = fdt_get_name(blob, offset, NULL);
+				node->parent = parent;
+				node->props = &base[props];
+				if (prev)
+					prev->sibling = node;
+				else if (parent)
+					parent->child = node;
+				prev = NULL;
+			}
+			nodes++;
+			depth++;
+			break;
+		case FDT_END_NODE:
+			if (--depth < 0)
+				return -EINVAL;
+			if (tree) {
+				prev = node;
+				node = node->parent;
+			}
+			break;
+		case FDT_PROP:
+			if (!depth)
+				return -EINVAL;
+			fprop = fdt_get_property_by_offset(blob, offset, NULL);
+			if (!fprop)
+				return -EINVAL;
+			name = fdt_string(blob, fdt32_to_cpu(fprop->nameoff));
+			if (!name)
+				return -EINVAL;
+			if (of_live_is_phandle(name))
+				phandles++;
+			if (tree) {
+				/* Properties must come before subnodes */
+				prop = &node->props[node->prop_count++];
+				if (prop != &base[props])
+					return -EINVAL;
+				prop->name = of_live_intern(tree, name, true);
+				prop->value = fprop->data;
+				prop->len = fdt32_to_cpu(fprop->len);
+				if (of_live_is_phandle(name) && prop->len >= 4)
+					node->phandle = fdt32_to_cpu(
+						*(fdt32_t *)prop->value);
+			}
+			props++;
+			break;
+		}
+		offset = next;
+	} while (tag != FDT_END);
+
+	if (depth || !nodes)
+		return -EINVAL;
+	if (nodesp) {
+		*nodesp = nodes;
+		*propsp = props;
+		*phandlesp = phandles;
+	}
+
+	return 0;
+}
+
+int of_live_build(const void *blob, struct of_live **treep)
+{
+	struct of_live_prop *props;
+	struct of_live *tree;
+	int nodes, prop_count, phandles;
+	int i, ret;
+
+	*treep = NULL;
+	if (!blob || fdt_check_header(blob))
+		return -EINVAL;
+	ret = of_live_walk(blob, NULL, &nodes, &prop_count, &phandles);
+	if (ret)
+		return ret;
+
+	tree = calloc(1, sizeof(*tree));
+	if (!tree)
+		return -ENOMEM;
+	tree->blob = blob;
+	memcpy(&tree->hdr, blob, sizeof(tree->hdr));
+	tree->node_count = nodes;
+	tree->nodes = calloc(nodes, sizeof(*tree->nodes));
+	props = calloc(prop_count + 1, sizeof(*props));
+	tree->name_mask = of_live_hash_size(prop_count) - 1;
+	tree->names = calloc(tree->name_mask + 1, sizeof(*tree->names));
+	tree->phandle_mask = of_live_hash_size(phandles) - 1;
+	tree->phandles = calloc(tree->phandle_mask + 1,
+				sizeof(*tree->phandles));
+	if (!tree->nodes || !props || !tree->names || !tree->phandles) {
+		if (tree->nodes)
+			tree->nodes[0].props = props;
+		else
+			free(props);
+		of_live_free(tree);
+		return -ENOMEM;
+	}
+	/* The root node's properties come first, so it owns the array */
+	tree->nodes[0].props = props;
+
+	ret = of_live_walk(blob, tree, NULL, NULL, NULL);
+	if (ret) {
+		of_live_free(tree);
+		return ret;
+	}
+	for (i = 0; i < nodes; i++) {
+		if (tree->nodes[i].phandle)
+			of_live_add_phandle(tree, &tree->nodes[i]);
+	}
+	*treep = tree;
+
+	return 0;
+}
+
+void of_live_free(struct of_live *tree)
+{
+	if (!tree)
+		return;
+	if (tree->nodes)
+		free(tree->nodes[0].props);
+	free(tree->nodes);
+	free(tree->names);
+	free(tree->phandles);
+	free(tree);
+}
+
+struct of_live_node *of_live_find_node(const struct of_live *tree, int offset)
+{
+	int low = 0, high = tree->node_count - 1, mid;
+
+	while (low <= high) {
+		mid = (low + high) / 2;
+		if (tree->nodes[mid].offset == offset)
+			return &tree->nodes[mid];
+		if (tree->nodes[mid].offset < offset)
+			low = mid + 1;
+		else
+			high = mid - 1;
+	}
+
+	return NULL;
+}
+
+const struct of_live_prop *of_live_find_prop(const struct of_live *tree,
+					     const struct of_live_node *node,
+					     const char *name)
+{
+	const char *iname = of_live_intern(tree, name, false);
+	int i;
+
+	/* A name which is not interned is not used by any property */
+	if (!iname)
+		return NULL;
+	for (i = 0; i < node->prop_count; i++) {
+		if (node->props[i].name == iname)
+			return &node->props[i];
+	}
+
+	return NULL;
+}
+
+#if CONFIG_IS_ENABLED(OF_LIVE)
+void of_live_sync(void)
+{
+	int ret;
+
+	of_live_free(gd->of_live);
+	gd->of_live = NULL;
+	if (!(gd->flags & GD_FLG_RELOC))
+		return;
+
+	/* Without it the flat tree is used, so a failure is not fatal */
+	ret = of_live_build(gd->fdt_blob, &gd->of_live);
+	if (ret)
+		debug("%s: no live tree: %d\n", __func__, ret);
+}
+
+/* Return the live tree for @blob, if there is one and it is up to date */
+static struct of_live *of_live_tree(const void *blob)
+{
+	struct of_live *tree = gd->of_live;
+
+	if (!tree || tree->blob != blob ||
+	    memcmp(&tree->hdr, blob, sizeof(tree->hdr)))
+		return NULL;
+
+	return tree;
+}
+
+/* Return the node at @offset if there is a live tree for @blob */
+static struct of_live_node *of_live_get(const void *blob, int offset)
+{
+	struct of_live *tree = of_live_tree(blob);
+
+	if (!tree || offset < 0)
+		return NULL;
+
+	return of_live_find_node(tree, offset);
+}
+
+const void *of_live_getprop(const void *blob, int node, const char *name,
+			    int *lenp)
+{
+	struct of_live_node *np = of_live_get(blob, node);
+	const struct of_live_prop *prop;
+
+	if (!np)
+		return fdt_getprop(blob, node, name, lenp);
+
+	prop = of_live_find_prop(gd->of_live, np, name);
+	if (lenp)
+		*lenp = prop ? prop->len : -FDT_ERR_NOTFOUND;
+
+	return prop ? prop->value : NULL;
+}
+
+int of_live_parent_offset(const void *blob, int node)
+{
+	struct of_live_node *np = of_live_get(blob, node);
+
+	if (!np)
+		return fdt_parent_offset(blob, node);
+
+	return np->parent ? np->parent->offset : -FDT_ERR_NOTFOUND;
+}
+
+/* Match a node name as libfdt does, ignoring a unit address not in @name */
+static bool of_live_name_eq(const char *node_name, const char *name, int len)
+{
+	if (strncmp(node_name, name, len))
+		return false;
+
+	return !node_name[len] ||
+	       (node_name[len] == '@' && !memchr(name, '@', len));
+}
+
+int of_live_path_offset(const void *blob, const char *path)
+{
+	struct of_live_node *np = of_live_get(blob, 0);
+	const char *end;
+	int len;
+
+	/* Aliases are left to libfdt */
+	if (!np || *path != '/')
+		return fdt_path_offset(blob, path);
+
+	while (np && *path) {
+		while (*path == '/')
+			path++;
+		if (!*path)
+			break;
+		end = strchr(path, '/');
+		len = end ? end - path : strlen(path);
+		for (np = np->child; np; np = np->sibling) {
+			if (of_live_name_eq(np->name, path, len))
+				break;
+		}
+		path += len;
+	}
+
+	return np ? np->offset : -FDT_ERR_NOTFOUND;
+}
+
+int of_live_node_by_phandle(const void *blob, uint32_t phandle)
+{
+	struct of_live *tree = of_live_tree(blob);
+	uint slot;
+
+	if (!tree)
+		return fdt_node_offset_by_phandle(blob, phandle);
+	if (phandle == 0 || phandle == (uint32_t)-1)
+		return -FDT_ERR_BADPHANDLE;
+
+	for (slot = phandle & tree->phandle_mask; tree->phandles[slot];
+	     slot = (slot + 1) & tree->phandle_mask) {
+		if (tree->phandles[slot]->phandle == phandle)
+			return tree->phandles[slot]->offset;
+	}
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+int of_live_first_subnode(const void *blob, int node)
+{
+	struct of_live_node *np = of_live_get(blob, node);
+
+	if (!np)
+		return fdt_first_subnode(blob, node);
+
+	return np->child ? np->child->offset : -FDT_ERR_NOTFOUND;
+}
+
+int of_live_next_subnode(const void *blob, int node)
+{
+	struct of_live_node *np = of_live_get(blob, node);
+
+	if (!np)
+		return fdt_next_subnode(blob, node);
+
+	return np->sibling ? np->sibling->offset : -FDT_ERR_NOTFOUND;
+}
+#endif
@@ -220,6 +220,31 @@ static void sha1_process(sha1_context *ctx, const unsigned char data[64])
 	ctx->state[4] += E;
 }
 
+void sha1_blocks_ref(sha1_context *ctx, const unsigned char *data,
+		     unsigned int blocks)
+{
+	for (; blocks; blocks--, data += 64)
+		sha1_process(ctx, data);
+}
+
+static void sha1_blocks(sha1_context *ctx, const unsigned char *data,
+			unsigned int blocks)
+{
+#if defined(CONFIG_SHA_SIMD) && !defined(CONFIG_SPL_BUILD) && \
+	!defined(USE_HOSTCC)
+	if (sha_simd_usable()) {
+		sha1_blocks_simd(ctx, data, blocks);
+		return;
+	}
+#endif
+#if defined(CONFIG_SHA_UNROLLED) && !defined(CONFIG_SPL_BUILD) && \
+	!defined(USE_HOSTCC)
+	sha1_blocks_unrolled(ctx, data, blocks);
+#else
+	sha1_blocks_ref(ctx, data, blocks);
+#endif
+}
+
 /*
  * SHA-1 process buffer
  */
@@ -243,16 +268,16 @@ void sha1_update(sha1_context *ctx, const unsigned char *input,
 
 	if (left && ilen >= fill) {
 		memcpy ((void *) (ctx->buffer + left), (void *) input, fill);
-		sha1_process (ctx, ctx->buffer);
+		sha1_blocks(ctx, ctx->buffer, 1);
 		input += fill;
 		ilen -= fill;
 		left = 0;
 	}
 
-	while (ilen >= 64) {
-		sha1_process (ctx, input);
-		input += 64;
-		ilen -= 64;
+	if (ilen >= 64) {
+		sha1_blocks(ctx, input, ilen / 64);
+		input += ilen & ~63;
+		ilen &= 63;
 	}
 
 	if (ilen > 0) {
@@ -187,6 +187,31 @@ static void sha256_process(sha256_context *ctx, const uint8_t data[64])
 	ctx->state[7] += H;
 }
 
+void sha256_blocks_ref(sha256_context *ctx, const uint8_t *data,
+		       unsigned int blocks)
+{
+	for (; blocks; blocks--, data += 64)
+		sha256_process(ctx, data);
+}
+
+static void sha256_blocks(sha256_context *ctx, const uint8_t *data,
+			  unsigned int blocks)
+{
+#if defined(CONFIG_SHA_SIMD) && !defined(CONFIG_SPL_BUILD) && \
+	!defined(USE_HOSTCC)
+	if (sha_simd_usable()) {
+		sha256_blocks_simd(ctx, data, blocks);
+		return;
+	}
+#endif
+#if defined(CONFIG_SHA_UNROLLED) && !defined(CONFIG_SPL_BUILD) && \
+	!defined(USE_HOSTCC)
+	sha256_blocks_unrolled(ctx, data, blocks);
+#else
+	sha256_blocks_ref(ctx, data, blocks);
+#endif
+}
+
 void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
 {
 	uint32_t left, fill;
@@ -205,16 +230,16 @@ void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
 
 	if (left && length >= fill) {
 		memcpy((void *) (ctx->buffer + left), (void *) input, fill);
-		sha256_process(ctx, ctx->buffer);
+		sha256_blocks(ctx, ctx->buffer, 1);
 		length -= fill;
 		input += fill;
 		left = 0;
 	}
 
-	while (length >= 64) {
-		sha256_process(ctx, input);
-		length -= 64;
-		input += 64;
+	if (length >= 64) {
+		sha256_blocks(ctx, input, length / 64);
+		input += length & ~63;
+		length &= 63;
 	}
 
 	if (length)
@@ -0,0 +1,186 @@
+/*
+ * SHA-1 and SHA-256 block functions with a SIMD message schedule
+ *
+ * Copyright (C) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+#include "sha_unrolled.h"
+
+/*
+ * The message schedule of a block is computed four words at a time with
+ * GCC vector extensions, which become NEON instructions on ARMv7 (this file
+ * is built with -mfpu=neon) and SSE on a sandbox host. The schedule words,
+ * with the round constants added, are then consumed by the same scalar
+ * rounds as the unrolled versions.
+ */
+typedef uint32_t sha_v4 __attribute__((vector_size(16)));
+/* The same, for loads and stores at any word in an array */
+typedef uint32_t sha_v4_u32 __attribute__((vector_size(16), aligned(4)));
+
+static inline sha_v4 sha_v4_load(const uint32_t *p)
+{
+	return *(const sha_v4_u32 *)p;
+}
+
+static inline void sha_v4_store(uint32_t *p, sha_v4 v)
+{
+	*(sha_v4_u32 *)p = v;
+}
+
+#define V4_ROL(x, n)	(((x) << (n)) | ((x) >> (32 - (n))))
+#define V4_ROR(x, n)	(((x) >> (n)) | ((x) << (32 - (n))))
+
+#ifdef CONFIG_ARM
+/*
+ * NEON is disabled out of reset and is left to the arch start-up code to
+ * enable. If it has not, the callers fall back to the scalar version.
+ */
+int sha_simd_usable(void)
+{
+	uint32_t cpacr, fpexc;
+
+	/* FPEXC cannot be read without access to cp10 and cp11 */
+	asm volatile("mrc p15, 0, %0, c1, c0, 2" : "=r" (cpacr));
+	if ((cpacr & (0xf << 20)) != (0xf << 20))
+		return 0;
+	asm volatile("vmrs %0, fpexc" : "=r" (fpexc));
+
+	return !!(fpexc & (1 << 30));
+}
+#else
+int sha_simd_usable(void)
+{
+	return 1;
+}
+#endif
+
+static void sha1_schedule(uint32_t w[80], uint32_t wk[80])
+{
+	sha_v4 x, k = { SHA1_K1, SHA1_K1, SHA1_K1, SHA1_K1 };
+	int t;
+
+	for (t = 0; t < 16; t += 4)
+		sha_v4_store(&wk[t], sha_v4_load(&w[t]) + k);
+
+	for (t = 16; t < 80; t += 4) {
+		/* w[t] is not known yet, so leave it out of the last lane */
+		x = (sha_v4){ w[t - 3], w[t - 2], w[t - 1], 0 };
+		x ^= sha_v4_load(&w[t - 8]) ^ sha_v4_load(&w[t - 14]) ^
+		     sha_v4_load(&w[t - 16]);
+		x = V4_ROL(x, 1);
+		/* ...and add it in now, rotated once more */
+		x[3] ^= ROL32(x[0], 1);
+		sha_v4_store(&w[t], x);
+
+		if (t == 20)
+			k = (sha_v4){ SHA1_K2, SHA1_K2, SHA1_K2, SHA1_K2 };
+		else if (t == 40)
+			k = (sha_v4){ SHA1_K3, SHA1_K3, SHA1_K3, SHA1_K3 };
+		else if (t == 60)
+			k = (sha_v4){ SHA1_K4, SHA1_K4, SHA1_K4, SHA1_K4 };
+		sha_v4_store(&wk[t], x + k);
+	}
+}
+
+#define SHA1_WK(t)	wk[t]
+
+void sha1_blocks_simd(sha1_context *ctx, const unsigned char *data,
+		      unsigned int blocks)
+{
+	uint32_t a, b, c, d, e;
+	uint32_t w[80], wk[80], buf[16];
+	const uint32_t *p;
+	int i;
+
+	a = ctx->state[0];
+	b = ctx->state[1];
+	c = ctx->state[2];
+	d = ctx->state[3];
+	e = ctx->state[4];
+
+	for (; blocks; blocks--, data += 64) {
+		p = sha_block_words(data, buf);
+		for (i = 0; i < 16; i++)
+			w[i] = be32_to_cpu(p[i]);
+		sha1_schedule(w, wk);
+
+		SHA1_ROUND20(SHA1_F1, SHA1_WK, 0);
+		SHA1_ROUND20(SHA1_F2, SHA1_WK, 20);
+		SHA1_ROUND20(SHA1_F3, SHA1_WK, 40);
+		SHA1_ROUND20(SHA1_F4, SHA1_WK, 60);
+
+		ctx->state[0] = a += ctx->state[0];
+		ctx->state[1] = b += ctx->state[1];
+		ctx->state[2] = c += ctx->state[2];
+		ctx->state[3] = d += ctx->state[3];
+		ctx->state[4] = e += ctx->state[4];
+	}
+}
+
+#define V4_s0(x)	(V4_ROR(x, 7) ^ V4_ROR(x, 18) ^ ((x) >> 3))
+#define V4_s1(x)	(V4_ROR(x, 17) ^ V4_ROR(x, 19) ^ ((x) >> 10))
+
+static void sha256_schedule(uint32_t w[64], uint32_t wk[64])
+{
+	sha_v4 x;
+	int t;
+
+	for (t = 0; t < 16; t += 4) {
+		sha_v4_store(&wk[t],
+			     sha_v4_load(&w[t]) + sha_v4_load(&sha256_k[t]));
+	}
+
+	for (t = 16; t < 64; t += 4) {
+		x = V4_s0(sha_v4_load(&w[t - 15])) + sha_v4_load(&w[t - 7]) +
+		    sha_v4_load(&w[t - 16]);
+		/* The first two lanes depend only on earlier words... */
+		x += V4_s1(((sha_v4){ w[t - 2], w[t - 1], 0, 0 }));
+		/* ...and the last two on the first two */
+		x += V4_s1(((sha_v4){ 0, 0, x[0], x[1] }));
+		sha_v4_store(&w[t], x);
+		sha_v4_store(&wk[t], x + sha_v4_load(&sha256_k[t]));
+	}
+}
+
+#define SHA256_WK(t)	wk[t]
+
+void sha256_blocks_simd(sha256_context *ctx, const uint8_t *data,
+			unsigned int blocks)
+{
+	uint32_t a, b, c, d, e, f, g, h;
+	uint32_t w[64], wk[64], buf[16];
+	const uint32_t *p;
+	int i;
+
+	a = ctx->state[0];
+	b = ctx->state[1];
+	c = ctx->state[2];
+	d = ctx->state[3];
+	e = ctx->state[4];
+	f = ctx->state[5];
+	g = ctx->state[6];
+	h = ctx->state[7];
+
+	for (; blocks; blocks--, data += 64) {
+		p = sha_block_words(data, buf);
+		for (i = 0; i < 16; i++)
+			w[i] = be32_to_cpu(p[i]);
+		sha256_schedule(w, wk);
+
+		SHA256_ROUND64(SHA256_WK);
+
+		a = ctx->state[0] += a;
+		b = ctx->state[1] += b;
+		c = ctx->state[2] += c;
+		d = ctx->state[3] += d;
+		e = ctx->state[4] += e;
+		f = ctx->state[5] += f;
+		g = ctx->state[6] += g;
+		h = ctx->state[7] += h;
+	}
+}
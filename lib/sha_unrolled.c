@@ -0,0 +1,123 @@
+/*
+ * Unrolled SHA-1 and SHA-256 block functions
+ *
+ * Copyright (C) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+#include "sha_unrolled.h"
+
+/*
+ * These compute the same as sha1_blocks_ref() and sha256_blocks_ref(), but
+ * keep the state in 32-bit locals across blocks, load the message a word at
+ * a time and keep only the last 16 words of the message schedule.
+ */
+
+const uint32_t sha256_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+/* Word @t of the SHA-1 message schedule, kept in a ring of 16 */
+#define SHA1_W(t)	w[(t) & 15]
+#define SHA1_X(t)							\
+	((t) < 16 ? SHA1_W(t) :						\
+	 (SHA1_W(t) = ROL32(SHA1_W((t) - 3) ^ SHA1_W((t) - 8) ^		\
+			    SHA1_W((t) - 14) ^ SHA1_W(t), 1)))
+
+#define SHA1_WK1(t)	(SHA1_X(t) + SHA1_K1)
+#define SHA1_WK2(t)	(SHA1_X(t) + SHA1_K2)
+#define SHA1_WK3(t)	(SHA1_X(t) + SHA1_K3)
+#define SHA1_WK4(t)	(SHA1_X(t) + SHA1_K4)
+
+void sha1_blocks_unrolled(sha1_context *ctx, const unsigned char *data,
+			  unsigned int blocks)
+{
+	uint32_t a, b, c, d, e;
+	uint32_t w[16], buf[16];
+	const uint32_t *p;
+	int i;
+
+	a = ctx->state[0];
+	b = ctx->state[1];
+	c = ctx->state[2];
+	d = ctx->state[3];
+	e = ctx->state[4];
+
+	for (; blocks; blocks--, data += 64) {
+		p = sha_block_words(data, buf);
+		for (i = 0; i < 16; i++)
+			w[i] = be32_to_cpu(p[i]);
+
+		SHA1_ROUND20(SHA1_F1, SHA1_WK1, 0);
+		SHA1_ROUND20(SHA1_F2, SHA1_WK2, 20);
+		SHA1_ROUND20(SHA1_F3, SHA1_WK3, 40);
+		SHA1_ROUND20(SHA1_F4, SHA1_WK4, 60);
+
+		/* The state is an unsigned long, so keep it to 32 bits */
+		ctx->state[0] = a += ctx->state[0];
+		ctx->state[1] = b += ctx->state[1];
+		ctx->state[2] = c += ctx->state[2];
+		ctx->state[3] = d += ctx->state[3];
+		ctx->state[4] = e += ctx->state[4];
+	}
+}
+
+#define SHA256_W(t)	w[(t) & 15]
+#define SHA256_WK(t)							\
+	(sha256_k[t] + ((t) < 16 ? SHA256_W(t) :			\
+	 (SHA256_W(t) += SHA256_s1(SHA256_W((t) - 2)) +			\
+			 SHA256_W((t) - 7) + SHA256_s0(SHA256_W((t) - 15)))))
+
+void sha256_blocks_unrolled(sha256_context *ctx, const uint8_t *data,
+			    unsigned int blocks)
+{
+	uint32_t a, b, c, d, e, f, g, h;
+	uint32_t w[16], buf[16];
+	const uint32_t *p;
+	int i;
+
+	a = ctx->state[0];
+	b = ctx->state[1];
+	c = ctx->state[2];
+	d = ctx->state[3];
+	e = ctx->state[4];
+	f = ctx->state[5];
+	g = ctx->state[6];
+	h = ctx->state[7];
+
+	for (; blocks; blocks--, data += 64) {
+		p = sha_block_words(data, buf);
+		for (i = 0; i < 16; i++)
+			w[i] = be32_to_cpu(p[i]);
+
+		SHA256_ROUND64(SHA256_WK);
+
+		a = ctx->state[0] += a;
+		b = ctx->state[1] += b;
+		c = ctx->state[2] += c;
+		d = ctx->state[3] += d;
+		e = ctx->state[4] += e;
+		f = ctx->state[5] += f;
+		g = ctx->state[6] += g;
+		h = ctx->state[7] += h;
+	}
+}
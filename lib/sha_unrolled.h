@@ -0,0 +1,105 @@
+/*
+ * Round macros shared by the unrolled SHA-1 and SHA-256 code
+ *
+ * Copyright (C) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __SHA_UNROLLED_H
+#define __SHA_UNROLLED_H
+
+#define ROL32(x, n)	(((x) << (n)) | ((x) >> (32 - (n))))
+#define ROR32(x, n)	(((x) >> (n)) | ((x) << (32 - (n))))
+
+#define SHA1_K1		0x5a827999
+#define SHA1_K2		0x6ed9eba1
+#define SHA1_K3		0x8f1bbcdc
+#define SHA1_K4		0xca62c1d6
+
+#define SHA1_F1(b, c, d)	((d) ^ ((b) & ((c) ^ (d))))
+#define SHA1_F2(b, c, d)	((b) ^ (c) ^ (d))
+#define SHA1_F3(b, c, d)	(((b) & (c)) | ((d) & ((b) | (c))))
+#define SHA1_F4			SHA1_F2
+
+/* One round, @wk being the schedule word plus the round constant */
+#define SHA1_ROUND(a, b, c, d, e, f, wk) do {				\
+	e += ROL32(a, 5) + f(b, c, d) + (wk);				\
+	b = ROL32(b, 30);						\
+} while (0)
+
+/*
+ * Rounds @t to @t + 4, after which the variables are back in place. @WK(t)
+ * gives the schedule word plus the round constant for round t.
+ */
+#define SHA1_ROUND5(f, WK, t) do {					\
+	SHA1_ROUND(a, b, c, d, e, f, WK(t));				\
+	SHA1_ROUND(e, a, b, c, d, f, WK((t) + 1));			\
+	SHA1_ROUND(d, e, a, b, c, f, WK((t) + 2));			\
+	SHA1_ROUND(c, d, e, a, b, f, WK((t) + 3));			\
+	SHA1_ROUND(b, c, d, e, a, f, WK((t) + 4));			\
+} while (0)
+
+#define SHA1_ROUND20(f, WK, t) do {					\
+	SHA1_ROUND5(f, WK, t);						\
+	SHA1_ROUND5(f, WK, (t) + 5);					\
+	SHA1_ROUND5(f, WK, (t) + 10);					\
+	SHA1_ROUND5(f, WK, (t) + 15);					\
+} while (0)
+
+#define SHA256_S0(x)	(ROR32(x, 2) ^ ROR32(x, 13) ^ ROR32(x, 22))
+#define SHA256_S1(x)	(ROR32(x, 6) ^ ROR32(x, 11) ^ ROR32(x, 25))
+#define SHA256_s0(x)	(ROR32(x, 7) ^ ROR32(x, 18) ^ ((x) >> 3))
+#define SHA256_s1(x)	(ROR32(x, 17) ^ ROR32(x, 19) ^ ((x) >> 10))
+
+#define SHA256_CH(e, f, g)	((g) ^ ((e) & ((f) ^ (g))))
+#define SHA256_MAJ(a, b, c)	(((a) & (b)) | ((c) & ((a) | (b))))
+
+#define SHA256_ROUND(a, b, c, d, e, f, g, h, wk) do {			\
+	uint32_t t1 = h + SHA256_S1(e) + SHA256_CH(e, f, g) + (wk);	\
+									\
+	d += t1;							\
+	h = t1 + SHA256_S0(a) + SHA256_MAJ(a, b, c);			\
+} while (0)
+
+/* Rounds @t to @t + 7, after which the variables are back in place */
+#define SHA256_ROUND8(WK, t) do {					\
+	SHA256_ROUND(a, b, c, d, e, f, g, h, WK(t));			\
+	SHA256_ROUND(h, a, b, c, d, e, f, g, WK((t) + 1));		\
+	SHA256_ROUND(g, h, a, b, c, d, e, f, WK((t) + 2));		\
+	SHA256_ROUND(f, g, h, a, b, c, d, e, WK((t) + 3));		\
+	SHA256_ROUND(e, f, g, h, a, b, c, d, WK((t) + 4));		\
+	SHA256_ROUND(d, e, f, g, h, a, b, c, WK((t) + 5));		\
+	SHA256_ROUND(c, d, e, f, g, h, a, b, WK((t) + 6));		\
+	SHA256_ROUND(b, c, d, e, f, g, h, a, WK((t) + 7));		\
+} while (0)
+
+#define SHA256_ROUND64(WK) do {						\
+	SHA256_ROUND8(WK, 0);						\
+	SHA256_ROUND8(WK, 8);						\
+	SHA256_ROUND8(WK, 16);						\
+	SHA256_ROUND8(WK, 24);						\
+	SHA256_ROUND8(WK, 32);						\
+	SHA256_ROUND8(WK, 40);						\
+	SHA256_ROUND8(WK, 48);						\
+	SHA256_ROUND8(WK, 56);						\
+} while (0)
+
+extern const uint32_t sha256_k[64];
+
+/*
+ * Return the 16 big-endian words of the block at @data, copying it to @buf
+ * first if it is not word-aligned
+ */
+static inline const uint32_t *sha_block_words(const unsigned char *data,
+					      uint32_t buf[16])
+{
+	if ((unsigned long)data & 3) {
+		memcpy(buf, data, 64);
+		return buf;
+	}
+
+	return (const uint32_t *)data;
+}
+
+#endif /* __SHA_UNROLLED_H */
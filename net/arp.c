@@ -27,28 +27,137 @@
 # define ARP_TIMEOUT_COUNT	CONFIG_NET_RETRY_COUNT
 #endif
 
-struct in_addr net_arp_wait_packet_ip;
-static struct in_addr net_arp_wait_reply_ip;
-/* MAC address of waiting packet's destination */
-uchar	       *arp_wait_packet_ethaddr;
-int		arp_wait_tx_packet_size;
-ulong		arp_wait_timer_start;
-int		arp_wait_try;
+#ifndef	CONFIG_ARP_CACHE_TIMEOUT
+/* Milliseconds an ARP cache entry is used before asking again */
+# define ARP_CACHE_TIMEOUT	60000UL
+#else
+# define ARP_CACHE_TIMEOUT	CONFIG_ARP_CACHE_TIMEOUT
+#endif
+
+#define ARP_CACHE_SIZE		CONFIG_NET_ARP_CACHE_SIZE
+#define ARP_QUEUE_SIZE		CONFIG_NET_ARP_QUEUE_SIZE
+
+/* A neighbour whose MAC address we know, kept across net_loop() calls */
+struct arp_entry {
+	struct in_addr ip;	/* next hop; 0 if the entry is free */
+	uchar ethaddr[ARP_HLEN];
+	int dev;		/* index of the ethernet device it is on */
+	ulong time;		/* when it was last heard from */
+};
+
+/* A packet waiting for the MAC address of its next hop */
+struct arp_wait {
+	struct in_addr packet_ip; /* destination; 0 if the slot is free */
+	struct in_addr reply_ip;  /* next hop, the server or the gateway */
+	uchar *ethaddr;		/* where to save the MAC address, or NULL */
+	uchar *packet;
+	int size;
+	ulong timer_start;
+	int try;
+};
+
+static struct arp_entry arp_cache[ARP_CACHE_SIZE];
+static struct arp_wait arp_queue[ARP_QUEUE_SIZE];
+static uchar	arp_queue_buf[ARP_QUEUE_SIZE * PKTSIZE_ALIGN + PKTALIGN];
 
 static uchar   *arp_tx_packet;	/* THE ARP transmit packet */
 static uchar	arp_tx_packet_buf[PKTSIZE_ALIGN + PKTALIGN];
 
 void arp_init(void)
 {
+	uchar *pkt;
+	int i;
+
 	/* XXX problem with bss workaround */
-	arp_wait_packet_ethaddr = NULL;
-	net_arp_wait_packet_ip.s_addr = 0;
-	net_arp_wait_reply_ip.s_addr = 0;
-	arp_wait_tx_packet_size = 0;
+	memset(arp_cache, '\0', sizeof(arp_cache));
+	pkt = &arp_queue_buf[0] + (PKTALIGN - 1);
+	pkt -= (ulong)pkt % PKTALIGN;
+	for (i = 0; i < ARP_QUEUE_SIZE; i++)
+		arp_queue[i].packet = pkt + i * PKTSIZE_ALIGN;
+	arp_cancel();
 	arp_tx_packet = &arp_tx_packet_buf[0] + (PKTALIGN - 1);
 	arp_tx_packet -= (ulong)arp_tx_packet % PKTALIGN;
 }
 
+void arp_cancel(void)
+{
+	int i;
+
+	for (i = 0; i < ARP_QUEUE_SIZE; i++)
+		arp_queue[i].packet_ip.s_addr = 0;
+}
+
+void arp_flush(void)
+{
+	memset(arp_cache, '\0', sizeof(arp_cache));
+}
+
+/* Work out which host on our link the packets for @ip go to */
+static struct in_addr arp_next_hop(struct in_addr ip)
+{
+	if ((ip.s_addr & net_netmask.s_addr) !=
+	    (net_ip.s_addr & net_netmask.s_addr) && net_gateway.s_addr)
+		return net_gateway;
+
+	return ip;
+}
+
+static struct arp_entry *arp_cache_find(struct in_addr ip)
+{
+	int dev = eth_get_dev_index();
+	int i;
+
+	for (i = 0; i < ARP_CACHE_SIZE; i++) {
+		if (arp_cache[i].ip.s_addr == ip.s_addr &&
+		    arp_cache[i].dev == dev)
+			return &arp_cache[i];
+	}
+
+	return NULL;
+}
+
+/* Remember @ethaddr for @ip, in place of the oldest entry if full */
+static void arp_cache_add(struct in_addr ip, const uchar *ethaddr)
+{
+	struct arp_entry *entry;
+	ulong now = get_timer(0);
+	int i;
+
+	entry = arp_cache_find(ip);
+	for (i = 0; !entry && i < ARP_CACHE_SIZE; i++) {
+		if (!arp_cache[i].ip.s_addr)
+			entry = &arp_cache[i];
+	}
+	if (!entry) {
+		entry = &arp_cache[0];
+		for (i = 1; i < ARP_CACHE_SIZE; i++) {
+			if (now - arp_cache[i].time > now - entry->time)
+				entry = &arp_cache[i];
+		}
+	}
+	entry->ip = ip;
+	memcpy(entry->ethaddr, ethaddr, ARP_HLEN);
+	entry->dev = eth_get_dev_index();
+	entry->time = now;
+}
+
+int arp_lookup(struct in_addr ip, uchar *ethaddr)
+{
+	struct arp_entry *entry;
+
+	entry = arp_cache_find(arp_next_hop(ip));
+	if (!entry)
+		return -ENOENT;
+	if (get_timer(entry->time) > ARP_CACHE_TIMEOUT) {
+		/* Too old: ask again, in case the host has changed */
+		entry->ip.s_addr = 0;
+		return -ENOENT;
+	}
+	memcpy(ethaddr, entry->ethaddr, ARP_HLEN);
+
+	return 0;
+}
+
 void arp_raw_request(struct in_addr source_ip, const uchar *target_ethaddr,
 	struct in_addr target_ip)
 {
@@ -56,7 +165,7 @@ void arp_raw_request(struct in_addr source_ip, const uchar *target_ethaddr,
 	struct arp_hdr *arp;
 	int eth_hdr_size;
 
-	debug_cond(DEBUG_DEV_PKT, "ARP broadcast %d\n", arp_wait_try);
+	debug_cond(DEBUG_DEV_PKT, "ARP broadcast for %pI4\n", &target_ip);
 
 	pkt = arp_tx_packet;
 
@@ -79,54 +188,103 @@ void arp_raw_request(struct in_addr source_ip, const uchar *target_ethaddr,
 	net_send_packet(arp_tx_packet, eth_hdr_size + ARP_HDR_SIZE);
 }
 
-void arp_request(void)
+static void arp_request(struct arp_wait *wait)
+{
+	if (wait->reply_ip.s_addr == wait->packet_ip.s_addr &&
+	    (wait->packet_ip.s_addr & net_netmask.s_addr) !=
+	    (net_ip.s_addr & net_netmask.s_addr))
+		puts("## Warning: gatewayip needed but not set\n");
+
+	arp_raw_request(net_ip, net_null_ethaddr, wait->reply_ip);
+}
+
+int arp_queue_packet(uchar *ethaddr, struct in_addr ip, uchar *pkt, int size)
 {
-	if ((net_arp_wait_packet_ip.s_addr & net_netmask.s_addr) !=
-	    (net_ip.s_addr & net_netmask.s_addr)) {
-		if (net_gateway.s_addr == 0) {
-			puts("## Warning: gatewayip needed but not set\n");
-			net_arp_wait_reply_ip = net_arp_wait_packet_ip;
-		} else {
-			net_arp_wait_reply_ip = net_gateway;
+	struct arp_wait *wait = NULL, *asked = NULL;
+	struct in_addr reply_ip = arp_next_hop(ip);
+	int i;
+
+	for (i = 0; i < ARP_QUEUE_SIZE; i++) {
+		if (!arp_queue[i].packet_ip.s_addr) {
+			if (!wait)
+				wait = &arp_queue[i];
+		} else if (arp_queue[i].reply_ip.s_addr == reply_ip.s_addr) {
+			asked = &arp_queue[i];
 		}
+	}
+	if (!wait) {
+		debug_cond(DEBUG_DEV_PKT, "ARP queue full, dropping packet\n");
+		return -ENOBUFS;
+	}
+
+	wait->packet_ip = ip;
+	wait->reply_ip = reply_ip;
+	wait->ethaddr = ethaddr;
+	memcpy(wait->packet, pkt, size);
+	wait->size = size;
+
+	/* Ask only once for all the packets to the same next hop */
+	if (asked) {
+		wait->timer_start = asked->timer_start;
+		wait->try = asked->try;
 	} else {
-		net_arp_wait_reply_ip = net_arp_wait_packet_ip;
+		wait->timer_start = get_timer(0);
+		wait->try = 1;
+		arp_request(wait);
 	}
 
-	arp_raw_request(net_ip, net_null_ethaddr, net_arp_wait_reply_ip);
+	return 0;
 }
 
 int arp_timeout_check(void)
 {
+	struct arp_wait *wait;
+	int waiting = 0;
 	ulong t;
-
-	if (!net_arp_wait_packet_ip.s_addr)
-		return 0;
+	int i, j;
 
 	t = get_timer(0);
 
-	/* check for arp timeout */
-	if ((t - arp_wait_timer_start) > ARP_TIMEOUT) {
-		arp_wait_try++;
+	for (i = 0; i < ARP_QUEUE_SIZE; i++) {
+		wait = &arp_queue[i];
+		if (!wait->packet_ip.s_addr)
+			continue;
+		waiting = 1;
 
-		if (arp_wait_try >= ARP_TIMEOUT_COUNT) {
+		/* check for arp timeout */
+		if ((t - wait->timer_start) <= ARP_TIMEOUT)
+			continue;
+
+		if (++wait->try >= ARP_TIMEOUT_COUNT) {
 			puts("\nARP Retry count exceeded; starting again\n");
-			arp_wait_try = 0;
+			arp_cancel();
 			net_set_state(NETLOOP_FAIL);
-		} else {
-			arp_wait_timer_start = t;
-			arp_request();
+			break;
+		}
+
+		for (j = i + 1; j < ARP_QUEUE_SIZE; j++) {
+			if (arp_queue[j].packet_ip.s_addr &&
+			    arp_queue[j].reply_ip.s_addr ==
+			    wait->reply_ip.s_addr) {
+				arp_queue[j].timer_start = t;
+				arp_queue[j].try = wait->try;
+			}
 		}
+		wait->timer_start = t;
+		arp_request(wait);
 	}
-	return 1;
+
+	return waiting;
 }
 
 void arp_receive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len)
 {
 	struct arp_hdr *arp;
+	struct arp_wait *wait;
 	struct in_addr reply_ip_addr;
 	uchar *pkt;
 	int eth_hdr_size;
+	int found, i;
 
 	/*
 	 * We have to deal with two types of ARP packets:
@@ -161,6 +319,10 @@ void arp_receive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len)
 
 	switch (ntohs(arp->ar_op)) {
 	case ARPOP_REQUEST:
+		/* The host asking is likely to be talked to next */
+		if (net_read_ip(&arp->ar_spa).s_addr)
+			arp_cache_add(net_read_ip(&arp->ar_spa), &arp->ar_sha);
+
 		/* reply with our IP address */
 		debug_cond(DEBUG_DEV_PKT, "Got ARP REQUEST, return our IP\n");
 		pkt = (uchar *)et;
@@ -189,45 +351,51 @@ void arp_receive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len)
 		return;
 
 	case ARPOP_REPLY:		/* arp reply */
-		/* are we waiting for a reply */
-		if (!net_arp_wait_packet_ip.s_addr)
-			break;
+		reply_ip_addr = net_read_ip(&arp->ar_spa);
+		found = 0;
+		for (i = 0; i < ARP_QUEUE_SIZE; i++) {
+			wait = &arp_queue[i];
+
+			/* matched waiting packet's address */
+			if (!wait->packet_ip.s_addr ||
+			    wait->reply_ip.s_addr != reply_ip_addr.s_addr)
+				continue;
+
+			if (!found) {
+				debug_cond(DEBUG_DEV_PKT,
+					   "Got ARP REPLY, set eth addr (%pM)\n",
+					   arp->ar_data);
+				arp_cache_add(reply_ip_addr, &arp->ar_sha);
+				net_get_arp_handler()((uchar *)arp, 0,
+						      reply_ip_addr, 0, len);
+				found = 1;
+			}
 
 #ifdef CONFIG_KEEP_SERVERADDR
-		if (net_server_ip.s_addr == net_arp_wait_packet_ip.s_addr) {
-			char buf[20];
-			sprintf(buf, "%pM", &arp->ar_sha);
-			setenv("serveraddr", buf);
-		}
+			if (net_server_ip.s_addr == wait->packet_ip.s_addr) {
+				char buf[20];
+				sprintf(buf, "%pM", &arp->ar_sha);
+				setenv("serveraddr", buf);
+			}
 #endif
 
-		reply_ip_addr = net_read_ip(&arp->ar_spa);
-
-		/* matched waiting packet's address */
-		if (reply_ip_addr.s_addr == net_arp_wait_reply_ip.s_addr) {
-			debug_cond(DEBUG_DEV_PKT,
-				   "Got ARP REPLY, set eth addr (%pM)\n",
-				   arp->ar_data);
-
 			/* save address for later use */
-			if (arp_wait_packet_ethaddr != NULL)
-				memcpy(arp_wait_packet_ethaddr,
-				       &arp->ar_sha, ARP_HLEN);
-
-			net_get_arp_handler()((uchar *)arp, 0, reply_ip_addr,
-					      0, len);
+			if (wait->ethaddr != NULL)
+				memcpy(wait->ethaddr, &arp->ar_sha, ARP_HLEN);
 
 			/* set the mac address in the waiting packet's header
 			   and transmit it */
-			memcpy(((struct ethernet_hdr *)net_tx_packet)->et_dest,
+			memcpy(((struct ethernet_hdr *)wait->packet)->et_dest,
 			       &arp->ar_sha, ARP_HLEN);
-			net_send_packet(net_tx_packet, arp_wait_tx_packet_size);
+			net_send_packet(wait->packet, wait->size);
 
 			/* no arp request pending now */
-			net_arp_wait_packet_ip.s_addr = 0;
-			arp_wait_tx_packet_size = 0;
-			arp_wait_packet_ethaddr = NULL;
+			wait->packet_ip.s_addr = 0;
 		}
+
+		/* Keep up with a host whose address we already know */
+		if (!found && arp_cache_find(reply_ip_addr))
+			arp_cache_add(reply_ip_addr, &arp->ar_sha);
 		return;
 	default:
 		debug("Unexpected ARP opcode 0x%x\n",
@@ -14,17 +14,42 @@
 
 #include <common.h>
 
-extern struct in_addr net_arp_wait_packet_ip;
-/* MAC address of waiting packet's destination */
-extern uchar *arp_wait_packet_ethaddr;
-extern int arp_wait_tx_packet_size;
-extern ulong arp_wait_timer_start;
-extern int arp_wait_try;
-
 void arp_init(void);
-void arp_request(void);
 void arp_raw_request(struct in_addr source_ip, const uchar *targetEther,
 	struct in_addr target_ip);
+
+/**
+ * arp_lookup() - Look up the MAC address to send packets for an IP to
+ *
+ * This looks in the ARP cache for the next hop to @ip: @ip itself if it is
+ * on our subnet, else the gateway.
+ *
+ * @ip:		IP address the packets are for
+ * @ethaddr:	Returns the MAC address, if found
+ * @return 0 if found, -ENOENT if not known or too old
+ */
+int arp_lookup(struct in_addr ip, uchar *ethaddr);
+
+/**
+ * arp_queue_packet() - Keep a packet until the MAC address of @ip is known
+ *
+ * This sends an ARP request for the next hop to @ip, unless one is already
+ * waiting for it. When the reply comes, the MAC address is saved in
+ * @ethaddr and in the packet's ethernet header, and the packet is sent.
+ *
+ * @ethaddr:	Where to save the MAC address, or NULL
+ * @ip:		IP address the packet is for
+ * @pkt:	Packet, starting with its ethernet header; it is copied
+ * @size:	Size of the packet
+ * @return 0 if queued, -ENOBUFS if too many packets are waiting already
+ */
+int arp_queue_packet(uchar *ethaddr, struct in_addr ip, uchar *pkt, int size);
+
+/* Drop the packets waiting for an ARP reply */
+void arp_cancel(void);
+/* Forget all the MAC addresses learnt */
+void arp_flush(void);
+
 int arp_timeout_check(void);
 void arp_receive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len);
 
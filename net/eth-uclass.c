@@ -9,6 +9,7 @@
 #include <common.h>
 #include <dm.h>
 #include <environment.h>
+#include <malloc.h>
 #include <net.h>
 #include <dm/device-internal.h>
 #include <dm/uclass-internal.h>
@@ -16,22 +17,33 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/* Packets taken from the driver at once when there is no receive queue */
+#define ETH_RX_BATCH		32
+
 /**
  * struct eth_device_priv - private structure for each Ethernet device
  *
  * @state: The state of the Ethernet MAC driver (defined by enum eth_state_t)
+ * @stats: Counters of the packets sent and received
  */
 struct eth_device_priv {
 	enum eth_state_t state;
+	struct eth_stats stats;
 };
 
 /**
  * struct eth_uclass_priv - The structure attached to the uclass itself
  *
  * @current: The Ethernet device that the network functions are using
+ * @rx_queue: CONFIG_NET_RX_QUEUE_SIZE buffers, into which the packets are
+ *	copied from the driver before they are processed, or NULL to process
+ *	each one in the driver's buffer
+ * @rx_len: Length of each packet in @rx_queue
  */
 struct eth_uclass_priv {
 	struct udevice *current;
+	uchar *rx_queue;
+	int *rx_len;
 };
 
 /* eth_errno - This stores the most recent failure code from DM functions */
@@ -326,9 +338,17 @@ int eth_is_active(struct udevice *dev)
 	return priv->state == ETH_STATE_ACTIVE;
 }
 
+struct eth_stats *eth_get_stats(struct udevice *dev)
+{
+	struct eth_device_priv *priv = dev->uclass_priv;
+
+	return &priv->stats;
+}
+
 int eth_send(void *packet, int length)
 {
 	struct udevice *current;
+	struct eth_stats *stats;
 	int ret;
 
 	current = eth_get_dev();
@@ -338,18 +358,26 @@ int eth_send(void *packet, int length)
 	if (!device_active(current))
 		return -EINVAL;
 
+	stats = eth_get_stats(current);
 	ret = eth_get_ops(current)->send(current, packet, length);
 	if (ret < 0) {
+		stats->tx_errors++;
 		/* We cannot completely return the error at present */
 		debug("%s: send() returned error %d\n", __func__, ret);
+	} else {
+		stats->tx_packets++;
 	}
 	return ret;
 }
 
 int eth_rx(void)
 {
+	struct eth_uclass_priv *uc_priv = eth_get_uclass_priv();
 	struct udevice *current;
-	uchar *packet;
+	struct eth_stats *stats;
+	uchar *packet, *buf;
+	int count = 0;
+	int max;
 	int flags;
 	int ret;
 	int i;
@@ -361,21 +389,51 @@ int eth_rx(void)
 	if (!device_active(current))
 		return -EINVAL;
 
-	/* Process up to 32 packets at one time */
+	/*
+	 * Take the packets waiting in the driver, giving each buffer back
+	 * at once so that its ring has room for more while they are
+	 * processed. Without a queue, process up to 32 packets at one time.
+	 */
+	stats = eth_get_stats(current);
+	max = uc_priv->rx_queue ? CONFIG_NET_RX_QUEUE_SIZE : ETH_RX_BATCH;
 	flags = ETH_RECV_CHECK_DEVICE;
-	for (i = 0; i < 32; i++) {
+	for (i = 0; i < max; i++) {
 		ret = eth_get_ops(current)->recv(current, flags, &packet);
 		flags = 0;
-		if (ret > 0)
-			net_process_received_packet(packet, ret);
+		if (ret > 0) {
+			stats->rx_packets++;
+			stats->rx_bytes += ret;
+			if (!uc_priv->rx_queue) {
+				net_process_received_packet(packet, ret);
+			} else if (ret > PKTSIZE_ALIGN) {
+				stats->rx_dropped++;
+			} else {
+				buf = uc_priv->rx_queue + count * PKTSIZE_ALIGN;
+				memcpy(buf, packet, ret);
+				uc_priv->rx_len[count++] = ret;
+			}
+		}
 		if (ret >= 0 && eth_get_ops(current)->free_pkt)
 			eth_get_ops(current)->free_pkt(current, packet, ret);
 		if (ret <= 0)
 			break;
 	}
+	if (i == max)
+		stats->rx_full++;
+	if (i)
+		stats->rx_polls++;
+	if (stats->rx_queue_max < i)
+		stats->rx_queue_max = i;
+
+	for (i = 0; i < count; i++)
+		net_process_received_packet(uc_priv->rx_queue +
+					    i * PKTSIZE_ALIGN,
+					    uc_priv->rx_len[i]);
+
 	if (ret == -EAGAIN)
 		ret = 0;
 	if (ret < 0) {
+		stats->rx_errors++;
 		/* We cannot completely return the error at present */
 		debug("%s: recv() returned error %d\n", __func__, ret);
 	}
@@ -445,6 +503,37 @@ static int eth_post_bind(struct udevice *dev)
 	return 0;
 }
 
+static int eth_uclass_init(struct uclass *uc)
+{
+	struct eth_uclass_priv *uc_priv = uc->priv;
+
+	if (!CONFIG_NET_RX_QUEUE_SIZE)
+		return 0;
+
+	/* Without the memory, packets are processed in the driver's buffers */
+	uc_priv->rx_queue = memalign(PKTALIGN,
+				     CONFIG_NET_RX_QUEUE_SIZE * PKTSIZE_ALIGN);
+	uc_priv->rx_len = calloc(CONFIG_NET_RX_QUEUE_SIZE, sizeof(int));
+	if (!uc_priv->rx_queue || !uc_priv->rx_len) {
+		free(uc_priv->rx_queue);
+		free(uc_priv->rx_len);
+		uc_priv->rx_queue = NULL;
+		uc_priv->rx_len = NULL;
+	}
+
+	return 0;
+}
+
+static int eth_uclass_destroy(struct uclass *uc)
+{
+	struct eth_uclass_priv *uc_priv = uc->priv;
+
+	free(uc_priv->rx_queue);
+	free(uc_priv->rx_len);
+
+	return 0;
+}
+
 static int eth_pre_unbind(struct udevice *dev)
 {
 	/* Don't hang onto a pointer that is going away */
@@ -543,6 +632,8 @@ static int eth_pre_remove(struct udevice *dev)
 UCLASS_DRIVER(eth) = {
 	.name		= "eth",
 	.id		= UCLASS_ETH,
+	.init		= eth_uclass_init,
+	.destroy	= eth_uclass_destroy,
 	.post_bind	= eth_post_bind,
 	.pre_unbind	= eth_pre_unbind,
 	.post_probe	= eth_post_probe,
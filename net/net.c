@@ -87,6 +87,7 @@
 #include <environment.h>
 #include <errno.h>
 #include <net.h>
+#include <net/tcp.h>
 #include <net/tftp.h>
 #if defined(CONFIG_LED_STATUS)
 #include <miiphy.h>
@@ -107,6 +108,7 @@
 #if defined(CONFIG_CMD_SNTP)
 #include "sntp.h"
 #endif
+#include "wget.h"
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -344,6 +346,8 @@ static void net_init_loop(void)
 {
 	if (eth_get_dev())
 		memcpy(net_ethaddr, eth_get_ethaddr(), 6);
+	/* The MAC addresses learnt are kept, but not the packets unsent */
+	arp_cancel();
 
 	return;
 }
@@ -353,6 +357,9 @@ static void net_clear_handlers(void)
 	net_set_udp_handler(NULL);
 	net_set_arp_handler(NULL);
 	net_set_timeout_handler(0, NULL);
+#ifdef CONFIG_PROT_TCP
+	tcp_reset();
+#endif
 }
 
 static void net_cleanup_loop(void)
@@ -484,6 +491,11 @@ restart:
 			nfs_start();
 			break;
 #endif
+#if defined(CONFIG_CMD_WGET)
+		case WGET:
+			wget_start();
+			break;
+#endif
 #if defined(CONFIG_CMD_CDP)
 		case CDP:
 			cdp_start();
@@ -558,7 +570,7 @@ restart:
 		 */
 		if (ctrlc()) {
 			/* cancel any ARP that may not have completed */
-			net_arp_wait_packet_ip.s_addr = 0;
+			arp_cancel();
 
 			net_cleanup_loop();
 			eth_halt();
@@ -668,6 +680,9 @@ int net_start_again(void)
 	unsigned long retrycnt = 0;
 	int ret;
 
+	/* The host may have changed its MAC address: ask again */
+	arp_flush();
+
 	nretry = getenv("netretry");
 	if (nretry) {
 		if (!strcmp(nretry, "yes"))
@@ -803,26 +818,28 @@ int net_send_udp_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 	net_set_udp_header(pkt, dest, dport, sport, payload_len);
 	pkt_hdr_size = eth_hdr_size + IP_UDP_HDR_SIZE;
 
-	/* if MAC address was not discovered yet, do an ARP request */
-	if (memcmp(ether, net_null_ethaddr, 6) == 0) {
-		debug_cond(DEBUG_DEV_PKT, "sending ARP for %pI4\n", &dest);
+	return net_send_ip_packet(ether, dest, pkt_hdr_size + payload_len);
+}
 
-		/* save the ip and eth addr for the packet to send after arp */
-		net_arp_wait_packet_ip = dest;
-		arp_wait_packet_ethaddr = ether;
+int net_send_ip_packet(uchar *ether, struct in_addr dest, int len)
+{
+	/* if MAC address was not discovered yet, try the ARP cache */
+	if (memcmp(ether, net_null_ethaddr, 6) == 0 &&
+	    !arp_lookup(dest, ether))
+		memcpy(((struct ethernet_hdr *)net_tx_packet)->et_dest, ether,
+		       6);
 
-		/* size of the waiting packet */
-		arp_wait_tx_packet_size = pkt_hdr_size + payload_len;
+	/* if it is not known either, do an ARP request */
+	if (memcmp(ether, net_null_ethaddr, 6) == 0) {
+		debug_cond(DEBUG_DEV_PKT, "sending ARP for %pI4\n", &dest);
 
-		/* and do the ARP request */
-		arp_wait_try = 1;
-		arp_wait_timer_start = get_timer(0);
-		arp_request();
+		/* keep the packet to send after arp */
+		arp_queue_packet(ether, dest, net_tx_packet, len);
 		return 1;	/* waiting */
 	} else {
-		debug_cond(DEBUG_DEV_PKT, "sending UDP to %pI4/%pM\n",
+		debug_cond(DEBUG_DEV_PKT, "sending IP to %pI4/%pM\n",
 			   &dest, ether);
-		net_send_packet(net_tx_packet, pkt_hdr_size + payload_len);
+		net_send_packet(net_tx_packet, len);
 		return 0;	/* transmitted */
 	}
 }
@@ -852,10 +869,51 @@ struct hole {
 	u16 unused;
 };
 
+/*
+ * A datagram being reassembled; total_len is 0 when the slot is free, and
+ * 0xffff until the last fragment has been seen
+ */
+struct defrag_slot {
+	uchar pkt_buff[IP_PKTSIZE] __aligned(PKTALIGN);
+	u16 first_hole;
+	u16 total_len;
+};
+
+static struct defrag_slot defrag_slots[CONFIG_NET_DEFRAG_SLOTS];
+
+/* Find the slot for the datagram @ip is part of, or take one for it */
+static struct defrag_slot *net_defrag_slot(struct ip_udp_hdr *ip)
+{
+	static int next_slot;
+	struct defrag_slot *slot, *free = NULL;
+	struct ip_udp_hdr *localip;
+	int i;
+
+	for (i = 0; i < CONFIG_NET_DEFRAG_SLOTS; i++) {
+		slot = &defrag_slots[i];
+		localip = (struct ip_udp_hdr *)slot->pkt_buff;
+		if (!slot->total_len) {
+			if (!free)
+				free = slot;
+		} else if (localip->ip_id == ip->ip_id) {
+			return slot;
+		}
+	}
+	if (free)
+		return free;
+
+	/* All busy: drop one, taking each in turn */
+	slot = &defrag_slots[next_slot];
+	next_slot = (next_slot + 1) % CONFIG_NET_DEFRAG_SLOTS;
+	slot->total_len = 0;
+
+	return slot;
+}
+
 static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 {
-	static uchar pkt_buff[IP_PKTSIZE] __aligned(PKTALIGN);
-	static u16 first_hole, total_len;
+	struct defrag_slot *slot = net_defrag_slot(ip);
+	uchar *pkt_buff = slot->pkt_buff;
 	struct hole *payload, *thisfrag, *h, *newh;
 	struct ip_udp_hdr *localip = (struct ip_udp_hdr *)pkt_buff;
 	uchar *indata = (uchar *)ip;
@@ -872,13 +930,13 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 	if (start + len > IP_MAXUDP) /* fragment extends too far */
 		return NULL;
 
-	if (!total_len || localip->ip_id != ip->ip_id) {
+	if (!slot->total_len || localip->ip_id != ip->ip_id) {
 		/* new (or different) packet, reset structs */
-		total_len = 0xffff;
+		slot->total_len = 0xffff;
 		payload[0].last_byte = ~0;
 		payload[0].next_hole = 0;
 		payload[0].prev_hole = 0;
-		first_hole = 0;
+		slot->first_hole = 0;
 		/* any IP header will work, copy the first we received */
 		memcpy(localip, ip, IP_HDR_SIZE);
 	}
@@ -890,7 +948,7 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 	 * so it is represented as byte count, not as 8-byte blocks.
 	 */
 
-	h = payload + first_hole;
+	h = payload + slot->first_hole;
 	while (h->last_byte < start) {
 		if (!h->next_hole) {
 			/* no hole that far away */
@@ -907,7 +965,7 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 
 	if (!(ip_off & IP_FLAGS_MFRAG)) {
 		/* no more fragmentss: truncate this (last) hole */
-		total_len = start + len;
+		slot->total_len = start + len;
 		h->last_byte = start + len;
 	}
 
@@ -924,7 +982,7 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 			done = 1;
 		} else if (!h->prev_hole) {
 			/* first hole */
-			first_hole = h->next_hole;
+			slot->first_hole = h->next_hole;
 			payload[h->next_hole].prev_hole = 0;
 		} else if (!h->next_hole) {
 			/* last hole */
@@ -949,7 +1007,7 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 		if (h->prev_hole)
 			payload[h->prev_hole].next_hole = (h - payload);
 		else
-			first_hole = (h - payload);
+			slot->first_hole = (h - payload);
 
 	} else {
 		/* fragment sits in the middle: split the hole */
@@ -967,8 +1025,10 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 	if (!done)
 		return NULL;
 
-	localip->ip_len = htons(total_len);
-	*lenp = total_len + IP_HDR_SIZE;
+	localip->ip_len = htons(slot->total_len);
+	*lenp = slot->total_len + IP_HDR_SIZE;
+	/* Free the slot; the packet stays in it until another datagram comes */
+	slot->total_len = 0;
 	return localip;
 }
 
@@ -1208,6 +1268,11 @@ void net_process_received_packet(uchar *in_packet, int len)
 		if (ip->ip_p == IPPROTO_ICMP) {
 			receive_icmp(ip, len, src_ip, et);
 			return;
+#ifdef CONFIG_PROT_TCP
+		} else if (ip->ip_p == IPPROTO_TCP) {
+			tcp_receive((struct ip_tcp_hdr *)ip, len);
+			return;
+#endif
 		} else if (ip->ip_p != IPPROTO_UDP) {	/* Only UDP packets */
 			return;
 		}
@@ -1309,6 +1374,9 @@ static int net_check_prereq(enum proto_t protocol)
 #endif
 #if defined(CONFIG_CMD_NFS)
 	case NFS:
+#endif
+#if defined(CONFIG_CMD_WGET)
+	case WGET:
 #endif
 		/* Fall through */
 	case TFTPGET:
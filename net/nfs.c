@@ -45,12 +45,29 @@
 #define NFS_RPC_ERR	1
 #define NFS_RPC_DROP	124
 
+/* Most READ requests outstanding at once */
+#define NFS_READ_WINDOW_MAX	16
+
+/* An outstanding READ request, whose reply is stored at @offset */
+struct nfs_read_slot {
+	unsigned long id;	/* RPC id of the request, 0 if free */
+	int offset;
+	int len;
+};
+
 static int fs_mounted;
 static unsigned long rpc_id;
-static int nfs_offset = -1;
-static int nfs_len;
+static int nfs_offset = -1;	/* Next offset to read */
 static ulong nfs_timeout = NFS_TIMEOUT;
 
+static struct nfs_read_slot nfs_read_slots[NFS_READ_WINDOW_MAX];
+static int nfs_read_window_max;	/* Window asked for */
+static int nfs_read_window;	/* Window now used, smaller after a timeout */
+static int nfs_read_replies;	/* Replies since the window last changed */
+static bool nfs_read_eof;
+static ulong nfs_read_bytes;
+static int nfs_hashes;
+
 static char dirfh[NFS_FHSIZE];	/* NFSv2 / NFSv3 file handle of directory */
 static char filefh[NFS3_FHSIZE]; /* NFSv2 / NFSv3 file handle */
 static int filefh3_length;	/* (variable) length of filefh when NFSv3 */
@@ -170,15 +187,14 @@ static uint32_t *rpc_add_credentials(uint32_t *p)
 /**************************************************************************
 RPC_LOOKUP - Lookup RPC Port numbers
 **************************************************************************/
-static void rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
+static void rpc_req_id(unsigned long id, int rpc_prog, int rpc_proc,
+		       uint32_t *data, int datalen)
 {
 	struct rpc_t rpc_pkt;
-	unsigned long id;
 	uint32_t *p;
 	int pktlen;
 	int sport;
 
-	id = ++rpc_id;
 	rpc_pkt.u.call.id = htonl(id);
 	rpc_pkt.u.call.type = htonl(MSG_CALL);
 	rpc_pkt.u.call.rpcvers = htonl(2);	/* use RPC version 2 */
@@ -217,6 +233,11 @@ static void rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
 			    nfs_our_port, pktlen);
 }
 
+static void rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
+{
+	rpc_req_id(++rpc_id, rpc_prog, rpc_proc, data, datalen);
+}
+
 /**************************************************************************
 RPC_LOOKUP - Lookup RPC Port numbers
 **************************************************************************/
@@ -356,7 +377,7 @@ static void nfs_lookup_req(char *fname)
 /**************************************************************************
 NFS_READ - Read File on NFS Server
 **************************************************************************/
-static void nfs_read_req(int offset, int readlen)
+static void nfs_read_req(unsigned long id, int offset, int readlen)
 {
 	uint32_t data[1024];
 	uint32_t *p;
@@ -383,7 +404,64 @@ static void nfs_read_req(int offset, int readlen)
 
 	len = (uint32_t *)p - (uint32_t *)&(data[0]);
 
-	rpc_req(PROG_NFS, NFS_READ, data, len);
+	rpc_req_id(id, PROG_NFS, NFS_READ, data, len);
+}
+
+/* Send a READ for @slot; a new one unless @slot is already outstanding */
+static void nfs_read_send(struct nfs_read_slot *slot)
+{
+	if (!slot->id)
+		slot->id = ++rpc_id;
+	nfs_read_req(slot->id, slot->offset, slot->len);
+}
+
+/* Keep the window full of requests for the rest of the file */
+static void nfs_read_fill(void)
+{
+	int outstanding = 0;
+	int i;
+
+	for (i = 0; i < NFS_READ_WINDOW_MAX; i++)
+		outstanding += nfs_read_slots[i].id != 0;
+
+	for (i = 0; i < NFS_READ_WINDOW_MAX && !nfs_read_eof &&
+	     outstanding < nfs_read_window; i++) {
+		if (nfs_read_slots[i].id)
+			continue;
+		nfs_read_slots[i].offset = nfs_offset;
+		nfs_read_slots[i].len = NFS_READ_SIZE;
+		nfs_read_send(&nfs_read_slots[i]);
+		nfs_offset += NFS_READ_SIZE;
+		outstanding++;
+	}
+}
+
+static void nfs_read_start(void)
+{
+	memset(nfs_read_slots, '\0', sizeof(nfs_read_slots));
+	nfs_offset = 0;
+	nfs_read_window = nfs_read_window_max;
+	nfs_read_replies = 0;
+	nfs_read_eof = false;
+	nfs_read_bytes = 0;
+	nfs_hashes = 0;
+	nfs_read_fill();
+}
+
+/*
+ * Send the outstanding requests again, with the same RPC ids so that a late
+ * reply to the first one still counts, and fewer at once from now on
+ */
+static void nfs_read_resend(void)
+{
+	int i;
+
+	nfs_read_window = max(nfs_read_window / 2, 1);
+	nfs_read_replies = 0;
+	for (i = 0; i < NFS_READ_WINDOW_MAX; i++) {
+		if (nfs_read_slots[i].id)
+			nfs_read_send(&nfs_read_slots[i]);
+	}
 }
 
 /**************************************************************************
@@ -416,7 +494,7 @@ static void nfs_send(void)
 		nfs_lookup_req(nfs_filename);
 		break;
 	case STATE_READ_REQ:
-		nfs_read_req(nfs_offset, nfs_len);
+		nfs_read_resend();
 		break;
 	case STATE_READLINK_REQ:
 		nfs_readlink_req();
@@ -652,20 +730,36 @@ static int nfs_readlink_reply(uchar *pkt, unsigned len)
 	return 0;
 }
 
-static int nfs_read_reply(uchar *pkt, unsigned len)
+static struct nfs_read_slot *nfs_read_find(unsigned long id)
+{
+	int i;
+
+	for (i = 0; i < NFS_READ_WINDOW_MAX; i++) {
+		if (id && nfs_read_slots[i].id == id)
+			return &nfs_read_slots[i];
+	}
+
+	return NULL;
+}
+
+static int nfs_read_reply(uchar *pkt, unsigned len,
+			  struct nfs_read_slot **slotp)
 {
 	struct rpc_t rpc_pkt;
+	struct nfs_read_slot *slot;
 	int rlen;
-	uchar *data_ptr;
+	uint32_t *data;
 
 	debug("%s\n", __func__);
 
-	memcpy(&rpc_pkt.u.data[0], pkt, sizeof(rpc_pkt.u.reply));
+	/* Only the headers are copied; the data is stored straight from pkt */
+	memcpy(&rpc_pkt.u.data[0], pkt,
+	       min_t(unsigned, len, NFS_READ_HDR_SIZE));
 
-	if (ntohl(rpc_pkt.u.reply.id) > rpc_id)
-		return -NFS_RPC_ERR;
-	else if (ntohl(rpc_pkt.u.reply.id) < rpc_id)
+	slot = nfs_read_find(ntohl(rpc_pkt.u.reply.id));
+	if (!slot)
 		return -NFS_RPC_DROP;
+	*slotp = slot;
 
 	if (rpc_pkt.u.reply.rstatus  ||
 	    rpc_pkt.u.reply.verifier ||
@@ -678,15 +772,9 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 		return -ntohl(rpc_pkt.u.reply.data[0]);
 	}
 
-	if ((nfs_offset != 0) && !((nfs_offset) %
-			(NFS_READ_SIZE / 2 * 10 * HASHES_PER_LINE)))
-		puts("\n\t ");
-	if (!(nfs_offset % ((NFS_READ_SIZE / 2) * 10)))
-		putc('#');
-
 	if (supported_nfs_versions & NFSV2_FLAG) {
 		rlen = ntohl(rpc_pkt.u.reply.data[18]);
-		data_ptr = (uchar *)&(rpc_pkt.u.reply.data[19]);
+		data = &rpc_pkt.u.reply.data[19];
 	} else {  /* NFSV3_FLAG */
 		int nfsv3_data_offset =
 			nfs3_get_attributes_offset(rpc_pkt.u.reply.data);
@@ -697,16 +785,63 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 			EOF:		32 bits value,
 			data_size:	32 bits value,
 		*/
-		data_ptr = (uchar *)
-			&(rpc_pkt.u.reply.data[4 + nfsv3_data_offset]);
+		data = &rpc_pkt.u.reply.data[4 + nfsv3_data_offset];
 	}
 
-	if (store_block(data_ptr, nfs_offset, rlen))
-			return -9999;
+	/* A reply cut short is dropped, and the request sent again */
+	pkt += (uchar *)data - rpc_pkt.u.data;
+	if (rlen < 0 || rlen > slot->len ||
+	    (uchar *)data - rpc_pkt.u.data + rlen > len)
+		return -NFS_RPC_DROP;
+
+	/* A read past the end has no data, and must not grow the file */
+	if (rlen && store_block(pkt, slot->offset, rlen))
+		return -9999;
 
 	return rlen;
 }
 
+/*
+ * Account for a reply of @rlen bytes to @slot, and send the next requests.
+ * Returns true once every request has been answered, up to the end of file
+ */
+static bool nfs_read_done(struct nfs_read_slot *slot, int rlen)
+{
+	int i;
+
+	nfs_read_bytes += rlen;
+	while (nfs_hashes < nfs_read_bytes / (NFS_READ_SIZE / 2 * 10)) {
+		putc('#');
+		if (++nfs_hashes % HASHES_PER_LINE == 0)
+			puts("\n\t ");
+	}
+
+	slot->id = 0;
+	if (!rlen) {
+		nfs_read_eof = true;
+	} else if (rlen < slot->len) {
+		/* Short read: ask for the rest, which may be the end */
+		slot->offset += rlen;
+		slot->len -= rlen;
+		nfs_read_send(slot);
+	}
+
+	/* Open the window up again, one request per window answered */
+	if (++nfs_read_replies >= nfs_read_window &&
+	    nfs_read_window < nfs_read_window_max) {
+		nfs_read_window++;
+		nfs_read_replies = 0;
+	}
+	nfs_read_fill();
+
+	for (i = 0; i < NFS_READ_WINDOW_MAX; i++) {
+		if (nfs_read_slots[i].id)
+			return false;
+	}
+
+	return nfs_read_eof;
+}
+
 /**************************************************************************
 Interfaces of U-BOOT
 **************************************************************************/
@@ -727,12 +862,13 @@ static void nfs_timeout_handler(void)
 static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			unsigned src, unsigned len)
 {
+	struct nfs_read_slot *slot;
 	int rlen;
 	int reply;
 
 	debug("%s\n", __func__);
 
-	if (dest != nfs_our_port)
+	if (dest != nfs_our_port || len > sizeof(struct rpc_t))
 		return;
 
 	switch (nfs_state) {
@@ -796,9 +932,7 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			nfs_send();
 		} else {
 			nfs_state = STATE_READ_REQ;
-			nfs_offset = 0;
-			nfs_len = NFS_READ_SIZE;
-			nfs_send();
+			nfs_read_start();
 		}
 		break;
 
@@ -821,20 +955,23 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		break;
 
 	case STATE_READ_REQ:
-		rlen = nfs_read_reply(pkt, len);
+		rlen = nfs_read_reply(pkt, len, &slot);
+		if (rlen == -NFS_RPC_DROP)
+			break;
 		net_set_timeout_handler(nfs_timeout, nfs_timeout_handler);
-		if (rlen > 0) {
-			nfs_offset += rlen;
+		if (rlen >= 0) {
+			if (!nfs_read_done(slot, rlen))
+				break;
+			nfs_download_state = NETLOOP_SUCCESS;
+			nfs_state = STATE_UMOUNT_REQ;
 			nfs_send();
 		} else if ((rlen == -NFSERR_ISDIR) || (rlen == -NFSERR_INVAL)) {
-			/* symbolic link */
+			/* symbolic link; drop the replies to other reads */
+			memset(nfs_read_slots, '\0', sizeof(nfs_read_slots));
 			nfs_state = STATE_READLINK_REQ;
 			nfs_send();
 		} else {
-			if (!rlen)
-				nfs_download_state = NETLOOP_SUCCESS;
-			if (rlen < 0)
-				debug("NFS READ error (%d)\n", rlen);
+			debug("NFS READ error (%d)\n", rlen);
 			nfs_state = STATE_UMOUNT_REQ;
 			nfs_send();
 		}
@@ -845,9 +982,25 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 
 void nfs_start(void)
 {
+	char *ep;
+
 	debug("%s\n", __func__);
 	nfs_download_state = NETLOOP_FAIL;
 
+	nfs_read_window_max = CONFIG_NFS_READ_WINDOW;
+	ep = getenv("nfswindowsize");
+	if (ep)
+		nfs_read_window_max = simple_strtol(ep, NULL, 10);
+	nfs_read_window_max = clamp(nfs_read_window_max, 1,
+				    NFS_READ_WINDOW_MAX);
+	/*
+	 * Fragments of the replies in flight arrive interleaved, and only
+	 * so many datagrams can be reassembled at once
+	 */
+	if (NFS_READ_FRAGMENTS)
+		nfs_read_window_max = min(nfs_read_window_max,
+					  CONFIG_NET_DEFRAG_SLOTS);
+
 	nfs_server_ip = net_server_ip;
 	nfs_path = (char *)nfs_path_buff;
 
@@ -38,15 +38,26 @@
 
 /* Block size used for NFS read accesses.  A RPC reply packet (including  all
  * headers) must fit within a single Ethernet frame to avoid fragmentation.
- * However, if CONFIG_IP_DEFRAG is set, the config file may want to use a
- * bigger value. In any case, most NFS servers are optimized for a power of 2.
+ * However, if CONFIG_IP_DEFRAG is set, the reply can be reassembled from
+ * fragments, so a bigger block that fits in CONFIG_NET_MAXDEFRAG (16 KiB by
+ * default) is used: that makes for far fewer round trips. In any case, most
+ * NFS servers are optimized for a power of 2.
  */
 #ifdef CONFIG_NFS_READ_SIZE
 #define NFS_READ_SIZE CONFIG_NFS_READ_SIZE
+#elif defined(CONFIG_IP_DEFRAG)
+#define NFS_READ_SIZE 8192 /* common NFS over UDP rsize */
 #else
 #define NFS_READ_SIZE 1024 /* biggest power of two that fits Ether frame */
 #endif
 
+/* RPC and NFS headers of a READ reply, up to the data */
+#define NFS_READ_HDR_SIZE	128
+
+/* A READ reply is bigger than an Ethernet frame, so comes in IP fragments */
+#define NFS_READ_FRAGMENTS \
+	(IP_UDP_HDR_SIZE + NFS_READ_HDR_SIZE + NFS_READ_SIZE > 1500)
+
 /* Values for Accept State flag on RPC answers (See: rfc1831) */
 enum rpc_accept_stat {
 	NFS_RPC_SUCCESS = 0,	/* RPC executed successfully */
@@ -76,7 +87,7 @@ struct rpc_t {
 			uint32_t verifier;
 			uint32_t v2;
 			uint32_t astatus;
-			uint32_t data[NFS_READ_SIZE];
+			uint32_t data[(NFS_READ_HDR_SIZE + NFS_READ_SIZE) / 4];
 		} reply;
 	} u;
 };
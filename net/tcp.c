@@ -0,0 +1,429 @@
+/*
+ * Minimal TCP client
+ *
+ * Copyright (c) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ *
+ * This handles a single connection, opened by us, which mostly receives.
+ * Data received is handed over as soon as it arrives, even ahead of a gap,
+ * and the handler stores it in place; so there is no reassembly buffer and
+ * the receive window can be large (0xffff << TCP_WSCALE bytes) when the
+ * peer does window scaling (RFC 7323).
+ *
+ * There is no SACK. When a segment is missing, each segment after it is
+ * answered at once by a duplicate ACK, so that the peer does a fast
+ * retransmit (RFC 5681) of the missing one after three of them, rather
+ * than waiting for its retransmission timer. The ACK then jumps over all
+ * the data received after the gap.
+ */
+
+#include <common.h>
+#include <net.h>
+#include <net/tcp.h>
+#include <asm/unaligned.h>
+
+/* Time between retransmissions, and number of them before giving up */
+#define TCP_TIMEOUT_MS		1000
+#define TCP_RETRY_MAX		10
+
+/* MSS to assume if the peer does not give one */
+#define TCP_DEFAULT_MSS		536
+
+/* Ranges of data received after a gap */
+#define TCP_OOO_MAX		8
+
+enum tcp_state {
+	TCP_CLOSED,
+	TCP_SYN_SENT,
+	TCP_ESTABLISHED,
+};
+
+struct tcp_range {
+	u32 start;
+	u32 end;
+};
+
+static enum tcp_state tcp_state;
+static struct in_addr tcp_remote_ip;
+static int tcp_remote_port;
+static int tcp_our_port;
+static rxhand_tcp_f *tcp_rx_handler;
+static thand_tcp_f *tcp_done_handler;
+static int tcp_timeout_count;
+
+/* Our initial sequence number, and the first byte not yet acknowledged */
+static u32 tcp_iss;
+static u32 tcp_snd_una;
+static u32 tcp_snd_nxt;
+static uchar tcp_tx_buf[TCP_TX_SIZE];
+static int tcp_tx_len;
+static int tcp_peer_mss;
+
+/* The peer's initial sequence number, and the next byte we expect */
+static u32 tcp_irs;
+static u32 tcp_rcv_nxt;
+/* Shift of our window, TCP_WSCALE if the peer agreed to it, else 0 */
+static int tcp_rcv_wscale;
+static struct tcp_range tcp_ooo[TCP_OOO_MAX];
+static int tcp_ooo_count;
+static bool tcp_fin_seen;
+static u32 tcp_fin_seq;
+
+static inline bool tcp_seq_before(u32 a, u32 b)
+{
+	return (s32)(a - b) < 0;
+}
+
+static inline u32 tcp_rcv_wnd(void)
+{
+	return 0xffff << tcp_rcv_wscale;
+}
+
+/* Checksum of the TCP segment after @ip, with its pseudo header */
+static unsigned int tcp_checksum(struct ip_tcp_hdr *ip, int len)
+{
+	struct {
+		struct in_addr src;
+		struct in_addr dst;
+		u8 zero;
+		u8 proto;
+		u16 len;
+	} ph;
+
+	ph.src = net_read_ip(&ip->ip_src);
+	ph.dst = net_read_ip(&ip->ip_dst);
+	ph.zero = 0;
+	ph.proto = IPPROTO_TCP;
+	ph.len = htons(len);
+
+	return add_ip_checksums(sizeof(ph),
+				compute_ip_checksum(&ph, sizeof(ph)),
+				compute_ip_checksum(&ip->tcp_src, len));
+}
+
+static void tcp_send_segment(u8 flags, u32 seq, const uchar *data, int len)
+{
+	struct ip_tcp_hdr *ip;
+	int eth_hdr_size, hdr_len = TCP_HDR_SIZE;
+	uchar *opt;
+
+	eth_hdr_size = net_set_ether(net_tx_packet, net_server_ethaddr,
+				     PROT_IP);
+	ip = (struct ip_tcp_hdr *)(net_tx_packet + eth_hdr_size);
+	opt = (uchar *)(ip + 1);
+	if (flags & TCP_SYN) {
+		opt[0] = TCP_OPT_MSS;
+		opt[1] = 4;
+		put_unaligned_be16(TCP_MSS, opt + 2);
+		opt[4] = TCP_OPT_NOP;
+		opt[5] = TCP_OPT_WSCALE;
+		opt[6] = 3;
+		opt[7] = TCP_WSCALE;
+		hdr_len += 8;
+	}
+	memcpy((uchar *)&ip->tcp_src + hdr_len, data, len);
+
+	net_set_ip_header((uchar *)ip, tcp_remote_ip, net_ip);
+	ip->ip_len = htons(IP_HDR_SIZE + hdr_len + len);
+	ip->ip_p = IPPROTO_TCP;
+	ip->ip_sum = compute_ip_checksum(ip, IP_HDR_SIZE);
+
+	ip->tcp_src = htons(tcp_our_port);
+	ip->tcp_dst = htons(tcp_remote_port);
+	put_unaligned_be32(seq, &ip->tcp_seq);
+	put_unaligned_be32(flags & TCP_ACK ? tcp_rcv_nxt : 0, &ip->tcp_ack);
+	ip->tcp_off = hdr_len / 4 << 4;
+	ip->tcp_flags = flags;
+	/* Always the largest window; scaled, except in a SYN */
+	ip->tcp_win = htons(0xffff);
+	ip->tcp_xsum = 0;
+	ip->tcp_urg = 0;
+	ip->tcp_xsum = tcp_checksum(ip, hdr_len + len);
+
+	net_send_ip_packet(net_server_ethaddr, tcp_remote_ip,
+			   eth_hdr_size + IP_HDR_SIZE + hdr_len + len);
+}
+
+/* Send the data from @seq to the end of the buffer, or an ACK if none */
+static void tcp_send_data(u32 seq)
+{
+	int offset = seq - tcp_iss - 1;
+	int len;
+
+	if (offset >= tcp_tx_len) {
+		tcp_send_segment(TCP_ACK, tcp_snd_nxt, NULL, 0);
+		return;
+	}
+	for (; offset < tcp_tx_len; offset += len) {
+		len = min(tcp_tx_len - offset, tcp_peer_mss);
+		tcp_send_segment(TCP_ACK | TCP_PSH, tcp_iss + 1 + offset,
+				 tcp_tx_buf + offset, len);
+	}
+	tcp_snd_nxt = tcp_iss + 1 + tcp_tx_len;
+}
+
+static void tcp_end(int err)
+{
+	tcp_state = TCP_CLOSED;
+	net_set_timeout_handler(0, NULL);
+	tcp_done_handler(err);
+}
+
+static void tcp_timeout_handler(void)
+{
+	if (++tcp_timeout_count > TCP_RETRY_MAX) {
+		puts("\nTCP: peer not answering\n");
+		tcp_end(-ETIMEDOUT);
+		return;
+	}
+	net_set_timeout_handler(TCP_TIMEOUT_MS, tcp_timeout_handler);
+	if (tcp_state == TCP_SYN_SENT)
+		tcp_send_segment(TCP_SYN, tcp_iss, NULL, 0);
+	else
+		tcp_send_data(tcp_snd_una);
+}
+
+static void tcp_parse_options(uchar *opt, int len)
+{
+	tcp_peer_mss = TCP_DEFAULT_MSS;
+	tcp_rcv_wscale = 0;
+	while (len > 0 && *opt != TCP_OPT_END) {
+		if (*opt == TCP_OPT_NOP) {
+			opt++;
+			len--;
+			continue;
+		}
+		if (len < 2 || opt[1] < 2 || opt[1] > len)
+			break;
+		if (opt[0] == TCP_OPT_MSS && opt[1] == 4)
+			tcp_peer_mss = min_t(int, get_unaligned_be16(opt + 2),
+					     TCP_MSS);
+		else if (opt[0] == TCP_OPT_WSCALE && opt[1] == 3)
+			tcp_rcv_wscale = TCP_WSCALE;
+		len -= opt[1];
+		opt += opt[1];
+	}
+}
+
+/* Move past the ranges received ahead which are no longer after a gap */
+static void tcp_ooo_pull(void)
+{
+	int i;
+
+	for (i = 0; i < tcp_ooo_count; i++) {
+		if (tcp_seq_before(tcp_rcv_nxt, tcp_ooo[i].start))
+			continue;
+		if (tcp_seq_before(tcp_rcv_nxt, tcp_ooo[i].end))
+			tcp_rcv_nxt = tcp_ooo[i].end;
+		tcp_ooo[i] = tcp_ooo[--tcp_ooo_count];
+		i = -1;
+	}
+}
+
+/* Record data received after a gap, merging it with the ranges it meets */
+static int tcp_ooo_add(u32 start, u32 end, uchar *data)
+{
+	int i, ret;
+
+	for (i = 0; i < tcp_ooo_count; i++) {
+		if (!tcp_seq_before(start, tcp_ooo[i].start) &&
+		    !tcp_seq_before(tcp_ooo[i].end, end))
+			return 0;
+	}
+	for (i = 0; i < tcp_ooo_count; i++) {
+		if (!tcp_seq_before(end, tcp_ooo[i].start) &&
+		    !tcp_seq_before(tcp_ooo[i].end, start))
+			break;
+	}
+	if (i == tcp_ooo_count && tcp_ooo_count == TCP_OOO_MAX)
+		return -ENOSPC;
+
+	ret = tcp_rx_handler(start - tcp_irs - 1, data, end - start);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < tcp_ooo_count; i++) {
+		if (tcp_seq_before(end, tcp_ooo[i].start) ||
+		    tcp_seq_before(tcp_ooo[i].end, start))
+			continue;
+		if (tcp_seq_before(tcp_ooo[i].start, start))
+			start = tcp_ooo[i].start;
+		if (tcp_seq_before(end, tcp_ooo[i].end))
+			end = tcp_ooo[i].end;
+		tcp_ooo[i--] = tcp_ooo[--tcp_ooo_count];
+	}
+	tcp_ooo[tcp_ooo_count].start = start;
+	tcp_ooo[tcp_ooo_count++].end = end;
+
+	return 0;
+}
+
+static void tcp_receive_data(u32 seq, uchar *data, unsigned int len)
+{
+	u32 end = seq + len;
+
+	if (tcp_seq_before(seq, tcp_rcv_nxt)) {
+		if (!tcp_seq_before(tcp_rcv_nxt, end))
+			return;
+		data += tcp_rcv_nxt - seq;
+		seq = tcp_rcv_nxt;
+	}
+	if (tcp_seq_before(tcp_rcv_nxt + tcp_rcv_wnd(), end))
+		return;
+
+	if (seq != tcp_rcv_nxt) {
+		tcp_ooo_add(seq, end, data);
+		return;
+	}
+	if (tcp_rx_handler(seq - tcp_irs - 1, data, end - seq))
+		return;
+	tcp_rcv_nxt = end;
+	tcp_ooo_pull();
+}
+
+void tcp_receive(struct ip_tcp_hdr *ip, int len)
+{
+	int hdr_len;
+	uchar *data;
+	u32 seq, ack;
+	u8 flags;
+
+	if (tcp_state == TCP_CLOSED || len < IP_TCP_HDR_SIZE)
+		return;
+	if (net_read_ip(&ip->ip_src).s_addr != tcp_remote_ip.s_addr ||
+	    ntohs(ip->tcp_src) != tcp_remote_port ||
+	    ntohs(ip->tcp_dst) != tcp_our_port)
+		return;
+	len -= IP_HDR_SIZE;
+	hdr_len = (ip->tcp_off >> 4) * 4;
+	if (hdr_len < TCP_HDR_SIZE || hdr_len > len)
+		return;
+	if (tcp_checksum(ip, len) & 0xfffe) {
+		debug("TCP checksum bad\n");
+		return;
+	}
+
+	flags = ip->tcp_flags;
+	seq = get_unaligned_be32(&ip->tcp_seq);
+	ack = get_unaligned_be32(&ip->tcp_ack);
+	data = (uchar *)&ip->tcp_src + hdr_len;
+	len -= hdr_len;
+
+	if (tcp_state == TCP_SYN_SENT) {
+		if (!(flags & TCP_ACK) || ack != tcp_iss + 1)
+			return;
+		if (flags & TCP_RST) {
+			tcp_end(-ECONNRESET);
+			return;
+		}
+		if (!(flags & TCP_SYN))
+			return;
+		tcp_parse_options((uchar *)(ip + 1), hdr_len - TCP_HDR_SIZE);
+		tcp_irs = seq;
+		tcp_rcv_nxt = seq + 1;
+		tcp_snd_una = ack;
+		tcp_state = TCP_ESTABLISHED;
+		tcp_timeout_count = 0;
+		net_set_timeout_handler(TCP_TIMEOUT_MS, tcp_timeout_handler);
+		tcp_send_data(tcp_snd_una);
+		return;
+	}
+
+	/* Only believe a reset which is inside the window */
+	if (flags & TCP_RST) {
+		if (!tcp_seq_before(seq, tcp_rcv_nxt) &&
+		    tcp_seq_before(seq, tcp_rcv_nxt + tcp_rcv_wnd()))
+			tcp_end(-ECONNRESET);
+		return;
+	}
+	if (flags & TCP_SYN) {
+		/* Our ACK of the SYN was lost */
+		tcp_send_segment(TCP_ACK, tcp_snd_nxt, NULL, 0);
+		return;
+	}
+
+	if ((flags & TCP_ACK) && tcp_seq_before(tcp_snd_una, ack) &&
+	    !tcp_seq_before(tcp_snd_nxt, ack))
+		tcp_snd_una = ack;
+	tcp_timeout_count = 0;
+	net_set_timeout_handler(TCP_TIMEOUT_MS, tcp_timeout_handler);
+
+	if (len)
+		tcp_receive_data(seq, data, len);
+	/* The handler may have closed the connection */
+	if (tcp_state == TCP_CLOSED)
+		return;
+	if (flags & TCP_FIN) {
+		tcp_fin_seen = true;
+		tcp_fin_seq = seq + len;
+	}
+	if (tcp_fin_seen && tcp_fin_seq == tcp_rcv_nxt) {
+		/* Acknowledge the FIN and close our side too */
+		tcp_rcv_nxt++;
+		tcp_send_segment(TCP_FIN | TCP_ACK, tcp_snd_nxt, NULL, 0);
+		tcp_end(0);
+		return;
+	}
+	/* Data after a gap gets a duplicate ACK, for a fast retransmit */
+	if (len || (flags & TCP_FIN))
+		tcp_send_segment(TCP_ACK, tcp_snd_nxt, NULL, 0);
+}
+
+int tcp_connect(struct in_addr dest, int dport, int sport, rxhand_tcp_f *rx,
+		thand_tcp_f *done)
+{
+	if (tcp_state != TCP_CLOSED)
+		return -EBUSY;
+
+	tcp_remote_ip = dest;
+	tcp_remote_port = dport;
+	tcp_our_port = sport;
+	tcp_rx_handler = rx;
+	tcp_done_handler = done;
+	tcp_iss = timer_get_us() * 2654435761U;
+	tcp_snd_una = tcp_iss;
+	tcp_snd_nxt = tcp_iss + 1;
+	tcp_tx_len = 0;
+	tcp_peer_mss = TCP_DEFAULT_MSS;
+	tcp_rcv_nxt = 0;
+	tcp_ooo_count = 0;
+	tcp_fin_seen = false;
+	tcp_timeout_count = 0;
+	tcp_state = TCP_SYN_SENT;
+
+	net_set_timeout_handler(TCP_TIMEOUT_MS, tcp_timeout_handler);
+	tcp_send_segment(TCP_SYN, tcp_iss, NULL, 0);
+
+	return 0;
+}
+
+int tcp_send(const void *data, int len)
+{
+	u32 seq = tcp_snd_nxt;
+
+	if (tcp_state == TCP_CLOSED)
+		return -ENOTCONN;
+	if (tcp_tx_len + len > TCP_TX_SIZE)
+		return -ENOSPC;
+
+	memcpy(tcp_tx_buf + tcp_tx_len, data, len);
+	tcp_tx_len += len;
+	if (tcp_state == TCP_ESTABLISHED)
+		tcp_send_data(seq);
+
+	return 0;
+}
+
+void tcp_close(void)
+{
+	if (tcp_state == TCP_ESTABLISHED)
+		tcp_send_segment(TCP_FIN | TCP_ACK, tcp_snd_nxt, NULL, 0);
+	tcp_reset();
+	net_set_timeout_handler(0, NULL);
+}
+
+void tcp_reset(void)
+{
+	tcp_state = TCP_CLOSED;
+}
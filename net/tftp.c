@@ -134,6 +134,27 @@ static char tftp_filename[MAX_LEN];
 static unsigned short tftp_block_size = TFTP_BLOCK_SIZE;
 static unsigned short tftp_block_size_option = TFTP_MTU_BLOCKSIZE;
 
+/*
+ * RFC 7440 lets the server send a window of blocks for each ACK, rather than
+ * waiting for an ACK of every block. We ACK the last block of each window, or
+ * the last block received in order when one goes missing, and the server then
+ * sends the next window starting after it. The server keeps the window size
+ * agreed in the OACK for the whole transfer, so after a timeout we just ACK
+ * again and wait for a full window.
+ */
+#ifdef CONFIG_TFTP_WINDOWSIZE
+#define TFTP_WINDOWSIZE CONFIG_TFTP_WINDOWSIZE
+#else
+#define TFTP_WINDOWSIZE 1
+#endif
+
+static unsigned short tftp_window_size = 1;
+static unsigned short tftp_window_size_option = TFTP_WINDOWSIZE;
+/* number of blocks received since we last sent an ACK */
+static unsigned short tftp_window_pos;
+/* 1 if we have ACKed the last block in order since one went missing */
+static int tftp_window_gap;
+
 #ifdef CONFIG_MCAST_TFTP
 #include <malloc.h>
 #define MTFTP_BITMAPSIZE	0x1000
@@ -211,6 +232,8 @@ static void new_transfer(void)
 	tftp_prev_block = 0;
 	tftp_block_wrap = 0;
 	tftp_block_wrap_offset = 0;
+	tftp_window_pos = 0;
+	tftp_window_gap = 0;
 #ifdef CONFIG_CMD_TFTPPUT
 	tftp_put_final_block_sent = 0;
 #endif
@@ -372,6 +395,10 @@ static void tftp_send(void)
 		/* try for more effic. blk size */
 		pkt += sprintf((char *)pkt, "blksize%c%d%c",
 				0, tftp_block_size_option, 0);
+		/* and for more than one block per ACK, if reading */
+		if (tftp_window_size_option > 1 && !tftp_put_active)
+			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+					0, tftp_window_size_option, 0);
 #ifdef CONFIG_MCAST_TFTP
 		/* Check all preconditions before even trying the option */
 		if (!tftp_mcast_disabled) {
@@ -462,6 +489,7 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 {
 	__be16 proto;
 	__be16 *s;
+	unsigned short block;
 	int i;
 
 	if (dest != tftp_our_port) {
@@ -496,8 +524,10 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 				 * Move to the next block. We want our block
 				 * count to wrap just like the other end!
 				 */
-				int block = ntohs(*s);
-				int ack_ok = (tftp_cur_block == block);
+				int ack_ok;
+
+				block = ntohs(*s);
+				ack_ok = (tftp_cur_block == block);
 
 				tftp_cur_block = (unsigned short)(block + 1);
 				update_block_number();
@@ -540,6 +570,17 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 				debug("Blocksize ack: %s, %d\n",
 				      (char *)pkt + i + 8, tftp_block_size);
 			}
+			if (strcmp((char *)pkt + i, "windowsize") == 0) {
+				tftp_window_size = (unsigned short)
+					simple_strtoul((char *)pkt + i + 11,
+						       NULL, 10);
+				if (!tftp_window_size ||
+				    tftp_window_size > tftp_window_size_option)
+					tftp_window_size =
+						tftp_window_size_option;
+				debug("Windowsize ack: %s, %d\n",
+				      (char *)pkt + i + 11, tftp_window_size);
+			}
 #ifdef CONFIG_TFTP_TSIZE
 			if (strcmp((char *)pkt+i, "tsize") == 0) {
 				tftp_tsize = simple_strtoul((char *)pkt + i + 6,
@@ -551,6 +592,9 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		}
 #ifdef CONFIG_MCAST_TFTP
 		parse_multicast_oack((char *)pkt, len - 1);
+		/* Each client must ACK every block it is missing */
+		if (tftp_mcast_active)
+			tftp_window_size = 1;
 		if ((tftp_mcast_active) && (!tftp_mcast_master_client))
 			tftp_state = STATE_DATA;	/* passive.. */
 		else
@@ -568,15 +612,22 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		if (len < 2)
 			return;
 		len -= 2;
-		tftp_cur_block = ntohs(*(__be16 *)pkt);
-
-		update_block_number();
+		block = ntohs(*(__be16 *)pkt);
 
 		if (tftp_state == STATE_SEND_RRQ)
 			debug("Server did not acknowledge timeout option!\n");
 
 		if (tftp_state == STATE_SEND_RRQ || tftp_state == STATE_OACK ||
 		    tftp_state == STATE_RECV_WRQ) {
+			/* An earlier block of the first window went missing */
+			if (block != 1 && tftp_window_size > 1) {
+				if (!tftp_window_gap) {
+					tftp_window_gap = 1;
+					tftp_send(); /* Send ACK(0) again */
+				}
+				break;
+			}
+
 			/* first block received */
 			tftp_state = STATE_DATA;
 			tftp_remote_port = src;
@@ -584,24 +635,46 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 
 #ifdef CONFIG_MCAST_TFTP
 			if (tftp_mcast_active) { /* start!=1 common if mcast */
-				tftp_prev_block = tftp_cur_block - 1;
+				tftp_prev_block = block - 1;
 			} else
 #endif
-			if (tftp_cur_block != 1) {	/* Assertion */
+			if (block != 1) {	/* Assertion */
 				puts("\nTFTP error: ");
-				printf("First block is not block 1 (%ld)\n",
-				       tftp_cur_block);
+				printf("First block is not block 1 (%u)\n",
+				       block);
 				puts("Starting again\n\n");
 				net_start_again();
 				break;
 			}
 		}
 
-		if (tftp_cur_block == tftp_prev_block) {
+		if (block == tftp_prev_block) {
 			/* Same block again; ignore it. */
 			break;
 		}
 
+		if (tftp_window_size > 1 &&
+		    block != (unsigned short)(tftp_prev_block + 1)) {
+			/*
+			 * Ignore blocks we already have. If we are missing
+			 * some, ACK the last one we got in order, once, so
+			 * that the server sends the rest again.
+			 */
+			if ((unsigned short)(block - tftp_prev_block) <
+			    TFTP_SEQUENCE_SIZE / 2 && !tftp_window_gap) {
+				debug("Missing block %lu, got %u\n",
+				      tftp_prev_block + 1, block);
+				tftp_window_gap = 1;
+				tftp_window_pos = 0;
+				tftp_send();
+			}
+			break;
+		}
+
+		tftp_cur_block = block;
+		update_block_number();
+		tftp_window_gap = 0;
+
 		tftp_prev_block = tftp_cur_block;
 		timeout_count_max = tftp_timeout_count_max;
 		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
@@ -638,7 +711,11 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			}
 		}
 #endif
-		tftp_send();
+		if (++tftp_window_pos >= tftp_window_size ||
+		    len < tftp_block_size) {
+			tftp_send();
+			tftp_window_pos = 0;
+		}
 
 #ifdef CONFIG_MCAST_TFTP
 		if (tftp_mcast_active) {
@@ -690,6 +767,9 @@ static void tftp_timeout_handler(void)
 	} else {
 		puts("T ");
 		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
+		/* The server sends a whole window after the ACK again */
+		if (tftp_state == STATE_DATA)
+			tftp_window_pos = 0;
 		if (tftp_state != STATE_RECV_WRQ)
 			tftp_send();
 	}
@@ -710,6 +790,10 @@ void tftp_start(enum proto_t protocol)
 	if (ep != NULL)
 		tftp_block_size_option = simple_strtol(ep, NULL, 10);
 
+	ep = getenv("tftpwindowsize");
+	if (ep != NULL)
+		tftp_window_size_option = simple_strtol(ep, NULL, 10);
+
 	ep = getenv("tftptimeout");
 	if (ep != NULL)
 		timeout_ms = simple_strtol(ep, NULL, 10);
@@ -731,8 +815,11 @@ void tftp_start(enum proto_t protocol)
 	}
 #endif
 
-	debug("TFTP blocksize = %i, timeout = %ld ms\n",
-	      tftp_block_size_option, timeout_ms);
+	if (!tftp_window_size_option)
+		tftp_window_size_option = 1;
+
+	debug("TFTP blocksize = %i, windowsize = %i, timeout = %ld ms\n",
+	      tftp_block_size_option, tftp_window_size_option, timeout_ms);
 
 	tftp_remote_ip = net_server_ip;
 	if (net_boot_file_name[0] == '\0') {
@@ -835,6 +922,8 @@ void tftp_start(enum proto_t protocol)
 	memset(net_server_ethaddr, 0, 6);
 	/* Revert tftp_block_size to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_window_size = 1;
+	tftp_window_gap = 0;
 #ifdef CONFIG_MCAST_TFTP
 	mcast_cleanup();
 #endif
@@ -864,6 +953,7 @@ void tftp_start_server(void)
 
 	/* Revert tftp_block_size to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_window_size = 1;
 	tftp_cur_block = 0;
 	tftp_our_port = WELL_KNOWN_PORT;
 
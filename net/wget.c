@@ -0,0 +1,243 @@
+/*
+ * HTTP GET over TCP
+ *
+ * Copyright (c) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ *
+ * The request is HTTP/1.0, so that the server neither keeps the connection
+ * open nor sends the body in chunks: the body is all the data up to the
+ * FIN. It is written straight to the load address as it arrives, in
+ * whatever order the segments come in, but never past the Content-Length
+ * or the end of the free memory there.
+ */
+
+#include <common.h>
+#include <lmb.h>
+#include <mapmem.h>
+#include <net.h>
+#include <net/tcp.h>
+#include "wget.h"
+
+/* Most header bytes kept for parsing */
+#define WGET_HDR_MAX		2048
+/* Body bytes per hash mark */
+#define WGET_HASH_SIZE		(64 << 10)
+#define HASHES_PER_LINE		65
+
+static struct in_addr wget_server_ip;
+static char *wget_path;
+static char wget_hdr[WGET_HDR_MAX + 1];
+static int wget_hdr_len;
+/* Offset of the body in the stream, or 0 until the headers are parsed */
+static int wget_body_start;
+/* Body size from the Content-Length header, or -1 if none */
+static long wget_content_len;
+/* Most body bytes that fit at the load address */
+static ulong wget_load_size;
+static int wget_hashes;
+static ulong time_start;
+
+static void wget_fail(const char *msg)
+{
+	printf("\nHTTP: %s\n", msg);
+	tcp_close();
+	net_set_state(NETLOOP_FAIL);
+}
+
+/*
+ * Check the status line, and pick up the Content-Length if any. The headers
+ * are cut off before the final "\r\n", so each line ends in "\r\n".
+ */
+static int wget_parse_headers(void)
+{
+	char *line, *end;
+
+	wget_hdr[wget_body_start - 2] = '\0';
+	end = strstr(wget_hdr, "\r\n");
+	if (!end)
+		return -EINVAL;
+	*end = '\0';
+	if (strncmp(wget_hdr, "HTTP/1.", 7) || wget_hdr[8] != ' ' ||
+	    wget_hdr[9] != '2') {
+		printf("\nHTTP: server replied '%s'\n", wget_hdr);
+		return -ENOENT;
+	}
+
+	wget_content_len = -1;
+	for (line = end + 2; *line; line = end + 2) {
+		end = strstr(line, "\r\n");
+		if (!end)
+			return -EINVAL;
+		*end = '\0';
+		if (strncasecmp(line, "Content-Length:", 15))
+			continue;
+		for (line += 15; *line == ' ' || *line == '\t'; line++)
+			;
+		wget_content_len = simple_strtol(line, NULL, 10);
+	}
+	if (wget_content_len >= 0 && wget_content_len > wget_load_size) {
+		puts("\nHTTP: file too large for memory\n");
+		return -EFBIG;
+	}
+
+	return 0;
+}
+
+/* Find how much memory is free for the OS from the load address on */
+static ulong wget_free_size(void)
+{
+#ifdef CONFIG_LMB
+	struct lmb lmb;
+
+	lmb_init(&lmb);
+	lmb_add(&lmb, getenv_bootm_low(), getenv_bootm_size());
+	arch_lmb_reserve(&lmb);
+	board_lmb_reserve(&lmb);
+
+	return lmb_get_free_size(&lmb, load_addr);
+#else
+	return ULONG_MAX - load_addr;
+#endif
+}
+
+static void wget_show_progress(void)
+{
+	while (wget_hashes < net_boot_file_size / WGET_HASH_SIZE) {
+		putc('#');
+		if (++wget_hashes % HASHES_PER_LINE == 0)
+			puts("\n\t ");
+	}
+}
+
+static int wget_handler(u32 offset, uchar *data, unsigned int len)
+{
+	ulong newsize;
+	void *ptr;
+	int skip;
+
+	if (!wget_body_start) {
+		/* The headers are only taken in order */
+		if (offset != wget_hdr_len)
+			return -EAGAIN;
+		skip = min_t(int, len, WGET_HDR_MAX - wget_hdr_len);
+		memcpy(wget_hdr + wget_hdr_len, data, skip);
+		wget_hdr_len += skip;
+		wget_hdr[wget_hdr_len] = '\0';
+		ptr = strstr(wget_hdr, "\r\n\r\n");
+		if (!ptr) {
+			if (wget_hdr_len == WGET_HDR_MAX)
+				wget_fail("headers too long");
+			return 0;
+		}
+		wget_body_start = ptr + 4 - (void *)wget_hdr;
+		if (wget_parse_headers()) {
+			wget_fail("download failed");
+			return 0;
+		}
+
+		/* The rest is the start of the body */
+		skip = wget_body_start - offset;
+		data += skip;
+		len -= skip;
+		offset = wget_body_start;
+	}
+
+	if (offset < wget_body_start || !len)
+		return 0;
+	offset -= wget_body_start;
+	newsize = offset + len;
+	if (wget_content_len >= 0 && newsize > wget_content_len) {
+		wget_fail("body is too long");
+		return 0;
+	}
+	if (newsize > wget_load_size) {
+		wget_fail("file too large for memory");
+		return 0;
+	}
+	ptr = map_sysmem(load_addr + offset, len);
+	memcpy(ptr, data, len);
+	unmap_sysmem(ptr);
+	if (net_boot_file_size < newsize)
+		net_boot_file_size = newsize;
+	wget_show_progress();
+
+	return 0;
+}
+
+static void wget_complete(void)
+{
+	time_start = get_timer(time_start);
+	if (time_start > 0) {
+		puts("\n\t ");	/* Line up with "Loading: " */
+		print_size(net_boot_file_size / time_start * 1000, "/s");
+	}
+	puts("\ndone\n");
+	net_set_state(NETLOOP_SUCCESS);
+}
+
+static void wget_done(int err)
+{
+	if (err)
+		wget_fail("connection lost");
+	else if (!wget_body_start)
+		wget_fail("no reply");
+	else if (wget_content_len >= 0 &&
+		 net_boot_file_size != wget_content_len)
+		wget_fail("body is short");
+	else
+		wget_complete();
+}
+
+void wget_start(void)
+{
+	char request[TCP_TX_SIZE];
+	int port = WGET_HTTP_PORT;
+	char *p;
+	int len;
+
+	wget_server_ip = net_server_ip;
+	wget_path = net_boot_file_name;
+	p = strchr(net_boot_file_name, ':');
+	if (p) {
+		wget_server_ip = string_to_ip(net_boot_file_name);
+		wget_path = p + 1;
+	}
+	if (*wget_path == '\0') {
+		puts("*** ERROR: no file name to fetch\n");
+		net_set_state(NETLOOP_FAIL);
+		return;
+	}
+	p = getenv("httpdstp");
+	if (p)
+		port = simple_strtol(p, NULL, 10);
+
+	printf("Using %s device\n", eth_get_name());
+	printf("HTTP from server %pI4:%d; our IP address is %pI4\n",
+	       &wget_server_ip, port, &net_ip);
+	printf("Filename '%s'.\n", wget_path);
+	printf("Load address: 0x%lx\n", load_addr);
+	puts("Loading: *\b");
+
+	wget_hdr_len = 0;
+	wget_body_start = 0;
+	wget_load_size = wget_free_size();
+	wget_hashes = 0;
+	time_start = get_timer(0);
+
+	len = snprintf(request, sizeof(request),
+		       "GET %s%s HTTP/1.0\r\nHost: %pI4\r\nUser-Agent: U-Boot\r\n\r\n",
+		       *wget_path == '/' ? "" : "/", wget_path,
+		       &wget_server_ip);
+	if (len >= sizeof(request)) {
+		puts("*** ERROR: file name too long\n");
+		net_set_state(NETLOOP_FAIL);
+		return;
+	}
+
+	/* zero out server ether in case the server ip has changed */
+	memset(net_server_ethaddr, 0, 6);
+	tcp_connect(wget_server_ip, port, 49152 + (get_timer(0) % 16384),
+		    wget_handler, wget_done);
+	tcp_send(request, len);
+}
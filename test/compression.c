@@ -11,7 +11,10 @@
 #include <command.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <os.h>
+#include <sandboxblockdev.h>
 #include <asm/io.h>
+#include <asm/unaligned.h>
 
 #include <u-boot/zlib.h>
 #include <bzlib.h>
@@ -448,6 +451,64 @@ static int run_bootm_test(int comp_type, mutate_func compress)
 	return 0;
 }
 
+/**
+ * run_bootm_stream_test() - Run tests on bootm streamed decompression
+ *
+ * @comp_type:	Compression type to test
+ * @compress:	Our function to compress data
+ * @return 0 if OK, non-zero on failure
+ */
+static int run_bootm_stream_test(int comp_type, mutate_func compress)
+{
+	struct bootm_decomp_stream ds;
+	ulong compress_size = 1024;
+	ulong load_len, avail;
+	void *compress_buff;
+	void *load_buf;
+	int unc_len;
+	int err;
+
+	printf("Testing stream: %s\n", genimg_get_comp_name(comp_type));
+	compress_buff = malloc(compress_size);
+	load_buf = malloc(TEST_BUFFER_SIZE);
+	if (!compress_buff || !load_buf) {
+		err = -ENOMEM;
+		goto out;
+	}
+	unc_len = strlen(plain);
+	compress((void *)plain, unc_len, compress_buff, compress_size,
+		 &compress_size);
+
+	/* Hand the image over a few bytes at a time, as a slow loader would */
+	err = bootm_decomp_stream_start(&ds, comp_type, load_buf,
+					compress_buff, unc_len);
+	for (avail = 0; !err && avail < compress_size; avail += 7)
+		err = bootm_decomp_stream_feed(&ds, avail) < 0;
+	if (!err)
+		err = bootm_decomp_stream_end(&ds, compress_size, &load_len);
+	if (err)
+		goto out;
+	if (load_len != unc_len || memcmp(load_buf, plain, unc_len)) {
+		err = -EINVAL;
+		goto out;
+	}
+
+	/* A truncated image must be reported */
+	if (comp_type == IH_COMP_NONE)
+		goto out;
+	err = bootm_decomp_stream_start(&ds, comp_type, load_buf,
+					compress_buff, unc_len);
+	if (!err && !bootm_decomp_stream_end(&ds, compress_size / 2,
+					     &load_len))
+		err = -EINVAL;
+
+out:
+	free(load_buf);
+	free(compress_buff);
+
+	return err;
+}
+
 static int do_ut_image_decomp(cmd_tbl_t *cmdtp, int flag, int argc,
 			      char *const argv[])
 {
@@ -459,12 +520,257 @@ static int do_ut_image_decomp(cmd_tbl_t *cmdtp, int flag, int argc,
 	err |= run_bootm_test(IH_COMP_LZO, compress_using_lzo);
 	err |= run_bootm_test(IH_COMP_LZ4, compress_using_lz4);
 	err |= run_bootm_test(IH_COMP_NONE, compress_using_none);
+	err |= run_bootm_stream_test(IH_COMP_GZIP, compress_using_gzip);
+	err |= run_bootm_stream_test(IH_COMP_LZ4, compress_using_lz4);
+	err |= run_bootm_stream_test(IH_COMP_NONE, compress_using_none);
 
 	printf("ut_image_decomp %s\n", err == 0 ? "ok" : "FAILED");
 
 	return 0;
 }
 
+#ifdef CONFIG_BLK
+#define BENCH_FILE	"decomp_bench.img"
+#define BENCH_SIZE	(8 << 20)
+
+static const char *const bench_words[] = {
+	"kernel", "device", "driver", "memory", "the", "of", "a", "boot",
+	"clock", "interrupt", "register", "\n", "0x1000", "probe", "init",
+};
+
+/* Fill @buf with text-like data, which compresses about as well as code */
+static void bench_fill(char *buf, ulong size)
+{
+	u32 seed = 1;
+	ulong pos = 0;
+	const char *word;
+	int len;
+
+	while (pos < size) {
+		seed = seed * 1103515245 + 12345;
+		if ((seed >> 16) % 4) {
+			word = bench_words[(seed >> 20) % ARRAY_SIZE(bench_words)];
+			len = min_t(ulong, strlen(word), size - pos);
+			memcpy(buf + pos, word, len);
+			pos += len;
+		} else {
+			buf[pos++] = seed >> 24;
+		}
+		if (pos < size)
+			buf[pos++] = ' ';
+	}
+}
+
+static u8 *lz4_put_len(u8 *op, ulong len)
+{
+	for (; len >= 255; len -= 255)
+		*op++ = 255;
+	*op++ = len;
+
+	return op;
+}
+
+/* Emit a sequence of @lit literals, followed by a match if @len != 0 */
+static u8 *lz4_put_seq(u8 *op, const u8 *lits, ulong lit, ulong offset,
+		       ulong len)
+{
+	u8 *token = op++;
+
+	*token = min_t(ulong, lit, 15) << 4;
+	if (lit >= 15)
+		op = lz4_put_len(op, lit - 15);
+	memcpy(op, lits, lit);
+	op += lit;
+	if (!len)
+		return op;
+
+	put_unaligned_le16(offset, op);
+	op += 2;
+	len -= 4;
+	*token |= min_t(ulong, len, 15);
+	if (len >= 15)
+		op = lz4_put_len(op, len - 15);
+
+	return op;
+}
+
+/*
+ * There is no lz4 compression in u-boot and a fixed image is too small to
+ * time, so use a simple greedy compressor producing a valid block
+ */
+static ulong lz4_compress_block(const u8 *in, ulong size, u8 *out)
+{
+	static u32 table[1 << 12];
+	const u8 *ip = in, *anchor = in, *ref;
+	const u8 *mflimit = in + size - 12, *matchlimit = in + size - 5;
+	u8 *op = out;
+	ulong len;
+	u32 seq, h;
+
+	memset(table, '\0', sizeof(table));
+	while (size > 12 && ip < mflimit) {
+		seq = get_unaligned_le32(ip);
+		h = (seq * 2654435761U) >> 20;
+		ref = table[h] ? in + table[h] - 1 : NULL;
+		table[h] = ip - in + 1;
+		if (!ref || ip - ref > 0xffff ||
+		    get_unaligned_le32(ref) != seq) {
+			ip++;
+			continue;
+		}
+		for (len = 4; ip + len < matchlimit && ref[len] == ip[len];)
+			len++;
+		op = lz4_put_seq(op, anchor, ip - anchor, ip - ref, len);
+		ip += len;
+		anchor = ip;
+	}
+
+	return lz4_put_seq(op, anchor, in + size - anchor, 0, 0) - out;
+}
+
+static int compress_using_lz4_frame(void *in, unsigned long in_size,
+				    void *out, unsigned long out_max,
+				    unsigned long *out_size)
+{
+	/* Independent blocks of at most 64KB, no checksums */
+	static const u8 frame_header[] = {
+		0x04, 0x22, 0x4d, 0x18, 0x60, 0x40, 0x82
+	};
+	const ulong block_size = 64 << 10;
+	u8 *op = out;
+	ulong pos, n;
+
+	if (out_max < in_size + in_size / 255 * 2 + 1024)
+		return -1;
+	memcpy(op, frame_header, sizeof(frame_header));
+	op += sizeof(frame_header);
+	for (pos = 0; pos < in_size; pos += n) {
+		n = min(block_size, in_size - pos);
+		put_unaligned_le32(lz4_compress_block(in + pos, n, op + 4), op);
+		op += 4 + get_unaligned_le32(op);
+	}
+	put_unaligned_le32(0, op);
+	op += 4;
+	*out_size = op - (u8 *)out;
+
+	return 0;
+}
+
+/**
+ * run_decomp_bench() - Time loading and decompressing an image from storage
+ *
+ * The image is first loaded and then decompressed, as bootm does, and then
+ * decompressed while it is being loaded, as diskboot does.
+ *
+ * @comp_type:	Compression type to test
+ * @compress:	Our function to compress data
+ * @uncompress:	Our function to uncompress data
+ * @return 0 if OK, non-zero on failure
+ */
+static int run_decomp_bench(int comp_type, mutate_func compress,
+			    mutate_func uncompress)
+{
+	ulong orig_size = BENCH_SIZE, comp_size, unc_size;
+	ulong load_us, decomp_us, stream_us;
+	void *orig_buf, *comp_buf, *unc_buf;
+	struct blk_desc *desc;
+	lbaint_t blkcnt;
+	ulong start;
+	int ret = -ENOMEM;
+	int fd;
+
+	orig_buf = malloc(orig_size);
+	comp_size = orig_size + orig_size / 8;
+	comp_buf = memalign(ARCH_DMA_MINALIGN, comp_size);
+	unc_buf = malloc(orig_size);
+	if (!orig_buf || !comp_buf || !unc_buf)
+		goto out;
+
+	bench_fill(orig_buf, orig_size);
+	ret = compress(orig_buf, orig_size, comp_buf, comp_size, &comp_size);
+	if (ret)
+		goto out;
+	blkcnt = DIV_ROUND_UP(comp_size, 512);
+
+	fd = os_open(BENCH_FILE, OS_O_RDWR | OS_O_CREAT);
+	if (fd < 0) {
+		ret = -EIO;
+		goto out;
+	}
+	if (os_write(fd, comp_buf, blkcnt * 512) != blkcnt * 512)
+		ret = -EIO;
+	os_close(fd);
+	if (!ret)
+		ret = host_dev_bind(0, BENCH_FILE);
+	if (!ret)
+		ret = blk_get_device_by_str("host", "0", &desc) < 0 ? -ENODEV
+								     : 0;
+	if (ret)
+		goto out_unlink;
+
+	/* Load, then decompress */
+	memset(comp_buf, '\0', comp_size);
+	start = timer_get_us();
+	if (blk_dread(desc, 0, blkcnt, comp_buf) != blkcnt) {
+		ret = -EIO;
+		goto out_unbind;
+	}
+	load_us = timer_get_us() - start;
+	start = timer_get_us();
+	ret = uncompress(comp_buf, comp_size, unc_buf, orig_size, &unc_size);
+	decomp_us = timer_get_us() - start;
+	if (ret || unc_size != orig_size || memcmp(orig_buf, unc_buf,
+						   orig_size)) {
+		ret = -EINVAL;
+		goto out_unbind;
+	}
+
+	/* Decompress while loading */
+	memset(comp_buf, '\0', comp_size);
+	memset(unc_buf, '\0', orig_size);
+	start = timer_get_us();
+	ret = bootm_decomp_blk(desc, 0, blkcnt, comp_buf, 0, comp_size,
+			       comp_type, IH_TYPE_KERNEL, unc_buf, orig_size,
+			       &unc_size);
+	stream_us = timer_get_us() - start;
+	if (ret || unc_size != orig_size || memcmp(orig_buf, unc_buf,
+						   orig_size)) {
+		ret = -EINVAL;
+		goto out_unbind;
+	}
+
+	printf("%s: %lu -> %lu bytes: load %lu us, decompress %lu us, total %lu us, overlapped %lu us\n",
+	       genimg_get_comp_name(comp_type), comp_size, orig_size, load_us,
+	       decomp_us, load_us + decomp_us, stream_us);
+
+out_unbind:
+	host_dev_bind(0, NULL);
+out_unlink:
+	os_unlink(BENCH_FILE);
+out:
+	free(unc_buf);
+	free(comp_buf);
+	free(orig_buf);
+
+	return ret;
+}
+
+static int do_ut_image_decomp_bench(cmd_tbl_t *cmdtp, int flag, int argc,
+				    char *const argv[])
+{
+	int err;
+
+	err = run_decomp_bench(IH_COMP_GZIP, compress_using_gzip,
+			       uncompress_using_gzip);
+	err |= run_decomp_bench(IH_COMP_LZ4, compress_using_lz4_frame,
+				uncompress_using_lz4);
+
+	printf("ut_image_decomp_bench %s\n", err == 0 ? "ok" : "FAILED");
+
+	return err ? CMD_RET_FAILURE : 0;
+}
+#endif /* CONFIG_BLK */
+
 U_BOOT_CMD(
 	ut_compression,	5,	1,	do_ut_compression,
 	"Basic test of compressors: gzip bzip2 lzma lzo", ""
@@ -474,3 +780,10 @@ U_BOOT_CMD(
 	ut_image_decomp,	5,	1, do_ut_image_decomp,
 	"Basic test of bootm decompression", ""
 );
+
+#ifdef CONFIG_BLK
+U_BOOT_CMD(
+	ut_image_decomp_bench,	1,	1, do_ut_image_decomp_bench,
+	"Time bootm decompression of an image loaded from storage", ""
+);
+#endif
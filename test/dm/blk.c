@@ -5,7 +5,12 @@
  */
 
 #include <common.h>
+#include <bootm.h>
 #include <dm.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <os.h>
+#include <sandboxblockdev.h>
 #include <usb.h>
 #include <asm/state.h>
 #include <dm/test.h>
@@ -94,3 +99,215 @@ static int dm_test_blk_usb(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_usb, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#ifdef CONFIG_BLOCK_CACHE
+#define BC_FILE		"blk_cache.img"
+#define BC_BLOCKS	32
+
+/* Test that only the blocks missing from the cache are read */
+static int dm_test_blk_cache_partial(struct unit_test_state *uts)
+{
+	struct blk_desc *desc;
+	u8 *buf;
+	int fd, i;
+
+	buf = malloc(BC_BLOCKS * 512);
+	ut_assertnonnull(buf);
+	memset(buf, 0x11, BC_BLOCKS * 512);
+	fd = os_open(BC_FILE, OS_O_RDWR | OS_O_CREAT);
+	ut_assert(fd >= 0);
+	ut_asserteq(BC_BLOCKS * 512, os_write(fd, buf, BC_BLOCKS * 512));
+
+	ut_assertok(host_dev_bind(0, BC_FILE));
+	ut_assertok(blk_get_device_by_str("host", "0", &desc));
+	/* Reading the partition table may have started a read-ahead */
+	blkreadahead_invalidate(desc);
+	ut_asserteq(2, blk_dread(desc, 10, 2, buf));
+	ut_asserteq(1, blk_dread(desc, 15, 1, buf));
+
+	/* Change the file behind the cache's back */
+	memset(buf, 0x22, BC_BLOCKS * 512);
+	ut_asserteq(0, os_lseek(fd, 0, OS_SEEK_SET));
+	ut_asserteq(BC_BLOCKS * 512, os_write(fd, buf, BC_BLOCKS * 512));
+	os_close(fd);
+
+	/* Blocks 10, 11 and 15 still come from the cache */
+	ut_asserteq(6, blk_dread(desc, 10, 6, buf));
+	for (i = 0; i < 6 * 512; i++)
+		ut_asserteq(i < 2 * 512 || i >= 5 * 512 ? 0x11 : 0x22,
+			    buf[i]);
+
+	ut_assertok(host_dev_bind(0, NULL));
+	os_unlink(BC_FILE);
+	free(buf);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_cache_partial, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
+
+#ifdef CONFIG_BLOCK_READAHEAD
+#define RA_FILE		"blk_readahead.img"
+#define RA_BLOCKS	8192
+/* Larger than the block cache takes, so that it stays out of the way */
+#define RA_CHUNK	64
+
+/* Check that each word of @buf holds its index in the backing file */
+static int check_blocks(struct unit_test_state *uts, u32 *buf,
+			lbaint_t start, lbaint_t blkcnt)
+{
+	int i;
+
+	for (i = 0; i < blkcnt * 512 / sizeof(u32); i++)
+		ut_asserteq(start * 512 / sizeof(u32) + i, buf[i]);
+
+	return 0;
+}
+
+/* Test that sequential reads are served by read-ahead */
+static int dm_test_blk_readahead(struct unit_test_state *uts)
+{
+	struct block_readahead_stats stats;
+	struct blk_desc *desc;
+	u32 *buf;
+	lbaint_t blk;
+	int fd, i;
+
+	buf = malloc(RA_BLOCKS * 512);
+	ut_assertnonnull(buf);
+	for (i = 0; i < RA_BLOCKS * 512 / sizeof(u32); i++)
+		buf[i] = i;
+	fd = os_open(RA_FILE, OS_O_RDWR | OS_O_CREAT);
+	ut_assert(fd >= 0);
+	ut_asserteq(RA_BLOCKS * 512, os_write(fd, buf, RA_BLOCKS * 512));
+	os_close(fd);
+
+	ut_assertok(host_dev_bind(0, RA_FILE));
+	ut_assertok(blk_get_device_by_str("host", "0", &desc));
+	blkreadahead_stats(&stats);
+
+	/*
+	 * Read the whole device in small chunks, as a filesystem would. The
+	 * first read, at block 0, is not known to be sequential yet.
+	 */
+	for (blk = 0; blk < RA_BLOCKS; blk += RA_CHUNK) {
+		ut_asserteq(RA_CHUNK, blk_dread(desc, blk, RA_CHUNK, buf));
+		ut_assertok(check_blocks(uts, buf, blk, RA_CHUNK));
+	}
+	blkreadahead_stats(&stats);
+	ut_asserteq(RA_BLOCKS / RA_CHUNK - 1, stats.hits);
+	ut_asserteq(1, stats.misses);
+	ut_assert(stats.windows < RA_BLOCKS / RA_CHUNK);
+
+	/* A random read is left to the driver */
+	ut_asserteq(1, blk_dread(desc, 100, 1, buf));
+	ut_assertok(check_blocks(uts, buf, 100, 1));
+	blkreadahead_stats(&stats);
+	ut_asserteq(0, stats.hits);
+	ut_asserteq(1, stats.misses);
+
+	/* A write must not leave stale data behind */
+	ut_asserteq(RA_CHUNK, blk_dread(desc, 200, RA_CHUNK, buf));
+	ut_asserteq(RA_CHUNK, blk_dread(desc, 200 + RA_CHUNK, RA_CHUNK, buf));
+	memset(buf, '\0', 512);
+	ut_asserteq(1, blk_dwrite(desc, 300, 1, buf));
+	ut_asserteq(RA_CHUNK, blk_dread(desc, 200 + 2 * RA_CHUNK, RA_CHUNK,
+					buf));
+	ut_assertok(check_blocks(uts, buf, 200 + 2 * RA_CHUNK, RA_CHUNK));
+	ut_asserteq(1, blk_dread(desc, 300, 1, buf));
+	ut_asserteq(0, buf[0]);
+
+	ut_assertok(host_dev_bind(0, NULL));
+	os_unlink(RA_FILE);
+	free(buf);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_readahead, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
+
+/* common_diskboot() is built for the usb command */
+#if defined(CONFIG_CMD_USB) && defined(CONFIG_IMAGE_FORMAT_LEGACY) && \
+	defined(CONFIG_GZIP_COMPRESSED)
+#define DB_FILE		"blk_diskboot.img"
+#define DB_ADDR		0x1000000
+#define DB_LOAD		0x100000
+#define DB_SIZE		(256 << 10)
+
+/* Test that diskboot decompresses a kernel while reading it, if asked */
+static int dm_test_blk_diskboot(struct unit_test_state *uts)
+{
+	char *const argv[] = { "diskboot", "1000000", "0" };
+	ulong comp_len, image_start, load_end;
+	image_header_t *hdr;
+	u8 *data, *load;
+	int fd, i, len;
+
+	data = malloc(DB_SIZE);
+	hdr = calloc(1, 2 * DB_SIZE);
+	ut_assertnonnull(data);
+	ut_assertnonnull(hdr);
+	for (i = 0; i < DB_SIZE; i++)
+		data[i] = i % 251 + i / 4096;
+
+	comp_len = DB_SIZE;
+	ut_assertok(gzip(hdr + 1, &comp_len, data, DB_SIZE));
+	image_set_magic(hdr, IH_MAGIC);
+	image_set_size(hdr, comp_len);
+	image_set_load(hdr, DB_LOAD);
+	image_set_ep(hdr, DB_LOAD);
+	image_set_dcrc(hdr, crc32(0, (u8 *)(hdr + 1), comp_len));
+	image_set_os(hdr, IH_OS_LINUX);
+	image_set_arch(hdr, IH_ARCH_SANDBOX);
+	image_set_type(hdr, IH_TYPE_KERNEL);
+	image_set_comp(hdr, IH_COMP_GZIP);
+	image_set_hcrc(hdr, crc32(0, (u8 *)hdr, sizeof(*hdr)));
+
+	len = ALIGN(sizeof(*hdr) + comp_len, 512);
+	fd = os_open(DB_FILE, OS_O_RDWR | OS_O_CREAT);
+	ut_assert(fd >= 0);
+	ut_asserteq(len, os_write(fd, hdr, len));
+	os_close(fd);
+	ut_assertok(host_dev_bind(0, DB_FILE));
+
+	/* Unless asked for, the kernel is left to bootm */
+	setenv("autostart", NULL);
+	setenv("diskboot_decomp", NULL);
+	load = map_sysmem(DB_LOAD, DB_SIZE);
+	memset(load, '\0', DB_SIZE);
+	ut_assertok(common_diskboot(NULL, "host", 3, argv));
+	ut_asserteq(DB_ADDR, load_addr);
+	ut_assert(!memcmp(hdr, map_sysmem(DB_ADDR, len), len));
+	ut_asserteq(0, load[DB_SIZE - 1]);
+	image_start = DB_ADDR + sizeof(*hdr);
+	ut_assert(!bootm_decomp_get_loaded(IH_COMP_GZIP, DB_LOAD, image_start,
+					   comp_len, &load_end));
+
+	setenv("diskboot_decomp", "yes");
+	ut_assertok(common_diskboot(NULL, "host", 3, argv));
+	ut_assert(!memcmp(hdr, map_sysmem(DB_ADDR, len), len));
+	ut_assert(!memcmp(data, load, DB_SIZE));
+
+	/* bootm finds the kernel decompressed, but only once */
+	ut_assert(bootm_decomp_get_loaded(IH_COMP_GZIP, DB_LOAD, image_start,
+					  comp_len, &load_end));
+	ut_asserteq(DB_LOAD + DB_SIZE, load_end);
+	ut_assert(!bootm_decomp_get_loaded(IH_COMP_GZIP, DB_LOAD, image_start,
+					   comp_len, &load_end));
+
+	/* Nor once another image has been loaded in its place */
+	ut_assertok(common_diskboot(NULL, "host", 3, argv));
+	image_set_hcrc(map_sysmem(DB_ADDR, len), image_get_hcrc(hdr) ^ 1);
+	ut_assert(!bootm_decomp_get_loaded(IH_COMP_GZIP, DB_LOAD, image_start,
+					   comp_len, &load_end));
+	setenv("diskboot_decomp", NULL);
+
+	ut_assertok(host_dev_bind(0, NULL));
+	os_unlink(DB_FILE);
+	free(hdr);
+	free(data);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_diskboot, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
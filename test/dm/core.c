@@ -12,6 +12,7 @@
 #include <fdtdec.h>
 #include <malloc.h>
 #include <dm/device-internal.h>
+#include <dm/lists.h>
 #include <dm/root.h>
 #include <dm/util.h>
 #include <dm/test.h>
@@ -862,3 +863,168 @@ static int dm_test_device_get_uclass_id(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_device_get_uclass_id, DM_TESTF_SCAN_PDATA);
+
+/* Find a driver the way lists_bind_fdt() did before the hash index */
+static struct driver *lists_linear_compat(const char *compat,
+					  const struct udevice_id **of_idp)
+{
+	struct driver *drv = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *of_id;
+	struct driver *entry;
+
+	for (entry = drv; entry != drv + n_ents; entry++) {
+		for (of_id = entry->of_match; of_id && of_id->compatible;
+		     of_id++) {
+			if (!strcmp(of_id->compatible, compat)) {
+				*of_idp = of_id;
+				return entry;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/* Look up every compatible string, returning the time taken */
+static ulong lists_lookup_all(bool linear)
+{
+	struct driver *drv = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *of_id, *id;
+	struct driver *entry;
+	ulong start;
+
+	start = timer_get_us();
+	for (entry = drv; entry != drv + n_ents; entry++) {
+		for (of_id = entry->of_match; of_id && of_id->compatible;
+		     of_id++) {
+			if (linear)
+				lists_linear_compat(of_id->compatible, &id);
+			else
+				lists_driver_lookup_compat(of_id->compatible,
+							   &id);
+		}
+	}
+
+	return timer_get_us() - start;
+}
+
+/* Test that drivers are found as they would be by searching the list */
+static int dm_test_lists_lookup(struct unit_test_state *uts)
+{
+	struct driver *drv = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *of_id, *id, *expect_id;
+	struct driver *entry, *expect;
+	ulong linear_us, index_us;
+
+	for (entry = drv; entry != drv + n_ents; entry++) {
+		for (expect = drv; strcmp(expect->name, entry->name);
+		     expect++)
+			;
+		ut_asserteq_ptr(expect, lists_driver_lookup_name(entry->name));
+
+		for (of_id = entry->of_match; of_id && of_id->compatible;
+		     of_id++) {
+			expect = lists_linear_compat(of_id->compatible,
+						     &expect_id);
+			id = NULL;
+			ut_asserteq_ptr(expect, lists_driver_lookup_compat(
+					of_id->compatible, &id));
+			ut_asserteq_ptr(expect_id, id);
+		}
+	}
+	ut_asserteq_ptr(NULL, lists_driver_lookup_name("no-such-driver"));
+	ut_asserteq_ptr(NULL, lists_driver_lookup_compat("no,such-device",
+							 &id));
+
+	linear_us = lists_lookup_all(true);
+	index_us = lists_lookup_all(false);
+	printf("%d drivers: linear search %lu us, lookup %lu us\n", n_ents,
+	       linear_us, index_us);
+
+	return 0;
+}
+DM_TEST(dm_test_lists_lookup, 0);
+
+#define INDEX_DEV_COUNT	40
+
+/* Check that the uclass indexes track devices as they come and go */
+static int dm_test_uclass_index(struct unit_test_state *uts)
+{
+	struct udevice *dev[INDEX_DEV_COUNT], *found;
+	ulong start, linear_us, index_us;
+	struct uclass *uc;
+	int i, seq;
+
+	ut_assertok(uclass_get(UCLASS_TEST, &uc));
+	ut_asserteq_ptr(uc, uclass_find(UCLASS_TEST));
+	ut_asserteq_ptr(NULL, uclass_find(UCLASS_INVALID));
+
+	for (i = 0; i < INDEX_DEV_COUNT; i++) {
+		ut_assertok(device_bind_by_name(gd->dm_root, false,
+						&driver_info_manual, &dev[i]));
+		dev_set_of_offset(dev[i], 1000 + i * 16);
+	}
+	/* Two devices with the same offset: the first in the list is found */
+	dev_set_of_offset(dev[5], 1000);
+	for (i = 0; i < INDEX_DEV_COUNT; i++) {
+		ut_assertok(uclass_find_device_by_of_offset(UCLASS_TEST,
+				dev_of_offset(dev[i]), &found));
+		ut_asserteq_ptr(i == 5 ? dev[0] : dev[i], found);
+	}
+	ut_asserteq(-ENODEV, uclass_find_device_by_of_offset(UCLASS_TEST, 1001,
+							     &found));
+	ut_asserteq(-ENODEV, uclass_find_device_by_of_offset(UCLASS_TEST, -1,
+							     &found));
+
+	ut_assertok(device_unbind(dev[0]));
+	ut_assertok(uclass_find_device_by_of_offset(UCLASS_TEST, 1000, &found));
+	ut_asserteq_ptr(dev[5], found);
+	for (i = 1; i < INDEX_DEV_COUNT; i += 2) {
+		ut_assertok(device_unbind(dev[i]));
+		ut_asserteq(-ENODEV, uclass_find_device_by_of_offset(UCLASS_TEST,
+				1000 + i * 16, &found));
+	}
+	for (i = 2; i < INDEX_DEV_COUNT; i += 2) {
+		ut_assertok(uclass_find_device_by_of_offset(UCLASS_TEST,
+				1000 + i * 16, &found));
+		ut_asserteq_ptr(dev[i], found);
+	}
+
+	/* Sequence numbers are indexed while a device is probed */
+	for (i = 2; i < INDEX_DEV_COUNT; i += 2) {
+		ut_assertok(device_probe(dev[i]));
+		ut_assertok(uclass_find_device_by_seq(UCLASS_TEST, dev[i]->seq,
+						      false, &found));
+		ut_asserteq_ptr(dev[i], found);
+	}
+	seq = dev[4]->seq;
+	ut_assertok(device_remove(dev[4], DM_REMOVE_NORMAL));
+	ut_asserteq(-ENODEV, uclass_find_device_by_seq(UCLASS_TEST, seq, false,
+						       &found));
+	ut_assertok(device_probe(dev[4]));
+	ut_asserteq(seq, dev[4]->seq);
+	ut_asserteq(-ENODEV, uclass_find_device_by_seq(UCLASS_TEST, DM_MAX_SEQ,
+						       false, &found));
+
+	start = timer_get_us();
+	for (i = 0; i < 1000; i++)
+		uclass_find_device_by_seq(UCLASS_TEST, i % 32, false, &found);
+	index_us = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < 1000; i++) {
+		list_for_each_entry(found, &uc->dev_head, uclass_node) {
+			if (found->seq == i % 32)
+				break;
+		}
+	}
+	linear_us = timer_get_us() - start;
+	printf("%d devices: linear search %lu us, lookup %lu us\n",
+	       INDEX_DEV_COUNT / 2, linear_us, index_us);
+
+	return 0;
+}
+DM_TEST(dm_test_uclass_index, 0);
@@ -16,6 +16,7 @@
 #include <dm/device-internal.h>
 #include <dm/uclass-internal.h>
 #include <asm/eth.h>
+#include <asm/test.h>
 #include <test/ut.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -259,3 +260,132 @@ static int dm_test_net_retry(struct unit_test_state *uts)
 	return retval;
 }
 DM_TEST(dm_test_net_retry, DM_TESTF_SCAN_FDT);
+
+static int eth_test_arps;
+static struct in_addr eth_test_arp_ip;
+
+/* Count the ARP requests, and let the usual replies through */
+static int eth_test_count_arp(struct udevice *dev, void *packet,
+			      unsigned int len)
+{
+	struct ethernet_hdr *eth = packet;
+	struct arp_hdr *arp = packet + ETHER_HDR_SIZE;
+
+	if (ntohs(eth->et_protlen) == PROT_ARP) {
+		eth_test_arps++;
+		eth_test_arp_ip = net_read_ip(&arp->ar_tpa);
+	}
+
+	return -ENOENT;
+}
+
+/* The asserts include a return on fail; cleanup in the caller */
+static int _dm_test_eth_arp_cache(struct unit_test_state *uts)
+{
+	/* Let whatever earlier tests learnt grow old */
+	sandbox_timer_add_offset(60001);
+
+	/* The server's address is asked for once, not for each command */
+	setenv("ethact", "eth@10002000");
+	ut_assertok(net_loop(PING));
+	ut_assertok(net_loop(PING));
+	ut_asserteq(1, eth_test_arps);
+
+	/* It is asked for again on another link */
+	setenv("ethact", "eth@10003000");
+	ut_assertok(net_loop(PING));
+	ut_asserteq(2, eth_test_arps);
+
+	/* And again once it is old */
+	setenv("ethact", "eth@10002000");
+	sandbox_timer_add_offset(60001);
+	ut_assertok(net_loop(PING));
+	ut_asserteq(3, eth_test_arps);
+
+	/* Hosts behind the gateway all share its address */
+	net_netmask = string_to_ip("255.255.255.0");
+	net_gateway = string_to_ip("1.2.3.254");
+	ut_assertok(net_loop(PING));
+	ut_asserteq(4, eth_test_arps);
+	ut_asserteq(string_to_ip("1.2.3.254").s_addr, eth_test_arp_ip.s_addr);
+	net_ping_ip = string_to_ip("1.1.2.3");
+	ut_assertok(net_loop(PING));
+	ut_asserteq(4, eth_test_arps);
+
+	return 0;
+}
+
+static int dm_test_eth_arp_cache(struct unit_test_state *uts)
+{
+	int retval;
+
+	net_ping_ip = string_to_ip("1.1.2.2");
+	eth_test_arps = 0;
+	sandbox_eth_set_tx_handler(0, eth_test_count_arp);
+	sandbox_eth_set_tx_handler(5, eth_test_count_arp);
+
+	retval = _dm_test_eth_arp_cache(uts);
+
+	/* Restore the env */
+	sandbox_eth_set_tx_handler(0, NULL);
+	sandbox_eth_set_tx_handler(5, NULL);
+	net_netmask.s_addr = 0;
+	net_gateway.s_addr = 0;
+	setenv("ethact", NULL);
+
+	return retval;
+}
+DM_TEST(dm_test_eth_arp_cache, DM_TESTF_SCAN_FDT);
+
+#define ETH_TEST_BURST		20
+
+/* Send a burst of packets back with the reply to a ping */
+static int eth_test_burst(struct udevice *dev, void *packet,
+			  unsigned int len)
+{
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	int i;
+
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_ICMP)
+		return -ENOENT;
+
+	/* Packets for another host, which are dropped once processed */
+	for (i = 0; i < ETH_TEST_BURST; i++)
+		sandbox_eth_recv_packet(dev, packet, len);
+
+	return -ENOENT;
+}
+
+static int dm_test_eth_stats(struct unit_test_state *uts)
+{
+	struct eth_stats *stats, before;
+	struct udevice *dev;
+	int ret;
+
+	ut_assertok(uclass_get_device_by_name(UCLASS_ETH, "eth@10002000",
+					      &dev));
+	stats = eth_get_stats(dev);
+	before = *stats;
+
+	net_ping_ip = string_to_ip("1.1.2.2");
+	setenv("ethact", "eth@10002000");
+	sandbox_eth_set_tx_handler(0, eth_test_burst);
+	ret = net_loop(PING);
+	sandbox_eth_set_tx_handler(0, NULL);
+	setenv("ethact", NULL);
+	ut_assertok(ret);
+
+	/* The burst and the reply are more than the queue takes at once */
+	ut_assert(stats->tx_packets > before.tx_packets);
+	ut_assert(stats->rx_packets >= before.rx_packets + ETH_TEST_BURST + 1);
+	ut_asserteq(CONFIG_NET_RX_QUEUE_SIZE, stats->rx_queue_max);
+	ut_assert(stats->rx_full > before.rx_full);
+	ut_asserteq(before.rx_dropped, stats->rx_dropped);
+	ut_asserteq(before.rx_errors, stats->rx_errors);
+
+	ut_assertok(run_command("net stats", 0));
+
+	return 0;
+}
+DM_TEST(dm_test_eth_stats, DM_TESTF_SCAN_FDT);
@@ -0,0 +1,114 @@
+/*
+ * Tests for binding device tree nodes on demand
+ *
+ * Copyright (C) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <fdtdec.h>
+#include <i2c.h>
+#include <asm/clk.h>
+#include <dm/device-internal.h>
+#include <dm/root.h>
+#include <dm/test.h>
+#include <dm/uclass-internal.h>
+#include <dm/util.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Count the devices of a uclass without binding any waiting nodes */
+static int lazy_count(enum uclass_id id)
+{
+	struct uclass *uc = uclass_find(id);
+
+	return uc ? list_count_items(&uc->dev_head) : 0;
+}
+
+/* Check that nodes are bound when they are looked up, and not before */
+static int dm_test_lazy_bind(struct unit_test_state *uts)
+{
+	const void *blob = gd->fdt_blob;
+	struct udevice *dev;
+	int pending, count;
+
+	ut_assertok(dm_lazy_init());
+	ut_assertok(dm_scan_fdt(blob, false));
+	pending = dm_lazy_pending();
+	ut_assert(pending > 0);
+	ut_asserteq(0, lazy_count(UCLASS_TEST_FDT));
+	ut_asserteq(0, lazy_count(UCLASS_MISC));
+	ut_asserteq(0, lazy_count(UCLASS_CLK));
+
+	/*
+	 * Looking up a node by offset binds it. Probing it looks up its
+	 * uclass, which binds the rest of the uclass's nodes.
+	 */
+	ut_assertok(device_get_global_by_of_offset(
+			fdt_path_offset(blob, "/b-test"), &dev));
+	ut_asserteq_str("b-test", dev->name);
+	ut_asserteq_ptr(dm_root(), dev->parent);
+	count = lazy_count(UCLASS_TEST_FDT);
+	ut_assert(count > 1);
+	ut_asserteq(pending - count, dm_lazy_pending());
+	ut_asserteq(0, lazy_count(UCLASS_CLK));
+
+	/* Resolving a phandle binds the uclass that it refers to */
+	ut_assertok(uclass_get_device_by_name(UCLASS_MISC, "clk-test", &dev));
+	ut_asserteq(0, lazy_count(UCLASS_CLK));
+	ut_assertok(sandbox_clk_test_get(dev));
+	ut_assert(lazy_count(UCLASS_CLK) >= 2);
+
+	return 0;
+}
+DM_TEST(dm_test_lazy_bind, 0);
+
+/* Check that waiting nodes are forgotten when their parent is unbound */
+static int dm_test_lazy_unbind(struct unit_test_state *uts)
+{
+	struct udevice *bus, *dev;
+	int pending;
+
+	ut_assertok(dm_lazy_init());
+	ut_assertok(dm_scan_fdt(gd->fdt_blob, false));
+
+	/* Probing the bus scans its three children */
+	pending = dm_lazy_pending();
+	ut_assertok(uclass_get_device(UCLASS_TEST_BUS, 0, &bus));
+	ut_asserteq(pending - 1 + 3, dm_lazy_pending());
+	ut_assertok(device_remove(bus, DM_REMOVE_NORMAL));
+	ut_assertok(device_unbind(bus));
+	ut_asserteq(pending - 1, dm_lazy_pending());
+
+	for (uclass_find_first_device(UCLASS_TEST_FDT, &dev); dev;
+	     uclass_find_next_device(&dev))
+		ut_assert(strncmp(dev->name, "c-test", 6));
+
+	return 0;
+}
+DM_TEST(dm_test_lazy_unbind, 0);
+
+/* Check that looking up the children of a bus binds its waiting nodes */
+static int dm_test_lazy_children(struct unit_test_state *uts)
+{
+	struct udevice *bus, *dev;
+	int pending;
+
+	ut_assertok(dm_lazy_init());
+	ut_assertok(dm_scan_fdt(gd->fdt_blob, false));
+
+	/* A bus looks for its chips among its children */
+	ut_assertok(uclass_get_device_by_seq(UCLASS_I2C, 0, &bus));
+	ut_asserteq(0, lazy_count(UCLASS_I2C_EEPROM));
+	pending = dm_lazy_pending();
+	ut_assertok(i2c_get_chip(bus, 0x2c, 1, &dev));
+	ut_asserteq_str("eeprom@2c", dev->name);
+	ut_asserteq(UCLASS_I2C_EEPROM, device_get_uclass_id(dev));
+	ut_assert(dm_lazy_pending() < pending);
+
+	return 0;
+}
+DM_TEST(dm_test_lazy_children, 0);
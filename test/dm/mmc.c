@@ -44,3 +44,31 @@ static int dm_test_mmc_blk(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_mmc_blk, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#ifdef CONFIG_BLOCK_READAHEAD
+/* Test that sequential reads are read ahead through send_cmd_start() */
+static int dm_test_mmc_readahead(struct unit_test_state *uts)
+{
+	struct block_readahead_stats stats;
+	struct blk_desc *dev_desc;
+	char buf[1024];
+	lbaint_t blk;
+
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+	ut_assert(dev_desc->lba >= 8);
+	/* Drop what was read when the partition table was scanned */
+	blkcache_invalidate(dev_desc->if_type, dev_desc->devnum);
+	blkreadahead_invalidate(dev_desc);
+	blkreadahead_stats(&stats);
+
+	for (blk = 0; blk < 8; blk += 2)
+		ut_asserteq(2, blk_dread(dev_desc, blk, 2, buf));
+	blkreadahead_stats(&stats);
+	ut_asserteq(3, stats.hits);
+	ut_asserteq(1, stats.misses);
+	ut_asserteq(1, stats.windows);
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_readahead, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
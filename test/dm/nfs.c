@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <net.h>
+#include <dm/test.h>
+#include <asm/test.h>
+#include <test/net.h>
+#include <test/ut.h>
+
+#define NFS_TEST_PORT		2049
+/* Round trip time to the server, added to the timer for each batch */
+#define NFS_TEST_RTT_MS		2
+
+#define RPC_REPLY		1
+#define PORTMAP_PORT		111
+#define PROG_PORTMAP		100000
+#define PROG_NFS		100003
+#define PROG_MOUNT		100005
+#define PORTMAP_GETPORT		3
+#define MOUNT_UMOUNTALL		4
+#define NFS_LOOKUP		4
+#define NFS_READ		6
+#define NFS_FHSIZE		32
+#define NFS_FATTR_WORDS		17
+
+/**
+ * struct nfs_test_read - A READ request held by the server
+ *
+ * @id: RPC id of the request
+ * @offset: Offset asked for
+ * @count: Number of bytes asked for
+ */
+struct nfs_test_read {
+	u32 id;
+	int offset;
+	int count;
+};
+
+/**
+ * struct nfs_test_server - State of the fake NFSv2 server
+ *
+ * It serves the test file as test.bin, over UDP. The
+ * READ requests are held until @hold of them are pending, or one reaches the
+ * end of the file, and are then answered last first, so that the client
+ * gets its replies out of order and their fragments interleaved.
+ *
+ * @hold: Number of READs to hold before answering them
+ * @stall: READ from which to answer nothing, counting from 1, or 0 for none
+ * @stalled: Last RPC id received since the stall, or 0 if none; the first
+ *	request sent again ends the stall
+ * @held: Number of READs held
+ * @reads: Number of READs received
+ * @batches: Number of times the held READs were answered
+ * @max_count: Largest READ asked for
+ * @max_outstanding: Most READs held at once
+ * @pending: READs held
+ */
+struct nfs_test_server {
+	int hold;
+	int stall;
+	u32 stalled;
+	int held;
+	int reads;
+	int batches;
+	int max_count;
+	int max_outstanding;
+	struct nfs_test_read pending[16];
+};
+
+static struct nfs_test_server nfs_server;
+/* Queue an accepted RPC reply to @id, with @words of result from @res */
+static int nfs_test_rpc_queue(void *request, u32 id, __be32 *res, int words)
+{
+	static __be32 reply[NET_TEST_MAX_UDP / 4];
+	struct ip_udp_hdr *req_ip = request + ETHER_HDR_SIZE;
+
+	reply[0] = htonl(id);
+	reply[1] = htonl(RPC_REPLY);
+	reply[2] = 0;		/* accepted */
+	reply[3] = 0;		/* verifier flavor */
+	reply[4] = 0;		/* verifier length */
+	reply[5] = 0;		/* success */
+	memcpy(reply + 6, res, words * 4);
+
+	return net_test_udp_queue(request, ntohs(req_ip->udp_dst), reply,
+				  (6 + words) * 4);
+}
+
+static int nfs_test_rpc_reply(struct udevice *dev, void *request, u32 id,
+			      __be32 *res, int words)
+{
+	int ret;
+
+	ret = nfs_test_rpc_queue(request, id, res, words);
+	if (ret)
+		return ret;
+
+	return net_test_udp_flush(dev);
+}
+
+static int nfs_test_read_queue(void *request, struct nfs_test_read *rd)
+{
+	static __be32 res[NET_TEST_MAX_UDP / 4];
+	u8 *data = (u8 *)(res + 2 + NFS_FATTR_WORDS);
+	int count, i;
+
+	count = max(0, min(rd->count, NET_TEST_SIZE - rd->offset));
+	memset(res, '\0', (2 + NFS_FATTR_WORDS) * 4);
+	res[1 + NFS_FATTR_WORDS] = htonl(count);
+	for (i = 0; i < count; i++)
+		data[i] = net_test_byte(rd->offset + i);
+	for (; i % 4; i++)
+		data[i] = 0;
+
+	return nfs_test_rpc_queue(request, rd->id, res,
+				  2 + NFS_FATTR_WORDS + i / 4);
+}
+
+/* Answer the held READs, last first */
+static int nfs_test_flush(struct udevice *dev, void *request)
+{
+	struct nfs_test_server *srv = &nfs_server;
+	int ret;
+
+	srv->batches++;
+	sandbox_timer_add_offset(NFS_TEST_RTT_MS);
+	while (srv->held) {
+		srv->held--;
+		ret = nfs_test_read_queue(request, &srv->pending[srv->held]);
+		if (ret)
+			return ret;
+	}
+
+	return net_test_udp_flush(dev);
+}
+
+static int nfs_test_read(struct udevice *dev, void *request, u32 id,
+			 __be32 *args)
+{
+	struct nfs_test_server *srv = &nfs_server;
+	struct nfs_test_read *rd;
+
+	srv->reads++;
+	if (srv->reads == srv->stall) {
+		/* Answer nothing until the client times out */
+		srv->stall = 0;
+		srv->stalled = id;
+		sandbox_timer_add_offset(2001);
+		return 0;
+	}
+	if (srv->stalled && id > srv->stalled) {
+		srv->stalled = id;
+		return 0;
+	}
+	srv->stalled = 0;
+
+	rd = &srv->pending[srv->held++];
+	rd->id = id;
+	rd->offset = ntohl(args[NFS_FHSIZE / 4]);
+	rd->count = ntohl(args[NFS_FHSIZE / 4 + 1]);
+	srv->max_count = max(srv->max_count, rd->count);
+	srv->max_outstanding = max(srv->max_outstanding, srv->held);
+	if (srv->held >= srv->hold || rd->offset + rd->count >= NET_TEST_SIZE)
+		return nfs_test_flush(dev, request);
+
+	return 0;
+}
+
+static int nfs_test_tx(struct udevice *dev, void *packet, unsigned int len)
+{
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	__be32 *call = (__be32 *)(ip + 1);
+	__be32 *args, res[1 + NFS_FHSIZE / 4 + NFS_FATTR_WORDS];
+	u32 id, prog, proc;
+
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_UDP)
+		return -ENOENT;
+
+	id = ntohl(call[0]);
+	prog = ntohl(call[3]);
+	proc = ntohl(call[5]);
+	/* Skip the credentials and the verifier */
+	args = call + 6;
+	args += 2 + ntohl(args[1]) / 4;
+	args += 2 + ntohl(args[1]) / 4;
+
+	memset(res, '\0', sizeof(res));
+	switch (prog) {
+	case PROG_PORTMAP:
+		if (ntohs(ip->udp_dst) != PORTMAP_PORT ||
+		    proc != PORTMAP_GETPORT)
+			return 0;
+		res[0] = htonl(NFS_TEST_PORT);
+		return nfs_test_rpc_reply(dev, packet, id, res, 1);
+	case PROG_MOUNT:
+		if (proc == MOUNT_UMOUNTALL)
+			return nfs_test_rpc_reply(dev, packet, id, res, 0);
+		/* Status and the directory's handle */
+		return nfs_test_rpc_reply(dev, packet, id, res,
+					  1 + NFS_FHSIZE / 4);
+	case PROG_NFS:
+		if (proc == NFS_LOOKUP) {
+			/* Status, the file's handle and its attributes */
+			return nfs_test_rpc_reply(dev, packet, id, res,
+						  ARRAY_SIZE(res));
+		}
+		if (proc == NFS_READ)
+			return nfs_test_read(dev, packet, id, args);
+		break;
+	}
+
+	return 0;
+}
+
+/* Fetch the test file and check that it arrived intact */
+static int nfs_test_get(struct unit_test_state *uts, ulong *msecs)
+{
+	struct nfs_test_server *srv = &nfs_server;
+
+	srv->held = 0;
+	srv->reads = 0;
+	srv->batches = 0;
+	srv->max_count = 0;
+	srv->max_outstanding = 0;
+
+	return net_test_get(uts, NFS, "/export/test.bin", msecs);
+}
+
+static int nfs_test_windows(struct unit_test_state *uts)
+{
+	struct nfs_test_server *srv = &nfs_server;
+	ulong lockstep_ms, window_ms;
+	int reads;
+
+	/* One READ at a time, of 8 KiB as the replies can be defragmented */
+	setenv("nfswindowsize", "1");
+	srv->hold = 1;
+	ut_assertok(nfs_test_get(uts, &lockstep_ms));
+	ut_asserteq(8192, srv->max_count);
+	ut_asserteq(1, srv->max_outstanding);
+	reads = srv->reads;
+	ut_asserteq(DIV_ROUND_UP(NET_TEST_SIZE, 8192) + 1, reads);
+
+	/* Four READs outstanding take a quarter of the round trips */
+	setenv("nfswindowsize", "4");
+	srv->hold = 4;
+	ut_assertok(nfs_test_get(uts, &window_ms));
+	ut_asserteq(4, srv->max_outstanding);
+	/* Up to three READs go past the end before the client sees it */
+	ut_assert(srv->reads <= reads + 3);
+	ut_assert(srv->batches * 3 < reads);
+	printf("%d bytes, %d ms per round trip: %lu ms, window 4: %lu ms\n",
+	       NET_TEST_SIZE, NFS_TEST_RTT_MS, lockstep_ms, window_ms);
+	ut_assert(window_ms * 2 < lockstep_ms);
+
+	/*
+	 * After a timeout the client sends the READs still outstanding
+	 * again, and carries on
+	 */
+	srv->hold = 1;
+	srv->stall = 50;
+	ut_assertok(nfs_test_get(uts, &window_ms));
+	ut_asserteq(0, srv->stall);
+	ut_assert(srv->reads > reads);
+
+	return 0;
+}
+
+static int dm_test_net_nfs_window(struct unit_test_state *uts)
+{
+	static const char *const env[] = { "nfswindowsize", NULL };
+
+	memset(&nfs_server, '\0', sizeof(nfs_server));
+
+	return net_test_run(uts, nfs_test_tx, env, nfs_test_windows);
+}
+DM_TEST(dm_test_net_nfs_window, DM_TESTF_SCAN_FDT);
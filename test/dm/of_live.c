@@ -0,0 +1,262 @@
+/*
+ * Tests for the live device tree
+ *
+ * Copyright (C) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <fdtdec.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <of_live.h>
+#include <dm/read.h>
+#include <dm/root.h>
+#include <dm/test.h>
+#include <dm/uclass-internal.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define TEST_BLOB_SIZE		(128 << 10)
+#define TEST_NODE_COUNT		200
+#define TEST_CLOCK_PHANDLE	1
+
+/* Build a tree of test devices, each with a few properties and a subnode */
+static int of_live_test_blob(void *blob)
+{
+	fdt32_t cell[2];
+	char name[20];
+	int ret, i;
+
+	ret = fdt_create(blob, TEST_BLOB_SIZE);
+	ret |= fdt_finish_reservemap(blob);
+	ret |= fdt_begin_node(blob, "");
+	ret |= fdt_property_u32(blob, "#address-cells", 1);
+	ret |= fdt_property_u32(blob, "#size-cells", 1);
+	ret |= fdt_property_string(blob, "model", "of_live test");
+
+	ret |= fdt_begin_node(blob, "clock");
+	ret |= fdt_property_u32(blob, "#clock-cells", 1);
+	ret |= fdt_property_u32(blob, "phandle", TEST_CLOCK_PHANDLE);
+	ret |= fdt_end_node(blob);
+
+	for (i = 0; i < TEST_NODE_COUNT; i++) {
+		snprintf(name, sizeof(name), "test@%x", i * 0x100);
+		ret |= fdt_begin_node(blob, name);
+		ret |= fdt_property_string(blob, "compatible",
+					   "denx,u-boot-fdt-test");
+		cell[0] = cpu_to_fdt32(i * 0x100);
+		cell[1] = cpu_to_fdt32(0x100);
+		ret |= fdt_property(blob, "reg", cell, sizeof(cell));
+		ret |= fdt_property_u32(blob, "ping-add", i);
+		ret |= fdt_property_u32(blob, "ping-expect", i);
+		cell[0] = cpu_to_fdt32(TEST_CLOCK_PHANDLE);
+		cell[1] = cpu_to_fdt32(i);
+		ret |= fdt_property(blob, "clocks", cell, sizeof(cell));
+		ret |= fdt_property_string(blob, "status", "okay");
+		ret |= fdt_property_u32(blob, "phandle", i + 2);
+		ret |= fdt_begin_node(blob, "port");
+		ret |= fdt_property_u32(blob, "remote", i + 2);
+		ret |= fdt_end_node(blob);
+		ret |= fdt_end_node(blob);
+	}
+	ret |= fdt_end_node(blob);
+	ret |= fdt_finish(blob);
+
+	return ret ? -EINVAL : 0;
+}
+
+/* Check that the live tree gives the same answers as libfdt */
+static int dm_test_of_live(struct unit_test_state *uts)
+{
+	static const char *const paths[] = {
+		"/", "/clock", "/test", "/test@100", "//test@c700/port",
+		"/test@100/port/", "/test@1", "/aliases", "/clock/port",
+	};
+	struct of_live *tree, *old_tree = gd->of_live;
+	const void *value, *expect;
+	int node, prop, len, expect_len, count = 0, i;
+	const char *name;
+	uint32_t phandle;
+	void *blob;
+
+	blob = malloc(TEST_BLOB_SIZE);
+	ut_assertnonnull(blob);
+	ut_assertok(of_live_test_blob(blob));
+	ut_assertok(of_live_build(blob, &tree));
+	gd->of_live = tree;
+
+	for (node = 0; node >= 0; node = fdt_next_node(blob, node, NULL)) {
+		ut_assertnonnull(of_live_find_node(tree, node));
+		ut_asserteq_str(fdt_get_name(blob, node, NULL),
+				of_live_find_node(tree, node)->name);
+		ut_asserteq(node ? fdt_parent_offset(blob, node) :
+			    -FDT_ERR_NOTFOUND,
+			    of_live_parent_offset(blob, node));
+		ut_asserteq(fdt_first_subnode(blob, node),
+			    of_live_first_subnode(blob, node));
+		if (node)
+			ut_asserteq(fdt_next_subnode(blob, node),
+				    of_live_next_subnode(blob, node));
+
+		fdt_for_each_property_offset(prop, blob, node) {
+			fdt_getprop_by_offset(blob, prop, &name, NULL);
+			expect = fdt_getprop(blob, node, name, &expect_len);
+			value = of_live_getprop(blob, node, name, &len);
+			ut_asserteq_ptr(expect, value);
+			ut_asserteq(expect_len, len);
+		}
+		ut_asserteq_ptr(NULL, of_live_getprop(blob, node,
+						      "no-such-prop", &len));
+		ut_asserteq(-FDT_ERR_NOTFOUND, len);
+
+		phandle = fdt_get_phandle(blob, node);
+		if (phandle) {
+			ut_asserteq(node, of_live_node_by_phandle(blob,
+								  phandle));
+			count++;
+		}
+	}
+	ut_asserteq(TEST_NODE_COUNT + 1, count);
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    of_live_node_by_phandle(blob, TEST_NODE_COUNT + 2));
+	ut_asserteq_ptr(NULL, of_live_find_node(tree, 1));
+
+	for (i = 0; i < ARRAY_SIZE(paths); i++)
+		ut_asserteq(fdt_path_offset(blob, paths[i]),
+			    of_live_path_offset(blob, paths[i]));
+
+	gd->of_live = old_tree;
+	of_live_free(tree);
+	free(blob);
+
+	return 0;
+}
+DM_TEST(dm_test_of_live, 0);
+
+/* Test that the live tree follows changes to the control FDT */
+static int dm_test_of_live_sync(struct unit_test_state *uts)
+{
+	struct fdt_header *old_working = working_fdt;
+	const void *old_blob = gd->fdt_blob;
+	struct of_live *tree;
+	char cmd[40];
+	void *blob;
+	int node;
+
+	blob = malloc(TEST_BLOB_SIZE);
+	ut_assertnonnull(blob);
+	ut_assertok(of_live_test_blob(blob));
+	ut_assertok(fdt_open_into(blob, blob, TEST_BLOB_SIZE));
+
+	/* Moving the control FDT rebuilds the tree */
+	snprintf(cmd, sizeof(cmd), "fdt addr -c %lx",
+		 (ulong)map_to_sysmem(blob));
+	ut_assertok(run_command(cmd, 0));
+	ut_asserteq_ptr(blob, gd->fdt_blob);
+	tree = gd->of_live;
+	ut_assertnonnull(tree);
+	ut_asserteq_ptr(blob, tree->blob);
+
+	/* A tree which does not match the blob's header is not used */
+	node = fdt_path_offset(blob, "/test@c700");
+	ut_assertok(fdt_setprop_string(blob, 0, "model",
+				       "of_live test, longer"));
+	ut_asserteq(node + 8, fdt_path_offset(blob, "/test@c700"));
+	ut_asserteq_str("of_live test, longer",
+			of_live_getprop(blob, 0, "model", NULL));
+	ut_asserteq(node + 8, of_live_path_offset(blob, "/test@c700"));
+	ut_asserteq(0, of_live_parent_offset(blob, node + 8));
+
+	/* Changing it with the fdt command rebuilds the tree */
+	snprintf(cmd, sizeof(cmd), "fdt addr %lx", (ulong)map_to_sysmem(blob));
+	ut_assertok(run_command(cmd, 0));
+	ut_assertok(run_command("fdt set / model \"of_live\"", 0));
+	ut_assertnonnull(gd->of_live);
+	ut_assertok(memcmp(&gd->of_live->hdr, blob, sizeof(struct fdt_header)));
+	ut_asserteq_str("of_live", of_live_getprop(blob, 0, "model", NULL));
+	node = fdt_path_offset(blob, "/test@c700");
+	ut_asserteq(node, of_live_path_offset(blob, "/test@c700"));
+	ut_asserteq_ptr(fdt_getprop(blob, node, "status", NULL),
+			of_live_getprop(blob, node, "status", NULL));
+
+	snprintf(cmd, sizeof(cmd), "fdt addr -c %lx",
+		 (ulong)map_to_sysmem(old_blob));
+	ut_assertok(run_command(cmd, 0));
+	ut_asserteq_ptr(old_blob, gd->fdt_blob);
+	ut_asserteq_ptr(old_blob, gd->of_live->blob);
+	working_fdt = old_working;
+	free(blob);
+
+	return 0;
+}
+DM_TEST(dm_test_of_live_sync, 0);
+
+/* Bind, probe and read the test devices, returning the time taken */
+static int of_live_scan(struct unit_test_state *uts, const void *blob,
+			ulong *usp)
+{
+	struct udevice *dev;
+	struct uclass *uc;
+	ulong start;
+	int count = 0;
+
+	start = timer_get_us();
+	ut_assertok(dm_scan_fdt(blob, false));
+	for (uclass_first_device(UCLASS_TEST_FDT, &dev); dev;
+	     uclass_next_device(&dev)) {
+		ut_asserteq(TEST_CLOCK_PHANDLE,
+			    fdt_get_phandle(blob, dev_read_phandle(dev,
+								    "clocks")));
+		ut_asserteq(dev->seq + 2,
+			    fdt_get_phandle(blob, dev_of_offset(dev)));
+		ut_asserteq(dev->seq * 0x100, dev_get_addr(dev));
+		ut_assert(dev_read_enabled(dev));
+		ut_assert(dev_read_first_subnode(dev) > 0);
+		count++;
+	}
+	*usp = timer_get_us() - start;
+	ut_asserteq(TEST_NODE_COUNT, count);
+
+	ut_assertok(uclass_get(UCLASS_TEST_FDT, &uc));
+	ut_assertok(uclass_destroy(uc));
+
+	return 0;
+}
+
+/* Compare driver model start-up with and without the live tree */
+static int dm_test_of_live_bench(struct unit_test_state *uts)
+{
+	struct of_live *tree, *old_tree = gd->of_live;
+	const void *old_blob = gd->fdt_blob;
+	ulong flat_us, live_us, build_us;
+	void *blob;
+
+	blob = malloc(TEST_BLOB_SIZE);
+	ut_assertnonnull(blob);
+	ut_assertok(of_live_test_blob(blob));
+	gd->fdt_blob = blob;
+
+	gd->of_live = NULL;
+	ut_assertok(of_live_scan(uts, blob, &flat_us));
+
+	build_us = timer_get_us();
+	ut_assertok(of_live_build(blob, &tree));
+	build_us = timer_get_us() - build_us;
+	gd->of_live = tree;
+	ut_assertok(of_live_scan(uts, blob, &live_us));
+
+	printf("%d devices: flat tree %lu us, live tree %lu us (built in %lu us)\n",
+	       TEST_NODE_COUNT, flat_us, live_us, build_us);
+
+	gd->of_live = old_tree;
+	gd->fdt_blob = old_blob;
+	of_live_free(tree);
+	free(blob);
+
+	return 0;
+}
+DM_TEST(dm_test_of_live_bench, 0);
@@ -10,6 +10,7 @@
 #include <fdtdec.h>
 #include <malloc.h>
 #include <asm/io.h>
+#include <dm/read.h>
 #include <dm/test.h>
 #include <dm/root.h>
 #include <dm/uclass-internal.h>
@@ -37,8 +38,7 @@ static int testfdt_ofdata_to_platdata(struct udevice *dev)
 {
 	struct dm_test_pdata *pdata = dev_get_platdata(dev);
 
-	pdata->ping_add = fdtdec_get_int(gd->fdt_blob, dev_of_offset(dev),
-					"ping-add", -1);
+	pdata->ping_add = dev_read_u32_default(dev, "ping-add", -1);
 	pdata->base = fdtdec_get_addr(gd->fdt_blob, dev_of_offset(dev),
 				      "ping-expect");
 
@@ -0,0 +1,202 @@
+/*
+ * Fake servers for the network protocol tests
+ *
+ * Copyright (c) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <net.h>
+#include <asm/eth.h>
+#include <test/net.h>
+#include <test/ut.h>
+
+u8 net_test_byte(int offset)
+{
+	return offset ^ (offset >> 9);
+}
+
+void net_test_ip_hdr(void *buf, void *request, int proto, int len)
+{
+	struct ethernet_hdr *req_eth = request;
+	struct ip_hdr *req_ip = request + ETHER_HDR_SIZE;
+	struct ethernet_hdr *eth = buf;
+	struct ip_hdr *ip = buf + ETHER_HDR_SIZE;
+
+	memcpy(eth->et_dest, req_eth->et_src, ARP_HLEN);
+	memcpy(eth->et_src, req_eth->et_dest, ARP_HLEN);
+	eth->et_protlen = htons(PROT_IP);
+
+	net_set_ip_header((uchar *)ip, net_read_ip(&req_ip->ip_src),
+			  net_read_ip(&req_ip->ip_dst));
+	ip->ip_len = htons(IP_HDR_SIZE + len);
+	ip->ip_p = proto;
+	ip->ip_sum = 0;
+	ip->ip_sum = compute_ip_checksum(ip, IP_HDR_SIZE);
+}
+
+/**
+ * struct net_test_dgram - A UDP datagram waiting to be sent to the client
+ *
+ * @request: Headers of the packet it answers
+ * @id: IP id of its fragments
+ * @len: Length of the datagram, with its UDP header
+ * @pos: Bytes sent so far
+ * @udp: The datagram
+ */
+struct net_test_dgram {
+	uchar request[ETHER_HDR_SIZE + IP_UDP_HDR_SIZE];
+	u16 id;
+	int len;
+	int pos;
+	u8 udp[UDP_HDR_SIZE + NET_TEST_MAX_UDP];
+};
+
+static struct net_test_dgram net_test_dgrams[NET_TEST_MAX_DGRAMS];
+static int net_test_queued;
+static u16 net_test_ip_id;
+
+int net_test_udp_queue(void *request, int port, const void *data, int len)
+{
+	struct ip_udp_hdr *req_ip = request + ETHER_HDR_SIZE;
+	struct net_test_dgram *dg;
+	__be16 *udp;
+
+	if (net_test_queued == NET_TEST_MAX_DGRAMS)
+		return -ENOSPC;
+	if (len > NET_TEST_MAX_UDP)
+		return -E2BIG;
+
+	dg = &net_test_dgrams[net_test_queued++];
+	memcpy(dg->request, request, sizeof(dg->request));
+	/* Every fragment of the datagram has the same id */
+	dg->id = htons(++net_test_ip_id);
+	dg->len = UDP_HDR_SIZE + len;
+	dg->pos = 0;
+	udp = (__be16 *)dg->udp;
+	udp[0] = htons(port);
+	udp[1] = req_ip->udp_src;
+	udp[2] = htons(dg->len);
+	udp[3] = 0;		/* no checksum */
+	memcpy(dg->udp + UDP_HDR_SIZE, data, len);
+
+	return 0;
+}
+
+/* Send the next fragment of @dg, or all of it if it fits in a frame */
+static int net_test_udp_frag(struct udevice *dev, struct net_test_dgram *dg)
+{
+	uchar buf[PKTSIZE_ALIGN];
+	struct ip_hdr *ip = (void *)buf + ETHER_HDR_SIZE;
+	int frag;
+
+	frag = dg->len - dg->pos;
+	if (frag > NET_TEST_MTU - IP_HDR_SIZE)
+		frag = (NET_TEST_MTU - IP_HDR_SIZE) & ~7;
+	net_test_ip_hdr(buf, dg->request, IPPROTO_UDP, frag);
+	ip->ip_id = dg->id;
+	ip->ip_off = htons(dg->pos / 8);
+	if (dg->pos + frag < dg->len)
+		ip->ip_off |= htons(IP_FLAGS_MFRAG);
+	ip->ip_sum = 0;
+	ip->ip_sum = compute_ip_checksum(ip, IP_HDR_SIZE);
+	memcpy(ip + 1, dg->udp + dg->pos, frag);
+	dg->pos += frag;
+
+	return sandbox_eth_recv_packet(dev, buf,
+				       ETHER_HDR_SIZE + IP_HDR_SIZE + frag);
+}
+
+int net_test_udp_flush(struct udevice *dev)
+{
+	int sent, ret, i;
+
+	/* One fragment of each datagram in turn */
+	do {
+		sent = 0;
+		for (i = 0; i < net_test_queued; i++) {
+			if (net_test_dgrams[i].pos == net_test_dgrams[i].len)
+				continue;
+			ret = net_test_udp_frag(dev, &net_test_dgrams[i]);
+			if (ret) {
+				net_test_queued = 0;
+				return ret;
+			}
+			sent++;
+		}
+	} while (sent);
+	net_test_queued = 0;
+
+	return 0;
+}
+
+int net_test_udp_reply(struct udevice *dev, void *request, int port,
+		       const void *data, int len)
+{
+	int ret;
+
+	ret = net_test_udp_queue(request, port, data, len);
+	if (ret)
+		return ret;
+
+	return net_test_udp_flush(dev);
+}
+
+int net_test_get(struct unit_test_state *uts, enum proto_t proto,
+		 const char *name, ulong *msecs)
+{
+	u8 *buf;
+	ulong start;
+	int ret, i;
+
+	buf = map_sysmem(NET_TEST_ADDR, NET_TEST_SIZE);
+	memset(buf, '\0', NET_TEST_SIZE);
+
+	load_addr = NET_TEST_ADDR;
+	copy_filename(net_boot_file_name, name, sizeof(net_boot_file_name));
+	start = get_timer(0);
+	ret = net_loop(proto);
+	*msecs = get_timer(start);
+	if (ret < 0)
+		return ret;
+
+	ut_asserteq(NET_TEST_SIZE, ret);
+	for (i = 0; i < NET_TEST_SIZE; i++)
+		ut_asserteq(net_test_byte(i), buf[i]);
+	unmap_sysmem(buf);
+
+	return 0;
+}
+
+int net_test_run(struct unit_test_state *uts, sandbox_eth_tx_hand_f *tx,
+		 const char *const env[],
+		 int (*test)(struct unit_test_state *uts))
+{
+	char *saved[NET_TEST_MAX_ENV];
+	const char *val;
+	int ret, i;
+
+	for (i = 0; env[i]; i++) {
+		ut_assert(i < NET_TEST_MAX_ENV);
+		val = getenv(env[i]);
+		saved[i] = val ? strdup(val) : NULL;
+	}
+	setenv("ethact", "eth@10002000");
+	net_server_ip = string_to_ip("1.1.2.2");
+	sandbox_eth_set_tx_handler(0, tx);
+
+	ret = test(uts);
+
+	sandbox_eth_set_tx_handler(0, NULL);
+	setenv("ethact", NULL);
+	for (i = 0; env[i]; i++) {
+		setenv(env[i], saved[i]);
+		free(saved[i]);
+	}
+
+	return ret;
+}
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <net.h>
+#include <dm/test.h>
+#include <asm/eth.h>
+#include <asm/test.h>
+#include <test/net.h>
+#include <test/ut.h>
+
+#define TFTP_TEST_PORT		1069
+/* Round trip time to the server, added to the timer for each ACK */
+#define TFTP_TEST_RTT_MS	1
+
+#define TFTP_RRQ		1
+#define TFTP_DATA		3
+#define TFTP_ACK		4
+#define TFTP_OACK		6
+
+/**
+ * struct tftp_test_server - State of the fake TFTP server
+ *
+ * It serves the test file, whatever the name asked for, and follows RFC 7440
+ * by sending the window after each block ACKed.
+ *
+ * @blksize: Block size asked for by the client
+ * @windowsize: Window size agreed with the client, 1 if none
+ * @max_window: Largest window size the server agrees to
+ * @last_block: Number of the last block of the file
+ * @acked: Last block ACKed by the client
+ * @drop: Block to leave out once, or 0 for none
+ * @stall: Block after whose ACK to send nothing once, or 0 for none
+ * @acks: Number of ACKs received in this transfer
+ * @sent: Number of DATA packets sent in this transfer
+ */
+struct tftp_test_server {
+	int blksize;
+	int windowsize;
+	int max_window;
+	int last_block;
+	int acked;
+	int drop;
+	int stall;
+	int acks;
+	int sent;
+};
+
+static struct tftp_test_server tftp_server;
+
+static int tftp_test_oack(struct udevice *dev, void *request, char *opt,
+			  char *end)
+{
+	struct tftp_test_server *srv = &tftp_server;
+	char oack[100], *p = oack + 2;
+
+	*(__be16 *)oack = htons(TFTP_OACK);
+	srv->blksize = 512;
+	srv->windowsize = 1;
+	for (; opt < end; opt += strlen(opt) + 1) {
+		if (!strcmp(opt, "blksize")) {
+			opt += strlen(opt) + 1;
+			srv->blksize = simple_strtoul(opt, NULL, 10);
+			p += sprintf(p, "blksize%c%d%c", 0, srv->blksize, 0);
+		} else if (!strcmp(opt, "windowsize") && srv->max_window > 1) {
+			opt += strlen(opt) + 1;
+			srv->windowsize = min((int)simple_strtoul(opt, NULL,
+								  10),
+					      srv->max_window);
+			p += sprintf(p, "windowsize%c%d%c", 0, srv->windowsize,
+				     0);
+		}
+	}
+	srv->last_block = NET_TEST_SIZE / srv->blksize + 1;
+	srv->acked = 0;
+	srv->acks = 0;
+	srv->sent = 0;
+
+	return net_test_udp_reply(dev, request, TFTP_TEST_PORT, oack,
+				  p - oack);
+}
+
+static int tftp_test_window(struct udevice *dev, void *request)
+{
+	struct tftp_test_server *srv = &tftp_server;
+	uchar data[4 + 1468];
+	int block, offset, len, ret;
+
+	for (block = srv->acked + 1;
+	     block <= min(srv->acked + srv->windowsize, srv->last_block);
+	     block++) {
+		if (block == srv->drop) {
+			srv->drop = 0;
+			continue;
+		}
+		offset = (block - 1) * srv->blksize;
+		len = min(srv->blksize, NET_TEST_SIZE - offset);
+		*(__be16 *)data = htons(TFTP_DATA);
+		*(__be16 *)(data + 2) = htons(block);
+		for (ret = 0; ret < len; ret++)
+			data[4 + ret] = net_test_byte(offset + ret);
+		ret = net_test_udp_reply(dev, request, TFTP_TEST_PORT, data,
+					 4 + len);
+		if (ret)
+			return ret;
+		srv->sent++;
+	}
+
+	return 0;
+}
+
+static int tftp_test_tx(struct udevice *dev, void *packet, unsigned int len)
+{
+	struct tftp_test_server *srv = &tftp_server;
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	uchar *pkt = (uchar *)(ip + 1);
+	int block;
+
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_UDP)
+		return -ENOENT;
+
+	switch (ntohs(*(__be16 *)pkt)) {
+	case TFTP_RRQ:
+		/* Skip the file name and mode */
+		pkt += 2;
+		pkt += strlen((char *)pkt) + 1;
+		pkt += strlen((char *)pkt) + 1;
+		return tftp_test_oack(dev, packet, (char *)pkt,
+				      (void *)ip + ntohs(ip->ip_len));
+	case TFTP_ACK:
+		block = ntohs(*(__be16 *)(pkt + 2));
+		srv->acks++;
+		sandbox_timer_add_offset(TFTP_TEST_RTT_MS);
+		srv->acked = block;
+		if (block && block == srv->stall) {
+			/* Send nothing, and let the client time out */
+			srv->stall = 0;
+			sandbox_timer_add_offset(2000);
+			return 0;
+		}
+		return tftp_test_window(dev, packet);
+	}
+
+	return 0;
+}
+
+static int tftp_test_windows(struct unit_test_state *uts)
+{
+	struct tftp_test_server *srv = &tftp_server;
+	ulong lockstep_ms, window_ms;
+	int blocks;
+
+	/* A server which does not know the option sends a block per ACK */
+	setenv("tftptimeout", "1000");
+	setenv("tftpwindowsize", "16");
+	srv->max_window = 1;
+	ut_assertok(net_test_get(uts, TFTPGET, "test.bin", &lockstep_ms));
+	blocks = srv->last_block;
+	ut_asserteq(1, srv->windowsize);
+	ut_asserteq(blocks + 1, srv->acks);
+
+	/* With windows of 16 blocks there are 16 times fewer round trips */
+	srv->max_window = 32;
+	ut_assertok(net_test_get(uts, TFTPGET, "test.bin", &window_ms));
+	ut_asserteq(16, srv->windowsize);
+	ut_asserteq(DIV_ROUND_UP(blocks, 16) + 1, srv->acks);
+	ut_asserteq(blocks, srv->sent);
+	printf("%d bytes, %d ms per round trip: %lu ms, window 16: %lu ms\n",
+	       NET_TEST_SIZE, TFTP_TEST_RTT_MS, lockstep_ms, window_ms);
+	ut_assert(window_ms * 4 < lockstep_ms);
+
+	/*
+	 * After a missing block the client ACKs the block before it, once,
+	 * and ignores the rest of the window
+	 */
+	srv->drop = 100;
+	ut_assertok(net_test_get(uts, TFTPGET, "test.bin", &window_ms));
+	ut_asserteq(DIV_ROUND_UP(blocks, 16) + 2, srv->acks);
+
+	/* So is the first block */
+	srv->drop = 1;
+	ut_assertok(net_test_get(uts, TFTPGET, "test.bin", &window_ms));
+	ut_asserteq(DIV_ROUND_UP(blocks, 16) + 2, srv->acks);
+
+	/* After a timeout the client ACKs again and gets the whole window */
+	srv->stall = 160;
+	ut_assertok(net_test_get(uts, TFTPGET, "test.bin", &window_ms));
+	ut_asserteq(DIV_ROUND_UP(blocks, 16) + 2, srv->acks);
+	ut_asserteq(blocks, srv->sent);
+
+	/* The window size can be limited by the client */
+	setenv("tftpwindowsize", "4");
+	ut_assertok(net_test_get(uts, TFTPGET, "test.bin", &window_ms));
+	ut_asserteq(4, srv->windowsize);
+	ut_asserteq(DIV_ROUND_UP(blocks, 4) + 1, srv->acks);
+
+	return 0;
+}
+
+static int dm_test_net_tftp_window(struct unit_test_state *uts)
+{
+	static const char *const env[] = {
+		"tftpwindowsize", "tftptimeout", NULL
+	};
+
+	memset(&tftp_server, '\0', sizeof(tftp_server));
+
+	return net_test_run(uts, tftp_test_tx, env, tftp_test_windows);
+}
+DM_TEST(dm_test_net_tftp_window, DM_TESTF_SCAN_FDT);
@@ -0,0 +1,340 @@
+/*
+ * Copyright (c) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <mapmem.h>
+#include <net.h>
+#include <net/tcp.h>
+#include <dm/test.h>
+#include <asm/eth.h>
+#include <asm/unaligned.h>
+#include <test/net.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define WGET_TEST_PORT		8080
+#define WGET_TEST_ISS		1000
+/* Segments the server sends before it waits for an ACK */
+#define WGET_TEST_WINDOW	16
+
+/**
+ * struct wget_test_server - State of the fake HTTP server
+ *
+ * It serves the test file as /test.bin, and answers 404
+ * for anything else. It keeps WGET_TEST_WINDOW segments in flight, and
+ * does a fast retransmit of the first segment not ACKed after three
+ * duplicate ACKs; it has no retransmission timer.
+ *
+ * @hdr: Headers of the reply
+ * @len: Length of the reply, headers and body
+ * @mss: MSS given by the client
+ * @wscale: Window scale given by the client, or -1 if none
+ * @win: Last window field sent by the client
+ * @client_port: Port the client connected from
+ * @client_seq: Next sequence number expected from the client
+ * @acked: Bytes of the reply ACKed by the client
+ * @sent: Bytes of the reply sent
+ * @dup_acks: Number of duplicate ACKs in a row
+ * @drop: Segment to leave out once, counting from 1, or 0 for none
+ * @content_len: Content-Length to give for the test file, or 0 for its
+ *	real size
+ * @segments: Number of segments of the reply sent in this connection,
+ *	fast retransmits included
+ * @fast_retransmits: Number of fast retransmits in this connection
+ * @fin_sent: true once the server has sent its FIN
+ * @closed: true once the client has sent its FIN
+ */
+struct wget_test_server {
+	char hdr[100];
+	int len;
+	int mss;
+	int wscale;
+	int win;
+	int client_port;
+	u32 client_seq;
+	int acked;
+	int sent;
+	int dup_acks;
+	int drop;
+	int content_len;
+	int segments;
+	int fast_retransmits;
+	bool fin_sent;
+	bool closed;
+};
+
+static struct wget_test_server wget_server;
+
+/* Byte at @offset of the reply */
+static u8 wget_test_reply_byte(int offset)
+{
+	struct wget_test_server *srv = &wget_server;
+	int hdr_len = strlen(srv->hdr);
+
+	if (offset < hdr_len)
+		return srv->hdr[offset];
+
+	return net_test_byte(offset - hdr_len);
+}
+
+/* Send a segment from the server to the client which sent @request */
+static int wget_test_send(struct udevice *dev, void *request, u8 flags,
+			  u32 seq, int offset, int len)
+{
+	struct wget_test_server *srv = &wget_server;
+	uchar buf[PKTSIZE_ALIGN];
+	struct ip_tcp_hdr *ip = (void *)buf + ETHER_HDR_SIZE;
+	uchar *opt = (uchar *)(ip + 1);
+	int hdr_len = TCP_HDR_SIZE;
+	struct {
+		struct in_addr src;
+		struct in_addr dst;
+		u8 zero;
+		u8 proto;
+		u16 len;
+	} ph;
+	int i;
+
+	if (flags & TCP_SYN) {
+		opt[0] = TCP_OPT_MSS;
+		opt[1] = 4;
+		put_unaligned_be16(TCP_MSS, opt + 2);
+		opt[4] = TCP_OPT_NOP;
+		opt[5] = TCP_OPT_WSCALE;
+		opt[6] = 3;
+		opt[7] = 7;
+		hdr_len += 8;
+	}
+	for (i = 0; i < len; i++)
+		opt[hdr_len - TCP_HDR_SIZE + i] =
+			wget_test_reply_byte(offset + i);
+
+	net_test_ip_hdr(buf, request, IPPROTO_TCP, hdr_len + len);
+	ip->tcp_src = htons(WGET_TEST_PORT);
+	ip->tcp_dst = htons(srv->client_port);
+	put_unaligned_be32(seq, &ip->tcp_seq);
+	put_unaligned_be32(srv->client_seq, &ip->tcp_ack);
+	ip->tcp_off = hdr_len / 4 << 4;
+	ip->tcp_flags = flags | TCP_ACK;
+	ip->tcp_win = htons(0xffff);
+	ip->tcp_urg = 0;
+	ip->tcp_xsum = 0;
+
+	ph.src = net_read_ip(&ip->ip_src);
+	ph.dst = net_read_ip(&ip->ip_dst);
+	ph.zero = 0;
+	ph.proto = IPPROTO_TCP;
+	ph.len = htons(hdr_len + len);
+	ip->tcp_xsum = add_ip_checksums(sizeof(ph),
+					compute_ip_checksum(&ph, sizeof(ph)),
+					compute_ip_checksum(&ip->tcp_src,
+							    hdr_len + len));
+
+	return sandbox_eth_recv_packet(dev, buf, ETHER_HDR_SIZE +
+				       IP_HDR_SIZE + hdr_len + len);
+}
+
+static int wget_test_send_data(struct udevice *dev, void *request, int offset)
+{
+	struct wget_test_server *srv = &wget_server;
+	int len = min(srv->mss, srv->len - offset);
+
+	srv->segments++;
+	if (srv->segments == srv->drop) {
+		srv->drop = 0;
+		return 0;
+	}
+
+	return wget_test_send(dev, request, TCP_PSH, WGET_TEST_ISS + 1 + offset,
+			      offset, len);
+}
+
+/* Send what the window allows, then the FIN */
+static int wget_test_send_window(struct udevice *dev, void *request)
+{
+	struct wget_test_server *srv = &wget_server;
+	int ret;
+
+	while (srv->sent < srv->len &&
+	       srv->sent - srv->acked < WGET_TEST_WINDOW * srv->mss) {
+		ret = wget_test_send_data(dev, request, srv->sent);
+		if (ret)
+			return ret;
+		srv->sent = min(srv->sent + srv->mss, srv->len);
+	}
+	if (srv->sent == srv->len && !srv->fin_sent) {
+		srv->fin_sent = true;
+		return wget_test_send(dev, request, TCP_FIN,
+				      WGET_TEST_ISS + 1 + srv->len, 0, 0);
+	}
+
+	return 0;
+}
+
+static void wget_test_options(uchar *opt, int len)
+{
+	struct wget_test_server *srv = &wget_server;
+
+	srv->mss = 536;
+	srv->wscale = -1;
+	while (len > 0 && *opt != TCP_OPT_END) {
+		if (*opt == TCP_OPT_NOP) {
+			opt++;
+			len--;
+			continue;
+		}
+		if (opt[0] == TCP_OPT_MSS)
+			srv->mss = get_unaligned_be16(opt + 2);
+		else if (opt[0] == TCP_OPT_WSCALE)
+			srv->wscale = opt[2];
+		len -= opt[1];
+		opt += opt[1];
+	}
+}
+
+static void wget_test_request(char *req, int len)
+{
+	struct wget_test_server *srv = &wget_server;
+
+	if (len > 18 && !strncmp(req, "GET /test.bin HTTP", 18))
+		sprintf(srv->hdr,
+			"HTTP/1.0 200 OK\r\nContent-Length: %d\r\n\r\n",
+			srv->content_len ? srv->content_len : NET_TEST_SIZE);
+	else
+		strcpy(srv->hdr, "HTTP/1.0 404 Not Found\r\n\r\n");
+	srv->len = strlen(srv->hdr);
+	if (srv->hdr[9] == '2')
+		srv->len += NET_TEST_SIZE;
+}
+
+static int wget_test_tx(struct udevice *dev, void *packet, unsigned int len)
+{
+	struct wget_test_server *srv = &wget_server;
+	struct ethernet_hdr *eth = packet;
+	struct ip_tcp_hdr *ip = packet + ETHER_HDR_SIZE;
+	int hdr_len, data_len, acked;
+	u32 seq;
+
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_TCP)
+		return -ENOENT;
+	if (ntohs(ip->tcp_dst) != WGET_TEST_PORT)
+		return 0;
+
+	hdr_len = (ip->tcp_off >> 4) * 4;
+	data_len = ntohs(ip->ip_len) - IP_HDR_SIZE - hdr_len;
+	seq = get_unaligned_be32(&ip->tcp_seq);
+	srv->win = ntohs(ip->tcp_win);
+
+	if (ip->tcp_flags & TCP_SYN) {
+		srv->client_port = ntohs(ip->tcp_src);
+		srv->client_seq = seq + 1;
+		srv->acked = 0;
+		srv->sent = 0;
+		srv->len = 0;
+		srv->fin_sent = false;
+		srv->closed = false;
+		srv->segments = 0;
+		srv->fast_retransmits = 0;
+		wget_test_options((uchar *)(ip + 1), hdr_len - TCP_HDR_SIZE);
+		return wget_test_send(dev, packet, TCP_SYN, WGET_TEST_ISS, 0,
+				      0);
+	}
+
+	if (data_len && seq == srv->client_seq) {
+		wget_test_request((char *)&ip->tcp_src + hdr_len, data_len);
+		srv->client_seq += data_len;
+	}
+	if (ip->tcp_flags & TCP_FIN) {
+		srv->client_seq++;
+		srv->closed = true;
+		return 0;
+	}
+	if (!srv->len)
+		return 0;
+
+	acked = get_unaligned_be32(&ip->tcp_ack) - WGET_TEST_ISS - 1;
+	if (acked > srv->acked) {
+		srv->acked = min(acked, srv->len);
+		srv->dup_acks = 0;
+	} else if (srv->acked < srv->len && ++srv->dup_acks == 3) {
+		srv->fast_retransmits++;
+		return wget_test_send_data(dev, packet, srv->acked);
+	}
+
+	return wget_test_send_window(dev, packet);
+}
+
+static int wget_test_transfers(struct unit_test_state *uts)
+{
+	struct wget_test_server *srv = &wget_server;
+	char port[8];
+	ulong msecs;
+	int segments, i;
+	u8 *buf;
+
+	sprintf(port, "%d", WGET_TEST_PORT);
+	setenv("httpdstp", port);
+	ut_assertok(net_test_get(uts, WGET, "/test.bin", &msecs));
+	ut_asserteq(TCP_MSS, srv->mss);
+	ut_asserteq(TCP_WSCALE, srv->wscale);
+	ut_asserteq(0xffff, srv->win);
+	ut_assert(srv->closed);
+	ut_asserteq(0, srv->fast_retransmits);
+	segments = srv->segments;
+	ut_asserteq(DIV_ROUND_UP(srv->len, TCP_MSS), segments);
+	printf("%d bytes in %lu ms\n", NET_TEST_SIZE, msecs);
+
+	/*
+	 * A lost segment is sent again after three duplicate ACKs, long
+	 * before the client would time out
+	 */
+	srv->drop = 100;
+	ut_assertok(net_test_get(uts, WGET, "test.bin", &msecs));
+	ut_asserteq(1, srv->fast_retransmits);
+	ut_asserteq(segments + 1, srv->segments);
+	ut_assert(msecs < 1000);
+
+	/* The host can be given with the path */
+	srv->drop = 2;
+	ut_assertok(net_test_get(uts, WGET, "1.1.2.2:/test.bin", &msecs));
+	ut_asserteq(1, srv->fast_retransmits);
+
+	/* Anything but a 2xx status fails */
+	ut_assert(net_test_get(uts, WGET, "/missing", &msecs) < 0);
+	ut_assert(srv->closed);
+
+	/* Nothing is written past the Content-Length */
+	srv->content_len = NET_TEST_SIZE / 2;
+	ut_assert(net_test_get(uts, WGET, "/test.bin", &msecs) < 0);
+	ut_assert(srv->closed);
+	buf = map_sysmem(NET_TEST_ADDR, NET_TEST_SIZE);
+	for (i = srv->content_len; i < NET_TEST_SIZE; i++)
+		ut_asserteq(0, buf[i]);
+	unmap_sysmem(buf);
+	srv->content_len = 0;
+
+	/* Nor past the end of the memory which bootm gives the OS */
+	setenv_hex("bootm_size", gd->ram_size);
+	load_addr = gd->ram_size - NET_TEST_SIZE / 2;
+	copy_filename(net_boot_file_name, "/test.bin",
+		      sizeof(net_boot_file_name));
+	ut_assert(net_loop(WGET) < 0);
+	ut_assert(srv->closed);
+
+	return 0;
+}
+
+static int dm_test_net_wget(struct unit_test_state *uts)
+{
+	static const char *const env[] = { "httpdstp", "bootm_size", NULL };
+
+	memset(&wget_server, '\0', sizeof(wget_server));
+
+	return net_test_run(uts, wget_test_tx, env, wget_test_transfers);
+}
+DM_TEST(dm_test_net_wget, DM_TESTF_SCAN_FDT);
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <environment.h>
+#include <malloc.h>
+#include <search.h>
+#include <test/env.h>
+#include <test/ut.h>
+
+#define BENCH_ENV_SIZE		(64 << 10)
+#define BENCH_ENV_ENTRIES	2700
+
+/* Check that only real changes make the environment dirty */
+static int env_test_dirty(struct unit_test_state *uts)
+{
+	env_set_clean();
+	ut_assert(!env_is_dirty());
+
+	/* Setting a variable to the value it has is not a change */
+	ut_assertok(setenv("ut_dirty", "1"));
+	ut_assert(env_is_dirty());
+	env_set_clean();
+	ut_assertok(setenv("ut_dirty", "1"));
+	ut_assert(!env_is_dirty());
+
+	ut_assertok(setenv("ut_dirty", "2"));
+	ut_assert(env_is_dirty());
+	env_set_clean();
+	ut_assertok(setenv("ut_dirty", NULL));
+	ut_assert(env_is_dirty());
+
+	return 0;
+}
+ENV_TEST(env_test_dirty, 0);
+
+/* Fill @buf with "name=value" pairs in sorted order, as hexport_r() gives */
+static int env_bench_text(char *buf, int size)
+{
+	int pos = 0, i;
+
+	for (i = 0; i < BENCH_ENV_ENTRIES; i++) {
+		pos += snprintf(buf + pos, size - pos, "var%04d=value%010u", i,
+				i * 7919);
+		buf[pos++] = '\0';
+		if (pos >= size)
+			return -ENOSPC;
+	}
+	buf[pos++] = '\0';
+
+	return pos;
+}
+
+/* Time importing and exporting a large environment with many variables */
+static int env_test_import_export_bench(struct unit_test_state *uts)
+{
+	struct hsearch_data htab = { 0 };
+	ulong import_us, export_us;
+	char *text, *out;
+	ssize_t len;
+	int size;
+
+	text = calloc(1, BENCH_ENV_SIZE);
+	out = calloc(1, BENCH_ENV_SIZE);
+	ut_assertnonnull(text);
+	ut_assertnonnull(out);
+	size = env_bench_text(text, BENCH_ENV_SIZE);
+	ut_assert(size > 0);
+
+	/* himport_r() caps the table at CONFIG_ENV_MAX_ENTRIES */
+	ut_asserteq(1, hcreate_r(BENCH_ENV_ENTRIES * 2, &htab));
+	import_us = timer_get_us();
+	ut_asserteq(1, himport_r(&htab, text, BENCH_ENV_SIZE, '\0',
+				 H_NOCLEAR, 0, 0, NULL));
+	import_us = timer_get_us() - import_us;
+	ut_asserteq(BENCH_ENV_ENTRIES, htab.filled);
+
+	export_us = timer_get_us();
+	len = hexport_r(&htab, '\0', 0, &out, BENCH_ENV_SIZE, 0, NULL);
+	export_us = timer_get_us() - export_us;
+	ut_asserteq(BENCH_ENV_SIZE, len);
+	ut_assertok(memcmp(text, out, size));
+
+	printf("%d variables, %d bytes: import %lu us, export %lu us\n",
+	       BENCH_ENV_ENTRIES, size, import_us, export_us);
+
+	hdestroy_r(&htab);
+	free(out);
+	free(text);
+
+	return 0;
+}
+ENV_TEST(env_test_import_export_bench, 0);
+
+#define STRESS_ENTRIES		10000
+
+static int env_stress_lookup(struct hsearch_data *htab, int i, bool present)
+{
+	char key[16], data[16];
+	ENTRY e, *ep;
+
+	snprintf(key, sizeof(key), "key%d", i);
+	snprintf(data, sizeof(data), "%d", i * 31);
+	e.key = key;
+	e.data = NULL;
+	if (!hsearch_r(e, FIND, &ep, htab, 0))
+		return present ? -ENOENT : 0;
+	if (!present || strcmp(ep->data, data))
+		return -EINVAL;
+
+	return 0;
+}
+
+static int env_stress_enter(struct hsearch_data *htab, int i)
+{
+	char key[16], data[16];
+	ENTRY e, *ep;
+
+	snprintf(key, sizeof(key), "key%d", i);
+	snprintf(data, sizeof(data), "%d", i * 31);
+	e.key = key;
+	e.data = data;
+
+	return hsearch_r(e, ENTER, &ep, htab, 0) ? 0 : -ENOMEM;
+}
+
+/* Check that a small table grows and clears out deleted entries */
+static int env_test_hash_stress(struct unit_test_state *uts)
+{
+	struct hsearch_data htab = { 0 };
+	unsigned int size;
+	char key[16];
+	ENTRY *ep;
+	int i, idx;
+
+	ut_asserteq(1, hcreate_r(16, &htab));
+	for (i = 0; i < STRESS_ENTRIES; i++)
+		ut_assertok(env_stress_enter(&htab, i));
+	ut_asserteq(STRESS_ENTRIES, htab.filled);
+	ut_assert(htab.size > STRESS_ENTRIES);
+	for (i = 0; i < STRESS_ENTRIES; i++)
+		ut_assertok(env_stress_lookup(&htab, i, true));
+
+	/* Delete every other entry, clearing out deleted slots as they pile up */
+	size = htab.size;
+	for (i = 0; i < STRESS_ENTRIES; i += 2) {
+		snprintf(key, sizeof(key), "key%d", i);
+		ut_asserteq(1, hdelete_r(key, &htab, 0));
+	}
+	ut_asserteq(STRESS_ENTRIES / 2, htab.filled);
+	ut_assert(htab.deleted * 4 <= htab.size);
+	for (i = 0; i < STRESS_ENTRIES; i++)
+		ut_assertok(env_stress_lookup(&htab, i, i & 1));
+
+	/* Every entry can be found by a walk, with none repeated */
+	for (i = 0, idx = 0; (idx = hmatch_r("key", idx, &ep, &htab)); i++)
+		ut_assertnonnull(ep);
+	ut_asserteq(STRESS_ENTRIES / 2, i);
+
+	/* Entering the deleted ones again does not grow the table */
+	for (i = 0; i < STRESS_ENTRIES; i += 2)
+		ut_assertok(env_stress_enter(&htab, i));
+	ut_asserteq(STRESS_ENTRIES, htab.filled);
+	ut_asserteq(size, htab.size);
+	for (i = 0; i < STRESS_ENTRIES; i++)
+		ut_assertok(env_stress_lookup(&htab, i, true));
+
+	hdestroy_r(&htab);
+
+	return 0;
+}
+ENV_TEST(env_test_hash_stress, 0);
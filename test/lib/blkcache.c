@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <test/lib.h>
+#include <test/ut.h>
+
+#define BLKC_IFTYPE	IF_TYPE_HOST
+#define BLKC_DEVNUM	7
+#define BLKC_BLKSZ	512
+
+/* Fill @buf with @blkcnt blocks, each holding its own block number */
+static void blkc_pattern(u8 *buf, lbaint_t start, lbaint_t blkcnt)
+{
+	lbaint_t i;
+
+	for (i = 0; i < blkcnt; i++)
+		memset(buf + i * BLKC_BLKSZ, start + i, BLKC_BLKSZ);
+}
+
+static int blkc_check(struct unit_test_state *uts, u8 *buf, lbaint_t start,
+		      lbaint_t blkcnt)
+{
+	lbaint_t i;
+
+	for (i = 0; i < blkcnt * BLKC_BLKSZ; i++)
+		ut_asserteq((u8)(start + i / BLKC_BLKSZ), buf[i]);
+
+	return 0;
+}
+
+static int blkc_read(struct unit_test_state *uts, lbaint_t start,
+		     lbaint_t blkcnt)
+{
+	u8 buf[8 * BLKC_BLKSZ];
+	lbaint_t miss, misscnt;
+
+	memset(buf, 0xff, sizeof(buf));
+	if (!blkcache_read(BLKC_IFTYPE, BLKC_DEVNUM, start, blkcnt,
+			   BLKC_BLKSZ, buf, &miss, &misscnt))
+		return -ENOENT;
+	ut_assertok(blkc_check(uts, buf, start, blkcnt));
+
+	return 0;
+}
+
+static void blkc_fill(lbaint_t start, lbaint_t blkcnt)
+{
+	u8 buf[9 * BLKC_BLKSZ];
+
+	blkc_pattern(buf, start, blkcnt);
+	blkcache_fill(BLKC_IFTYPE, BLKC_DEVNUM, start, blkcnt, BLKC_BLKSZ,
+		      buf);
+}
+
+static int blkc_dev_stats(struct unit_test_state *uts,
+			  struct block_cache_dev_stats *stats)
+{
+	int i;
+
+	for (i = 0; !blkcache_dev_stats(i, stats); i++)
+		if (stats->iftype == BLKC_IFTYPE &&
+		    stats->devnum == BLKC_DEVNUM)
+			return 0;
+
+	return -ENOENT;
+}
+
+/* Test that requests overlapping earlier ones are served */
+static int lib_test_blkcache_overlap(struct unit_test_state *uts)
+{
+	struct block_cache_dev_stats dev_stats;
+	struct block_cache_stats stats;
+
+	blkcache_configure(8, 16 * BLKC_BLKSZ);
+	blkc_fill(10, 4);
+	ut_assertok(blkc_read(uts, 11, 2));
+	ut_asserteq(-ENOENT, blkc_read(uts, 13, 2));
+	blkc_fill(13, 2);
+	ut_assertok(blkc_read(uts, 10, 5));
+
+	blkcache_stats(&stats);
+	ut_asserteq(2, stats.hits);
+	ut_asserteq(1, stats.partial);
+	ut_asserteq(0, stats.misses);
+	ut_asserteq(5, stats.entries);
+	ut_asserteq(5 * BLKC_BLKSZ, stats.size);
+	ut_assertok(blkc_dev_stats(uts, &dev_stats));
+	ut_asserteq(2, dev_stats.hits);
+	ut_asserteq(1, dev_stats.partial);
+	ut_asserteq(0, dev_stats.misses);
+	ut_asserteq(5, dev_stats.entries);
+
+	blkcache_invalidate(BLKC_IFTYPE, BLKC_DEVNUM);
+	ut_asserteq(-ENOENT, blkc_read(uts, 10, 1));
+	blkcache_stats(&stats);
+	ut_asserteq(0, stats.entries);
+
+	blkcache_configure(32, CONFIG_BLOCK_CACHE_SIZE);
+
+	return 0;
+}
+LIB_TEST(lib_test_blkcache_overlap, 0);
+
+/* Test that the least recently used blocks are evicted to stay in size */
+static int lib_test_blkcache_lru(struct unit_test_state *uts)
+{
+	struct block_cache_stats stats;
+
+	blkcache_configure(8, 4 * BLKC_BLKSZ);
+	blkc_fill(0, 4);
+	ut_assertok(blkc_read(uts, 0, 1));
+	blkc_fill(4, 1);
+	ut_asserteq(-ENOENT, blkc_read(uts, 1, 1));
+	ut_assertok(blkc_read(uts, 0, 1));
+	ut_assertok(blkc_read(uts, 2, 3));
+
+	/* Requests larger than the configured limit are not cached */
+	blkc_fill(20, 9);
+	ut_asserteq(-ENOENT, blkc_read(uts, 20, 1));
+
+	blkcache_stats(&stats);
+	ut_asserteq(4, stats.entries);
+	ut_asserteq(4 * BLKC_BLKSZ, stats.size);
+
+	blkcache_configure(32, CONFIG_BLOCK_CACHE_SIZE);
+
+	return 0;
+}
+LIB_TEST(lib_test_blkcache_lru, 0);
+
+/* Test that larger blocks get larger slots, within the same size */
+static int lib_test_blkcache_blksz(struct unit_test_state *uts)
+{
+	struct block_cache_stats stats;
+	u8 buf[4 * BLKC_BLKSZ];
+	lbaint_t miss, misscnt;
+
+	blkcache_configure(8, 4 * BLKC_BLKSZ);
+	blkc_fill(0, 4);
+
+	/* Two blocks of twice the size fill the cache again */
+	memset(buf, 0x55, sizeof(buf));
+	blkcache_fill(BLKC_IFTYPE, BLKC_DEVNUM + 1, 0, 2, 2 * BLKC_BLKSZ,
+		      buf);
+	ut_asserteq(-ENOENT, blkc_read(uts, 0, 1));
+	memset(buf, '\0', sizeof(buf));
+	ut_asserteq(1, blkcache_read(BLKC_IFTYPE, BLKC_DEVNUM + 1, 0, 2,
+				     2 * BLKC_BLKSZ, buf, &miss, &misscnt));
+	ut_asserteq(0x55, buf[sizeof(buf) - 1]);
+
+	/* Smaller blocks now take the larger slots */
+	blkc_fill(0, 4);
+	blkcache_stats(&stats);
+	ut_asserteq(2, stats.entries);
+	ut_assertok(blkc_read(uts, 2, 2));
+
+	blkcache_configure(32, CONFIG_BLOCK_CACHE_SIZE);
+
+	return 0;
+}
+LIB_TEST(lib_test_blkcache_blksz, 0);
+
+/* Test that the cached ends of a request are served, leaving the gap */
+static int lib_test_blkcache_partial(struct unit_test_state *uts)
+{
+	struct block_cache_stats stats;
+	u8 buf[8 * BLKC_BLKSZ];
+	lbaint_t miss, misscnt;
+
+	blkcache_configure(8, 16 * BLKC_BLKSZ);
+	blkcache_invalidate(BLKC_IFTYPE, BLKC_DEVNUM);
+	blkc_fill(10, 2);
+	blkc_fill(15, 1);
+
+	/* Blocks 10-11 and 15 are cached, 12-14 are not */
+	memset(buf, 0xff, sizeof(buf));
+	ut_asserteq(0, blkcache_read(BLKC_IFTYPE, BLKC_DEVNUM, 10, 6,
+				     BLKC_BLKSZ, buf, &miss, &misscnt));
+	ut_asserteq(12, miss);
+	ut_asserteq(3, misscnt);
+	ut_assertok(blkc_check(uts, buf, 10, 2));
+	ut_assertok(blkc_check(uts, buf + 5 * BLKC_BLKSZ, 15, 1));
+	ut_asserteq(0xff, buf[2 * BLKC_BLKSZ]);
+
+	/* Only the end is cached */
+	ut_asserteq(0, blkcache_read(BLKC_IFTYPE, BLKC_DEVNUM, 8, 4,
+				     BLKC_BLKSZ, buf, &miss, &misscnt));
+	ut_asserteq(8, miss);
+	ut_asserteq(2, misscnt);
+	ut_assertok(blkc_check(uts, buf + 2 * BLKC_BLKSZ, 10, 2));
+
+	/* Nothing is cached */
+	ut_asserteq(0, blkcache_read(BLKC_IFTYPE, BLKC_DEVNUM, 20, 3,
+				     BLKC_BLKSZ, buf, &miss, &misscnt));
+	ut_asserteq(20, miss);
+	ut_asserteq(3, misscnt);
+
+	/* Once the gap is filled, the whole request is a hit */
+	blkc_fill(12, 3);
+	ut_assertok(blkc_read(uts, 10, 6));
+
+	blkcache_stats(&stats);
+	ut_asserteq(1, stats.hits);
+	ut_asserteq(2, stats.partial);
+	ut_asserteq(1, stats.misses);
+
+	blkcache_invalidate(BLKC_IFTYPE, BLKC_DEVNUM);
+	blkcache_configure(32, CONFIG_BLOCK_CACHE_SIZE);
+
+	return 0;
+}
+LIB_TEST(lib_test_blkcache_partial, 0);
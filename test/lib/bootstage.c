@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <bootstage.h>
+#include <fdtdec.h>
+#include <libfdt.h>
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/ut.h>
+
+#define PROF_NAME	"ut_prof_blk"
+#define PROF_EXPORT	"ut_prof_export"
+#define PROF_BUF_SIZE	0x4000
+
+/* Test that transfers are added up in a block device profile record */
+static int lib_test_bootstage_prof(struct unit_test_state *uts)
+{
+	struct bootstage_prof prof;
+	ulong start;
+
+	/* Devices probed by earlier tests may have filled the table */
+	bootstage_prof_reset();
+	ut_asserteq(-ENOENT, bootstage_prof_get(BOOTSTAGE_PROF_BLK, PROF_NAME,
+						&prof));
+
+	/* Bootstage marks have been made, so the timer can be used */
+	start = bootstage_prof_start();
+	ut_assert(start != BOOTSTAGE_PROF_NONE);
+	bootstage_prof_add(BOOTSTAGE_PROF_BLK, PROF_NAME, start, 4, 2048);
+	bootstage_prof_add(BOOTSTAGE_PROF_BLK, PROF_NAME, start, 8, 4096);
+	bootstage_prof_add(BOOTSTAGE_PROF_BLK, PROF_NAME,
+			   BOOTSTAGE_PROF_NONE, 1, 512);
+
+	ut_assertok(bootstage_prof_get(BOOTSTAGE_PROF_BLK, PROF_NAME, &prof));
+	ut_asserteq(2, prof.count);
+	ut_asserteq(12, prof.blocks);
+	ut_asserteq(6144, prof.bytes);
+	ut_asserteq_str(PROF_NAME, prof.name);
+
+	/* The same name of another kind is another record */
+	ut_asserteq(-ENOENT, bootstage_prof_get(BOOTSTAGE_PROF_PROBE,
+						PROF_NAME, &prof));
+
+	return 0;
+}
+LIB_TEST(lib_test_bootstage_prof, 0);
+
+/* Test that profile records are written to the stash and device tree */
+static int lib_test_bootstage_prof_export(struct unit_test_state *uts)
+{
+	struct fdt_header *old_fdt = working_fdt;
+	struct bootstage_prof prof;
+	const fdt64_t *bytes;
+	const char *name;
+	bool found = false;
+	char *buf;
+	int node, parent;
+	int i;
+
+	buf = malloc(PROF_BUF_SIZE);
+	ut_assertnonnull(buf);
+	bootstage_prof_reset();
+	bootstage_prof_add(BOOTSTAGE_PROF_BLK, PROF_EXPORT,
+			   bootstage_prof_start(), 1, 512);
+	ut_assertok(bootstage_prof_get(BOOTSTAGE_PROF_BLK, PROF_EXPORT,
+				       &prof));
+
+	ut_assertok(bootstage_stash(buf, PROF_BUF_SIZE));
+	for (i = 0; i < PROF_BUF_SIZE - sizeof(PROF_EXPORT); i++) {
+		if (!memcmp(buf + i, PROF_EXPORT, sizeof(PROF_EXPORT)))
+			found = true;
+	}
+	ut_assert(found);
+
+	ut_assertok(fdt_create_empty_tree(buf, PROF_BUF_SIZE));
+	working_fdt = (struct fdt_header *)buf;
+	bootstage_fdt_add_report();
+	working_fdt = old_fdt;
+
+	parent = fdt_path_offset(buf, "/bootstage");
+	ut_assert(parent >= 0);
+	found = false;
+	fdt_for_each_subnode(node, buf, parent) {
+		name = fdt_getprop(buf, node, "name", NULL);
+		if (!name || strcmp(name, "blk " PROF_EXPORT))
+			continue;
+		ut_asserteq(prof.time_us,
+			    fdtdec_get_int(buf, node, "accum", -1));
+		ut_asserteq(prof.count, fdtdec_get_int(buf, node, "count", 0));
+		ut_asserteq(prof.blocks,
+			    fdtdec_get_int(buf, node, "blocks", 0));
+		bytes = fdt_getprop(buf, node, "bytes", NULL);
+		ut_assertnonnull(bytes);
+		ut_asserteq(prof.bytes, fdt64_to_cpu(*bytes));
+		found = true;
+	}
+	ut_assert(found);
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_bootstage_prof_export, 0);
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <bouncebuf.h>
+#include <common.h>
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/ut.h>
+
+#define BB_TEST_LEN	(8 * ARCH_DMA_MINALIGN)
+
+/* Test that aligned buffers are used in place and others are bounced */
+static int lib_test_bouncebuf(struct unit_test_state *uts)
+{
+	struct bounce_buffer state;
+	u8 *buf;
+	int i;
+
+	buf = memalign(ARCH_DMA_MINALIGN, BB_TEST_LEN + ARCH_DMA_MINALIGN);
+	ut_assertnonnull(buf);
+	for (i = 0; i < BB_TEST_LEN + ARCH_DMA_MINALIGN; i++)
+		buf[i] = i;
+
+	/* An aligned buffer is given to the DMA as it is, either way */
+	ut_assertok(bounce_buffer_start(&state, buf, BB_TEST_LEN,
+					GEN_BB_WRITE));
+	ut_asserteq_ptr(buf, state.bounce_buffer);
+	ut_assertok(bounce_buffer_stop(&state));
+	ut_assertok(bounce_buffer_start(&state, buf, BB_TEST_LEN,
+					GEN_BB_READ));
+	ut_asserteq_ptr(buf, state.bounce_buffer);
+	ut_assertok(bounce_buffer_stop(&state));
+
+	/* An unaligned one is copied to an aligned buffer for the DMA */
+	ut_assertok(bounce_buffer_start(&state, buf + 1, BB_TEST_LEN,
+					GEN_BB_READ));
+	ut_assert(state.bounce_buffer != buf + 1);
+	ut_assert(IS_ALIGNED((ulong)state.bounce_buffer, ARCH_DMA_MINALIGN));
+	ut_assert(!memcmp(state.bounce_buffer, buf + 1, BB_TEST_LEN));
+	ut_assertok(bounce_buffer_stop(&state));
+
+	/* What the DMA writes is copied back, and nothing more */
+	ut_assertok(bounce_buffer_start(&state, buf + 1, BB_TEST_LEN - 1,
+					GEN_BB_WRITE));
+	ut_assert(state.bounce_buffer != buf + 1);
+	memset(state.bounce_buffer, 0xaa, state.len_aligned);
+	ut_assertok(bounce_buffer_stop(&state));
+	ut_asserteq(0, buf[0]);
+	for (i = 1; i < BB_TEST_LEN; i++)
+		ut_asserteq(0xaa, buf[i]);
+	ut_asserteq((u8)BB_TEST_LEN, buf[BB_TEST_LEN]);
+
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_bouncebuf, 0);
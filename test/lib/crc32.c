@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/ut.h>
+#include <u-boot/crc.h>
+
+#define CRC_BENCH_SIZE	(8 << 20)
+
+typedef uint32_t (*crc32_func)(uint32_t, const unsigned char *, uint);
+
+static const struct {
+	const char *name;
+	crc32_func func;
+} crc32_variants[] = {
+	{ "byte-wise", crc32_no_comp_byte },
+	{ "slice-by-8", crc32_no_comp_slice8 },
+	{ "crc32_no_comp", crc32_no_comp },
+};
+
+/* A bit at a time, straight from the definition */
+static uint32_t crc32_ref(uint32_t crc, const unsigned char *buf, uint len)
+{
+	int i;
+
+	while (len--) {
+		crc ^= *buf++;
+		for (i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ (crc & 1 ? 0xedb88320 : 0);
+	}
+
+	return crc;
+}
+
+static void crc32_fill(unsigned char *buf, ulong size)
+{
+	u32 seed = 1;
+	ulong i;
+
+	for (i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+		buf[i] = seed >> 16;
+	}
+}
+
+/* Test each variant against the reference, at all alignments and tails */
+static int lib_test_crc32(struct unit_test_state *uts)
+{
+	unsigned char buf[128];
+	uint32_t expect;
+	int start, len, i;
+
+	crc32_fill(buf, sizeof(buf));
+	for (start = 0; start < 8; start++) {
+		for (len = 0; len <= sizeof(buf) - 8; len++) {
+			expect = crc32_ref(0x12345678, buf + start, len);
+			for (i = 0; i < ARRAY_SIZE(crc32_variants); i++) {
+				ut_asserteq(expect,
+					    crc32_variants[i].func(0x12345678,
+							buf + start, len));
+			}
+		}
+	}
+
+	/* The standard check value */
+	ut_asserteq(0xcbf43926, crc32(0, (unsigned char *)"123456789", 9));
+
+	return 0;
+}
+LIB_TEST(lib_test_crc32, 0);
+
+/* Time each variant on a large buffer, checking that they agree */
+static int lib_test_crc32_bench(struct unit_test_state *uts)
+{
+	unsigned char *buf;
+	uint32_t crc, expect = 0;
+	ulong start, us;
+	int i;
+
+	buf = malloc(CRC_BENCH_SIZE);
+	ut_assertnonnull(buf);
+	crc32_fill(buf, CRC_BENCH_SIZE);
+
+	for (i = 0; i < ARRAY_SIZE(crc32_variants); i++) {
+		start = timer_get_us();
+		crc = crc32_variants[i].func(~0, buf, CRC_BENCH_SIZE);
+		us = max(timer_get_us() - start, 1UL);
+		if (!i)
+			expect = crc;
+		ut_asserteq(expect, crc);
+		printf("%-14s %lu bytes in %lu us, %lu MB/s\n",
+		       crc32_variants[i].name, (ulong)CRC_BENCH_SIZE, us,
+		       CRC_BENCH_SIZE / us);
+	}
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_crc32_bench, 0);
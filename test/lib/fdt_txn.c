@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <fdt_support.h>
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/ut.h>
+
+#define TXN_BLOB_SIZE		(64 << 10)
+#define TXN_BENCH_SIZE		(256 << 10)
+#define TXN_BENCH_NODES		1000
+
+/* Build a small tree to edit */
+static int fdt_txn_test_blob(void *blob)
+{
+	static const u8 zero_mac[6];
+	fdt32_t reg[2];
+	int ret;
+
+	ret = fdt_create(blob, TXN_BLOB_SIZE);
+	ret |= fdt_add_reservemap_entry(blob, 0x1000, 0x100);
+	ret |= fdt_finish_reservemap(blob);
+	ret |= fdt_begin_node(blob, "");
+	ret |= fdt_property_u32(blob, "#address-cells", 1);
+	ret |= fdt_property_u32(blob, "#size-cells", 1);
+	ret |= fdt_property_string(blob, "model", "fdt_txn test");
+
+	ret |= fdt_begin_node(blob, "aliases");
+	ret |= fdt_property_string(blob, "ethernet0", "/ethernet@1000");
+	ret |= fdt_property_string(blob, "serial0", "/serial@2000");
+	ret |= fdt_end_node(blob);
+
+	ret |= fdt_begin_node(blob, "memory@0");
+	reg[0] = cpu_to_fdt32(0);
+	reg[1] = cpu_to_fdt32(0x1000000);
+	ret |= fdt_property(blob, "reg", reg, sizeof(reg));
+	ret |= fdt_end_node(blob);
+
+	ret |= fdt_begin_node(blob, "ethernet@1000");
+	ret |= fdt_property_string(blob, "compatible", "test,eth");
+	ret |= fdt_property(blob, "mac-address", zero_mac, sizeof(zero_mac));
+	ret |= fdt_property_string(blob, "status", "disabled");
+	ret |= fdt_end_node(blob);
+
+	ret |= fdt_begin_node(blob, "serial@2000");
+	ret |= fdt_property_string(blob, "compatible", "test,serial");
+	ret |= fdt_property_string(blob, "status", "okay");
+	ret |= fdt_begin_node(blob, "port");
+	ret |= fdt_property_u32(blob, "reg", 0);
+	ret |= fdt_end_node(blob);
+	ret |= fdt_begin_node(blob, "console");
+	ret |= fdt_end_node(blob);
+	ret |= fdt_end_node(blob);
+
+	ret |= fdt_end_node(blob);
+	ret |= fdt_finish(blob);
+
+	return ret ? -EINVAL : 0;
+}
+
+/* Make the same edits through a batch, looking nodes up each time */
+static int fdt_txn_test_edit(struct unit_test_state *uts, struct fdt_txn *txn)
+{
+	u64 start = 0x40000000, size = 0x2000000;
+	const char *str;
+	int chosen, node, len;
+
+	ut_assertok(fdt_txn_root(txn));
+	ut_assertok(fdt_txn_chosen(txn));
+	fdt_txn_fixup_ethernet(txn);
+	ut_assertok(fdt_txn_fixup_memory_banks(txn, &start, &size, 1));
+
+	ut_assertok(fdt_txn_set_node_status(txn,
+			fdt_txn_path_offset(txn, "/ethernet@1000"),
+			FDT_STATUS_OKAY, 0));
+	ut_assertok(fdt_txn_set_node_status(txn,
+			fdt_txn_path_offset(txn, "/serial@2000"),
+			FDT_STATUS_FAIL_ERROR_CODE, 5));
+	str = fdt_txn_getprop(txn, fdt_txn_path_offset(txn, "/serial@2000"),
+			      "status", NULL);
+	ut_asserteq_str("fail-5", str);
+
+	/* A deleted property is added again as a new one */
+	node = fdt_txn_path_offset(txn, "/serial@2000");
+	ut_assertok(fdt_txn_delprop(txn, node, "compatible"));
+	ut_asserteq_ptr(NULL, fdt_txn_getprop(txn, node, "compatible", NULL));
+	ut_asserteq(-FDT_ERR_NOTFOUND, fdt_txn_delprop(txn, node,
+						       "compatible"));
+	ut_assertok(fdt_txn_setprop_string(txn, node, "compatible",
+					   "test,serial2"));
+	ut_assertok(fdt_txn_del_node(txn, fdt_txn_subnode_offset(txn, node,
+								 "port")));
+	ut_asserteq(-FDT_ERR_NOTFOUND, fdt_txn_path_offset(txn,
+						"/serial@2000/port"));
+
+	/* Nodes within new nodes, and a new property changed and deleted */
+	chosen = fdt_txn_subnode_offset(txn, 0, "chosen");
+	ut_assert(chosen > 0);
+	node = fdt_txn_add_subnode(txn, chosen, "framebuffer@0");
+	ut_assert(node > 0);
+	ut_assertok(fdt_txn_setprop_string(txn, node, "status", "okay"));
+	ut_assertok(fdt_txn_setprop_u32(txn, node, "width", 640));
+	ut_assertok(fdt_txn_setprop_u64(txn, node, "width", 1024));
+	ut_assertok(fdt_txn_setprop_u32(txn, node, "height", 480));
+	ut_assertnonnull(fdt_txn_getprop(txn, node, "width", &len));
+	ut_asserteq(8, len);
+	ut_assertok(fdt_txn_delprop(txn, node, "status"));
+	ut_asserteq(-FDT_ERR_EXISTS, fdt_txn_add_subnode(txn, chosen,
+							 "framebuffer"));
+	chosen = fdt_txn_subnode_offset(txn, 0, "chosen");
+	ut_assert(fdt_txn_add_subnode(txn, chosen, "extra") > 0);
+	chosen = fdt_txn_subnode_offset(txn, 0, "chosen");
+	ut_assertok(fdt_txn_del_node(txn, fdt_txn_subnode_offset(txn, chosen,
+								 "extra")));
+	node = fdt_txn_path_offset(txn, "/memory@0");
+	ut_assert(fdt_txn_add_subnode(txn, node, "bank0") > 0);
+	node = fdt_txn_path_offset(txn, "/memory@0");
+	ut_assert(fdt_txn_add_subnode(txn, node, "bank1") > 0);
+
+	return 0;
+}
+
+/* libfdt leaves whatever was there in the padding after a property value */
+static void fdt_txn_zero_padding(void *blob)
+{
+	const struct fdt_property *prop;
+	int offset = 0, next, len;
+	uint32_t tag;
+
+	do {
+		tag = fdt_next_tag(blob, offset, &next);
+		if (tag == FDT_PROP) {
+			prop = fdt_get_property_by_offset(blob, offset, &len);
+			memset((char *)prop->data + len, '\0',
+			       next - offset - sizeof(*prop) - len);
+		}
+		offset = next;
+	} while (tag != FDT_END);
+}
+
+/* Check that a batch gives the same tree as editing in place */
+static int lib_test_fdt_txn(struct unit_test_state *uts)
+{
+	char *orig, *direct, *batch;
+	struct fdt_txn txn;
+	int size;
+
+	orig = malloc(TXN_BLOB_SIZE);
+	direct = malloc(TXN_BLOB_SIZE);
+	batch = malloc(TXN_BLOB_SIZE);
+	ut_assertnonnull(orig);
+	ut_assertnonnull(direct);
+	ut_assertnonnull(batch);
+	ut_assertok(fdt_txn_test_blob(orig));
+	ut_assertok(fdt_pack(orig));
+
+	/* serial# and ethaddr can only be set once, so use what is there */
+	if (!getenv("serial#"))
+		setenv("serial#", "ut-1234");
+	setenv("bootargs", "console=ttyS0 root=/dev/mmcblk0p2");
+
+	ut_assertok(fdt_open_into(orig, direct, TXN_BLOB_SIZE));
+	fdt_txn_init_direct(&txn, direct);
+	ut_assertok(fdt_txn_test_edit(uts, &txn));
+	ut_assertok(fdt_pack(direct));
+	fdt_txn_zero_padding(direct);
+
+	ut_assertok(fdt_txn_init(&txn, orig));
+	ut_assertok(fdt_txn_test_edit(uts, &txn));
+	ut_asserteq(-FDT_ERR_NOSPACE, fdt_txn_commit(&txn, batch,
+						     fdt_totalsize(direct) - 4));
+	ut_assertok(fdt_txn_commit(&txn, batch, TXN_BLOB_SIZE));
+	fdt_txn_free(&txn);
+	ut_asserteq(TXN_BLOB_SIZE, fdt_totalsize(batch));
+	ut_assertok(fdt_pack(batch));
+
+	size = fdt_totalsize(direct);
+	ut_asserteq(size, fdt_totalsize(batch));
+	ut_assertok(memcmp(direct, batch, size));
+	ut_asserteq_str("console=ttyS0 root=/dev/mmcblk0p2",
+			fdt_getprop(batch, fdt_path_offset(batch, "/chosen"),
+				    "bootargs", NULL));
+
+	setenv("bootargs", NULL);
+	free(batch);
+	free(direct);
+	free(orig);
+
+	return 0;
+}
+LIB_TEST(lib_test_fdt_txn, 0);
+
+/* Give each of many nodes a new property and a changed one */
+static int fdt_txn_bench_edit(struct unit_test_state *uts,
+			      struct fdt_txn *txn)
+{
+	int node, i;
+
+	/* Editing a node in place moves the nodes after it, not the node */
+	for (i = 0, node = fdt_first_subnode(txn->fdt, 0); i < TXN_BENCH_NODES;
+	     i++, node = fdt_next_subnode(txn->fdt, node)) {
+		ut_assertok(fdt_txn_setprop_u32(txn, node, "index", i));
+		ut_assertok(fdt_txn_setprop_string(txn, node, "status",
+						   "disabled"));
+	}
+
+	return 0;
+}
+
+/* Compare editing a large tree in place with editing it as a batch */
+static int lib_test_fdt_txn_bench(struct unit_test_state *uts)
+{
+	ulong direct_us, batch_us;
+	char *orig, *direct, *batch;
+	struct fdt_txn txn;
+	char name[20];
+	int ret, i;
+
+	orig = malloc(TXN_BENCH_SIZE);
+	direct = malloc(TXN_BENCH_SIZE);
+	batch = malloc(TXN_BENCH_SIZE);
+	ut_assertnonnull(orig);
+	ut_assertnonnull(direct);
+	ut_assertnonnull(batch);
+
+	ret = fdt_create(orig, TXN_BENCH_SIZE);
+	ret |= fdt_finish_reservemap(orig);
+	ret |= fdt_begin_node(orig, "");
+	for (i = 0; i < TXN_BENCH_NODES; i++) {
+		snprintf(name, sizeof(name), "test@%x", i);
+		ret |= fdt_begin_node(orig, name);
+		ret |= fdt_property_string(orig, "compatible", "test,bench");
+		ret |= fdt_property_string(orig, "status", "okay");
+		ret |= fdt_end_node(orig);
+	}
+	ret |= fdt_end_node(orig);
+	ret |= fdt_finish(orig);
+	ut_assertok(ret);
+
+	ut_assertok(fdt_open_into(orig, direct, TXN_BENCH_SIZE));
+	direct_us = timer_get_us();
+	fdt_txn_init_direct(&txn, direct);
+	ut_assertok(fdt_txn_bench_edit(uts, &txn));
+	direct_us = timer_get_us() - direct_us;
+	ut_assertok(fdt_pack(direct));
+	fdt_txn_zero_padding(direct);
+
+	batch_us = timer_get_us();
+	ut_assertok(fdt_txn_init(&txn, orig));
+	ut_assertok(fdt_txn_bench_edit(uts, &txn));
+	ut_assertok(fdt_txn_commit(&txn, batch, TXN_BENCH_SIZE));
+	fdt_txn_free(&txn);
+	batch_us = timer_get_us() - batch_us;
+	ut_assertok(fdt_pack(batch));
+
+	ut_asserteq(fdt_totalsize(direct), fdt_totalsize(batch));
+	ut_assertok(memcmp(direct, batch, fdt_totalsize(direct)));
+	printf("%d nodes: in place %lu us, batch %lu us\n", TXN_BENCH_NODES,
+	       direct_us, batch_us);
+
+	free(batch);
+	free(direct);
+	free(orig);
+
+	return 0;
+}
+LIB_TEST(lib_test_fdt_txn_bench, 0);
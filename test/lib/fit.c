@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <bootstage.h>
+#include <image.h>
+#include <lmb.h>
+#include <mapmem.h>
+#include <u-boot/crc.h>
+#include <test/lib.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define FIT_ADDR		0x100000
+#define FIT_SIZE		0x10000
+#define FIT_RD_SIZE		0x2345
+#define FIT_RD_ALIGNED		0x1000	/* data-position of a page */
+#define FIT_RD_UNALIGNED	0x4004
+#define FIT_RD_LOAD		0x200000
+#define FIT_FDT_POS		0x8000
+#define FIT_FDT_LOAD		0x300000
+
+/* Add an image node whose data is after the FIT, at @pos */
+static int fit_test_image(void *fit, const char *name, const char *type,
+			  int pos, const void *data, int size, ulong load)
+{
+	int ret;
+
+	ret = fdt_begin_node(fit, name);
+	ret |= fdt_property_string(fit, FIT_TYPE_PROP, type);
+	ret |= fdt_property_string(fit, FIT_OS_PROP, "linux");
+	ret |= fdt_property_string(fit, FIT_ARCH_PROP, "sandbox");
+	ret |= fdt_property_string(fit, FIT_COMP_PROP, "none");
+	ret |= fdt_property_u32(fit, FIT_LOAD_PROP, load);
+	ret |= fdt_property_u32(fit, FIT_DATA_POSITION_PROP, pos);
+	ret |= fdt_property_u32(fit, FIT_DATA_SIZE_PROP, size);
+	ret |= fdt_begin_node(fit, "hash@1");
+	ret |= fdt_property_string(fit, FIT_ALGO_PROP, "crc32");
+	ret |= fdt_property_u32(fit, FIT_VALUE_PROP, crc32(0, data, size));
+	ret |= fdt_end_node(fit);
+	ret |= fdt_end_node(fit);
+
+	return ret;
+}
+
+/* Build a FIT with external data: two ramdisks and a device tree */
+static int fit_test_blob(void *fit)
+{
+	char *rd = fit + FIT_RD_ALIGNED, *fdt = fit + FIT_FDT_POS;
+	int ret, i;
+
+	for (i = 0; i < FIT_RD_SIZE; i++)
+		rd[i] = i * 7;
+	memcpy(fit + FIT_RD_UNALIGNED, rd, FIT_RD_SIZE);
+	ret = fdt_create_empty_tree(fdt, 0x100);
+
+	ret |= fdt_create(fit, FIT_RD_ALIGNED);
+	ret |= fdt_finish_reservemap(fit);
+	ret |= fdt_begin_node(fit, "");
+	ret |= fdt_property_string(fit, FIT_DESC_PROP, "FIT in place test");
+	ret |= fdt_property_u32(fit, FIT_TIMESTAMP_PROP, 0);
+	ret |= fdt_begin_node(fit, FIT_IMAGES_PATH + 1);
+	ret |= fit_test_image(fit, "ramdisk@1", "ramdisk", FIT_RD_ALIGNED, rd,
+			      FIT_RD_SIZE, FIT_RD_LOAD);
+	ret |= fit_test_image(fit, "ramdisk@2", "ramdisk", FIT_RD_UNALIGNED, rd,
+			      FIT_RD_SIZE, FIT_RD_LOAD);
+	ret |= fit_test_image(fit, "fdt@1", "flat_dt", FIT_FDT_POS, fdt,
+			      fdt_totalsize(fdt), FIT_FDT_LOAD);
+	ret |= fdt_end_node(fit);
+	ret |= fdt_end_node(fit);
+	ret |= fdt_finish(fit);
+
+	return ret ? -EINVAL : 0;
+}
+
+static int fit_test_load(bootm_headers_t *images, const char *name, int type,
+			 ulong *datap)
+{
+	ulong len;
+
+	return fit_image_load(images, FIT_ADDR, &name, NULL, IH_ARCH_SANDBOX,
+			      type, BOOTSTAGE_ID_FIT_RD_START,
+			      FIT_LOAD_OPTIONAL_NON_ZERO, datap, &len);
+}
+
+/* Check the bytes copied so far for an image type */
+static int fit_test_copied(struct unit_test_state *uts, const char *name,
+			   uint count, uint64_t bytes)
+{
+#ifdef CONFIG_BOOTSTAGE_PROFILE
+	struct bootstage_prof prof;
+
+	ut_assertok(bootstage_prof_get(BOOTSTAGE_PROF_COPY, name, &prof));
+	ut_asserteq(count, prof.count);
+	ut_asserteq(bytes, prof.bytes);
+#endif
+
+	return 0;
+}
+
+/* Check that FIT subimages are used in place when they can be */
+static int lib_test_fit_in_place(struct unit_test_state *uts)
+{
+	struct bootstage_prof old = { 0 };
+	bootm_headers_t images;
+	void *fit;
+	char *rd;
+	ulong data, size;
+
+	fit = map_sysmem(FIT_ADDR, FIT_SIZE);
+	ut_assertok(fit_test_blob(fit));
+	rd = fit + FIT_RD_ALIGNED;
+
+	memset(&images, '\0', sizeof(images));
+	images.verify = 1;
+	lmb_init(&images.lmb);
+	lmb_add(&images.lmb, 0, gd->ram_size);
+#ifdef CONFIG_BOOTSTAGE_PROFILE
+	bootstage_prof_get(BOOTSTAGE_PROF_COPY, "ramdisk", &old);
+#endif
+
+	/* Aligned data is used where it is, and then reserved */
+	ut_assert(fit_test_load(&images, "ramdisk@1", IH_TYPE_RAMDISK,
+				&data) > 0);
+	ut_asserteq(FIT_ADDR + FIT_RD_ALIGNED, data);
+	ut_assert(lmb_is_reserved(&images.lmb, data + FIT_RD_SIZE - 1));
+	ut_assertok(fit_test_copied(uts, "ramdisk", old.count + 1, old.bytes));
+
+	/* Reserved or unaligned data is copied */
+	ut_assert(fit_test_load(&images, "ramdisk@1", IH_TYPE_RAMDISK,
+				&data) > 0);
+	ut_asserteq(FIT_RD_LOAD, data);
+	ut_assert(fit_test_load(&images, "ramdisk@2", IH_TYPE_RAMDISK,
+				&data) > 0);
+	ut_asserteq(FIT_RD_LOAD, data);
+	ut_assertok(memcmp(map_sysmem(data, FIT_RD_SIZE), rd, FIT_RD_SIZE));
+	ut_assertok(fit_test_copied(uts, "ramdisk", old.count + 3,
+				    old.bytes + 2 * FIT_RD_SIZE));
+
+	/* So is data which loading a compressed kernel could overwrite */
+	images.os.load = FIT_ADDR;
+	images.os.comp = IH_COMP_GZIP;
+	ut_assert(fit_test_load(&images, "fdt@1", IH_TYPE_FLATDT, &data) > 0);
+	ut_asserteq(FIT_FDT_LOAD, data);
+	images.os.comp = IH_COMP_NONE;
+	images.os.image_len = FIT_RD_ALIGNED;
+
+	/* A device tree needs room to grow by CONFIG_SYS_FDT_PAD */
+	size = fdt_totalsize(fit + FIT_FDT_POS) + CONFIG_SYS_FDT_PAD;
+	lmb_reserve(&images.lmb, FIT_ADDR + FIT_FDT_POS + size - 1, 1);
+	ut_assert(fit_test_load(&images, "fdt@1", IH_TYPE_FLATDT, &data) > 0);
+	ut_asserteq(FIT_FDT_LOAD, data);
+	lmb_free(&images.lmb, FIT_ADDR + FIT_FDT_POS + size - 1, 1);
+	ut_assert(fit_test_load(&images, "fdt@1", IH_TYPE_FLATDT, &data) > 0);
+	ut_asserteq(FIT_ADDR + FIT_FDT_POS, data);
+	ut_assert(lmb_is_reserved(&images.lmb, data + size - 1));
+
+	/* The hash is still checked */
+	lmb_free(&images.lmb, FIT_ADDR + FIT_RD_ALIGNED, FIT_RD_SIZE);
+	rd[FIT_RD_SIZE - 1] ^= 1;
+	ut_asserteq(-EACCES, fit_test_load(&images, "ramdisk@1",
+					   IH_TYPE_RAMDISK, &data));
+	unmap_sysmem(fit);
+
+	return 0;
+}
+LIB_TEST(lib_test_fit_in_place, 0);
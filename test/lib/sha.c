@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <hash.h>
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/ut.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+
+#define SHA_TEST_SIZE	4096
+#define SHA_BENCH_SIZE	(8 << 20)
+
+static const struct {
+	const char *name;
+	void (*sha1)(sha1_context *ctx, const unsigned char *data,
+		     unsigned int blocks);
+	void (*sha256)(sha256_context *ctx, const uint8_t *data,
+		       unsigned int blocks);
+} sha_backends[] = {
+	{ "reference", sha1_blocks_ref, sha256_blocks_ref },
+	{ "unrolled", sha1_blocks_unrolled, sha256_blocks_unrolled },
+#ifdef CONFIG_SHA_SIMD
+	{ "simd", sha1_blocks_simd, sha256_blocks_simd },
+#endif
+};
+
+static const struct {
+	const char *msg;
+	uint8_t sha1[SHA1_SUM_LEN];
+	uint8_t sha256[SHA256_SUM_LEN];
+} sha_vectors[] = {
+	{
+		"abc",
+		{ 0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a,
+		  0xba, 0x3e, 0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c,
+		  0x9c, 0xd0, 0xd8, 0x9d },
+		{ 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+		  0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+		  0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+		  0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad },
+	}, {
+		"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+		{ 0x84, 0x98, 0x3e, 0x44, 0x1c, 0x3b, 0xd2, 0x6e,
+		  0xba, 0xae, 0x4a, 0xa1, 0xf9, 0x51, 0x29, 0xe5,
+		  0xe5, 0x46, 0x70, 0xf1 },
+		{ 0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8,
+		  0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+		  0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67,
+		  0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1 },
+	},
+};
+
+static void sha_fill(unsigned char *buf, ulong size)
+{
+	u32 seed = 1;
+	ulong i;
+
+	for (i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+		buf[i] = seed >> 16;
+	}
+}
+
+/* Hash the whole blocks of @data with backend @i, the rest as usual */
+static void sha1_backend(int i, const unsigned char *data, uint len,
+			 uint8_t *out)
+{
+	sha1_context ctx;
+
+	sha1_starts(&ctx);
+	sha_backends[i].sha1(&ctx, data, len / 64);
+	ctx.total[0] = len & ~63;
+	sha1_update(&ctx, data + (len & ~63), len & 63);
+	sha1_finish(&ctx, out);
+}
+
+static void sha256_backend(int i, const uint8_t *data, uint len,
+			   uint8_t *out)
+{
+	sha256_context ctx;
+
+	sha256_starts(&ctx);
+	sha_backends[i].sha256(&ctx, data, len / 64);
+	ctx.total[0] = len & ~63;
+	sha256_update(&ctx, data + (len & ~63), len & 63);
+	sha256_finish(&ctx, out);
+}
+
+/* Test the hashes of known messages, through the hash_algo table */
+static int lib_test_sha_vectors(struct unit_test_state *uts)
+{
+	uint8_t out[HASH_MAX_DIGEST_SIZE];
+	const char *msg;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(sha_vectors); i++) {
+		msg = sha_vectors[i].msg;
+		ut_assertok(hash_block("sha1", msg, strlen(msg), out, NULL));
+		ut_assertok(memcmp(sha_vectors[i].sha1, out, SHA1_SUM_LEN));
+		ut_assertok(hash_block("sha256", msg, strlen(msg), out,
+				       NULL));
+		ut_assertok(memcmp(sha_vectors[i].sha256, out,
+				   SHA256_SUM_LEN));
+	}
+
+	return 0;
+}
+LIB_TEST(lib_test_sha_vectors, 0);
+
+/* Test each backend against the reference, aligned and not */
+static int lib_test_sha_backends(struct unit_test_state *uts)
+{
+	static const uint lens[] = { 0, 1, 55, 56, 63, 64, 65, 127, 128,
+				     1000, SHA_TEST_SIZE - 1 };
+	uint8_t expect[HASH_MAX_DIGEST_SIZE], out[HASH_MAX_DIGEST_SIZE];
+	unsigned char *buf, *data;
+	int i, j, offset;
+
+#ifdef CONFIG_SHA_SIMD
+	ut_assert(sha_simd_usable());
+#endif
+	buf = malloc(SHA_TEST_SIZE);
+	ut_assertnonnull(buf);
+	sha_fill(buf, SHA_TEST_SIZE);
+
+	for (offset = 0; offset < 2; offset++) {
+		data = buf + offset;
+		for (j = 0; j < ARRAY_SIZE(lens); j++) {
+			sha1_csum_wd(data, lens[j], expect, CHUNKSZ_SHA1);
+			for (i = 0; i < ARRAY_SIZE(sha_backends); i++) {
+				sha1_backend(i, data, lens[j], out);
+				ut_assertok(memcmp(expect, out, SHA1_SUM_LEN));
+			}
+			sha256_csum_wd(data, lens[j], expect, CHUNKSZ_SHA256);
+			for (i = 0; i < ARRAY_SIZE(sha_backends); i++) {
+				sha256_backend(i, data, lens[j], out);
+				ut_assertok(memcmp(expect, out,
+						   SHA256_SUM_LEN));
+			}
+		}
+	}
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_sha_backends, 0);
+
+/* Time each backend on a large buffer */
+static int lib_test_sha_bench(struct unit_test_state *uts)
+{
+	uint8_t expect[2][HASH_MAX_DIGEST_SIZE], out[HASH_MAX_DIGEST_SIZE];
+	unsigned char *buf;
+	ulong start, us[2];
+	int i;
+
+	buf = malloc(SHA_BENCH_SIZE);
+	ut_assertnonnull(buf);
+	sha_fill(buf, SHA_BENCH_SIZE);
+
+	for (i = 0; i < ARRAY_SIZE(sha_backends); i++) {
+		start = timer_get_us();
+		sha1_backend(i, buf, SHA_BENCH_SIZE, out);
+		us[0] = max(timer_get_us() - start, 1UL);
+		if (!i)
+			memcpy(expect[0], out, SHA1_SUM_LEN);
+		ut_assertok(memcmp(expect[0], out, SHA1_SUM_LEN));
+
+		start = timer_get_us();
+		sha256_backend(i, buf, SHA_BENCH_SIZE, out);
+		us[1] = max(timer_get_us() - start, 1UL);
+		if (!i)
+			memcpy(expect[1], out, SHA256_SUM_LEN);
+		ut_assertok(memcmp(expect[1], out, SHA256_SUM_LEN));
+
+		printf("%-10s sha1 %lu MB/s, sha256 %lu MB/s\n",
+		       sha_backends[i].name, SHA_BENCH_SIZE / us[0],
+		       SHA_BENCH_SIZE / us[1]);
+	}
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_sha_bench, 0);
@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <image-sparse.h>
+#include <malloc.h>
+#include <sparse_format.h>
+#include <test/lib.h>
+#include <test/ut.h>
+
+#define SPARSE_BLKSZ		512
+#define SPARSE_BLKS		32
+#define SPARSE_ERASE_GRP	4
+#define SPARSE_STALE		0xaaaaaaaa
+#define SPARSE_PATTERN		0xdeadbeef
+
+/* In-memory storage which records the operations done on it */
+struct sparse_test_dev {
+	u8 data[SPARSE_BLKS * SPARSE_BLKSZ];
+	int writes;
+	int erases;
+	lbaint_t written;
+	lbaint_t erased;
+};
+
+static lbaint_t sparse_test_write(struct sparse_storage *info,
+				  lbaint_t blk, lbaint_t blkcnt,
+				  const void *buffer)
+{
+	struct sparse_test_dev *dev = info->priv;
+
+	if (blk + blkcnt > SPARSE_BLKS)
+		return 0;
+	memcpy(dev->data + blk * SPARSE_BLKSZ, buffer, blkcnt * SPARSE_BLKSZ);
+	dev->writes++;
+	dev->written += blkcnt;
+
+	return blkcnt;
+}
+
+static lbaint_t sparse_test_reserve(struct sparse_storage *info,
+				    lbaint_t blk, lbaint_t blkcnt)
+{
+	return blkcnt;
+}
+
+static lbaint_t sparse_test_erase(struct sparse_storage *info,
+				  lbaint_t blk, lbaint_t blkcnt)
+{
+	struct sparse_test_dev *dev = info->priv;
+
+	/* A real device would erase whole groups, so reject partial ones */
+	if (blk % SPARSE_ERASE_GRP || blkcnt % SPARSE_ERASE_GRP ||
+	    blk + blkcnt > SPARSE_BLKS)
+		return 0;
+	memset(dev->data + blk * SPARSE_BLKSZ, '\0', blkcnt * SPARSE_BLKSZ);
+	dev->erases++;
+	dev->erased += blkcnt;
+
+	return blkcnt;
+}
+
+static void *sparse_add_chunk(sparse_header_t *hdr, void **pos, u16 type,
+			      u32 blks, u32 data_sz)
+{
+	chunk_header_t *chunk = *pos;
+
+	chunk->chunk_type = type;
+	chunk->reserved1 = 0;
+	chunk->chunk_sz = blks;
+	chunk->total_sz = sizeof(*chunk) + data_sz;
+	*pos += chunk->total_sz;
+	hdr->total_chunks++;
+	hdr->total_blks += blks;
+
+	return chunk + 1;
+}
+
+static void sparse_add_raw(sparse_header_t *hdr, void **pos, u32 blks,
+			   u8 val)
+{
+	void *data = sparse_add_chunk(hdr, pos, CHUNK_TYPE_RAW, blks,
+				      blks * SPARSE_BLKSZ);
+
+	memset(data, val, blks * SPARSE_BLKSZ);
+}
+
+static void sparse_add_fill(sparse_header_t *hdr, void **pos, u32 blks,
+			    u32 val)
+{
+	u32 *data = sparse_add_chunk(hdr, pos, CHUNK_TYPE_FILL, blks,
+				     sizeof(val));
+
+	*data = val;
+}
+
+/*
+ * Build the test image:
+ *   blocks  0-1   RAW 0x11
+ *   blocks  2-4   RAW 0x22 (merged with the previous chunk)
+ *   blocks  5-14  FILL 0
+ *   blocks 15-18  FILL 0xdeadbeef
+ *   blocks 19-26  DONT_CARE
+ *   block  27     RAW 0x33
+ *   blocks 28-29  FILL 0xdeadbeef
+ */
+static int sparse_build_image(void *buf)
+{
+	sparse_header_t *hdr = buf;
+	void *pos = hdr + 1;
+
+	memset(hdr, '\0', sizeof(*hdr));
+	hdr->magic = SPARSE_HEADER_MAGIC;
+	hdr->major_version = 1;
+	hdr->file_hdr_sz = sizeof(*hdr);
+	hdr->chunk_hdr_sz = sizeof(chunk_header_t);
+	hdr->blk_sz = SPARSE_BLKSZ;
+
+	sparse_add_raw(hdr, &pos, 2, 0x11);
+	sparse_add_raw(hdr, &pos, 3, 0x22);
+	sparse_add_fill(hdr, &pos, 10, 0);
+	sparse_add_fill(hdr, &pos, 4, SPARSE_PATTERN);
+	sparse_add_chunk(hdr, &pos, CHUNK_TYPE_DONT_CARE, 8, 0);
+	sparse_add_raw(hdr, &pos, 1, 0x33);
+	sparse_add_fill(hdr, &pos, 2, SPARSE_PATTERN);
+
+	return pos - buf;
+}
+
+static bool sparse_blocks_are(struct sparse_test_dev *dev, lbaint_t blk,
+			      lbaint_t blkcnt, u32 val)
+{
+	u32 *word = (u32 *)(dev->data + blk * SPARSE_BLKSZ);
+	int i;
+
+	for (i = 0; i < blkcnt * SPARSE_BLKSZ / sizeof(*word); i++) {
+		if (word[i] != val)
+			return false;
+	}
+
+	return true;
+}
+
+static int sparse_test_setup(struct sparse_storage *info,
+			     struct sparse_test_dev *dev, bool erase)
+{
+	memset(dev, '\0', sizeof(*dev));
+	memset(dev->data, 0xaa, sizeof(dev->data));
+
+	memset(info, '\0', sizeof(*info));
+	info->blksz = SPARSE_BLKSZ;
+	info->start = 0;
+	info->size = SPARSE_BLKS;
+	info->priv = dev;
+	info->write = sparse_test_write;
+	info->reserve = sparse_test_reserve;
+	if (erase) {
+		info->erase = sparse_test_erase;
+		info->erase_grp = SPARSE_ERASE_GRP;
+		info->erase_zeroes = true;
+	}
+
+	return 0;
+}
+
+/* Check the output and operation counts with an erase-capable device */
+static int lib_test_sparse_erase(struct unit_test_state *uts)
+{
+	struct sparse_test_dev *dev;
+	struct sparse_storage info;
+	void *img;
+	int size;
+
+	dev = malloc(sizeof(*dev));
+	img = malloc(SPARSE_BLKS * SPARSE_BLKSZ * 2);
+	ut_assertnonnull(dev);
+	ut_assertnonnull(img);
+
+	sparse_test_setup(&info, dev, true);
+	size = sparse_build_image(img);
+	ut_assertok(write_sparse_image(&info, "test", img, size));
+
+	ut_assert(sparse_blocks_are(dev, 0, 2, 0x11111111));
+	ut_assert(sparse_blocks_are(dev, 2, 3, 0x22222222));
+	ut_assert(sparse_blocks_are(dev, 5, 10, 0));
+	ut_assert(sparse_blocks_are(dev, 15, 4, SPARSE_PATTERN));
+	ut_assert(sparse_blocks_are(dev, 19, 1, SPARSE_STALE));
+	ut_assert(sparse_blocks_are(dev, 20, 4, 0));
+	ut_assert(sparse_blocks_are(dev, 24, 3, SPARSE_STALE));
+	ut_assert(sparse_blocks_are(dev, 27, 1, 0x33333333));
+	ut_assert(sparse_blocks_are(dev, 28, 2, SPARSE_PATTERN));
+	ut_assert(sparse_blocks_are(dev, 30, 2, SPARSE_STALE));
+
+	/*
+	 * One write for the merged RAW run, two for the unaligned ends of
+	 * the zero FILL, one per pattern FILL and one for the last RAW.
+	 * The aligned middles of the zero FILL and DONT_CARE are erased.
+	 */
+	ut_asserteq(6, dev->writes);
+	ut_asserteq(18, dev->written);
+	ut_asserteq(2, dev->erases);
+	ut_asserteq(8, dev->erased);
+
+	free(img);
+	free(dev);
+
+	return 0;
+}
+LIB_TEST(lib_test_sparse_erase, 0);
+
+/* Without an erase callback everything is written, DONT_CARE is skipped */
+static int lib_test_sparse_write(struct unit_test_state *uts)
+{
+	struct sparse_test_dev *dev;
+	struct sparse_storage info;
+	void *img;
+	int size;
+
+	dev = malloc(sizeof(*dev));
+	img = malloc(SPARSE_BLKS * SPARSE_BLKSZ * 2);
+	ut_assertnonnull(dev);
+	ut_assertnonnull(img);
+
+	sparse_test_setup(&info, dev, false);
+	size = sparse_build_image(img);
+	ut_assertok(write_sparse_image(&info, "test", img, size));
+
+	ut_assert(sparse_blocks_are(dev, 0, 2, 0x11111111));
+	ut_assert(sparse_blocks_are(dev, 2, 3, 0x22222222));
+	ut_assert(sparse_blocks_are(dev, 5, 10, 0));
+	ut_assert(sparse_blocks_are(dev, 15, 4, SPARSE_PATTERN));
+	ut_assert(sparse_blocks_are(dev, 19, 8, SPARSE_STALE));
+	ut_assert(sparse_blocks_are(dev, 27, 1, 0x33333333));
+	ut_assert(sparse_blocks_are(dev, 28, 2, SPARSE_PATTERN));
+	ut_assert(sparse_blocks_are(dev, 30, 2, SPARSE_STALE));
+
+	ut_asserteq(5, dev->writes);
+	ut_asserteq(22, dev->written);
+	ut_asserteq(0, dev->erases);
+
+	free(img);
+	free(dev);
+
+	return 0;
+}
+LIB_TEST(lib_test_sparse_write, 0);
+
+/* A truncated image is rejected before anything past the end is used */
+static int lib_test_sparse_truncated(struct unit_test_state *uts)
+{
+	struct sparse_test_dev *dev;
+	struct sparse_storage info;
+	void *img;
+	int size;
+
+	dev = malloc(sizeof(*dev));
+	img = malloc(SPARSE_BLKS * SPARSE_BLKSZ * 2);
+	ut_assertnonnull(dev);
+	ut_assertnonnull(img);
+
+	sparse_test_setup(&info, dev, false);
+	size = sparse_build_image(img);
+	ut_assert(write_sparse_image(&info, "test", img, size - 1) < 0);
+
+	free(img);
+	free(dev);
+
+	return 0;
+}
+LIB_TEST(lib_test_sparse_truncated, 0);
+
+/* The image is left as it was, so it can be flashed again */
+static int lib_test_sparse_twice(struct unit_test_state *uts)
+{
+	struct sparse_test_dev *dev;
+	struct sparse_storage info;
+	void *img, *copy;
+	int size;
+
+	dev = malloc(sizeof(*dev));
+	img = malloc(SPARSE_BLKS * SPARSE_BLKSZ * 2);
+	copy = malloc(SPARSE_BLKS * SPARSE_BLKSZ * 2);
+	ut_assertnonnull(dev);
+	ut_assertnonnull(img);
+	ut_assertnonnull(copy);
+
+	size = sparse_build_image(img);
+	memcpy(copy, img, size);
+	sparse_test_setup(&info, dev, false);
+	ut_assertok(write_sparse_image(&info, "test", img, size));
+	ut_assert(!memcmp(copy, img, size));
+
+	sparse_test_setup(&info, dev, false);
+	ut_assertok(write_sparse_image(&info, "test", img, size));
+	ut_assert(sparse_blocks_are(dev, 0, 2, 0x11111111));
+	ut_assert(sparse_blocks_are(dev, 2, 3, 0x22222222));
+	ut_assert(sparse_blocks_are(dev, 27, 1, 0x33333333));
+	ut_asserteq(5, dev->writes);
+
+	free(copy);
+	free(img);
+	free(dev);
+
+	return 0;
+}
+LIB_TEST(lib_test_sparse_twice, 0);
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <image-stream.h>
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/ut.h>
+
+#define STREAM_BLKSZ		512
+#define STREAM_BLKS		32
+#define STREAM_START		4
+#define STREAM_CHUNK		(4 * STREAM_BLKSZ)
+#define STREAM_PACKET		512
+#define STREAM_STALE		0xaa
+
+/* In-memory storage which records the writes done on it */
+struct stream_test_dev {
+	u8 data[STREAM_BLKS * STREAM_BLKSZ];
+	int writes;
+	lbaint_t written;
+};
+
+static lbaint_t stream_test_write(struct stream_storage *info,
+				  lbaint_t blk, lbaint_t blkcnt,
+				  const void *buffer)
+{
+	struct stream_test_dev *dev = info->priv;
+
+	if (blk + blkcnt > STREAM_BLKS)
+		return 0;
+	memcpy(dev->data + blk * STREAM_BLKSZ, buffer, blkcnt * STREAM_BLKSZ);
+	dev->writes++;
+	dev->written += blkcnt;
+
+	return blkcnt;
+}
+
+static void stream_test_setup(struct stream_storage *info,
+			      struct stream_test_dev *dev, lbaint_t size)
+{
+	memset(dev, '\0', sizeof(*dev));
+	memset(dev->data, STREAM_STALE, sizeof(dev->data));
+
+	memset(info, '\0', sizeof(*info));
+	info->blksz = STREAM_BLKSZ;
+	info->start = STREAM_START;
+	info->size = size;
+	info->priv = dev;
+	info->write = stream_test_write;
+}
+
+/*
+ * Receive @img in packets as a USB gadget would, writing out each full
+ * chunk after moving on to the other buffer, and return the first error
+ */
+static int stream_test_run(struct unit_test_state *uts,
+			   struct image_stream *stream, const u8 *img,
+			   unsigned int size)
+{
+	unsigned int pos, len, room, chunk_len;
+	void *chunk, *next;
+	int ret = 0;
+
+	for (pos = 0; pos < size; pos += len) {
+		next = image_stream_next(stream, &room);
+		len = min3(size - pos, room, (unsigned int)STREAM_PACKET);
+		memcpy(next, img + pos, len);
+		chunk = image_stream_rx(stream, len, pos + len == size,
+					&chunk_len);
+		if (!chunk)
+			continue;
+
+		/* The next data goes to the other buffer */
+		next = image_stream_next(stream, &room);
+		ut_asserteq(STREAM_CHUNK, room);
+		ut_assert(next != chunk);
+		ut_assert(next == stream->buf || next == stream->buf +
+			  STREAM_CHUNK);
+		ut_assert(chunk == stream->buf || chunk == stream->buf +
+			  STREAM_CHUNK);
+		if (!ret)
+			ret = image_stream_write(stream, chunk, chunk_len);
+		else
+			ut_asserteq(ret, image_stream_write(stream, chunk,
+							    chunk_len));
+	}
+
+	return ret;
+}
+
+/* Test that an image is written chunk by chunk from two buffers */
+static int lib_test_stream_write(struct unit_test_state *uts)
+{
+	struct stream_test_dev *dev;
+	struct stream_storage info;
+	struct image_stream stream;
+	unsigned int size;
+	void *buf;
+	u8 *img;
+	int i;
+
+	dev = malloc(sizeof(*dev));
+	buf = malloc(2 * STREAM_CHUNK);
+	img = malloc(STREAM_BLKS * STREAM_BLKSZ);
+	ut_assertnonnull(dev);
+	ut_assertnonnull(buf);
+	ut_assertnonnull(img);
+
+	/* Five chunks and a bit, ending in a partial block */
+	size = 5 * STREAM_CHUNK + STREAM_BLKSZ + 100;
+	for (i = 0; i < size; i++)
+		img[i] = i * 7 + i / STREAM_BLKSZ;
+
+	stream_test_setup(&info, dev, STREAM_BLKS - STREAM_START);
+	image_stream_init(&stream, &info, buf, STREAM_CHUNK);
+	ut_assertok(stream_test_run(uts, &stream, img, size));
+
+	ut_asserteq(6, dev->writes);
+	ut_asserteq(22, dev->written);
+	ut_asserteq(22 * STREAM_BLKSZ, image_stream_written(&stream));
+	ut_assert(!memcmp(img, dev->data + STREAM_START * STREAM_BLKSZ,
+			  size));
+	for (i = 0; i < STREAM_START * STREAM_BLKSZ; i++)
+		ut_asserteq(STREAM_STALE, dev->data[i]);
+	for (i = (STREAM_START + 22) * STREAM_BLKSZ; i < sizeof(dev->data);
+	     i++)
+		ut_asserteq(STREAM_STALE, dev->data[i]);
+
+	free(img);
+	free(buf);
+	free(dev);
+
+	return 0;
+}
+LIB_TEST(lib_test_stream_write, 0);
+
+/* Test that nothing is written past the end of the storage */
+static int lib_test_stream_too_large(struct unit_test_state *uts)
+{
+	struct stream_test_dev *dev;
+	struct stream_storage info;
+	struct image_stream stream;
+	void *buf;
+	u8 *img;
+	int i;
+
+	dev = malloc(sizeof(*dev));
+	buf = malloc(2 * STREAM_CHUNK);
+	img = malloc(STREAM_BLKS * STREAM_BLKSZ);
+	ut_assertnonnull(dev);
+	ut_assertnonnull(buf);
+	ut_assertnonnull(img);
+	memset(img, 0x55, STREAM_BLKS * STREAM_BLKSZ);
+
+	/* Room for two and a half chunks, but three are sent */
+	stream_test_setup(&info, dev, 10);
+	image_stream_init(&stream, &info, buf, STREAM_CHUNK);
+	ut_asserteq(-EFBIG, stream_test_run(uts, &stream, img,
+					    3 * STREAM_CHUNK));
+
+	ut_asserteq(2, dev->writes);
+	ut_asserteq(8, dev->written);
+	ut_asserteq(8 * STREAM_BLKSZ, image_stream_written(&stream));
+	for (i = (STREAM_START + 8) * STREAM_BLKSZ; i < sizeof(dev->data);
+	     i++)
+		ut_asserteq(STREAM_STALE, dev->data[i]);
+
+	free(img);
+	free(buf);
+	free(dev);
+
+	return 0;
+}
+LIB_TEST(lib_test_stream_too_large, 0);
@@ -0,0 +1,333 @@
+/*
+ * Tests for applying a list of device tree overlays
+ *
+ * Copyright (C) 2017 Nexell Co., Ltd.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <fdt_support.h>
+#include <malloc.h>
+
+#include <linux/sizes.h>
+
+#include <test/ut.h>
+#include <test/overlay.h>
+
+#define LIST_COPY_SIZE		(4 * SZ_1K)
+#define LIST_BENCH_SIZE		(512 * SZ_1K)
+#define LIST_BENCH_OVL_SIZE	(16 * SZ_1K)
+#define LIST_BENCH_NODES	2000
+#define LIST_BENCH_OVERLAYS	8
+#define LIST_BENCH_FRAGMENTS	16
+
+extern u32 __dtb_test_fdt_base_begin;
+extern u32 __dtb_test_fdt_overlay_begin;
+extern u32 __dtb_test_fdt_overlay_stacked_begin;
+
+/* libfdt leaves whatever was there in the padding after a property value */
+static void list_zero_padding(void *blob)
+{
+	const struct fdt_property *prop;
+	int offset = 0, next, len;
+	uint32_t tag;
+
+	do {
+		tag = fdt_next_tag(blob, offset, &next);
+		if (tag == FDT_PROP) {
+			prop = fdt_get_property_by_offset(blob, offset, &len);
+			memset((char *)prop->data + len, '\0',
+			       next - offset - sizeof(*prop) - len);
+		}
+		offset = next;
+	} while (tag != FDT_END);
+}
+
+static u32 list_phandle(void *fdt, const char *path)
+{
+	return fdt_get_phandle(fdt, fdt_path_offset(fdt, path));
+}
+
+static u32 list_getprop_u32(void *fdt, const char *path, const char *name,
+			    int index)
+{
+	const fdt32_t *val;
+	int len;
+
+	val = fdt_getprop(fdt, fdt_path_offset(fdt, path), name, &len);
+	if (!val || len < sizeof(*val) * (index + 1))
+		return 0;
+
+	return fdt32_to_cpu(val[index]);
+}
+
+/* Check that a list gives the same tree as applying each overlay in turn */
+static int fdt_overlay_list_same(struct unit_test_state *uts)
+{
+	void *ovl[2], *seq, *list;
+	u32 phandle;
+	int node, i;
+
+	seq = malloc(LIST_COPY_SIZE);
+	list = malloc(LIST_COPY_SIZE);
+	ovl[0] = malloc(LIST_COPY_SIZE);
+	ovl[1] = malloc(LIST_COPY_SIZE);
+	ut_assertnonnull(seq);
+	ut_assertnonnull(list);
+	ut_assertnonnull(ovl[0]);
+	ut_assertnonnull(ovl[1]);
+
+	ut_assertok(fdt_open_into(&__dtb_test_fdt_base_begin, seq,
+				  LIST_COPY_SIZE));
+	ut_assertok(fdt_open_into(&__dtb_test_fdt_base_begin, list,
+				  LIST_COPY_SIZE));
+	for (i = 0; i < 2; i++) {
+		ut_assertok(fdt_open_into(&__dtb_test_fdt_overlay_begin,
+					  ovl[0], LIST_COPY_SIZE));
+		ut_assertok(fdt_open_into(&__dtb_test_fdt_overlay_stacked_begin,
+					  ovl[1], LIST_COPY_SIZE));
+		if (i) {
+			ut_assertok(fdt_overlay_apply_list(list, ovl, 2));
+		} else {
+			ut_assertok(fdt_overlay_apply(seq, ovl[0]));
+			ut_assertok(fdt_overlay_apply(seq, ovl[1]));
+		}
+		ut_asserteq(~0, fdt_magic(ovl[0]));
+		ut_asserteq(~0, fdt_magic(ovl[1]));
+	}
+
+	ut_asserteq(LIST_COPY_SIZE, fdt_totalsize(list));
+	ut_assertok(fdt_pack(seq));
+	ut_assertok(fdt_pack(list));
+	list_zero_padding(seq);
+	ut_asserteq(fdt_totalsize(seq), fdt_totalsize(list));
+	ut_assertok(memcmp(seq, list, fdt_totalsize(seq)));
+
+	/* The second overlay's phandles come after those of the first */
+	phandle = list_phandle(list, "/new-local-node/stacked-node");
+	ut_assert(phandle > list_phandle(list, "/new-local-node"));
+	ut_asserteq(44, list_getprop_u32(list, "/new-local-node",
+					 "stacked-property", 0));
+	ut_asserteq(list_phandle(list, "/test-node/sub-test-node"),
+		    list_getprop_u32(list, "/new-local-node/stacked-node",
+				     "test-phandle", 0));
+	ut_asserteq(phandle, list_getprop_u32(list,
+					      "/new-local-node/stacked-node",
+					      "test-phandle", 1));
+	node = fdt_path_offset(list, "/test-node/sub-test-node");
+	ut_asserteq_str("stacked", fdt_getprop(list, node,
+					       "new-sub-test-property", NULL));
+
+	free(ovl[1]);
+	free(ovl[0]);
+	free(list);
+	free(seq);
+
+	return CMD_RET_SUCCESS;
+}
+OVERLAY_TEST(fdt_overlay_list_same, 0);
+
+/* Check that the tree is left alone if an overlay cannot be applied */
+static int fdt_overlay_list_error(struct unit_test_state *uts)
+{
+	void *ovl[2], *orig, *list;
+
+	orig = malloc(LIST_COPY_SIZE);
+	list = malloc(LIST_COPY_SIZE);
+	ovl[0] = malloc(LIST_COPY_SIZE);
+	ovl[1] = malloc(LIST_COPY_SIZE);
+	ut_assertnonnull(orig);
+	ut_assertnonnull(list);
+	ut_assertnonnull(ovl[0]);
+	ut_assertnonnull(ovl[1]);
+
+	ut_assertok(fdt_open_into(&__dtb_test_fdt_base_begin, orig,
+				  LIST_COPY_SIZE));
+	memcpy(list, orig, LIST_COPY_SIZE);
+	ut_assertok(fdt_open_into(&__dtb_test_fdt_overlay_begin, ovl[0],
+				  LIST_COPY_SIZE));
+	memcpy(ovl[1], ovl[0], LIST_COPY_SIZE);
+	fdt_set_magic(ovl[1], ~0);
+
+	ut_asserteq(-FDT_ERR_BADMAGIC, fdt_overlay_apply_list(list, ovl, 2));
+	ut_assertok(memcmp(orig, list, LIST_COPY_SIZE));
+
+	/* The stacked overlay needs a node added by the first */
+	ut_assertok(fdt_open_into(&__dtb_test_fdt_overlay_stacked_begin,
+				  ovl[0], LIST_COPY_SIZE));
+	ut_asserteq(-FDT_ERR_NOTFOUND, fdt_overlay_apply_list(list, ovl, 1));
+	ut_assertok(memcmp(orig, list, LIST_COPY_SIZE));
+
+	free(ovl[1]);
+	free(ovl[0]);
+	free(list);
+	free(orig);
+
+	return CMD_RET_SUCCESS;
+}
+OVERLAY_TEST(fdt_overlay_list_error, 0);
+
+/* Build a large tree with a symbol and a phandle for each node */
+static int list_bench_base(void *blob)
+{
+	char name[20], path[30];
+	int ret, i;
+
+	ret = fdt_create(blob, LIST_BENCH_SIZE);
+	ret |= fdt_finish_reservemap(blob);
+	ret |= fdt_begin_node(blob, "");
+	ret |= fdt_begin_node(blob, "bus");
+	for (i = 0; i < LIST_BENCH_NODES; i++) {
+		snprintf(name, sizeof(name), "dev@%x", i);
+		ret |= fdt_begin_node(blob, name);
+		ret |= fdt_property_string(blob, "compatible", "test,bench");
+		ret |= fdt_property_string(blob, "status", "disabled");
+		ret |= fdt_property_u32(blob, "phandle", i + 1);
+		ret |= fdt_end_node(blob);
+	}
+	ret |= fdt_end_node(blob);
+	ret |= fdt_begin_node(blob, "__symbols__");
+	for (i = 0; i < LIST_BENCH_NODES; i++) {
+		snprintf(name, sizeof(name), "dev%d", i);
+		snprintf(path, sizeof(path), "/bus/dev@%x", i);
+		ret |= fdt_property_string(blob, name, path);
+	}
+	ret |= fdt_end_node(blob);
+	ret |= fdt_end_node(blob);
+	ret |= fdt_finish(blob);
+
+	return ret ? -EINVAL : 0;
+}
+
+/*
+ * Build an overlay as dtc would for fragments like this, where each 'dev' is
+ * a different node of the base tree:
+ *
+ *	fragment@0 {
+ *		target = <&dev>;
+ *		__overlay__ {
+ *			status = "okay";
+ *			ovl: child-0 {
+ *				links = <&ovl &dev>;
+ *			};
+ *		};
+ *	};
+ */
+static int list_bench_overlay(void *blob, int num)
+{
+	char name[40], fixup[100];
+	fdt32_t links[2];
+	int ret, i, dev, len;
+
+	ret = fdt_create(blob, LIST_BENCH_OVL_SIZE);
+	ret |= fdt_finish_reservemap(blob);
+	ret |= fdt_begin_node(blob, "");
+	for (i = 0; i < LIST_BENCH_FRAGMENTS; i++) {
+		snprintf(name, sizeof(name), "fragment@%d", i);
+		ret |= fdt_begin_node(blob, name);
+		ret |= fdt_property_u32(blob, "target", ~0);
+		ret |= fdt_begin_node(blob, "__overlay__");
+		ret |= fdt_property_string(blob, "status", "okay");
+		snprintf(name, sizeof(name), "child-%d", i);
+		ret |= fdt_begin_node(blob, name);
+		ret |= fdt_property_u32(blob, "phandle", i + 1);
+		links[0] = cpu_to_fdt32(i + 1);
+		links[1] = cpu_to_fdt32(~0);
+		ret |= fdt_property(blob, "links", links, sizeof(links));
+		ret |= fdt_end_node(blob);
+		ret |= fdt_end_node(blob);
+		ret |= fdt_end_node(blob);
+	}
+
+	ret |= fdt_begin_node(blob, "__fixups__");
+	for (i = 0; i < LIST_BENCH_FRAGMENTS; i++) {
+		dev = (num * LIST_BENCH_FRAGMENTS + i) * 7 % LIST_BENCH_NODES;
+		snprintf(name, sizeof(name), "dev%d", dev);
+		len = snprintf(fixup, sizeof(fixup), "/fragment@%d:target:0",
+			       i);
+		len += snprintf(fixup + len + 1, sizeof(fixup) - len - 1,
+				"/fragment@%d/__overlay__/child-%d:links:4", i,
+				i);
+		ret |= fdt_property(blob, name, fixup, len + 2);
+	}
+	ret |= fdt_end_node(blob);
+
+	ret |= fdt_begin_node(blob, "__local_fixups__");
+	for (i = 0; i < LIST_BENCH_FRAGMENTS; i++) {
+		snprintf(name, sizeof(name), "fragment@%d", i);
+		ret |= fdt_begin_node(blob, name);
+		ret |= fdt_begin_node(blob, "__overlay__");
+		snprintf(name, sizeof(name), "child-%d", i);
+		ret |= fdt_begin_node(blob, name);
+		ret |= fdt_property_u32(blob, "links", 0);
+		ret |= fdt_end_node(blob);
+		ret |= fdt_end_node(blob);
+		ret |= fdt_end_node(blob);
+	}
+	ret |= fdt_end_node(blob);
+
+	ret |= fdt_end_node(blob);
+	ret |= fdt_finish(blob);
+
+	return ret ? -EINVAL : 0;
+}
+
+/* Compare applying overlays in turn with applying them as a list */
+static int fdt_overlay_list_bench(struct unit_test_state *uts)
+{
+	void *ovl[LIST_BENCH_OVERLAYS], *orig[LIST_BENCH_OVERLAYS];
+	ulong seq_us, list_us;
+	void *base, *seq, *list;
+	int i;
+
+	base = malloc(LIST_BENCH_SIZE);
+	seq = malloc(LIST_BENCH_SIZE);
+	list = malloc(LIST_BENCH_SIZE);
+	ut_assertnonnull(base);
+	ut_assertnonnull(seq);
+	ut_assertnonnull(list);
+	ut_assertok(list_bench_base(base));
+	for (i = 0; i < LIST_BENCH_OVERLAYS; i++) {
+		orig[i] = malloc(LIST_BENCH_OVL_SIZE);
+		ovl[i] = malloc(LIST_BENCH_OVL_SIZE);
+		ut_assertnonnull(orig[i]);
+		ut_assertnonnull(ovl[i]);
+		ut_assertok(list_bench_overlay(orig[i], i));
+	}
+
+	ut_assertok(fdt_open_into(base, seq, LIST_BENCH_SIZE));
+	for (i = 0; i < LIST_BENCH_OVERLAYS; i++)
+		memcpy(ovl[i], orig[i], LIST_BENCH_OVL_SIZE);
+	seq_us = timer_get_us();
+	for (i = 0; i < LIST_BENCH_OVERLAYS; i++)
+		ut_assertok(fdt_overlay_apply(seq, ovl[i]));
+	seq_us = timer_get_us() - seq_us;
+
+	ut_assertok(fdt_open_into(base, list, LIST_BENCH_SIZE));
+	for (i = 0; i < LIST_BENCH_OVERLAYS; i++)
+		memcpy(ovl[i], orig[i], LIST_BENCH_OVL_SIZE);
+	list_us = timer_get_us();
+	ut_assertok(fdt_overlay_apply_list(list, ovl, LIST_BENCH_OVERLAYS));
+	list_us = timer_get_us() - list_us;
+
+	ut_assertok(fdt_pack(seq));
+	ut_assertok(fdt_pack(list));
+	list_zero_padding(seq);
+	ut_asserteq(fdt_totalsize(seq), fdt_totalsize(list));
+	ut_assertok(memcmp(seq, list, fdt_totalsize(seq)));
+	printf("%d overlays on %d nodes: in turn %lu us, as a list %lu us\n",
+	       LIST_BENCH_OVERLAYS, LIST_BENCH_NODES, seq_us, list_us);
+
+	for (i = 0; i < LIST_BENCH_OVERLAYS; i++) {
+		free(ovl[i]);
+		free(orig[i]);
+	}
+	free(list);
+	free(seq);
+	free(base);
+
+	return CMD_RET_SUCCESS;
+}
+OVERLAY_TEST(fdt_overlay_list_bench, 0);
@@ -14,6 +14,7 @@ intarray 2 3 4 0
 longbytearray 09 0a 0b 0c 0d 0e 0f 10 11
 string message
 stringarray "multi-word" "message" ""
+clocks
 of-platdata probe:
 bool 0
 byte 08
@@ -23,6 +24,7 @@ intarray 5 0 0 0
 longbytearray 09 00 00 00 00 00 00 00 00
 string message2
 stringarray "another" "multi-word" "message"
+clocks
 of-platdata probe:
 bool 0
 byte 00
@@ -32,6 +34,7 @@ intarray 0 0 0 0
 longbytearray 00 00 00 00 00 00 00 00 00
 string <NULL>
 stringarray "one" "" ""
+clocks 1:7 3:0
 '''
 
 @pytest.mark.buildconfigspec('spl_of_platdata')
@@ -0,0 +1,64 @@
+# Copyright (C) 2017 Nexell Co., Ltd.
+#
+# SPDX-License-Identifier: GPL-2.0
+
+# Test the Nexell USB downloader, "udown". The test starts a download in
+# U-Boot, sends a file of random data from the host with the Nexell download
+# tool, and checks the CRC32 of what was received.
+
+import binascii
+import os
+import os.path
+import pytest
+import struct
+import u_boot_utils
+
+"""
+Note: This test relies on boardenv_* containing the host command which sends
+a file to the board, and optionally the load address and sizes to test.
+Without the host command, this test is skipped. For example:
+
+env__udown_config = {
+    # %s is replaced with the file to send
+    "host_cmd": "usb-downloader -t nxp3220 -f %s",
+    # Optional; the defaults are shown
+    "addr": 0x48000000,
+    "sizes": (1000, 64 * 1024 * 1024 + 123),
+}
+
+The file sent starts with a 512-byte NSIH header, whose word 17 holds the
+size of the data which follows it.
+"""
+
+@pytest.mark.buildconfigspec('cmd_nx_usb_downloader', 'cmd_crc32')
+def test_udown(u_boot_console):
+    """Test the "udown" command with a few download sizes."""
+
+    f = u_boot_console.config.env.get('env__udown_config', None)
+    if not f:
+        pytest.skip('No udown configuration is defined')
+    addr = f.get('addr', 0x48000000)
+    sizes = f.get('sizes', (1000, 64 * 1024 * 1024 + 123))
+
+    fn = u_boot_console.config.persistent_data_dir + '/udown.bin'
+    for size in sizes:
+        data = os.urandom(size)
+        header = struct.pack('<17I', *([0] * 17)) + struct.pack('<I', size)
+        header += b'\0' * (512 - len(header))
+        with open(fn, 'wb') as fh:
+            fh.write(header)
+            fh.write(data)
+        expected_crc32 = '%08x' % (binascii.crc32(data) & 0xffffffff)
+
+        with u_boot_console.temporary_timeout(60 * 1000):
+            u_boot_console.run_command('udown %x' % addr,
+                                       wait_for_prompt=False)
+            u_boot_utils.run_and_log(u_boot_console, f['host_cmd'] % fn)
+            u_boot_console.wait_for('%d bytes in' % size)
+            if u_boot_console.config.buildconfig.get(
+                    'config_usb_gadget_dwc2_nexell_downloader_dma',
+                    'n') == 'y':
+                u_boot_console.wait_for('(dma)')
+
+        response = u_boot_console.run_command('crc32 %x %x' % (addr, size))
+        assert expected_crc32 in response
@@ -227,6 +227,53 @@ class DtbPlatdata:
             return True
         return False
 
+    def GetPhandleArgs(self, prop):
+        """Split a phandle property into the references it contains
+
+        Each reference is a phandle followed by as many argument cells as
+        the target node's '#<name>-cells' property gives, e.g. '#clock-cells'
+        for 'clocks'. A target without that property is assumed to take one
+        argument. struct phandle_2_cell holds a single argument, so targets
+        which take more are not supported.
+
+        Args:
+            prop: Prop object containing phandles
+        Return:
+            List of (Node, argument) tuples, one for each reference. The
+            argument is 0 for a target which takes no arguments.
+        """
+        cells_name = '#%s-cells' % prop.name[:-1]
+        value = prop.value
+        if type(value) != list:
+            value = [value]
+        refs = []
+        i = 0
+        while i < len(value):
+            phandle = fdt_util.fdt32_to_cpu(value[i])
+            if not phandle:
+                # Padding added when widening the property
+                break
+            target_node = self._phandle_node.get(phandle)
+            if not target_node:
+                raise ValueError("Property '%s' refers to phandle %d, which "
+                                 "is not a valid node" % (prop.name, phandle))
+            cells_prop = target_node.props.get(cells_name)
+            if cells_prop:
+                num_args = fdt_util.fdt32_to_cpu(cells_prop.value)
+            else:
+                num_args = 1
+            if num_args > 1:
+                raise ValueError("Node '%s' has %d '%s', only 0 or 1 is "
+                                 "supported" % (target_node.name, num_args,
+                                                cells_name))
+            if num_args and i + 1 < len(value):
+                arg = fdt_util.fdt32_to_cpu(value[i + 1])
+            else:
+                arg = 0
+            refs.append((target_node, arg))
+            i += 1 + num_args
+        return refs
+
     def ScanStructs(self):
         """Scan the device tree building up the C structures we will use.
 
@@ -288,10 +335,15 @@ class DtbPlatdata:
             for pname in sorted(structs[name]):
                 prop = structs[name][pname]
                 if self.IsPhandle(prop):
-                    # For phandles, include a reference to the target
+                    # For phandles, include a reference to the target. Use
+                    # the largest number of references in any node.
+                    count = max([len(self.GetPhandleArgs(node.props[pname]))
+                                 for node in self._valid_nodes
+                                 if self.GetCompatName(node) == name and
+                                 pname in node.props])
                     self.Out('\t%s%s[%d]' % (TabTo(2, 'struct phandle_2_cell'),
                                              Conv_name_to_c(prop.name),
-                                             len(prop.value) / 2))
+                                             count))
                 else:
                     ptype = TYPE_NAMES[prop.type]
                     self.Out('\t%s%s' % (TabTo(2, ptype),
@@ -312,6 +364,15 @@ class DtbPlatdata:
         self.Out('#include <dm.h>\n')
         self.Out('#include <dt-structs.h>\n')
         self.Out('\n')
+
+        # Declare the devices which phandles may refer to, so that they can
+        # be referenced before they are defined
+        for node in self._valid_nodes:
+            if 'phandle' in node.props:
+                self.Out('U_BOOT_DEVICE_DECL(%s);\n' %
+                         Conv_name_to_c(node.name))
+        self.Out('\n')
+
         node_txt_list = []
         for node in self._valid_nodes:
             struct_name = self.GetCompatName(node)
@@ -325,24 +386,22 @@ class DtbPlatdata:
                 member_name = Conv_name_to_c(prop.name)
                 self.Buf('\t%s= ' % TabTo(3, '.' + member_name))
 
+                # For phandles, output a reference to the device declared
+                # for the target node, along with the argument
+                if self.IsPhandle(prop):
+                    vals = []
+                    for target_node, arg in self.GetPhandleArgs(prop):
+                        name = Conv_name_to_c(target_node.name)
+                        vals.append('{U_BOOT_DEVICE_REF(%s), %d}' %
+                                    (name, arg))
+                    self.Buf('{%s}' % ', '.join(vals))
+
                 # Special handling for lists
-                if type(prop.value) == list:
+                elif type(prop.value) == list:
                     self.Buf('{')
                     vals = []
-                    # For phandles, output a reference to the platform data
-                    # of the target node.
-                    if self.IsPhandle(prop):
-                        # Process the list as pairs of (phandle, id)
-                        it = iter(prop.value)
-                        for phandle_cell, id_cell in zip(it, it):
-                            phandle = fdt_util.fdt32_to_cpu(phandle_cell)
-                            id = fdt_util.fdt32_to_cpu(id_cell)
-                            target_node = self._phandle_node[phandle]
-                            name = Conv_name_to_c(target_node.name)
-                            vals.append('{&%s%s, %d}' % (VAL_PREFIX, name, id))
-                    else:
-                        for val in prop.value:
-                            vals.append(self.GetValue(prop.type, val))
+                    for val in prop.value:
+                        vals.append(self.GetValue(prop.type, val))
                     self.Buf(', '.join(vals))
                     self.Buf('}')
                 else:
@@ -359,15 +418,15 @@ class DtbPlatdata:
             self.Buf('};\n')
             self.Buf('\n')
 
-            # Output phandle target nodes first, since they may be referenced
-            # by others
+            # Output phandle target nodes first, so that they are bound
+            # before the devices which refer to them
             if 'phandle' in node.props:
                 self.Out(''.join(self.GetBuf()))
             else:
                 node_txt_list.append(self.GetBuf())
 
         # Output all the nodes which are not phandle targets themselves, but
-        # may reference them. This avoids the need for forward declarations.
+        # may reference them
         for node_txt in node_txt_list:
             self.Out(''.join(node_txt))
 